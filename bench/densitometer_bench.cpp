@@ -0,0 +1,719 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <string.h>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QFile>
+#include <QSysInfo>
+#include <QDebug>
+
+#include "../src/denscommand.h"
+#include "../src/denscommandview.h"
+#include "../src/densbufferedtransport.h"
+#include "../src/densinterface.h"
+#include "../src/polyfit.h"
+#include "../src/stmcrc32.h"
+#include "../src/util.h"
+#include "../src/densistick/densistickinterface.h"
+#include "../src/densistick/densistickrunner.h"
+#include "../src/densistick/densisticksettings.h"
+#include "../src/densistick/densistickworker.h"
+#include "../src/densistick/ft260emulator.h"
+
+namespace
+{
+/* Number of timed samples taken of each benchmark, the median is reported */
+static const int SAMPLE_COUNT = 5;
+
+/* Lines in each synthetic stream fed through DensInterface */
+static const int STREAM_LINES = 1000;
+
+/* Location of the calibration page in the DensiStick EEPROM */
+static const qsizetype EEPROM_CAL_PAGE = 0x110;
+static const qsizetype EEPROM_CAL_PAGE_SIZE = 112;
+
+/* Wall time allowed for one emulated measurement before giving up on it */
+static const int RUNNER_TIMEOUT_MS = 5000;
+
+/* Stream values collected from the emulator in each timed streaming pass */
+static const qint64 STREAM_VALUE_COUNT = 500;
+
+/* Consumes benchmark results, so the work producing them is not optimized away */
+volatile quint64 benchSink = 0;
+
+bool verboseOutput = false;
+
+void benchMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    Q_UNUSED(context)
+    if (verboseOutput || type == QtCriticalMsg || type == QtFatalMsg) {
+        std::cerr << msg.toStdString() << std::endl;
+    }
+}
+
+/**
+ * Transport that hands DensInterface a prepared byte stream,
+ * as if it had all just arrived from the device.
+ */
+class BenchTransport : public DensBufferedTransport
+{
+public:
+    explicit BenchTransport(QObject *parent = nullptr) : DensBufferedTransport(parent) {}
+
+    bool open() override { open_ = true; return true; }
+    void close() override { open_ = false; }
+    bool isOpen() const override { return open_; }
+
+    QString description() const override { return QStringLiteral("bench"); }
+    QString errorString() const override { return QString(); }
+
+    qint64 write(const QByteArray &data) override { return data.size(); }
+
+    void deliver(const QByteArray &data)
+    {
+        clearReceived();
+        appendReceived(data);
+        emit readyRead();
+    }
+
+private:
+    bool open_ = false;
+};
+
+struct BenchResult
+{
+    QString name;
+    qint64 iterations = 0;
+    double nsPerOp = 0;
+    qint64 bytesPerOp = 0;
+    QJsonObject counters;
+};
+
+/**
+ * Runs each benchmark for long enough to get a stable timing,
+ * and collects the results for output as JSON.
+ */
+class BenchRunner
+{
+public:
+    BenchRunner(qint64 minTimeMs, const QString &filter)
+        : minTimeNs_(minTimeMs * 1000000), filter_(filter)
+    {
+    }
+
+    /**
+     * Time a single benchmark. The function performs one operation and
+     * returns a value derived from its result. If bytesPerOp is set,
+     * throughput is reported as well.
+     */
+    template <typename Fn>
+    void run(const char *name, qint64 bytesPerOp, Fn fn)
+    {
+        const QString benchName = QString::fromLatin1(name);
+        if (!filter_.isEmpty() && !benchName.contains(filter_)) { return; }
+
+        // Find an iteration count that takes a measurable amount of time
+        qint64 iterations = 1;
+        for (;;) {
+            const qint64 elapsed = timeIterations(iterations, fn);
+            if (elapsed >= minTimeNs_ / SAMPLE_COUNT || iterations >= (qint64(1) << 40)) { break; }
+            iterations *= (elapsed > 0 && elapsed < minTimeNs_ / (SAMPLE_COUNT * 10)) ? 10 : 2;
+        }
+
+        std::vector<double> samples;
+        for (int i = 0; i < SAMPLE_COUNT; i++) {
+            samples.push_back(static_cast<double>(timeIterations(iterations, fn)) / static_cast<double>(iterations));
+        }
+        std::sort(samples.begin(), samples.end());
+
+        BenchResult result;
+        result.name = benchName;
+        result.iterations = iterations;
+        result.nsPerOp = samples[samples.size() / 2];
+        result.bytesPerOp = bytesPerOp;
+        results_.append(result);
+
+        std::cerr << name << ": " << result.nsPerOp << " ns/op" << std::endl;
+    }
+
+    /** Attach extra measurements to a benchmark that has already run */
+    void addCounters(const char *name, const QJsonObject &counters)
+    {
+        const QString benchName = QString::fromLatin1(name);
+        for (BenchResult &result : results_) {
+            if (result.name == benchName) {
+                result.counters = counters;
+                for (auto it = counters.constBegin(); it != counters.constEnd(); ++it) {
+                    std::cerr << "  " << it.key().toStdString() << ": " << it.value().toDouble() << std::endl;
+                }
+                return;
+            }
+        }
+    }
+
+    QJsonDocument toJson() const
+    {
+        QJsonArray benchmarks;
+        for (const BenchResult &result : results_) {
+            QJsonObject entry;
+            entry["name"] = result.name;
+            entry["iterations"] = result.iterations;
+            entry["ns_per_op"] = result.nsPerOp;
+            if (result.bytesPerOp > 0 && result.nsPerOp > 0) {
+                entry["bytes_per_op"] = result.bytesPerOp;
+                entry["mb_per_s"] = (static_cast<double>(result.bytesPerOp) * 1000.0) / result.nsPerOp;
+            }
+            if (!result.counters.isEmpty()) {
+                entry["counters"] = result.counters;
+            }
+            benchmarks.append(entry);
+        }
+
+        QJsonObject root;
+        root["version"] = QCoreApplication::applicationVersion();
+        root["qt_version"] = QString::fromLatin1(qVersion());
+        root["cpu"] = QSysInfo::currentCpuArchitecture();
+        root["os"] = QSysInfo::prettyProductName();
+        root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+        root["benchmarks"] = benchmarks;
+        return QJsonDocument(root);
+    }
+
+private:
+    template <typename Fn>
+    qint64 timeIterations(qint64 iterations, Fn &fn)
+    {
+        quint64 sink = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for (qint64 i = 0; i < iterations; i++) {
+            sink += static_cast<quint64>(fn());
+        }
+        const qint64 elapsed = timer.nsecsElapsed();
+        benchSink = benchSink + sink;
+        return elapsed;
+    }
+
+    qint64 minTimeNs_;
+    QString filter_;
+    QList<BenchResult> results_;
+};
+
+quint64 floatBits(float value)
+{
+    quint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+QList<float> sampleFloats(int count)
+{
+    QList<float> values;
+    values.reserve(count);
+    for (int i = 0; i < count; i++) {
+        values.append(std::pow(10.0F, -static_cast<float>(i % 40) / 10.0F) * 1.2345F);
+    }
+    return values;
+}
+
+void benchCommand(BenchRunner &runner)
+{
+    QStringList args;
+    const QList<float> values = sampleFloats(8);
+    for (float value : values) {
+        args.append(util::encode_f32(value));
+    }
+    const DensCommand command(DensCommand::TypeGet, DensCommand::CategoryCalibration, "GAIN", args);
+    const QByteArray line = command.toString().toLatin1() + "\r\n";
+
+    runner.run("command.parse", line.size(), [&line]() {
+        const DensCommand parsed = DensCommand::parse(line);
+        return parsed.args().size();
+    });
+    runner.run("command.view", line.size(), [&line]() {
+        const DensCommandView view(line);
+        return view.argCount();
+    });
+    runner.run("command.to_string", line.size(), [&command]() {
+        return command.toString().size();
+    });
+}
+
+void benchFloatCodec(BenchRunner &runner)
+{
+    const QList<float> values = sampleFloats(64);
+    QStringList encoded;
+    QList<QByteArray> encodedBytes;
+    for (float value : values) {
+        encoded.append(util::encode_f32(value));
+        encodedBytes.append(encoded.last().toLatin1());
+    }
+
+    int index = 0;
+    runner.run("f32.encode_buffer", 0, [&values, &index]() {
+        char buf[8];
+        util::encode_f32(values.at(index++ & 63), buf);
+        return buf[7];
+    });
+    runner.run("f32.encode_string", 0, [&values, &index]() {
+        return util::encode_f32(values.at(index++ & 63)).size();
+    });
+    runner.run("f32.decode_string", 0, [&encoded, &index]() {
+        return floatBits(util::decode_f32(encoded.at(index++ & 63)));
+    });
+    runner.run("f32.decode_bytes", 0, [&encodedBytes, &index]() {
+        return floatBits(util::decode_f32(QByteArrayView(encodedBytes.at(index++ & 63))));
+    });
+
+    const QStringList argList = encoded.mid(0, 8);
+    runner.run("f32.decode_list8", 0, [&argList]() {
+        float out[8];
+        util::decode_f32_list(argList, out, 8);
+        return floatBits(out[7]);
+    });
+
+    QByteArray block;
+    for (int i = 0; i < 64; i++) {
+        block.append(encodedBytes.at(i));
+    }
+    block = block.repeated(8);
+    std::vector<uint8_t> decoded(block.size() / 2);
+    runner.run("hex.decode_4k", block.size(), [&block, &decoded]() {
+        return util::decode_hex(block, decoded.data());
+    });
+    runner.run("hex.from_hex_4k", block.size(), [&block]() {
+        return QByteArray::fromHex(block).size();
+    });
+}
+
+void benchCrc(BenchRunner &runner)
+{
+    std::vector<uint32_t> words(64 * 1024 / 4);
+    for (size_t i = 0; i < words.size(); i++) {
+        words[i] = static_cast<uint32_t>(i * 2654435761U);
+    }
+
+    runner.run("crc.stm32_40b", 40, [&words]() {
+        return util::calculateStmCrc32(words.data(), 10);
+    });
+    runner.run("crc.stm32_64k", static_cast<qint64>(words.size() * 4), [&words]() {
+        return util::calculateStmCrc32(words.data(), words.size());
+    });
+
+    // Each engine on its own, the nibble engine being the original implementation
+    static const struct { const char *shortName; const char *longName; StmCrc32::Engine engine; } engines[] = {
+        { "crc.nibble_40b", "crc.nibble_64k", StmCrc32::EngineNibble },
+        { "crc.slicing8_40b", "crc.slicing8_64k", StmCrc32::EngineSlicing8 },
+        { "crc.clmul_40b", "crc.clmul_64k", StmCrc32::EngineClmul }
+    };
+    for (const auto &entry : engines) {
+        if (!StmCrc32::isSupported(entry.engine)) { continue; }
+        const StmCrc32::Engine engine = entry.engine;
+        runner.run(entry.shortName, 40, [&words, engine]() {
+            return StmCrc32::update(engine, 0xFFFFFFFF, words.data(), 10);
+        });
+        runner.run(entry.longName, static_cast<qint64>(words.size() * 4), [&words, engine]() {
+            return StmCrc32::update(engine, 0xFFFFFFFF, words.data(), words.size());
+        });
+    }
+
+    // Streamed in uneven pieces, as it would arrive from a device
+    const QByteArray bytes(reinterpret_cast<const char *>(words.data()), static_cast<qsizetype>(words.size() * 4));
+    runner.run("crc.stream_64k", bytes.size(), [&bytes]() {
+        StmCrc32 crc;
+        for (qsizetype pos = 0; pos < bytes.size(); pos += 61) {
+            crc.addData(QByteArrayView(bytes).sliced(pos, qMin<qsizetype>(61, bytes.size() - pos)));
+        }
+        return crc.result();
+    });
+}
+
+void benchPolyfit(BenchRunner &runner)
+{
+    QList<float> xList;
+    QList<float> yList;
+    for (int i = 0; i < 21; i++) {
+        const float x = static_cast<float>(i) * 0.15F;
+        xList.append(x);
+        yList.append(0.02F + (0.98F * x) + (0.015F * x * x));
+    }
+
+    runner.run("polyfit.quadratic_21", 0, [&xList, &yList]() {
+        const auto result = util::polyfit(xList, yList);
+        return floatBits(std::get<1>(result));
+    });
+
+    // Cost of taking one more point into an existing fit, then re-solving
+    PolyFit<2> fit;
+    for (qsizetype i = 0; i < xList.size(); i++) {
+        fit.addPoint(xList[i], yList[i]);
+    }
+    runner.run("polyfit.add_point", 0, [&fit]() {
+        fit.addPoint(1.5, 1.5);
+        fit.removePoint(1.5, 1.5);
+        return fit.count();
+    });
+    runner.run("polyfit.solve", 0, [&fit]() {
+        PolyFit<2>::Coefficients beta;
+        fit.solve(beta);
+        return static_cast<quint64>(beta[1] * 1000000.0);
+    });
+}
+
+DensiStickCalibration benchCalibration()
+{
+    PeripheralCalGain calGain;
+    float gainValue = 0.5F;
+    for (int i = PeripheralCalGain::Gain0_5X; i <= PeripheralCalGain::Gain256X; i++) {
+        calGain.setGainValue(static_cast<PeripheralCalGain::GainLevel>(i), gainValue);
+        gainValue *= 2.01F;
+    }
+    PeripheralCalDensityTarget calTarget;
+    calTarget.setLoDensity(0.08F);
+    calTarget.setLoReading(123456.0F);
+    calTarget.setHiDensity(2.95F);
+    calTarget.setHiReading(150.0F);
+
+    DensiStickCalibration calibration;
+    calibration.setGainCalibration(calGain);
+    calibration.setTargetCalibration(calTarget);
+    return calibration;
+}
+
+void benchDensiStick(BenchRunner &runner)
+{
+    const QByteArray page = DensiStickSettings::encodeCalibration(benchCalibration());
+
+    runner.run("densistick.parse_calibration", page.size(), [&page]() {
+        const DensiStickCalibration parsed = DensiStickSettings::parseCalibration(page);
+        return floatBits(parsed.targetCalibration().hiReading());
+    });
+
+    // A full FIFO worth of 7 byte records, alternating gain and saturation
+    QByteArray fifo;
+    for (int i = 0; i < 73; i++) {
+        const quint32 value = 100000U + static_cast<quint32>(i) * 37U;
+        fifo.append(static_cast<char>(value & 0xFF));
+        fifo.append(static_cast<char>((value >> 8) & 0xFF));
+        fifo.append(static_cast<char>((value >> 16) & 0xFF));
+        fifo.append(static_cast<char>((value >> 24) & 0xFF));
+        fifo.append(static_cast<char>((i % 16) == 15 ? 0x08 : 0x00));
+        fifo.append(static_cast<char>(i % 10));
+        fifo.append('\0');
+    }
+
+    runner.run("densistick.decode_fifo", fifo.size(), [&fifo]() {
+        return DensiStickWorker::decodeFifoRecords(fifo, 1000000, 10.0F).size();
+    });
+}
+
+/**
+ * Continuously measure through DensiStickRunner, against the emulator in
+ * virtual time, covering the path from the sensor FIFO through
+ * DensiStickInterface::readStream() to the streamValues() signal.
+ */
+void benchDensiStickStream(BenchRunner &runner, DensiStickRunner &stickRunner, Ft260Emulator *emulator)
+{
+    QEventLoop loop;
+    QTimer watchdog;
+    watchdog.setSingleShot(true);
+    QObject::connect(&watchdog, &QTimer::timeout, &loop, &QEventLoop::quit);
+
+    qint64 received = 0;
+    qint64 target = 0;
+    QObject::connect(&stickRunner, &DensiStickRunner::streamValues, &loop,
+                     [&loop, &received, &target](const QList<DensiStickStreamValue> &values) {
+        for (const DensiStickStreamValue &value : values) {
+            benchSink += static_cast<quint64>(value.basicReading);
+        }
+        received += values.size();
+        if (received >= target) {
+            loop.quit();
+        }
+    });
+
+    if (!stickRunner.startStreaming()) {
+        qWarning() << "Unable to start streaming from the emulated DensiStick";
+        return;
+    }
+
+    qint64 passes = 0;
+    qint64 timeouts = 0;
+    auto stream = [&loop, &watchdog, &received, &target, &passes, &timeouts]() {
+        if (timeouts > 0) { return received; }
+
+        target = received + STREAM_VALUE_COUNT;
+        watchdog.start(RUNNER_TIMEOUT_MS);
+        loop.exec();
+        if (watchdog.isActive()) {
+            watchdog.stop();
+            passes++;
+        } else {
+            timeouts++;
+        }
+        return received;
+    };
+
+    // Make sure values are flowing before timing it
+    stream();
+    if (passes == 0) {
+        qWarning() << "Emulated DensiStick stream did not deliver any values";
+        stickRunner.stopStreaming();
+        return;
+    }
+
+    passes = 0;
+    received = 0;
+    emulator->resetStats();
+    const qint64 startUs = emulator->clockUs();
+    runner.run("densistick.runner_stream_virtual", 0, stream);
+    const qint64 elapsedUs = emulator->clockUs() - startUs;
+
+    stickRunner.stopStreaming();
+
+    if (received > 0) {
+        const Ft260EmulatorStats stats = emulator->stats();
+        const double count = static_cast<double>(received);
+        QJsonObject counters;
+        counters["values"] = received;
+        counters["timeouts"] = timeouts;
+        counters["values_per_second"] = elapsedUs > 0 ? count * 1000000.0 / static_cast<double>(elapsedUs) : 0.0;
+        counters["transactions_per_value"] = static_cast<double>(stats.transactions) / count;
+        counters["bus_time_us_per_value"] = static_cast<double>(stats.busTimeUs) / count;
+        counters["interrupts_per_value"] = static_cast<double>(stats.interrupts) / count;
+        runner.addCounters("densistick.runner_stream_virtual", counters);
+    }
+}
+
+/**
+ * Take complete target measurements through DensiStickRunner, against
+ * the emulator in virtual time. Besides the wall time per measurement,
+ * this reports the emulated time and bus traffic each one took.
+ */
+void benchDensiStickRunner(BenchRunner &runner)
+{
+    Ft260Emulator::setEnabled(true);
+    const QList<Ft260DeviceInfo> devices = Ft260Emulator::listDevices();
+    if (devices.isEmpty()) { return; }
+
+    Ft260Emulator *emulator = new Ft260Emulator(devices.first());
+    emulator->setRealTime(false);
+    emulator->setIdleAdvance(true);
+
+    QByteArray eeprom = emulator->eepromContents();
+    eeprom.replace(EEPROM_CAL_PAGE, EEPROM_CAL_PAGE_SIZE, DensiStickSettings::encodeCalibration(benchCalibration()));
+    emulator->setEepromContents(eeprom);
+
+    DensiStickRunner stickRunner(new DensiStickInterface(emulator));
+    if (!stickRunner.stickInterface()->open()) {
+        qWarning() << "Unable to open the emulated DensiStick";
+        return;
+    }
+    stickRunner.reloadCalibration();
+    stickRunner.setEnabled(true);
+
+    QEventLoop loop;
+    QTimer watchdog;
+    watchdog.setSingleShot(true);
+    QObject::connect(&watchdog, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(&stickRunner, &DensiStickRunner::targetMeasurement, &loop, &QEventLoop::quit);
+
+    qint64 measurements = 0;
+    qint64 timeouts = 0;
+    auto measure = [emulator, &loop, &watchdog, &measurements, &timeouts]() {
+        // A runner stuck in the middle of a measurement ignores the button
+        if (timeouts > 0) { return measurements; }
+
+        emulator->setButtonPressed(true);
+        emulator->setButtonPressed(false);
+        watchdog.start(RUNNER_TIMEOUT_MS);
+        loop.exec();
+        if (watchdog.isActive()) {
+            watchdog.stop();
+            measurements++;
+        } else {
+            timeouts++;
+        }
+        return measurements;
+    };
+
+    // Make sure the whole stack works before timing it
+    measure();
+    if (measurements == 0) {
+        qWarning() << "Emulated DensiStick measurement did not complete";
+        return;
+    }
+
+    measurements = 0;
+    emulator->resetStats();
+    const qint64 startUs = emulator->clockUs();
+    runner.run("densistick.runner_measure_virtual", 0, measure);
+
+    if (measurements > 0) {
+        const Ft260EmulatorStats stats = emulator->stats();
+        const double count = static_cast<double>(measurements);
+        QJsonObject counters;
+        counters["measurements"] = measurements;
+        counters["timeouts"] = timeouts;
+        counters["latency_us"] = static_cast<double>(emulator->clockUs() - startUs) / count;
+        counters["transactions_per_op"] = static_cast<double>(stats.transactions) / count;
+        counters["i2c_ops_per_op"] = static_cast<double>(stats.i2cOperations) / count;
+        counters["bus_time_us_per_op"] = static_cast<double>(stats.busTimeUs) / count;
+        counters["interrupts_per_op"] = static_cast<double>(stats.interrupts) / count;
+        runner.addCounters("densistick.runner_measure_virtual", counters);
+    }
+
+    benchDensiStickStream(runner, stickRunner, emulator);
+
+    stickRunner.setEnabled(false);
+    stickRunner.stickInterface()->close();
+}
+
+QByteArray densityStream(bool extended)
+{
+    const QList<float> values = sampleFloats(STREAM_LINES);
+    QByteArray stream;
+    for (int i = 0; i < STREAM_LINES; i++) {
+        const float density = -std::log10(values.at(i) / 1.2345F);
+        stream.append((i & 1) ? 'T' : 'R');
+        stream.append(QByteArray::number(density, 'f', 2));
+        stream.append('D');
+        if (extended) {
+            char buf[8];
+            for (float value : { density, 0.0F, values.at(i), values.at(i) }) {
+                util::encode_f32(value, buf);
+                stream.append(',');
+                stream.append(buf, sizeof(buf));
+            }
+        }
+        stream.append("\r\n");
+    }
+    return stream;
+}
+
+QByteArray logStream()
+{
+    static const char LEVELS[] = { 'D', 'D', 'I', 'W' };
+    QByteArray stream;
+    for (int i = 0; i < STREAM_LINES; i++) {
+        stream.append(LEVELS[i % 4]);
+        stream.append("/sensor: ch0=");
+        stream.append(QByteArray::number(100000 + i));
+        stream.append(", ch1=");
+        stream.append(QByteArray::number(10000 + i));
+        stream.append("\r\n");
+    }
+    return stream;
+}
+
+void benchInterface(BenchRunner &runner)
+{
+    DensInterface densInterface;
+    BenchTransport *transport = new BenchTransport(&densInterface);
+    transport->open();
+    if (!densInterface.connectToDevice(transport, DensInterface::DeviceBaseline)) {
+        qWarning() << "Unable to connect to bench transport";
+        return;
+    }
+
+    const DensCommand version(DensCommand::TypeGet, DensCommand::CategorySystem, "V",
+                              QStringList() << "Printalyzer Densitometer" << "0.0.0-bench");
+    transport->deliver(version.toString().toLatin1() + "\r\n");
+    if (!densInterface.connected()) {
+        qWarning() << "Bench transport did not connect";
+        return;
+    }
+
+    int readings = 0;
+    QObject::connect(&densInterface, &DensInterface::densityReading, [&readings]() { readings++; });
+
+    const QByteArray basicStream = densityStream(false);
+    runner.run("interface.read_density_1k", basicStream.size(), [transport, &basicStream, &readings]() {
+        transport->deliver(basicStream);
+        return readings;
+    });
+
+    const QByteArray extendedStream = densityStream(true);
+    runner.run("interface.read_density_ext_1k", extendedStream.size(), [transport, &extendedStream, &readings]() {
+        transport->deliver(extendedStream);
+        return readings;
+    });
+
+    int logLines = 0;
+    QObject::connect(&densInterface, &DensInterface::diagLogLine, [&logLines]() { logLines++; });
+
+    const QByteArray logs = logStream();
+    runner.run("interface.read_log_1k", logs.size(), [transport, &logs, &logLines]() {
+        transport->deliver(logs);
+        return logLines;
+    });
+
+    densInterface.disconnectFromDevice();
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("densitometer_bench");
+    QCoreApplication::setApplicationVersion("1.1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Micro-benchmarks for the densitometer protocol and device code.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption filterOption(QStringList() << "f" << "filter",
+                                    "Only run benchmarks whose name contains the given text.", "text");
+    parser.addOption(filterOption);
+
+    QCommandLineOption minTimeOption(QStringList() << "min-time",
+                                     "Minimum time spent on each benchmark, in milliseconds.", "ms", "500");
+    parser.addOption(minTimeOption);
+
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Write the JSON results to a file, instead of standard output.", "file");
+    parser.addOption(outputOption);
+
+    QCommandLineOption verboseOption(QStringList() << "verbose",
+                                     "Show log messages from the code being benchmarked.");
+    parser.addOption(verboseOption);
+
+    parser.process(app);
+
+    verboseOutput = parser.isSet(verboseOption);
+    qInstallMessageHandler(benchMessageHandler);
+
+    BenchRunner runner(qMax(1, parser.value(minTimeOption).toInt()), parser.value(filterOption));
+    benchCommand(runner);
+    benchFloatCodec(runner);
+    benchCrc(runner);
+    benchPolyfit(runner);
+    benchDensiStick(runner);
+    benchDensiStickRunner(runner);
+    benchInterface(runner);
+
+    const QByteArray json = runner.toJson().toJson(QJsonDocument::Indented);
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            std::cerr << "Unable to write results to: " << file.fileName().toStdString() << std::endl;
+            return 1;
+        }
+        file.write(json);
+    } else {
+        std::cout << json.toStdString();
+    }
+
+    return 0;
+}
@@ -252,10 +252,7 @@ void CalibrationBaselineTab::onDensityReading(DensInterface::DensityType type, f
 void CalibrationBaselineTab::onCalGetAllValues()
 {
     densInterface_->sendGetCalLight();
-    densInterface_->sendGetCalGain();
-    densInterface_->sendGetCalSlope();
-    densInterface_->sendGetCalReflection();
-    densInterface_->sendGetCalTransmission();
+    densInterface_->sendGetCalSnapshot();
 }
 
 void CalibrationBaselineTab::onCalLightSetClicked()
@@ -556,9 +553,9 @@ void CalibrationBaselineTab::onSlopeCalibrationToolFinished(int result)
     dialog->deleteLater();
 
     if (result == QDialog::Accepted) {
-        auto result = dialog->calValues();
-        ui->b0LineEdit->setText(QString::number(std::get<0>(result), 'f'));
-        ui->b1LineEdit->setText(QString::number(std::get<1>(result), 'f'));
-        ui->b2LineEdit->setText(QString::number(std::get<2>(result), 'f'));
+        const PolyFit<2>::Coefficients result = dialog->calValues();
+        ui->b0LineEdit->setText(QString::number(result[0], 'f'));
+        ui->b1LineEdit->setText(QString::number(result[1], 'f'));
+        ui->b2LineEdit->setText(QString::number(result[2], 'f'));
     }
 }
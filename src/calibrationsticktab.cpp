@@ -6,7 +6,6 @@
 
 #include "floatitemdelegate.h"
 #include "stickgaincalibrationdialog.h"
-#include "densistick/densisticksettings.h"
 #include "util.h"
 
 CalibrationStickTab::CalibrationStickTab(DensiStickRunner *stickRunner, QWidget *parent)
@@ -17,6 +16,8 @@ CalibrationStickTab::CalibrationStickTab(DensiStickRunner *stickRunner, QWidget
 
     connect(stickRunner_, &QObject::destroyed, this, &CalibrationStickTab::onStickInterfaceDestroyed);
     connect(stickRunner_, &DensiStickRunner::targetMeasurement, this, &CalibrationStickTab::onTargetMeasurement);
+    connect(stickRunner_->stickInterface(), &DensiStickInterface::calibrationChanged, this, &CalibrationStickTab::onCalibrationChanged);
+    connect(stickRunner_->stickInterface(), &DensiStickInterface::calibrationWritten, this, &CalibrationStickTab::onCalibrationWritten);
 
     // Calibration UI signals
     connect(ui->calGetAllPushButton, &QPushButton::clicked, this, &CalibrationStickTab::onCalGetAllValues);
@@ -131,9 +132,8 @@ void CalibrationStickTab::onCalGetAllValues()
 {
     if (!stickRunner_ || !stickRunner_->stickInterface()->connected() || !stickRunner_->stickInterface()->hasSettings()) { return; }
 
-    calData_ = stickRunner_->stickInterface()->settings()->readCalibration();
-    updateCalGain();
-    updateCalTarget();
+    calReadPending_ = true;
+    stickRunner_->stickInterface()->readCalibration();
 }
 
 void CalibrationStickTab::onCalGainCalClicked()
@@ -197,12 +197,8 @@ void CalibrationStickTab::onCalGainSetClicked()
 
     updatedCal.setGainCalibration(calGain);
 
-    if (stickRunner_->stickInterface()->settings()->writeCalibration(updatedCal)) {
-        calData_ = updatedCal;
-        stickRunner_->reloadCalibration();
-        updateCalGain();
-    }
-    emit calibrationSaved();
+    calWritePending_ = CalSectionGain;
+    stickRunner_->stickInterface()->writeCalibration(updatedCal);
 }
 
 void CalibrationStickTab::onCalReflectionSetClicked()
@@ -225,11 +221,34 @@ void CalibrationStickTab::onCalReflectionSetClicked()
     DensiStickCalibration updatedCal = calData_;
     updatedCal.setTargetCalibration(calTarget);
 
-    if (stickRunner_->stickInterface()->settings()->writeCalibration(updatedCal)) {
-        calData_ = updatedCal;
+    calWritePending_ = CalSectionTarget;
+    stickRunner_->stickInterface()->writeCalibration(updatedCal);
+}
+
+void CalibrationStickTab::onCalibrationChanged(const DensiStickCalibration &calibration)
+{
+    if (!calReadPending_) { return; }
+    calReadPending_ = false;
+
+    calData_ = calibration;
+    updateCalGain();
+    updateCalTarget();
+}
+
+void CalibrationStickTab::onCalibrationWritten(bool success)
+{
+    if (!stickRunner_ || calWritePending_ == CalSectionNone) { return; }
+
+    if (success) {
+        calData_ = stickRunner_->stickInterface()->calibration();
         stickRunner_->reloadCalibration();
-        updateCalTarget();
+        if (calWritePending_ == CalSectionGain) {
+            updateCalGain();
+        } else {
+            updateCalTarget();
+        }
     }
+    calWritePending_ = CalSectionNone;
     emit calibrationSaved();
 }
 
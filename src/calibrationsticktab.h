@@ -46,7 +46,16 @@ private slots:
     void onCalGainItemChanged(QTableWidgetItem *item);
     void onCalReflectionTextChanged();
 
+    void onCalibrationChanged(const DensiStickCalibration &calibration);
+    void onCalibrationWritten(bool success);
+
 private:
+    enum CalSection {
+        CalSectionNone,
+        CalSectionGain,
+        CalSectionTarget
+    };
+
     void refreshButtonState();
     void updateCalGain();
     void updateCalTarget();
@@ -56,6 +65,8 @@ private:
     Ui::CalibrationStickTab *ui;
     DensiStickRunner *stickRunner_ = nullptr;
     DensiStickCalibration calData_;
+    bool calReadPending_ = false;
+    CalSection calWritePending_ = CalSectionNone;
 };
 
 #endif // CALIBRATIONSTICKTAB_H
@@ -241,13 +241,7 @@ void CalibrationUvVisTab::onDensityReading(DensInterface::DensityType type, floa
 
 void CalibrationUvVisTab::onCalGetAllValues()
 {
-    densInterface_->sendGetCalGain();
-    densInterface_->sendGetCalSlope();
-    densInterface_->sendGetCalVisTemperature();
-    densInterface_->sendGetCalUvTemperature();
-    densInterface_->sendGetCalReflection();
-    densInterface_->sendGetCalTransmission();
-    densInterface_->sendGetCalUvTransmission();
+    densInterface_->sendGetCalSnapshot();
 }
 
 
@@ -0,0 +1,79 @@
+#include "densbufferedtransport.h"
+
+#include <string.h>
+
+namespace
+{
+/* Compact the receive buffer once this much of it has been consumed */
+static const qsizetype COMPACT_THRESHOLD = 4096;
+}
+
+DensBufferedTransport::DensBufferedTransport(QObject *parent)
+    : DensTransport(parent)
+{
+}
+
+DensBufferedTransport::~DensBufferedTransport()
+{
+}
+
+bool DensBufferedTransport::canReadLine() const
+{
+    return buffer_.indexOf('\n', readPos_) >= 0;
+}
+
+QByteArray DensBufferedTransport::readLine()
+{
+    const qsizetype end = buffer_.indexOf('\n', readPos_);
+    if (end < 0) { return QByteArray(); }
+
+    const QByteArray line = buffer_.sliced(readPos_, end + 1 - readPos_);
+    consume(line.size());
+    return line;
+}
+
+qint64 DensBufferedTransport::bytesAvailable() const
+{
+    return buffer_.size() - readPos_;
+}
+
+qint64 DensBufferedTransport::read(char *data, qint64 maxSize)
+{
+    const qint64 size = qMin<qint64>(maxSize, buffer_.size() - readPos_);
+    if (size <= 0) { return 0; }
+
+    memcpy(data, buffer_.constData() + readPos_, size);
+    consume(size);
+    return size;
+}
+
+QByteArray DensBufferedTransport::readAll()
+{
+    const QByteArray data = buffer_.sliced(readPos_);
+    clearReceived();
+    return data;
+}
+
+void DensBufferedTransport::appendReceived(QByteArrayView data)
+{
+    buffer_.append(data);
+}
+
+void DensBufferedTransport::clearReceived()
+{
+    buffer_.clear();
+    readPos_ = 0;
+}
+
+void DensBufferedTransport::consume(qsizetype size)
+{
+    readPos_ += size;
+
+    if (readPos_ == buffer_.size()) {
+        buffer_.clear();
+        readPos_ = 0;
+    } else if (readPos_ >= COMPACT_THRESHOLD) {
+        buffer_.remove(0, readPos_);
+        readPos_ = 0;
+    }
+}
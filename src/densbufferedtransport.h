@@ -0,0 +1,40 @@
+#ifndef DENSBUFFEREDTRANSPORT_H
+#define DENSBUFFEREDTRANSPORT_H
+
+#include "denstransport.h"
+
+/**
+ * Transport that keeps everything it receives in its own buffer,
+ * and serves all reads from that buffer.
+ *
+ * Subclasses only have to append incoming data with appendReceived(),
+ * and emit readyRead() once it is there. Consumed data is only moved out
+ * of the way once enough of it has built up, so reading line by line
+ * does not shift the rest of the buffer every time.
+ */
+class DensBufferedTransport : public DensTransport
+{
+    Q_OBJECT
+public:
+    explicit DensBufferedTransport(QObject *parent = nullptr);
+    virtual ~DensBufferedTransport();
+
+    virtual bool canReadLine() const override;
+    virtual QByteArray readLine() override;
+    virtual qint64 bytesAvailable() const override;
+    virtual qint64 read(char *data, qint64 maxSize) override;
+
+    QByteArray readAll();
+
+protected:
+    void appendReceived(QByteArrayView data);
+    void clearReceived();
+
+private:
+    void consume(qsizetype size);
+
+    QByteArray buffer_;
+    qsizetype readPos_ = 0;
+};
+
+#endif // DENSBUFFEREDTRANSPORT_H
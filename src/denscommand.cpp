@@ -1,5 +1,7 @@
 #include "denscommand.h"
 
+#include "denscommandview.h"
+
 class DensCommandData : public QSharedData
 {
 public:
@@ -56,7 +58,7 @@ bool DensCommand::isValid() const
             && !d->action.isEmpty();
 }
 
-bool DensCommand::isMatch(const DensCommand &other)
+bool DensCommand::isMatch(const DensCommand &other) const
 {
     return d->type == other.d->type
             && d->category == other.d->category
@@ -76,80 +78,7 @@ bool DensCommand::isError() const
 
 DensCommand DensCommand::parse(const QByteArray &data)
 {
-    const QStringList elements = splitLine(data);
-    CommandType type = TypeUnknown;
-    CommandCategory category = CategoryUnknown;
-    QString action;
-    QStringList args;
-
-    if (elements.count() > 0) {
-        const QString cmd = elements[0];
-        if (cmd.length() > 0) {
-            switch (cmd[0].toLatin1()) {
-            case 'S':
-                type = TypeSet;
-                break;
-            case 'G':
-                type = TypeGet;
-                break;
-            case 'I':
-                type = TypeInvoke;
-                break;
-            case 'R':
-                type = TypeDensityReflection;
-                break;
-            case 'T':
-                type = TypeDensityTransmission;
-                break;
-            case 'U':
-                type = TypeDensityUvTransmission;
-                break;
-            default:
-                type = TypeUnknown;
-                break;
-            }
-        }
-        if (type == TypeDensityReflection || type == TypeDensityTransmission || type == TypeDensityUvTransmission) {
-            if (cmd.length() > 1) {
-                args.append(cmd.mid(1));
-            }
-            args.append(elements.mid(1));
-        } else {
-            if (cmd.length() > 1) {
-                switch (cmd[1].toLatin1()) {
-                case 'S':
-                    category = CategorySystem;
-                    break;
-                case 'M':
-                    category = CategoryMeasurement;
-                    break;
-                case 'C':
-                    category = CategoryCalibration;
-                    break;
-                case 'D':
-                    category = CategoryDiagnostics;
-                    break;
-                default:
-                    category = CategoryUnknown;
-                    break;
-                }
-            }
-            if (cmd.length() > 3 && cmd[2] == QChar::Space) {
-                action = cmd.mid(3);
-            }
-        }
-    }
-    if (args.isEmpty() && elements.count() > 1) {
-        args.append(elements.mid(1));
-    }
-
-    if ((type == TypeDensityReflection || type == TypeDensityTransmission || type == TypeDensityUvTransmission) && !args.isEmpty()) {
-        return DensCommand(type, CategoryUnknown, QString(), args);
-    } else if (type != TypeUnknown && category != CategoryUnknown && !action.isEmpty()) {
-        return DensCommand(type, category, action, args);
-    } else {
-        return DensCommand();
-    }
+    return DensCommandView(data).toCommand();
 }
 
 DensCommand::CommandType DensCommand::type() const
@@ -241,18 +170,3 @@ QString DensCommand::toString() const
     }
     return result;
 }
-
-QStringList DensCommand::splitLine(const QByteArray &line)
-{
-    QStringList result;
-    const QList<QByteArray> elementList = line.trimmed().split(',');
-    for (const QByteArray &element : elementList) {
-        if (element.length() >= 2 && element.startsWith('"') && element.endsWith('"')) {
-            QString elementStr = QString::fromLatin1(element.mid(1, element.size() - 2));
-            result.append(elementStr);
-        } else {
-            result.append(QString::fromLatin1(element));
-        }
-    }
-    return result;
-}
@@ -33,7 +33,7 @@ public:
     ~DensCommand();
 
     bool isValid() const;
-    bool isMatch(const DensCommand &other);
+    bool isMatch(const DensCommand &other) const;
     bool isDensity() const;
     bool isError() const;
 
@@ -50,7 +50,6 @@ public:
     QString toString() const;
 
 private:
-    static QStringList splitLine(const QByteArray &line);
     QSharedDataPointer<DensCommandData> d;
 };
 
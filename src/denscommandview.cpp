@@ -0,0 +1,193 @@
+#include "denscommandview.h"
+
+namespace
+{
+bool nextField(QByteArrayView line, qsizetype *pos, QByteArrayView *field)
+{
+    if (*pos > line.size()) { return false; }
+
+    qsizetype end = line.indexOf(',', *pos);
+    if (end < 0) { end = line.size(); }
+
+    QByteArrayView element = line.sliced(*pos, end - *pos);
+    if (element.size() >= 2 && element.startsWith('"') && element.endsWith('"')) {
+        element = element.sliced(1, element.size() - 2);
+    }
+
+    *field = element;
+    *pos = end + 1;
+    return true;
+}
+}
+
+DensCommandView::DensCommandView(QByteArrayView line)
+    : line_(line.trimmed())
+    , type_(DensCommand::TypeUnknown)
+    , category_(DensCommand::CategoryUnknown)
+    , argCount_(0)
+    , truncated_(false)
+{
+    qsizetype pos = 0;
+    QByteArrayView cmd;
+    if (!nextField(line_, &pos, &cmd)) { return; }
+
+    if (cmd.size() > 0) {
+        switch (cmd[0]) {
+        case 'S':
+            type_ = DensCommand::TypeSet;
+            break;
+        case 'G':
+            type_ = DensCommand::TypeGet;
+            break;
+        case 'I':
+            type_ = DensCommand::TypeInvoke;
+            break;
+        case 'R':
+            type_ = DensCommand::TypeDensityReflection;
+            break;
+        case 'T':
+            type_ = DensCommand::TypeDensityTransmission;
+            break;
+        case 'U':
+            type_ = DensCommand::TypeDensityUvTransmission;
+            break;
+        default:
+            type_ = DensCommand::TypeUnknown;
+            break;
+        }
+    }
+
+    if (isDensityType(type_)) {
+        // Density readings carry their first value directly after the type
+        if (cmd.size() > 1) {
+            args_[argCount_++] = cmd.sliced(1);
+        }
+    } else {
+        if (cmd.size() > 1) {
+            switch (cmd[1]) {
+            case 'S':
+                category_ = DensCommand::CategorySystem;
+                break;
+            case 'M':
+                category_ = DensCommand::CategoryMeasurement;
+                break;
+            case 'C':
+                category_ = DensCommand::CategoryCalibration;
+                break;
+            case 'D':
+                category_ = DensCommand::CategoryDiagnostics;
+                break;
+            default:
+                category_ = DensCommand::CategoryUnknown;
+                break;
+            }
+        }
+        if (cmd.size() > 3 && cmd[2] == ' ') {
+            action_ = cmd.sliced(3);
+        }
+    }
+
+    QByteArrayView field;
+    while (nextField(line_, &pos, &field)) {
+        if (argCount_ < MaxFields) {
+            args_[argCount_] = field;
+        } else {
+            truncated_ = true;
+        }
+        argCount_++;
+    }
+}
+
+bool DensCommandView::isValid() const
+{
+    if (isDensityType(type_)) {
+        return argCount_ > 0;
+    } else {
+        return type_ != DensCommand::TypeUnknown
+            && category_ != DensCommand::CategoryUnknown
+            && !action_.isEmpty();
+    }
+}
+
+bool DensCommandView::isDensity() const
+{
+    return isDensityType(type_) && argCount_ > 0;
+}
+
+bool DensCommandView::hasSingleArg(QByteArrayView value) const
+{
+    return isValid() && argCount_ == 1 && args_[0] == value;
+}
+
+DensCommand::CommandType DensCommandView::type() const
+{
+    return type_;
+}
+
+DensCommand::CommandCategory DensCommandView::category() const
+{
+    return category_;
+}
+
+QByteArrayView DensCommandView::action() const
+{
+    return action_;
+}
+
+qsizetype DensCommandView::argCount() const
+{
+    return argCount_;
+}
+
+QByteArrayView DensCommandView::arg(qsizetype i) const
+{
+    if (i < 0 || i >= argCount_ || i >= MaxFields) {
+        return QByteArrayView();
+    }
+    return args_[i];
+}
+
+QByteArrayView DensCommandView::line() const
+{
+    return line_;
+}
+
+DensCommand DensCommandView::toCommand() const
+{
+    if (!isValid()) {
+        return DensCommand();
+    }
+
+    QStringList args;
+    args.reserve(argCount_);
+
+    if (truncated_) {
+        // More fields than the view keeps track of, so split the line again
+        qsizetype pos = 0;
+        QByteArrayView field;
+        nextField(line_, &pos, &field);
+        if (isDensityType(type_) && field.size() > 1) {
+            args.append(QString::fromLatin1(field.sliced(1)));
+        }
+        while (nextField(line_, &pos, &field)) {
+            args.append(QString::fromLatin1(field));
+        }
+    } else {
+        for (qsizetype i = 0; i < argCount_; i++) {
+            args.append(QString::fromLatin1(args_[i]));
+        }
+    }
+
+    if (isDensityType(type_)) {
+        return DensCommand(type_, DensCommand::CategoryUnknown, QString(), args);
+    } else {
+        return DensCommand(type_, category_, QString::fromLatin1(action_), args);
+    }
+}
+
+bool DensCommandView::isDensityType(DensCommand::CommandType type)
+{
+    return type == DensCommand::TypeDensityReflection
+        || type == DensCommand::TypeDensityTransmission
+        || type == DensCommand::TypeDensityUvTransmission;
+}
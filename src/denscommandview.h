@@ -0,0 +1,51 @@
+#ifndef DENSCOMMANDVIEW_H
+#define DENSCOMMANDVIEW_H
+
+#include <QByteArrayView>
+#include <array>
+
+#include "denscommand.h"
+
+/**
+ * Non-owning view of a single line received from the device.
+ *
+ * The line is split into comma-separated fields that reference the
+ * original buffer, without any heap allocation. The buffer must outlive
+ * the view. Responses that need more than a quick inspection can be
+ * materialized into a full DensCommand with toCommand().
+ */
+class DensCommandView
+{
+public:
+    static constexpr qsizetype MaxFields = 16;
+
+    explicit DensCommandView(QByteArrayView line);
+
+    bool isValid() const;
+    bool isDensity() const;
+    bool hasSingleArg(QByteArrayView value) const;
+
+    DensCommand::CommandType type() const;
+    DensCommand::CommandCategory category() const;
+    QByteArrayView action() const;
+
+    qsizetype argCount() const;
+    QByteArrayView arg(qsizetype i) const;
+
+    QByteArrayView line() const;
+
+    DensCommand toCommand() const;
+
+private:
+    static bool isDensityType(DensCommand::CommandType type);
+
+    QByteArrayView line_;
+    DensCommand::CommandType type_;
+    DensCommand::CommandCategory category_;
+    QByteArrayView action_;
+    std::array<QByteArrayView, MaxFields> args_;
+    qsizetype argCount_;
+    bool truncated_;
+};
+
+#endif // DENSCOMMANDVIEW_H
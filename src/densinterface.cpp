@@ -1,14 +1,39 @@
 #include "densinterface.h"
 
 #include <QDebug>
+#include <QTimer>
+#include <memory>
 
 #include "denscommand.h"
+#include "denscommandview.h"
+#include "denstransport.h"
+#include "sessioncapture.h"
+#include "stmcrc32.h"
+#include "logarchive.h"
+#include "metrics.h"
+#include "trace.h"
 #include "util.h"
 
+namespace
+{
+static const int DEFAULT_PIPELINE_DEPTH = 4;
+static const int DEFAULT_COMMAND_TIMEOUT = 5000;
+
+/* Timeout for commands that run a sensor cycle before responding */
+static const int LONG_COMMAND_TIMEOUT = 30000;
+}
+
 DensInterface::DensInterface(QObject *parent)
     : QObject(parent)
-    , serialPort_(nullptr)
+    , transport_(nullptr)
     , multilinePending_(false)
+    , commandTimer_(new QTimer(this))
+    , nextTicket_(1)
+    , pipelineDepth_(DEFAULT_PIPELINE_DEPTH)
+    , commandTimeout_(DEFAULT_COMMAND_TIMEOUT)
+    , commandRetries_(0)
+    , snapshotSupport_(SnapshotUnknown)
+    , snapshotBatching_(false)
     , connecting_(false)
     , connected_(false)
     , deviceUnrecognized_(false)
@@ -20,6 +45,8 @@ DensInterface::DensInterface(QObject *parent)
     , freeRtosTaskCount_(0)
     , diagLightMax_(128)
 {
+    commandTimer_->setSingleShot(true);
+    connect(commandTimer_, &QTimer::timeout, this, &DensInterface::onCommandTimeout);
 }
 
 DensInterface::DeviceType DensInterface::portDeviceType(const QSerialPortInfo &info)
@@ -33,10 +60,10 @@ DensInterface::DeviceType DensInterface::portDeviceType(const QSerialPortInfo &i
     }
 }
 
-bool DensInterface::connectToDevice(QSerialPort *serialPort, DeviceType deviceType)
+bool DensInterface::connectToDevice(DensTransport *transport, DeviceType deviceType)
 {
-    if (serialPort_) { return false; }
-    if (!serialPort || !serialPort->isOpen()) {
+    if (transport_) { return false; }
+    if (!transport || !transport->isOpen()) {
         return false;
     }
     if (connected_ || connecting_) {
@@ -47,92 +74,343 @@ bool DensInterface::connectToDevice(QSerialPort *serialPort, DeviceType deviceTy
     connecting_ = true;
     deviceUnrecognized_ = false;
     remoteControlEnabled_ = false;
+    snapshotSupport_ = SnapshotUnknown;
 
     // Connect to signals for non-blocking command use
-    if (serialPort->parent() == nullptr) {
-        serialPort->setParent(this);
+    const bool adopted = transport->parent() == nullptr;
+    if (adopted) {
+        transport->setParent(this);
     }
-    serialPort_ = serialPort;
+    transport_ = transport;
     deviceType_ = deviceType;
-    connect(serialPort_, &QSerialPort::errorOccurred, this, &DensInterface::handleError);
-    connect(serialPort_, &QSerialPort::readyRead, this, &DensInterface::readData);
+    framer_.clear();
+    connect(transport_, &DensTransport::errorOccurred, this, &DensInterface::handleError);
+    connect(transport_, &DensTransport::readyRead, this, &DensInterface::readData);
+
+    if (SessionRecorder::isActive()) {
+        SessionRecorder::record(SessionEvent::TypeDensConnect, QByteArray(1, static_cast<char>(deviceType)));
+    }
 
     // Send command to get system version, to verify connected device
     DensCommand command(DensCommand::TypeGet, DensCommand::CategorySystem, "V");
-    return sendCommand(command);
+    if (!writeCommand(command)) {
+        // Hand the transport back untouched, since the caller still owns it
+        disconnect(transport_, &DensTransport::errorOccurred, this, &DensInterface::handleError);
+        disconnect(transport_, &DensTransport::readyRead, this, &DensInterface::readData);
+        if (adopted) {
+            transport_->setParent(nullptr);
+        }
+        transport_ = nullptr;
+        deviceType_ = DeviceType::DeviceUnknown;
+        connecting_ = false;
+        return false;
+    }
+    return true;
 }
 
 void DensInterface::disconnectFromDevice()
 {
     bool notify = connected_ || connecting_;
-    if (serialPort_) {
-        disconnect(serialPort_, &QSerialPort::errorOccurred, this, &DensInterface::handleError);
-        disconnect(serialPort_, &QSerialPort::readyRead, this, &DensInterface::readData);
-        if (serialPort_->parent() == this) {
-            if (serialPort_->isOpen()) {
-                serialPort_->close();
+    if (transport_) {
+        disconnect(transport_, &DensTransport::errorOccurred, this, &DensInterface::handleError);
+        disconnect(transport_, &DensTransport::readyRead, this, &DensInterface::readData);
+        if (transport_->parent() == this) {
+            if (transport_->isOpen()) {
+                transport_->close();
             }
-			serialPort_->deleteLater();
+			transport_->deleteLater();
         }
-		serialPort_ = nullptr;
+		transport_ = nullptr;
     }
+    framer_.clear();
     multilineResponse_ = DensCommand();
-    multilineBuffer_.clear();
     multilinePending_ = false;
     connecting_ = false;
     connected_ = false;
     remoteControlEnabled_ = false;
+    abortCommands();
     if (notify) {
         emit connectionClosed();
     }
 }
 
-void DensInterface::sendGetSystemVersion()
+int DensInterface::pipelineDepth() const { return pipelineDepth_; }
+
+void DensInterface::setPipelineDepth(int depth)
+{
+    pipelineDepth_ = qMax(1, depth);
+    dispatchCommands();
+}
+
+int DensInterface::commandTimeout() const { return commandTimeout_; }
+
+void DensInterface::setCommandTimeout(int msec)
+{
+    commandTimeout_ = qMax(0, msec);
+}
+
+int DensInterface::commandRetries() const { return commandRetries_; }
+
+/**
+ * Timeout for a command queued without an explicit one. Sensor reads,
+ * measurements, and gain calibration only respond once the sensor has
+ * finished, which can take far longer than anything else.
+ */
+int DensInterface::defaultTimeout(const DensCommand &command) const
+{
+    if (commandTimeout_ <= 0) { return commandTimeout_; }
+
+    if (command.type() == DensCommand::TypeInvoke
+            && ((command.category() == DensCommand::CategoryDiagnostics
+                 && (command.action() == QLatin1String("READ") || command.action() == QLatin1String("MEAS")))
+                || (command.category() == DensCommand::CategoryCalibration
+                    && command.action() == QLatin1String("GAIN")))) {
+        return qMax(commandTimeout_, LONG_COMMAND_TIMEOUT);
+    }
+    return commandTimeout_;
+}
+
+void DensInterface::setCommandRetries(int retries)
+{
+    commandRetries_ = qMax(0, retries);
+}
+
+/**
+ * Queue a command for sending to the device.
+ *
+ * Commands are written once there is room in the pipeline, and are
+ * completed by the first response that matches them. Requesting a value
+ * that is already queued or in flight shares the existing ticket, rather
+ * than sending a duplicate command.
+ *
+ * @param command Command to send
+ * @param timeout Response timeout in milliseconds, 0 for none, or -1 for the default
+ * @param retries Number of times to resend on timeout, or -1 for the default
+ * @return Ticket for the command, or 0 if it could not be queued
+ */
+quint32 DensInterface::queueCommand(const DensCommand &command, int timeout, int retries)
+{
+    if (!transport_ || !transport_->isOpen() || !command.isValid()) {
+        return 0;
+    }
+
+    if (command.type() == DensCommand::TypeGet) {
+        const QString commandStr = command.toString();
+        for (const PendingCommand &pending : std::as_const(inflightCommands_)) {
+            if (pending.command.toString() == commandStr) { return pending.ticket; }
+        }
+        for (const PendingCommand &pending : std::as_const(queuedCommands_)) {
+            if (pending.command.toString() == commandStr) { return pending.ticket; }
+        }
+    }
+
+    PendingCommand pending;
+    pending.ticket = nextTicket_++;
+    if (nextTicket_ == 0) { nextTicket_ = 1; }
+    pending.command = command;
+    pending.timeout = timeout < 0 ? defaultTimeout(command) : timeout;
+    pending.retries = retries < 0 ? commandRetries_ : retries;
+    pending.attempts = 0;
+    queuedCommands_.append(pending);
+
+    dispatchCommands();
+    return pending.ticket;
+}
+
+/**
+ * Register a handler to be called when the command for a ticket finishes.
+ *
+ * The handler is called exactly once, after the response has been parsed
+ * and the normal response signals have been emitted. If a context object
+ * is provided, and it is destroyed first, the handler is not called.
+ *
+ * @return False if the ticket is not currently pending
+ */
+bool DensInterface::addResponseHandler(quint32 ticket, const QObject *context, const ResponseHandler &handler)
+{
+    if (ticket == 0 || !handler) { return false; }
+
+    ResponseCallback callback;
+    callback.context = context;
+    callback.hasContext = context != nullptr;
+    callback.handler = handler;
+
+    for (PendingCommand &pending : inflightCommands_) {
+        if (pending.ticket == ticket) {
+            pending.callbacks.append(callback);
+            return true;
+        }
+    }
+    for (PendingCommand &pending : queuedCommands_) {
+        if (pending.ticket == ticket) {
+            pending.callbacks.append(callback);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Start collecting calibration table writes into a single snapshot.
+ *
+ * Until commitCalSnapshot() is called, the sendSetCal*() functions
+ * record their tables instead of sending them, and return 0.
+ */
+void DensInterface::beginCalSnapshot()
+{
+    snapshotBatching_ = true;
+    snapshotTables_.clear();
+}
+
+/**
+ * Send all calibration tables collected since beginCalSnapshot().
+ *
+ * The tables are written as one multiline block, with a trailing CRC
+ * of all the values, and are acknowledged by the device as a whole.
+ * If the device does not support snapshots, each table is sent on its
+ * own instead. Either way, calSnapshotSetComplete() is emitted once all
+ * tables have been written.
+ */
+void DensInterface::commitCalSnapshot()
+{
+    snapshotBatching_ = false;
+    const QList<DensCommand> tables = snapshotTables_;
+    snapshotTables_.clear();
+
+    if (tables.isEmpty()) { return; }
+
+    if (snapshotSupport_ == SnapshotSupported) {
+        writeCalSnapshot(tables);
+    } else if (snapshotSupport_ == SnapshotUnsupported) {
+        sendCalTables(tables);
+    } else {
+        // Older firmware would try to interpret each line of the block
+        // as a separate command, so probe for snapshot support with a
+        // harmless read before sending one.
+        DensCommand probe(DensCommand::TypeGet, DensCommand::CategoryCalibration, "SNAP");
+        const quint32 ticket = queueCommand(probe);
+        if (ticket == 0) {
+            emit calSnapshotError();
+            return;
+        }
+
+        addResponseHandler(ticket, this, [this, tables](CommandResult result, const DensCommand &) {
+            if (result == ResultOk) {
+                snapshotSupport_ = SnapshotSupported;
+                writeCalSnapshot(tables);
+            } else if (result == ResultError || result == ResultTimeout) {
+                // A probe that goes unanswered would only time out again,
+                // so do not try it again for the rest of the connection
+                qDebug() << "Calibration snapshot not supported, writing each table";
+                snapshotSupport_ = SnapshotUnsupported;
+                sendCalTables(tables);
+            } else {
+                emit calSnapshotError();
+            }
+        });
+    }
+}
+
+void DensInterface::writeCalSnapshot(const QList<DensCommand> &tables)
+{
+    // Each table is written as its name followed by the same values
+    // as its individual set command, packed into a single hex string
+    QByteArray block;
+    StmCrc32 crc;
+    for (const DensCommand &table : tables) {
+        const QByteArray packed = table.args().join(QString()).toLatin1();
+        for (qsizetype i = 0; i + 8 <= packed.size(); i += 8) {
+            uint8_t bytes[4];
+            util::decode_hex(QByteArrayView(packed).sliced(i, 8), bytes);
+            const uint32_t word = util::copy_to_u32(bytes);
+            crc.addWords(&word, 1);
+        }
+
+        block.append(table.action().toLatin1());
+        block.append(',');
+        block.append(packed);
+        block.append("\r\n");
+    }
+
+    block.append("CRC,");
+    block.append(QByteArray::number(crc.result(), 16).rightJustified(8, '0').toUpper());
+    block.append("\r\n");
+
+    QStringList args;
+    args.append("[[");
+
+    DensCommand command(DensCommand::TypeSet, DensCommand::CategoryCalibration, "SNAP", args);
+    command.setBuffer(block);
+
+    const quint32 ticket = queueCommand(command);
+    if (ticket == 0) {
+        emit calSnapshotError();
+        return;
+    }
+
+    addResponseHandler(ticket, this, [this, tables](CommandResult result, const DensCommand &response) {
+        if (result == ResultOk && isResponseSetOk(response, QLatin1String("SNAP"))) {
+            // Report each table as if it had been set individually
+            for (const DensCommand &table : tables) {
+                QStringList okArgs;
+                okArgs.append("OK");
+                readCalibrationResponse(DensCommand(DensCommand::TypeSet, DensCommand::CategoryCalibration,
+                                                    table.action(), okArgs));
+            }
+            emit calSnapshotSetComplete();
+        } else {
+            qWarning() << "Calibration snapshot write failed:" << response.toString();
+            emit calSnapshotError();
+        }
+    });
+}
+
+quint32 DensInterface::sendGetSystemVersion()
 {
     DensCommand command(DensCommand::TypeGet, DensCommand::CategorySystem, "V");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendGetSystemBuild()
+quint32 DensInterface::sendGetSystemBuild()
 {
     DensCommand command(DensCommand::TypeGet, DensCommand::CategorySystem, "B");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendGetSystemDeviceInfo()
+quint32 DensInterface::sendGetSystemDeviceInfo()
 {
     DensCommand command(DensCommand::TypeGet, DensCommand::CategorySystem, "DEV");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendGetSystemRtosInfo()
+quint32 DensInterface::sendGetSystemRtosInfo()
 {
     DensCommand command(DensCommand::TypeGet, DensCommand::CategorySystem, "RTOS");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendGetSystemUID()
+quint32 DensInterface::sendGetSystemUID()
 {
     DensCommand command(DensCommand::TypeGet, DensCommand::CategorySystem, "UID");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendGetSystemInternalSensors()
+quint32 DensInterface::sendGetSystemInternalSensors()
 {
     DensCommand command(DensCommand::TypeGet, DensCommand::CategorySystem, "ISEN");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendInvokeSystemRemoteControl(bool enabled)
+quint32 DensInterface::sendInvokeSystemRemoteControl(bool enabled)
 {
     QStringList args;
     args.append(enabled ? "1" : "0");
 
     DensCommand command(DensCommand::TypeInvoke, DensCommand::CategorySystem, "REMOTE", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetSystemDisplayText(const QString &text)
+quint32 DensInterface::sendSetSystemDisplayText(const QString &text)
 {
     QString sendText = text;
     sendText.replace(QChar('\\'), QLatin1String("\\\\"));
@@ -146,21 +424,21 @@ void DensInterface::sendSetSystemDisplayText(const QString &text)
     args.append(sendText);
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategorySystem, "DISP", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetSystemDisplayEnable(bool enabled)
+quint32 DensInterface::sendSetSystemDisplayEnable(bool enabled)
 {
-    if (deviceType_ != DeviceType::DeviceUvVis) { return; }
+    if (deviceType_ != DeviceType::DeviceUvVis) { return 0; }
 
     QStringList args;
     args.append(enabled ? "1" : "0");
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategorySystem, "DISP", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetMeasurementFormat(DensInterface::DensityFormat format)
+quint32 DensInterface::sendSetMeasurementFormat(DensInterface::DensityFormat format)
 {
     QStringList args;
     if (format == FormatBasic) {
@@ -169,14 +447,14 @@ void DensInterface::sendSetMeasurementFormat(DensInterface::DensityFormat format
         args.append("EXT");
     } else {
         qWarning() << "Unsupported format:" << format;
-        return;
+        return 0;
     }
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryMeasurement, "FORMAT", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetAllowUncalibratedMeasurements(bool allow)
+quint32 DensInterface::sendSetAllowUncalibratedMeasurements(bool allow)
 {
     QStringList args;
     if (allow) {
@@ -186,24 +464,24 @@ void DensInterface::sendSetAllowUncalibratedMeasurements(bool allow)
     }
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryMeasurement, "UNCAL", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendGetDiagDisplayScreenshot()
+quint32 DensInterface::sendGetDiagDisplayScreenshot()
 {
     DensCommand command(DensCommand::TypeGet, DensCommand::CategoryDiagnostics, "DISP");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendGetDiagLightMax()
+quint32 DensInterface::sendGetDiagLightMax()
 {
-    if (deviceType_ != DeviceType::DeviceUvVis) { return; }
+    if (deviceType_ != DeviceType::DeviceUvVis) { return 0; }
 
     DensCommand command(DensCommand::TypeGet, DensCommand::CategoryDiagnostics, "LMAX");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetDiagLightRefl(int value)
+quint32 DensInterface::sendSetDiagLightRefl(int value)
 {
     if (value < 0) { value = 0; }
     else if (value > std::numeric_limits<uint16_t>::max()) { value = std::numeric_limits<uint16_t>::max(); }
@@ -212,10 +490,10 @@ void DensInterface::sendSetDiagLightRefl(int value)
     args.append(QString::number(value));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryDiagnostics, "LR", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetDiagLightTran(int value)
+quint32 DensInterface::sendSetDiagLightTran(int value)
 {
     if (value < 0) { value = 0; }
     else if (value > std::numeric_limits<uint16_t>::max()) { value = std::numeric_limits<uint16_t>::max(); }
@@ -224,12 +502,12 @@ void DensInterface::sendSetDiagLightTran(int value)
     args.append(QString::number(value));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryDiagnostics, "LT", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetDiagLightTranUv(int value)
+quint32 DensInterface::sendSetDiagLightTranUv(int value)
 {
-    if (deviceType_ != DeviceType::DeviceUvVis) { return; }
+    if (deviceType_ != DeviceType::DeviceUvVis) { return 0; }
 
     if (value < 0) { value = 0; }
     else if (value > std::numeric_limits<uint16_t>::max()) { value = std::numeric_limits<uint16_t>::max(); }
@@ -238,26 +516,26 @@ void DensInterface::sendSetDiagLightTranUv(int value)
     args.append(QString::number(value));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryDiagnostics, "LTU", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendInvokeDiagSensorStart()
+quint32 DensInterface::sendInvokeDiagSensorStart()
 {
     DensCommand command(DensCommand::TypeInvoke, DensCommand::CategoryDiagnostics, "S",
                         QStringList() << "START");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendInvokeDiagSensorStop()
+quint32 DensInterface::sendInvokeDiagSensorStop()
 {
     DensCommand command(DensCommand::TypeInvoke, DensCommand::CategoryDiagnostics, "S",
                         QStringList() << "STOP");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetUvDiagSensorMode(int mode)
+quint32 DensInterface::sendSetUvDiagSensorMode(int mode)
 {
-    if (deviceType_ != DeviceType::DeviceUvVis) { return; }
+    if (deviceType_ != DeviceType::DeviceUvVis) { return 0; }
     if (mode < 0) { mode = 0; }
     else if (mode > 2) { mode = 2; }
 
@@ -266,12 +544,12 @@ void DensInterface::sendSetUvDiagSensorMode(int mode)
     args.append(QString::number(mode));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryDiagnostics, "S", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetBaselineDiagSensorConfig(int gain, int integration)
+quint32 DensInterface::sendSetBaselineDiagSensorConfig(int gain, int integration)
 {
-    if (deviceType_ != DeviceBaseline) { return; }
+    if (deviceType_ != DeviceBaseline) { return 0; }
 
     if (gain < 0) { gain = 0; }
     else if (gain > 3) { gain = 3; }
@@ -284,12 +562,12 @@ void DensInterface::sendSetBaselineDiagSensorConfig(int gain, int integration)
     args.append(QString::number(integration));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryDiagnostics, "S", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetUvDiagSensorConfig(int gain, int sampleTime, int sampleCount)
+quint32 DensInterface::sendSetUvDiagSensorConfig(int gain, int sampleTime, int sampleCount)
 {
-    if (deviceType_ != DeviceUvVis) { return; }
+    if (deviceType_ != DeviceUvVis) { return 0; }
 
     if (gain < 0) { gain = 0; }
     else if (gain > 9) { gain = 9; }
@@ -305,36 +583,36 @@ void DensInterface::sendSetUvDiagSensorConfig(int gain, int sampleTime, int samp
     args.append(QString::number(sampleCount));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryDiagnostics, "S", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
 
-void DensInterface::sendSetUvDiagSensorAgcEnable(int sampleCount)
+quint32 DensInterface::sendSetUvDiagSensorAgcEnable(int sampleCount)
 {
-    if (deviceType_ != DeviceUvVis) { return; }
+    if (deviceType_ != DeviceUvVis) { return 0; }
 
     QStringList args;
     args.append("AGCEN");
     args.append(QString::number(sampleCount));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryDiagnostics, "S", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetUvDiagSensorAgcDisable()
+quint32 DensInterface::sendSetUvDiagSensorAgcDisable()
 {
-    if (deviceType_ != DeviceUvVis) { return; }
+    if (deviceType_ != DeviceUvVis) { return 0; }
 
     QStringList args;
     args.append("AGCDIS");
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryDiagnostics, "S", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendInvokeBaselineDiagRead(DensInterface::SensorLight light, int gain, int integration)
+quint32 DensInterface::sendInvokeBaselineDiagRead(DensInterface::SensorLight light, int gain, int integration)
 {
-    if (deviceType_ != DeviceBaseline) { return; }
+    if (deviceType_ != DeviceBaseline) { return 0; }
 
     QStringList args;
     if (light == SensorLight::SensorLightReflection) {
@@ -348,12 +626,12 @@ void DensInterface::sendInvokeBaselineDiagRead(DensInterface::SensorLight light,
     args.append(QString::number(integration));
 
     DensCommand command(DensCommand::TypeInvoke, DensCommand::CategoryDiagnostics, "READ", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendInvokeUvDiagRead(DensInterface::SensorLight light, int lightValue, int mode, int gain, int sampleTime, int sampleCount)
+quint32 DensInterface::sendInvokeUvDiagRead(DensInterface::SensorLight light, int lightValue, int mode, int gain, int sampleTime, int sampleCount)
 {
-    if (deviceType_ != DeviceUvVis) { return; }
+    if (deviceType_ != DeviceUvVis) { return 0; }
 
     QStringList args;
     if (light == SensorLight::SensorLightReflection) {
@@ -376,12 +654,12 @@ void DensInterface::sendInvokeUvDiagRead(DensInterface::SensorLight light, int l
     args.append(QString::number(sampleCount));
 
     DensCommand command(DensCommand::TypeInvoke, DensCommand::CategoryDiagnostics, "READ", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendInvokeUvDiagMeasure(DensInterface::SensorLight light, int lightValue)
+quint32 DensInterface::sendInvokeUvDiagMeasure(DensInterface::SensorLight light, int lightValue)
 {
-    if (deviceType_ != DeviceUvVis) { return; }
+    if (deviceType_ != DeviceUvVis) { return 0; }
 
     QStringList args;
     if (light == SensorLight::SensorLightReflection) {
@@ -391,7 +669,7 @@ void DensInterface::sendInvokeUvDiagMeasure(DensInterface::SensorLight light, in
     } else if (light == SensorLight::SensorLightUvTransmission) {
         args.append("U");
     } else {
-        return;
+        return 0;
     }
 
     if (lightValue < 0) { lightValue = 0; }
@@ -399,54 +677,54 @@ void DensInterface::sendInvokeUvDiagMeasure(DensInterface::SensorLight light, in
     args.append(QString::number(lightValue));
 
     DensCommand command(DensCommand::TypeInvoke, DensCommand::CategoryDiagnostics, "MEAS", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetDiagLoggingModeUsb()
+quint32 DensInterface::sendSetDiagLoggingModeUsb()
 {
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryDiagnostics,
                         "LOG", QStringList() << "U");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetDiagLoggingModeDebug()
+quint32 DensInterface::sendSetDiagLoggingModeDebug()
 {
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryDiagnostics,
                         "LOG", QStringList() << "D");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendInvokeCalGain()
+quint32 DensInterface::sendInvokeCalGain()
 {
     DensCommand command(DensCommand::TypeInvoke, DensCommand::CategoryCalibration, "GAIN");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendGetCalLight()
+quint32 DensInterface::sendGetCalLight()
 {
     DensCommand command(DensCommand::TypeGet, DensCommand::CategoryCalibration, "LIGHT");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetCalLight(const DensCalLight &calLight)
+quint32 DensInterface::sendSetCalLight(const DensCalLight &calLight)
 {
     QStringList args;
     args.append(QString::number(calLight.reflectionValue()));
     args.append(QString::number(calLight.transmissionValue()));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryCalibration, "LIGHT", args);
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendGetCalGain()
+quint32 DensInterface::sendGetCalGain()
 {
     DensCommand command(DensCommand::TypeGet, DensCommand::CategoryCalibration, "GAIN");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetCalGain(const DensCalGain &calGain)
+quint32 DensInterface::sendSetCalGain(const DensCalGain &calGain)
 {
-    if (deviceType_ != DeviceBaseline) { return; }
+    if (deviceType_ != DeviceBaseline) { return 0; }
 
     QStringList args;
     args.append(util::encode_f32(calGain.med0()));
@@ -457,12 +735,12 @@ void DensInterface::sendSetCalGain(const DensCalGain &calGain)
     args.append(util::encode_f32(calGain.max1()));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryCalibration, "GAIN", args);
-    sendCommand(command);
+    return queueCalTable(command);
 }
 
-void DensInterface::sendSetUvVisCalGain(const DensUvVisCalGain &calGain)
+quint32 DensInterface::sendSetUvVisCalGain(const DensUvVisCalGain &calGain)
 {
-    if (deviceType_ != DeviceUvVis) { return; }
+    if (deviceType_ != DeviceUvVis) { return 0; }
 
     QStringList args;
     args.append(util::encode_f32(calGain.gainValue(DensUvVisCalGain::Gain0_5X)));
@@ -477,20 +755,20 @@ void DensInterface::sendSetUvVisCalGain(const DensUvVisCalGain &calGain)
     args.append(util::encode_f32(calGain.gainValue(DensUvVisCalGain::Gain256X)));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryCalibration, "GAIN", args);
-    sendCommand(command);
+    return queueCalTable(command);
 }
 
-void DensInterface::sendGetCalSlope()
+quint32 DensInterface::sendGetCalSlope()
 {
-    if (deviceType_ != DeviceBaseline) { return; }
+    if (deviceType_ != DeviceBaseline) { return 0; }
 
     DensCommand command(DensCommand::TypeGet, DensCommand::CategoryCalibration, "SLOPE");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetCalSlope(const DensCalSlope &calSlope)
+quint32 DensInterface::sendSetCalSlope(const DensCalSlope &calSlope)
 {
-    if (deviceType_ != DeviceBaseline) { return; }
+    if (deviceType_ != DeviceBaseline) { return 0; }
 
     QStringList args;
     args.append(util::encode_f32(calSlope.b0()));
@@ -498,20 +776,20 @@ void DensInterface::sendSetCalSlope(const DensCalSlope &calSlope)
     args.append(util::encode_f32(calSlope.b2()));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryCalibration, "SLOPE", args);
-    sendCommand(command);
+    return queueCalTable(command);
 }
 
-void DensInterface::sendGetCalVisTemperature()
+quint32 DensInterface::sendGetCalVisTemperature()
 {
-    if (deviceType_ != DeviceUvVis) { return; }
+    if (deviceType_ != DeviceUvVis) { return 0; }
 
     DensCommand command(DensCommand::TypeGet, DensCommand::CategoryCalibration, "VTEMP");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetCalVisTemperature(const DensCalTemperature &calTemperature)
+quint32 DensInterface::sendSetCalVisTemperature(const DensCalTemperature &calTemperature)
 {
-    if (deviceType_ != DeviceUvVis) { return; }
+    if (deviceType_ != DeviceUvVis) { return 0; }
 
     QStringList args;
     args.append(util::encode_f32(calTemperature.b0()));
@@ -519,20 +797,20 @@ void DensInterface::sendSetCalVisTemperature(const DensCalTemperature &calTemper
     args.append(util::encode_f32(calTemperature.b2()));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryCalibration, "VTEMP", args);
-    sendCommand(command);
+    return queueCalTable(command);
 }
 
-void DensInterface::sendGetCalUvTemperature()
+quint32 DensInterface::sendGetCalUvTemperature()
 {
-    if (deviceType_ != DeviceUvVis) { return; }
+    if (deviceType_ != DeviceUvVis) { return 0; }
 
     DensCommand command(DensCommand::TypeGet, DensCommand::CategoryCalibration, "UTEMP");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetCalUvTemperature(const DensCalTemperature &calTemperature)
+quint32 DensInterface::sendSetCalUvTemperature(const DensCalTemperature &calTemperature)
 {
-    if (deviceType_ != DeviceUvVis) { return; }
+    if (deviceType_ != DeviceUvVis) { return 0; }
 
     QStringList args;
     args.append(util::encode_f32(calTemperature.b0()));
@@ -540,16 +818,16 @@ void DensInterface::sendSetCalUvTemperature(const DensCalTemperature &calTempera
     args.append(util::encode_f32(calTemperature.b2()));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryCalibration, "UTEMP", args);
-    sendCommand(command);
+    return queueCalTable(command);
 }
 
-void DensInterface::sendGetCalReflection()
+quint32 DensInterface::sendGetCalReflection()
 {
     DensCommand command(DensCommand::TypeGet, DensCommand::CategoryCalibration, "REFL");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetCalReflection(const DensCalTarget &calTarget)
+quint32 DensInterface::sendSetCalReflection(const DensCalTarget &calTarget)
 {
     QStringList args;
     args.append(util::encode_f32(calTarget.loDensity()));
@@ -558,16 +836,16 @@ void DensInterface::sendSetCalReflection(const DensCalTarget &calTarget)
     args.append(util::encode_f32(calTarget.hiReading()));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryCalibration, "REFL", args);
-    sendCommand(command);
+    return queueCalTable(command);
 }
 
-void DensInterface::sendGetCalTransmission()
+quint32 DensInterface::sendGetCalTransmission()
 {
     DensCommand command(DensCommand::TypeGet, DensCommand::CategoryCalibration, "TRAN");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetCalTransmission(const DensCalTarget &calTarget)
+quint32 DensInterface::sendSetCalTransmission(const DensCalTarget &calTarget)
 {
     QStringList args;
     args.append(util::encode_f32(calTarget.loDensity()));
@@ -576,20 +854,20 @@ void DensInterface::sendSetCalTransmission(const DensCalTarget &calTarget)
     args.append(util::encode_f32(calTarget.hiReading()));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryCalibration, "TRAN", args);
-    sendCommand(command);
+    return queueCalTable(command);
 }
 
-void DensInterface::sendGetCalUvTransmission()
+quint32 DensInterface::sendGetCalUvTransmission()
 {
-    if (deviceType_ != DeviceUvVis) { return; }
+    if (deviceType_ != DeviceUvVis) { return 0; }
 
     DensCommand command(DensCommand::TypeGet, DensCommand::CategoryCalibration, "UVTR");
-    sendCommand(command);
+    return queueCommand(command);
 }
 
-void DensInterface::sendSetCalUvTransmission(const DensCalTarget &calTarget)
+quint32 DensInterface::sendSetCalUvTransmission(const DensCalTarget &calTarget)
 {
-    if (deviceType_ != DeviceUvVis) { return; }
+    if (deviceType_ != DeviceUvVis) { return 0; }
 
     QStringList args;
     args.append(util::encode_f32(calTarget.loDensity()));
@@ -598,7 +876,73 @@ void DensInterface::sendSetCalUvTransmission(const DensCalTarget &calTarget)
     args.append(util::encode_f32(calTarget.hiReading()));
 
     DensCommand command(DensCommand::TypeSet, DensCommand::CategoryCalibration, "UVTR", args);
-    sendCommand(command);
+    return queueCalTable(command);
+}
+
+/**
+ * Read the complete set of sensor and target calibration tables.
+ *
+ * The tables are requested with a single snapshot command, and the usual
+ * per-table response signals are emitted once its checksum has been
+ * verified. If the device does not support snapshots, each table is
+ * requested on its own instead. Either way, calSnapshotResponse() is
+ * emitted once all tables have been read.
+ *
+ * The handler is called once this particular request has finished, so
+ * callers are not confused by snapshots that someone else requested.
+ */
+void DensInterface::sendGetCalSnapshot(const QObject *context, const ResponseHandler &handler)
+{
+    ResponseCallback callback;
+    callback.context = context;
+    callback.hasContext = context != nullptr;
+    callback.handler = handler;
+
+    if (snapshotSupport_ == SnapshotUnsupported) {
+        sendGetCalTables(callback);
+        return;
+    }
+
+    DensCommand command(DensCommand::TypeGet, DensCommand::CategoryCalibration, "SNAP");
+    const quint32 ticket = queueCommand(command);
+    if (ticket == 0) {
+        finishCalSnapshot(callback, ResultError, DensCommand());
+        return;
+    }
+
+    addResponseHandler(ticket, this, [this, callback](CommandResult result, const DensCommand &response) {
+        if (result == ResultOk) {
+            snapshotSupport_ = SnapshotSupported;
+            if (readCalSnapshot(response.buffer())) {
+                finishCalSnapshot(callback, ResultOk, response);
+            } else {
+                qWarning() << "Calibration snapshot read failed:" << response.toString();
+                finishCalSnapshot(callback, ResultError, response);
+            }
+        } else if (result == ResultError
+                   || (result == ResultTimeout && snapshotSupport_ == SnapshotUnknown)) {
+            // A probe that goes unanswered would only time out again,
+            // so do not try it again for the rest of the connection
+            qDebug() << "Calibration snapshot not supported, reading each table";
+            snapshotSupport_ = SnapshotUnsupported;
+            sendGetCalTables(callback);
+        } else {
+            finishCalSnapshot(callback, result, response);
+        }
+    });
+}
+
+void DensInterface::finishCalSnapshot(const ResponseCallback &callback, CommandResult result, const DensCommand &response)
+{
+    if (result == ResultOk) {
+        emit calSnapshotResponse();
+    } else {
+        emit calSnapshotError();
+    }
+
+    if (callback.handler && !(callback.hasContext && !callback.context)) {
+        callback.handler(result, response);
+    }
 }
 
 bool DensInterface::connected() const { return connected_; }
@@ -643,13 +987,33 @@ DensCalTarget DensInterface::calUvTransmission() const { return calUvTransmissio
 
 void DensInterface::readData()
 {
-    while (serialPort_->canReadLine()) {
-        const QByteArray line = serialPort_->readLine();
+    TRACE_SCOPE("DensInterface::readData");
+    // Drain everything received so far straight into the framer,
+    // which then hands out each complete line as a view into it
+    static MetricCounter &bytesReceived = Metrics::counter(QStringLiteral("dens.bytes.received"));
+    static MetricCounter &linesReceived = Metrics::counter(QStringLiteral("dens.lines.received"));
+    static MetricCounter &linesUnrecognized = Metrics::counter(QStringLiteral("dens.lines.unrecognized"));
+    static MetricCounter &linesNak = Metrics::counter(QStringLiteral("dens.lines.nak"));
+
+    qint64 available;
+    while (transport_ && (available = transport_->bytesAvailable()) > 0) {
+        const qint64 size = transport_->read(framer_.prepareWrite(available), available);
+        if (size <= 0) { break; }
+        framer_.commitWrite(size);
+        bytesReceived.add(size);
+    }
+
+    QByteArrayView line;
+    while (transport_ && framer_.nextLine(&line)) {
+        linesReceived.add();
+        if (SessionRecorder::isActive()) {
+            SessionRecorder::record(SessionEvent::TypeDensRead, line.toByteArray());
+        }
         if (connecting_) {
             // In connecting mode we expect to only receive very specific
             // information from the device. Anything else will cause the
             // connection check to fail.
-            DensCommand response = DensCommand::parse(line);
+            DensCommand response = DensCommand::parse(line.toByteArray());
             if (response.isDensity()) {
                 // Density responses are the only thing the device can send
                 // without first receiving a command or mode change request.
@@ -680,6 +1044,7 @@ void DensInterface::readData()
                     }
                     emit connectionOpened();
                     emit systemVersionResponse();
+                    dispatchCommands();
                 } else {
                     // Failing to cleanly parse the version response should
                     // be treated like a connection failure
@@ -703,64 +1068,91 @@ void DensInterface::readData()
 
         if (multilinePending_) {
             if (line == "]]\r\n") {
-                multilineResponse_.setBuffer(multilineBuffer_);
-                multilineBuffer_.clear();
+                // The block was kept in the framer as it arrived,
+                // so it only needs to be copied out once
+                multilineResponse_.setBuffer(framer_.endBlock().toByteArray());
                 multilinePending_ = false;
 
-                if (multilineResponse_.isValid()) {
+                if (multilineResponse_.isValid() && discardStaleResponse(multilineResponse_)) {
+                    dispatchCommands();
+                } else if (multilineResponse_.isValid()) {
                     readCommandResponse(multilineResponse_);
+                    completeCommand(multilineResponse_, ResultOk);
                 } else {
                     qWarning() << "Unrecognized line:" << line;
+                    linesUnrecognized.add();
                 }
                 multilineResponse_ = DensCommand();
                 continue;
             } else {
-                multilineBuffer_.append(line);
                 continue;
             }
         }
 
         if (isLogLine(line)) {
-            emit diagLogLine(line);
+            const QByteArray logLine = line.toByteArray();
+            if (LogArchive::isActive()) {
+                LogArchive::appendDeviceLine(logLine);
+            }
+            emit diagLogLine(logLine);
         } else {
-            DensCommand response = DensCommand::parse(line);
-
-            if (response.args().size() == 1 && response.args().at(0) == QLatin1String("NAK")) {
-                qWarning() << "Invalid command:" << response.toString();
-            } else if (response.args().size() == 1 && response.args().at(0) == QLatin1String("[[")) {
-                multilineResponse_ = response;
-                multilineBuffer_.clear();
+            const DensCommandView response(line);
+
+            if (response.hasSingleArg("NAK")) {
+                qWarning() << "Invalid command:" << response.line();
+                linesNak.add();
+                const DensCommand command = response.toCommand();
+                if (discardStaleResponse(command)) {
+                    dispatchCommands();
+                } else {
+                    completeCommand(command, ResultError);
+                }
+            } else if (response.hasSingleArg("[[")) {
+                multilineResponse_ = response.toCommand();
+                framer_.beginBlock();
                 multilinePending_ = true;
             } else {
                 if (response.isDensity()) {
                     readDensityResponse(response);
                 } else if (response.isValid()) {
-                    readCommandResponse(response);
+                    const DensCommand command = response.toCommand();
+                    if (isProgressResponse(command)) {
+                        // The command stays in flight until its final result
+                        readCommandResponse(command);
+                        continue;
+                    }
+                    if (discardStaleResponse(command)) {
+                        dispatchCommands();
+                        continue;
+                    }
+                    readCommandResponse(command);
+                    completeCommand(command, ResultOk);
                 } else {
                     qWarning() << "Unrecognized line:" << line;
+                    linesUnrecognized.add();
                 }
             }
         }
     }
 }
 
-void DensInterface::handleError(QSerialPort::SerialPortError error)
+void DensInterface::handleError(const QString &errorString)
 {
-    qDebug() << "Serial port error:" << error;
+    qDebug() << "Transport error:" << errorString;
     emit connectionError();
 }
 
-bool DensInterface::isLogLine(const QByteArray &line)
+bool DensInterface::isLogLine(QByteArrayView line)
 {
     return line.size() > 2 && line[1] == '/'
             && (line[0] == 'A' || line[0] == 'E' || line[0] == 'W'
             || line[0] == 'I' || line[0] == 'D' || line[0] == 'V');
 }
 
-void DensInterface::readDensityResponse(const DensCommand &response)
+void DensInterface::readDensityResponse(const DensCommandView &response)
 {
-    qDebug() << "Read:" << response.toString();
-    if (!response.args().isEmpty() && response.args().at(0).endsWith(QLatin1Char('D'))) {
+    qDebug() << "Read:" << response.line();
+    if (response.argCount() > 0 && response.arg(0).endsWith('D')) {
         DensityType densityType;
         float dValue;
         float dZero = qSNaN();
@@ -777,24 +1169,22 @@ void DensInterface::readDensityResponse(const DensCommand &response)
             return;
         }
 
-        if (response.args().size() > 1) {
-            dValue = util::decode_f32(response.args().at(1));
-            if (response.args().size() > 2) {
-                dZero = util::decode_f32(response.args().at(2));
+        if (response.argCount() > 1) {
+            dValue = util::decode_f32(response.arg(1));
+            if (response.argCount() > 2) {
+                dZero = util::decode_f32(response.arg(2));
             }
-            if (response.args().size() > 3) {
-                rawValue = util::decode_f32(response.args().at(3));
+            if (response.argCount() > 3) {
+                rawValue = util::decode_f32(response.arg(3));
             }
-            if (response.args().size() > 4) {
-                corrValue = util::decode_f32(response.args().at(4));
+            if (response.argCount() > 4) {
+                corrValue = util::decode_f32(response.arg(4));
             }
         } else {
-            QString readingStr = response.args().at(0);
-            readingStr.chop(1);
             bool ok;
-            dValue = readingStr.toFloat(&ok);
+            dValue = response.arg(0).chopped(1).toFloat(&ok);
             if (!ok) {
-                qWarning() << "Bad reading value:" << response.args().at(0);
+                qWarning() << "Bad reading value:" << response.arg(0);
                 return;
             }
         }
@@ -950,26 +1340,30 @@ void DensInterface::readCalibrationResponse(const DensCommand &response)
     } else if (response.type() == DensCommand::TypeGet
                && response.action() == QLatin1String("GAIN")) {
         if (deviceType_ == DeviceBaseline && response.args().size() >= 8) {
-            calGain_.setLow0(util::decode_f32(response.args().at(0)));
-            calGain_.setLow1(util::decode_f32(response.args().at(1)));
-            calGain_.setMed0(util::decode_f32(response.args().at(2)));
-            calGain_.setMed1(util::decode_f32(response.args().at(3)));
-            calGain_.setHigh0(util::decode_f32(response.args().at(4)));
-            calGain_.setHigh1(util::decode_f32(response.args().at(5)));
-            calGain_.setMax0(util::decode_f32(response.args().at(6)));
-            calGain_.setMax1(util::decode_f32(response.args().at(7)));
+            float values[8];
+            util::decode_f32_list(response.args(), values, 8);
+            calGain_.setLow0(values[0]);
+            calGain_.setLow1(values[1]);
+            calGain_.setMed0(values[2]);
+            calGain_.setMed1(values[3]);
+            calGain_.setHigh0(values[4]);
+            calGain_.setHigh1(values[5]);
+            calGain_.setMax0(values[6]);
+            calGain_.setMax1(values[7]);
             emit calGainResponse();
         } else if (deviceType_ == DeviceUvVis && response.args().size() >= 10) {
-            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain0_5X, util::decode_f32(response.args().at(0)));
-            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain1X, util::decode_f32(response.args().at(1)));
-            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain2X, util::decode_f32(response.args().at(2)));
-            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain4X, util::decode_f32(response.args().at(3)));
-            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain8X, util::decode_f32(response.args().at(4)));
-            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain16X, util::decode_f32(response.args().at(5)));
-            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain32X, util::decode_f32(response.args().at(6)));
-            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain64X, util::decode_f32(response.args().at(7)));
-            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain128X, util::decode_f32(response.args().at(8)));
-            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain256X, util::decode_f32(response.args().at(9)));
+            float values[10];
+            util::decode_f32_list(response.args(), values, 10);
+            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain0_5X, values[0]);
+            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain1X, values[1]);
+            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain2X, values[2]);
+            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain4X, values[3]);
+            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain8X, values[4]);
+            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain16X, values[5]);
+            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain32X, values[6]);
+            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain64X, values[7]);
+            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain128X, values[8]);
+            calUvVisGain_.setGainValue(DensUvVisCalGain::Gain256X, values[9]);
             emit calGainResponse();
         } else {
             qDebug() << response.toString();
@@ -979,63 +1373,152 @@ void DensInterface::readCalibrationResponse(const DensCommand &response)
     } else if (response.type() == DensCommand::TypeGet
              && response.action() == QLatin1String("SLOPE")
              && response.args().length() >= 3) {
-        calSlope_.setB0(util::decode_f32(response.args().at(0)));
-        calSlope_.setB1(util::decode_f32(response.args().at(1)));
-        calSlope_.setB2(util::decode_f32(response.args().at(2)));
+        float values[3];
+        util::decode_f32_list(response.args(), values, 3);
+        calSlope_.setB0(values[0]);
+        calSlope_.setB1(values[1]);
+        calSlope_.setB2(values[2]);
         emit calSlopeResponse();
     } else if (isResponseSetOk(response, QLatin1String("SLOPE"))) {
         emit calSlopeSetComplete();
     } else if (response.type() == DensCommand::TypeGet
                && response.action() == QLatin1String("VTEMP")
                && response.args().length() >= 3) {
-        calVisTemperature_.setB0(util::decode_f32(response.args().at(0)));
-        calVisTemperature_.setB1(util::decode_f32(response.args().at(1)));
-        calVisTemperature_.setB2(util::decode_f32(response.args().at(2)));
+        float values[3];
+        util::decode_f32_list(response.args(), values, 3);
+        calVisTemperature_.setB0(values[0]);
+        calVisTemperature_.setB1(values[1]);
+        calVisTemperature_.setB2(values[2]);
         emit calVisTemperatureResponse();
     } else if (isResponseSetOk(response, QLatin1String("VTEMP"))) {
         emit calVisTemperatureSetComplete();
     } else if (response.type() == DensCommand::TypeGet
                && response.action() == QLatin1String("UTEMP")
                && response.args().length() >= 3) {
-        calUvTemperature_.setB0(util::decode_f32(response.args().at(0)));
-        calUvTemperature_.setB1(util::decode_f32(response.args().at(1)));
-        calUvTemperature_.setB2(util::decode_f32(response.args().at(2)));
+        float values[3];
+        util::decode_f32_list(response.args(), values, 3);
+        calUvTemperature_.setB0(values[0]);
+        calUvTemperature_.setB1(values[1]);
+        calUvTemperature_.setB2(values[2]);
         emit calUvTemperatureResponse();
     } else if (isResponseSetOk(response, QLatin1String("UTEMP"))) {
         emit calUvTemperatureSetComplete();
     } else if (response.type() == DensCommand::TypeGet
                && response.action() == QLatin1String("REFL")
                && response.args().length() == 4) {
-        calReflection_.setLoDensity(util::decode_f32(response.args().at(0)));
-        calReflection_.setLoReading(util::decode_f32(response.args().at(1)));
-        calReflection_.setHiDensity(util::decode_f32(response.args().at(2)));
-        calReflection_.setHiReading(util::decode_f32(response.args().at(3)));
+        float values[4];
+        util::decode_f32_list(response.args(), values, 4);
+        calReflection_.setLoDensity(values[0]);
+        calReflection_.setLoReading(values[1]);
+        calReflection_.setHiDensity(values[2]);
+        calReflection_.setHiReading(values[3]);
         emit calReflectionResponse();
     } else if (isResponseSetOk(response, QLatin1String("REFL"))) {
         emit calReflectionSetComplete();
     } else if (response.type() == DensCommand::TypeGet
                && response.action() == QLatin1String("TRAN")
                && response.args().length() == 4) {
-        calTransmission_.setLoDensity(util::decode_f32(response.args().at(0)));
-        calTransmission_.setLoReading(util::decode_f32(response.args().at(1)));
-        calTransmission_.setHiDensity(util::decode_f32(response.args().at(2)));
-        calTransmission_.setHiReading(util::decode_f32(response.args().at(3)));
+        float values[4];
+        util::decode_f32_list(response.args(), values, 4);
+        calTransmission_.setLoDensity(values[0]);
+        calTransmission_.setLoReading(values[1]);
+        calTransmission_.setHiDensity(values[2]);
+        calTransmission_.setHiReading(values[3]);
         emit calTransmissionResponse();
     } else if (isResponseSetOk(response, QLatin1String("TRAN"))) {
         emit calTransmissionSetComplete();
     } else if (response.type() == DensCommand::TypeGet
                && response.action() == QLatin1String("UVTR")
                && response.args().length() == 4) {
-        calUvTransmission_.setLoDensity(util::decode_f32(response.args().at(0)));
-        calUvTransmission_.setLoReading(util::decode_f32(response.args().at(1)));
-        calUvTransmission_.setHiDensity(util::decode_f32(response.args().at(2)));
-        calUvTransmission_.setHiReading(util::decode_f32(response.args().at(3)));
+        float values[4];
+        util::decode_f32_list(response.args(), values, 4);
+        calUvTransmission_.setLoDensity(values[0]);
+        calUvTransmission_.setLoReading(values[1]);
+        calUvTransmission_.setHiDensity(values[2]);
+        calUvTransmission_.setHiReading(values[3]);
         emit calUvTransmissionResponse();
     } else if (isResponseSetOk(response, QLatin1String("UVTR"))) {
         emit calUvTransmissionSetComplete();
     }
 }
 
+/**
+ * Parse a calibration snapshot block, and emit the per-table response
+ * signals if its checksum matches.
+ */
+bool DensInterface::readCalSnapshot(const QByteArray &buffer)
+{
+    QList<DensCommand> tables;
+    StmCrc32 crc;
+    uint32_t expectedCrc = 0;
+    bool hasCrc = false;
+
+    const QByteArrayView data(buffer);
+    qsizetype start = 0;
+    while (start < data.size()) {
+        qsizetype end = data.indexOf('\n', start);
+        if (end < 0) { end = data.size(); }
+        const QByteArrayView line = data.sliced(start, end - start).trimmed();
+        start = end + 1;
+        if (line.isEmpty()) { continue; }
+
+        const qsizetype sep = line.indexOf(',');
+        const QByteArrayView tag = sep > 0 ? line.first(sep) : line;
+        const QByteArrayView packed = sep > 0 ? line.sliced(sep + 1) : QByteArrayView();
+
+        if (tag == "CRC") {
+            expectedCrc = packed.toUInt(&hasCrc, 16);
+            continue;
+        }
+
+        if (sep <= 0 || packed.isEmpty() || packed.size() % 8 != 0) {
+            qWarning() << "Invalid calibration snapshot line:" << line;
+            return false;
+        }
+
+        // Unpack the table into the same form as its individual response
+        QStringList args;
+        args.reserve(packed.size() / 8);
+        for (qsizetype i = 0; i < packed.size(); i += 8) {
+            const QByteArrayView digits = packed.sliced(i, 8);
+            uint8_t bytes[4];
+            if (util::decode_hex(digits, bytes) != 4) {
+                qWarning() << "Invalid calibration snapshot line:" << line;
+                return false;
+            }
+            const uint32_t word = util::copy_to_u32(bytes);
+            crc.addWords(&word, 1);
+            args.append(QString::fromLatin1(digits));
+        }
+        tables.append(DensCommand(DensCommand::TypeGet, DensCommand::CategoryCalibration,
+                                  QString::fromLatin1(tag), args));
+    }
+
+    if (!hasCrc || crc.result() != expectedCrc) {
+        qWarning() << "Calibration snapshot checksum mismatch";
+        return false;
+    }
+
+    for (const DensCommand &table : std::as_const(tables)) {
+        readCalibrationResponse(table);
+    }
+    return true;
+}
+
+/**
+ * Check for an intermediate status report from a long-running command,
+ * such as the progress of gain calibration, which comes ahead of the
+ * response that actually finishes the command.
+ */
+bool DensInterface::isProgressResponse(const DensCommand &response)
+{
+    return response.type() == DensCommand::TypeInvoke
+            && response.category() == DensCommand::CategoryCalibration
+            && response.action() == QLatin1String("GAIN")
+            && !response.args().isEmpty()
+            && response.args().at(0) == QLatin1String("STATUS");
+}
+
 bool DensInterface::isResponseSetOk(const DensCommand &response, QLatin1String action)
 {
     if (response.type() == DensCommand::TypeSet
@@ -1134,13 +1617,293 @@ void DensInterface::readDiagnosticsResponse(const DensCommand &response)
     }
 }
 
-bool DensInterface::sendCommand(const DensCommand &command)
+bool DensInterface::writeCommand(const DensCommand &command)
 {
-    if (!serialPort_ || !serialPort_->isOpen() || !command.isValid()) {
+    TRACE_SCOPE("DensInterface::writeCommand");
+    if (!transport_ || !transport_->isOpen() || !command.isValid()) {
         return false;
     }
 
     QByteArray commandBytes = command.toString().toLatin1();
     commandBytes.append("\r\n");
-    return serialPort_->write(commandBytes) != -1;
+    if (!command.buffer().isEmpty()) {
+        commandBytes.append(command.buffer());
+        commandBytes.append("]]\r\n");
+    }
+    if (SessionRecorder::isActive()) {
+        SessionRecorder::record(SessionEvent::TypeDensWrite, commandBytes);
+    }
+    if (transport_->write(commandBytes) == -1) {
+        return false;
+    }
+
+    static MetricCounter &commandsSent = Metrics::counter(QStringLiteral("dens.commands.sent"));
+    static MetricCounter &bytesSent = Metrics::counter(QStringLiteral("dens.bytes.sent"));
+    commandsSent.add();
+    bytesSent.add(commandBytes.size());
+    return true;
+}
+
+void DensInterface::dispatchCommands()
+{
+    TRACE_SCOPE("DensInterface::dispatchCommands");
+    if (!connected_) { return; }
+
+    while (!queuedCommands_.isEmpty() && inflightCommands_.size() < pipelineDepth_) {
+        // Responses are only correlated by type, category, and action,
+        // so hold back any command that would be ambiguous with one
+        // that is already in flight, or with a late reply still owed
+        // to an abandoned attempt.
+        const PendingCommand &next = queuedCommands_.first();
+        bool ambiguous = isStaleMatch(next.command);
+        for (const PendingCommand &pending : std::as_const(inflightCommands_)) {
+            if (ambiguous) { break; }
+            ambiguous = pending.command.isMatch(next.command);
+        }
+        if (ambiguous) { break; }
+
+        PendingCommand pending = queuedCommands_.takeFirst();
+        if (!writeCommand(pending.command)) {
+            finishCommand(pending, ResultError, DensCommand());
+            continue;
+        }
+        pending.attempts = 1;
+        pending.deadline = pending.timeout > 0
+            ? QDeadlineTimer(pending.timeout) : QDeadlineTimer(QDeadlineTimer::Forever);
+        pending.sentTimer.start();
+        inflightCommands_.append(pending);
+    }
+
+    updateCommandTimer();
+}
+
+void DensInterface::completeCommand(const DensCommand &response, CommandResult result)
+{
+    for (qsizetype i = 0; i < inflightCommands_.size(); i++) {
+        if (inflightCommands_[i].command.isMatch(response)) {
+            static MetricHistogram &latency = Metrics::histogram(QStringLiteral("dens.commands.latency"));
+            PendingCommand pending = inflightCommands_.takeAt(i);
+            latency.record(static_cast<quint64>(pending.sentTimer.nsecsElapsed() / 1000));
+
+            // There is no telling which attempt this reply belongs to,
+            // but any others are still owed and must not complete the
+            // next command of the same kind.
+            addStaleResponses(pending, pending.attempts - 1);
+            finishCommand(pending, result, response);
+            break;
+        }
+    }
+    dispatchCommands();
+}
+
+void DensInterface::finishCommand(PendingCommand &pending, CommandResult result, const DensCommand &response)
+{
+    static MetricCounter &timeouts = Metrics::counter(QStringLiteral("dens.commands.timeouts"));
+    static MetricCounter &errors = Metrics::counter(QStringLiteral("dens.commands.errors"));
+    if (result == ResultTimeout) {
+        qWarning() << "Command timed out:" << pending.command.toString();
+        timeouts.add();
+    } else if (result == ResultError) {
+        errors.add();
+    }
+
+    for (const ResponseCallback &callback : std::as_const(pending.callbacks)) {
+        if (callback.hasContext && !callback.context) { continue; }
+        callback.handler(result, response);
+    }
+    emit commandFinished(pending.ticket, result);
+}
+
+void DensInterface::addStaleResponses(const PendingCommand &pending, int count)
+{
+    if (count <= 0 || pending.timeout <= 0) { return; }
+
+    StaleResponse stale;
+    stale.command = pending.command;
+    stale.remaining = count;
+    stale.deadline = QDeadlineTimer(pending.timeout);
+    staleResponses_.append(stale);
+}
+
+bool DensInterface::isStaleMatch(const DensCommand &command)
+{
+    for (qsizetype i = staleResponses_.size() - 1; i >= 0; --i) {
+        if (staleResponses_[i].deadline.hasExpired()) {
+            staleResponses_.removeAt(i);
+        } else if (staleResponses_[i].command.isMatch(command)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Check a response against the replies still owed to abandoned attempts,
+ * consuming one if it matches.
+ *
+ * @return True if the response should be dropped
+ */
+bool DensInterface::discardStaleResponse(const DensCommand &response)
+{
+    if (staleResponses_.isEmpty()) { return false; }
+
+    // A command with the same signature in flight was sent after the
+    // abandoned attempts, so their replies are the ones due first.
+    for (qsizetype i = 0; i < staleResponses_.size(); i++) {
+        StaleResponse &stale = staleResponses_[i];
+        if (stale.deadline.hasExpired() || !stale.command.isMatch(response)) { continue; }
+
+        static MetricCounter &staleCount = Metrics::counter(QStringLiteral("dens.commands.stale"));
+        qDebug() << "Dropping late response:" << response.toString();
+        staleCount.add();
+        if (--stale.remaining <= 0) {
+            staleResponses_.removeAt(i);
+        }
+        return true;
+    }
+    return false;
+}
+
+void DensInterface::abortCommands()
+{
+    commandTimer_->stop();
+
+    staleResponses_.clear();
+
+    QList<PendingCommand> commands;
+    commands.swap(inflightCommands_);
+    commands.append(queuedCommands_);
+    queuedCommands_.clear();
+
+    for (PendingCommand &pending : commands) {
+        finishCommand(pending, ResultDisconnected, DensCommand());
+    }
+}
+
+void DensInterface::waitForCommands(const QList<quint32> &tickets, const std::function<void(bool)> &finished)
+{
+    struct WaitState
+    {
+        qsizetype remaining;
+        bool success;
+    };
+    if (tickets.isEmpty()) {
+        finished(true);
+        return;
+    }
+
+    auto state = std::make_shared<WaitState>(WaitState{tickets.size(), true});
+
+    auto onFinished = [state, finished](CommandResult result, const DensCommand &) {
+        if (result != ResultOk) { state->success = false; }
+        if (--state->remaining == 0) {
+            finished(state->success);
+        }
+    };
+
+    for (quint32 ticket : tickets) {
+        if (!addResponseHandler(ticket, this, onFinished)) {
+            onFinished(ResultError, DensCommand());
+        }
+    }
+}
+
+quint32 DensInterface::queueCalTable(const DensCommand &command)
+{
+    if (snapshotBatching_) {
+        snapshotTables_.append(command);
+        return 0;
+    }
+    return queueCommand(command);
+}
+
+void DensInterface::sendGetCalTables(const ResponseCallback &callback)
+{
+    QList<quint32> tickets;
+    tickets.append(sendGetCalGain());
+    tickets.append(sendGetCalReflection());
+    tickets.append(sendGetCalTransmission());
+    if (deviceType_ == DeviceBaseline) {
+        tickets.append(sendGetCalSlope());
+    } else if (deviceType_ == DeviceUvVis) {
+        tickets.append(sendGetCalUvTransmission());
+        tickets.append(sendGetCalVisTemperature());
+        tickets.append(sendGetCalUvTemperature());
+    }
+
+    waitForCommands(tickets, [this, callback](bool success) {
+        finishCalSnapshot(callback, success ? ResultOk : ResultError, DensCommand());
+    });
+}
+
+void DensInterface::sendCalTables(const QList<DensCommand> &tables)
+{
+    QList<quint32> tickets;
+    for (const DensCommand &table : tables) {
+        tickets.append(queueCommand(table));
+    }
+
+    waitForCommands(tickets, [this](bool success) {
+        if (success) {
+            emit calSnapshotSetComplete();
+        } else {
+            emit calSnapshotError();
+        }
+    });
+}
+
+void DensInterface::updateCommandTimer()
+{
+    static MetricGauge &inflight = Metrics::gauge(QStringLiteral("dens.commands.inflight"));
+    static MetricGauge &queued = Metrics::gauge(QStringLiteral("dens.commands.queued"));
+    inflight.set(inflightCommands_.size());
+    queued.set(queuedCommands_.size());
+
+    QDeadlineTimer earliest = QDeadlineTimer::Forever;
+    for (const PendingCommand &pending : std::as_const(inflightCommands_)) {
+        if (pending.deadline < earliest) {
+            earliest = pending.deadline;
+        }
+    }
+
+    // Wake up when a held back command can be sent
+    if (!queuedCommands_.isEmpty()) {
+        for (const StaleResponse &stale : std::as_const(staleResponses_)) {
+            if (stale.deadline < earliest) {
+                earliest = stale.deadline;
+            }
+        }
+    }
+    if (earliest.isForever()) {
+        commandTimer_->stop();
+    } else {
+        commandTimer_->start(static_cast<int>(qMax<qint64>(0, earliest.remainingTime())));
+    }
+}
+
+void DensInterface::onCommandTimeout()
+{
+    QList<PendingCommand> expired;
+    for (qsizetype i = inflightCommands_.size() - 1; i >= 0; --i) {
+        PendingCommand &pending = inflightCommands_[i];
+        if (!pending.deadline.hasExpired()) { continue; }
+
+        if (pending.retries > 0 && writeCommand(pending.command)) {
+            static MetricCounter &retries = Metrics::counter(QStringLiteral("dens.commands.retries"));
+            qDebug() << "Retrying command:" << pending.command.toString();
+            retries.add();
+            pending.retries--;
+            pending.attempts++;
+            pending.deadline.setRemainingTime(pending.timeout);
+        } else {
+            expired.prepend(inflightCommands_.takeAt(i));
+        }
+    }
+
+    for (PendingCommand &pending : expired) {
+        addStaleResponses(pending, pending.attempts);
+        finishCommand(pending, ResultTimeout, DensCommand());
+    }
+
+    dispatchCommands();
 }
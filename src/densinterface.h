@@ -3,11 +3,19 @@
 
 #include <stdint.h>
 #include <QObject>
-#include <QSerialPort>
 #include <QSerialPortInfo>
 #include <QDateTime>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <functional>
 #include "denscommand.h"
 #include "denscalvalues.h"
+#include "denslineframer.h"
+
+class QTimer;
+class DensCommandView;
+class DensTransport;
 
 class DensInterface : public QObject
 {
@@ -41,63 +49,92 @@ public:
     };
     Q_ENUM(SensorLight)
 
+    enum CommandResult {
+        ResultOk,
+        ResultError,
+        ResultTimeout,
+        ResultDisconnected
+    };
+    Q_ENUM(CommandResult)
+
+    typedef std::function<void(DensInterface::CommandResult result, const DensCommand &response)> ResponseHandler;
+
     explicit DensInterface(QObject *parent = nullptr);
 
     static DeviceType portDeviceType(const QSerialPortInfo &info);
 
-    bool connectToDevice(QSerialPort *serialPort, DeviceType deviceType);
+    /**
+     * Start talking to a device over an already opened transport.
+     * If the transport has no parent, the interface takes ownership of it
+     * and will close and delete it on disconnect.
+     */
+    bool connectToDevice(DensTransport *transport, DeviceType deviceType);
     void disconnectFromDevice();
 
+    int pipelineDepth() const;
+    void setPipelineDepth(int depth);
+    int commandTimeout() const;
+    void setCommandTimeout(int msec);
+    int commandRetries() const;
+    void setCommandRetries(int retries);
+
+    quint32 queueCommand(const DensCommand &command, int timeout = -1, int retries = -1);
+    bool addResponseHandler(quint32 ticket, const QObject *context, const ResponseHandler &handler);
+
+    void beginCalSnapshot();
+    void commitCalSnapshot();
+
 public slots:
-    void sendGetSystemVersion();
-    void sendGetSystemBuild();
-    void sendGetSystemDeviceInfo();
-    void sendGetSystemRtosInfo();
-    void sendGetSystemUID();
-    void sendGetSystemInternalSensors();
-    void sendInvokeSystemRemoteControl(bool enabled);
-    void sendSetSystemDisplayText(const QString &text);
-    void sendSetSystemDisplayEnable(bool enabled);
-
-    void sendSetMeasurementFormat(DensInterface::DensityFormat format);
-    void sendSetAllowUncalibratedMeasurements(bool allow);
-
-    void sendGetDiagDisplayScreenshot();
-    void sendGetDiagLightMax();
-    void sendSetDiagLightRefl(int value);
-    void sendSetDiagLightTran(int value);
-    void sendSetDiagLightTranUv(int value);
-    void sendInvokeDiagSensorStart();
-    void sendInvokeDiagSensorStop();
-    void sendSetUvDiagSensorMode(int mode);
-    void sendSetBaselineDiagSensorConfig(int gain, int integration);
-    void sendSetUvDiagSensorConfig(int gain, int sampleTime, int sampleCount);
-    void sendSetUvDiagSensorAgcEnable(int sampleCount);
-    void sendSetUvDiagSensorAgcDisable();
-    void sendInvokeBaselineDiagRead(DensInterface::SensorLight light, int gain, int integration);
-    void sendInvokeUvDiagRead(DensInterface::SensorLight light, int lightValue, int mode, int gain, int sampleTime, int sampleCount);
-    void sendInvokeUvDiagMeasure(DensInterface::SensorLight light, int lightValue);
-    void sendSetDiagLoggingModeUsb();
-    void sendSetDiagLoggingModeDebug();
-
-    void sendInvokeCalGain();
-    void sendGetCalLight();
-    void sendSetCalLight(const DensCalLight &calLight);
-    void sendGetCalGain();
-    void sendSetCalGain(const DensCalGain &calGain);
-    void sendSetUvVisCalGain(const DensUvVisCalGain &calGain);
-    void sendGetCalSlope();
-    void sendSetCalSlope(const DensCalSlope &calSlope);
-    void sendGetCalVisTemperature();
-    void sendSetCalVisTemperature(const DensCalTemperature &calTemperature);
-    void sendGetCalUvTemperature();
-    void sendSetCalUvTemperature(const DensCalTemperature &calTemperature);
-    void sendGetCalReflection();
-    void sendSetCalReflection(const DensCalTarget &calTarget);
-    void sendGetCalTransmission();
-    void sendSetCalTransmission(const DensCalTarget &calTarget);
-    void sendGetCalUvTransmission();
-    void sendSetCalUvTransmission(const DensCalTarget &calTarget);
+    quint32 sendGetSystemVersion();
+    quint32 sendGetSystemBuild();
+    quint32 sendGetSystemDeviceInfo();
+    quint32 sendGetSystemRtosInfo();
+    quint32 sendGetSystemUID();
+    quint32 sendGetSystemInternalSensors();
+    quint32 sendInvokeSystemRemoteControl(bool enabled);
+    quint32 sendSetSystemDisplayText(const QString &text);
+    quint32 sendSetSystemDisplayEnable(bool enabled);
+
+    quint32 sendSetMeasurementFormat(DensInterface::DensityFormat format);
+    quint32 sendSetAllowUncalibratedMeasurements(bool allow);
+
+    quint32 sendGetDiagDisplayScreenshot();
+    quint32 sendGetDiagLightMax();
+    quint32 sendSetDiagLightRefl(int value);
+    quint32 sendSetDiagLightTran(int value);
+    quint32 sendSetDiagLightTranUv(int value);
+    quint32 sendInvokeDiagSensorStart();
+    quint32 sendInvokeDiagSensorStop();
+    quint32 sendSetUvDiagSensorMode(int mode);
+    quint32 sendSetBaselineDiagSensorConfig(int gain, int integration);
+    quint32 sendSetUvDiagSensorConfig(int gain, int sampleTime, int sampleCount);
+    quint32 sendSetUvDiagSensorAgcEnable(int sampleCount);
+    quint32 sendSetUvDiagSensorAgcDisable();
+    quint32 sendInvokeBaselineDiagRead(DensInterface::SensorLight light, int gain, int integration);
+    quint32 sendInvokeUvDiagRead(DensInterface::SensorLight light, int lightValue, int mode, int gain, int sampleTime, int sampleCount);
+    quint32 sendInvokeUvDiagMeasure(DensInterface::SensorLight light, int lightValue);
+    quint32 sendSetDiagLoggingModeUsb();
+    quint32 sendSetDiagLoggingModeDebug();
+
+    quint32 sendInvokeCalGain();
+    quint32 sendGetCalLight();
+    quint32 sendSetCalLight(const DensCalLight &calLight);
+    quint32 sendGetCalGain();
+    quint32 sendSetCalGain(const DensCalGain &calGain);
+    quint32 sendSetUvVisCalGain(const DensUvVisCalGain &calGain);
+    quint32 sendGetCalSlope();
+    quint32 sendSetCalSlope(const DensCalSlope &calSlope);
+    quint32 sendGetCalVisTemperature();
+    quint32 sendSetCalVisTemperature(const DensCalTemperature &calTemperature);
+    quint32 sendGetCalUvTemperature();
+    quint32 sendSetCalUvTemperature(const DensCalTemperature &calTemperature);
+    quint32 sendGetCalReflection();
+    quint32 sendSetCalReflection(const DensCalTarget &calTarget);
+    quint32 sendGetCalTransmission();
+    quint32 sendSetCalTransmission(const DensCalTarget &calTarget);
+    quint32 sendGetCalUvTransmission();
+    quint32 sendSetCalUvTransmission(const DensCalTarget &calTarget);
+    void sendGetCalSnapshot(const QObject *context = nullptr, const ResponseHandler &handler = ResponseHandler());
 
 public:
     bool connected() const;
@@ -175,6 +212,8 @@ signals:
     void diagSensorInvokeMeasurementError();
     void diagLogLine(const QByteArray &data);
 
+    void commandFinished(quint32 ticket, DensInterface::CommandResult result);
+
     void calLightResponse();
     void calLightSetComplete();
     void calGainCalStatus(int status, int param);
@@ -194,27 +233,96 @@ signals:
     void calTransmissionSetComplete();
     void calUvTransmissionResponse();
     void calUvTransmissionSetComplete();
+    void calSnapshotResponse();
+    void calSnapshotSetComplete();
+    void calSnapshotError();
 
 private slots:
     void readData();
-    void handleError(QSerialPort::SerialPortError error);
+    void handleError(const QString &errorString);
+    void onCommandTimeout();
 
 private:
-    static bool isLogLine(const QByteArray &line);
-    void readDensityResponse(const DensCommand &response);
+    enum SnapshotSupport {
+        SnapshotUnknown,
+        SnapshotSupported,
+        SnapshotUnsupported
+    };
+
+    struct ResponseCallback
+    {
+        QPointer<const QObject> context;
+        bool hasContext;
+        ResponseHandler handler;
+    };
+
+    struct PendingCommand
+    {
+        quint32 ticket;
+        DensCommand command;
+        int timeout;
+        int retries;
+        int attempts;
+        QDeadlineTimer deadline;
+        QElapsedTimer sentTimer;
+        QList<ResponseCallback> callbacks;
+    };
+
+    /**
+     * Replies still owed by attempts that were abandoned, either by a
+     * retry that completed first or by the command timing out.
+     */
+    struct StaleResponse
+    {
+        DensCommand command;
+        int remaining;
+        QDeadlineTimer deadline;
+    };
+
+    static bool isLogLine(QByteArrayView line);
+    void readDensityResponse(const DensCommandView &response);
     void readCommandResponse(const DensCommand &response);
     void readSystemResponse(const DensCommand &response);
     void readMeasurementResponse(const DensCommand &response);
     void readCalibrationResponse(const DensCommand &response);
     void readDiagnosticsResponse(const DensCommand &response);
+    bool readCalSnapshot(const QByteArray &buffer);
+    static bool isProgressResponse(const DensCommand &response);
     static bool isResponseSetOk(const DensCommand &response, QLatin1String action);
 
-    bool sendCommand(const DensCommand &command);
-
-    QSerialPort *serialPort_;
+    bool writeCommand(const DensCommand &command);
+    int defaultTimeout(const DensCommand &command) const;
+    void dispatchCommands();
+    void completeCommand(const DensCommand &response, CommandResult result);
+    void finishCommand(PendingCommand &pending, CommandResult result, const DensCommand &response);
+    void addStaleResponses(const PendingCommand &pending, int count);
+    bool isStaleMatch(const DensCommand &command);
+    bool discardStaleResponse(const DensCommand &response);
+    void abortCommands();
+    void waitForCommands(const QList<quint32> &tickets, const std::function<void(bool)> &finished);
+
+    quint32 queueCalTable(const DensCommand &command);
+    void sendGetCalTables(const ResponseCallback &callback);
+    void finishCalSnapshot(const ResponseCallback &callback, CommandResult result, const DensCommand &response);
+    void writeCalSnapshot(const QList<DensCommand> &tables);
+    void sendCalTables(const QList<DensCommand> &tables);
+    void updateCommandTimer();
+
+    DensTransport *transport_;
+    DensLineFramer framer_;
     bool multilinePending_;
     DensCommand multilineResponse_;
-    QByteArray multilineBuffer_;
+    QList<PendingCommand> queuedCommands_;
+    QList<PendingCommand> inflightCommands_;
+    QList<StaleResponse> staleResponses_;
+    QTimer *commandTimer_;
+    quint32 nextTicket_;
+    int pipelineDepth_;
+    int commandTimeout_;
+    int commandRetries_;
+    SnapshotSupport snapshotSupport_;
+    bool snapshotBatching_;
+    QList<DensCommand> snapshotTables_;
     bool connecting_;
     bool connected_;
     bool deviceUnrecognized_;
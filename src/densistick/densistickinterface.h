@@ -4,11 +4,23 @@
 #include <QObject>
 #include "ft260.h"
 #include "densistickreading.h"
-
-class M24C08;
-class DensiStickSettings;
-class TSL2585;
-
+#include "densistickworker.h"
+#include "peripheralcalvalues.h"
+
+class QThread;
+
+/**
+ * GUI-side interface to the DensiStick.
+ *
+ * All device I/O is delegated to a DensiStickWorker running in its own
+ * thread. Commands are queued to the worker and return immediately,
+ * while state accessors return the most recent snapshot published by it.
+ * Only open() and close() block until the worker has finished.
+ *
+ * In streaming mode, samples are handed over through a lock-free buffer
+ * rather than as individual signals, and streamDataAvailable() is emitted
+ * whenever a new batch has been added to it.
+ */
 class DensiStickInterface : public QObject
 {
     Q_OBJECT
@@ -22,12 +34,15 @@ public:
     bool connected() const;
     bool hasSettings() const;
     bool running() const;
+    bool streaming() const;
 
     QString version() const;
     QString systemClock() const;
     QString serialNumber() const;
 
-    DensiStickSettings *settings();
+    DensiStickCalibration calibration() const;
+    void readCalibration();
+    void writeCalibration(const DensiStickCalibration &calibration);
 
     bool setLightEnable(bool enable);
     bool lightEnabled() const;
@@ -42,40 +57,31 @@ public:
     bool setSensorAgcDisable();
 
     bool sensorStart();
+    bool sensorStartStream();
     bool sensorStop();
 
+    size_t readStream(DensiStickSample *samples, size_t count);
+
 signals:
     void connectionClosed();
     void buttonEvent(bool pressed);
     void sensorReading(const DensiStickReading& reading);
+    void sensorReadings(const QList<DensiStickReading> &readings);
+    void streamDataAvailable();
+    void calibrationChanged(const DensiStickCalibration &calibration);
+    void calibrationWritten(bool success);
 
 private slots:
-    void onConnectionClosed();
-    void onSensorInterrupt();
+    void onStateChanged(const DensiStickState &state);
+    void onStreamDataAvailable();
+    void onCalibrationChanged(const DensiStickCalibration &calibration);
 
 private:
-    DensiStickReading readSensor();
-
-    bool connected_ = false;
-    Ft260 *ft260_ = nullptr;
-    M24C08 *eeprom_ = nullptr;
-    tsl2585_sensor_type_t sensorType_ = SENSOR_TYPE_UNKNOWN;
-    QString ft260Version_;
-    QString ft260SystemClock_;
-    DensiStickSettings *settings_ = nullptr;
-    TSL2585 *sensor_ = nullptr;
-    bool hasSettings_ = false;
-    Ft260GpioReport gpioReport_;
-    quint8 lightBrightness_ = 0;
-    quint8 sensorGain_ = 8;
-    quint16 sensorSampleTime_ = 719;
-    quint16 sensorSampleCount_ = 199;
-    quint16 sensorAgcCount_ = 0;
-    bool sensorAgcEnabled_ = false;
-    bool discardNextReading_ = false;
-    bool agcDisabledResetGain_ = false;
-    bool sensorRunning_ = false;
-    bool shutdown_ = false;
+    DensiStickWorker *worker_ = nullptr;
+    QThread *thread_ = nullptr;
+    DensiStickState state_;
+    DensiStickCalibration calibration_;
+    DensiStickSampleBuffer streamBuffer_;
 };
 
 #endif // DENSISTICKINTERFACE_H
@@ -7,6 +7,7 @@ public:
     DensiStickReading::Status status = DensiStickReading::ResultInvalid;
     tsl2585_gain_t gain = TSL2585_GAIN_MAX;
     uint32_t reading = 0;
+    qint64 timestamp = 0;
 };
 
 DensiStickReading::DensiStickReading()
@@ -14,12 +15,13 @@ DensiStickReading::DensiStickReading()
 {
 }
 
-DensiStickReading::DensiStickReading(DensiStickReading::Status status, tsl2585_gain_t gain, uint32_t reading)
+DensiStickReading::DensiStickReading(DensiStickReading::Status status, tsl2585_gain_t gain, uint32_t reading, qint64 timestamp)
     : data(new DensiStickReadingData)
 {
     data->status = status;
     data->gain = gain;
     data->reading = reading;
+    data->timestamp = timestamp;
 }
 
 DensiStickReading::DensiStickReading(const DensiStickReading &rhs)
@@ -53,6 +55,11 @@ uint32_t DensiStickReading::reading() const
     return data->reading;
 }
 
+qint64 DensiStickReading::timestamp() const
+{
+    return data->timestamp;
+}
+
 QDebug operator<<(QDebug debug, const DensiStickReading &reading)
 {
     QDebugStateSaver saver(debug);
@@ -19,7 +19,7 @@ public:
     };
 
     DensiStickReading();
-    DensiStickReading(DensiStickReading::Status status, tsl2585_gain_t gain, uint32_t reading);
+    DensiStickReading(DensiStickReading::Status status, tsl2585_gain_t gain, uint32_t reading, qint64 timestamp = 0);
     DensiStickReading(const DensiStickReading &);
     DensiStickReading &operator=(const DensiStickReading &);
     ~DensiStickReading();
@@ -28,10 +28,25 @@ public:
     tsl2585_gain_t gain() const;
     uint32_t reading() const;
 
+    /** Time the sample was taken, in milliseconds since the epoch */
+    qint64 timestamp() const;
+
 private:
     QSharedDataPointer<DensiStickReadingData> data;
 };
 
 QDebug operator<<(QDebug debug, const DensiStickReading &reading);
 
+/**
+ * Plain value form of a sensor reading, used where readings are streamed
+ * in bulk and the shared data of DensiStickReading would be too costly.
+ */
+struct DensiStickSample
+{
+    qint64 timestamp = 0;
+    uint32_t reading = 0;
+    tsl2585_gain_t gain = TSL2585_GAIN_MAX;
+    DensiStickReading::Status status = DensiStickReading::ResultInvalid;
+};
+
 #endif // DENSISTICKREADING_H
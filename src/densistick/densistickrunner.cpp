@@ -4,7 +4,8 @@
 #include <QTimer>
 #include <QDebug>
 
-#include "densisticksettings.h"
+#include "../metrics.h"
+#include "../trace.h"
 
 namespace
 {
@@ -14,6 +15,8 @@ static const quint16 SAMPLE_COUNT = 199;
 static const quint16 PRE_SAMPLE_COUNT = 29;
 static const quint16 AGC_SAMPLE_COUNT = 19;
 static const int READING_COUNT = 2;
+static const quint16 STREAM_AGC_SAMPLE_COUNT = 3;
+static const size_t STREAM_READ_CHUNK = 256;
 }
 
 DensiStickRunner::DensiStickRunner(DensiStickInterface *stickInterface, QObject *parent)
@@ -24,7 +27,8 @@ DensiStickRunner::DensiStickRunner(DensiStickInterface *stickInterface, QObject
     }
 
     connect(stickInterface_, &DensiStickInterface::buttonEvent, this, &DensiStickRunner::onButtonEvent);
-    connect(stickInterface_, &DensiStickInterface::sensorReading, this, &DensiStickRunner::onSensorReading);
+    connect(stickInterface_, &DensiStickInterface::sensorReadings, this, &DensiStickRunner::onSensorReadings);
+    connect(stickInterface_, &DensiStickInterface::streamDataAvailable, this, &DensiStickRunner::onStreamDataAvailable);
 }
 
 DensiStickInterface *DensiStickRunner::stickInterface()
@@ -50,26 +54,71 @@ bool DensiStickRunner::enabled() const
     return enabled_;
 }
 
+bool DensiStickRunner::startStreaming(quint16 sampleTime, quint16 sampleCount)
+{
+    if (streaming_ || measuring_ || calData_.isEmpty()) { return false; }
+
+    qDebug() << "Starting continuous measurement";
+    stickInterface_->setLightBrightness(0);
+    stickInterface_->setSensorGain(STARTING_GAIN);
+    stickInterface_->setSensorIntegration(sampleTime, sampleCount);
+    stickInterface_->setSensorAgcEnable(qMin(STREAM_AGC_SAMPLE_COUNT, sampleCount));
+    stickInterface_->setLightEnable(true);
+
+    if (!stickInterface_->sensorStartStream()) {
+        stickInterface_->setLightEnable(enabled_);
+        return false;
+    }
+
+    streamTimeMs_ = TSL2585::integrationTimeMs(sampleTime, sampleCount);
+    streaming_ = true;
+    return true;
+}
+
+void DensiStickRunner::stopStreaming()
+{
+    if (!streaming_) { return; }
+
+    streaming_ = false;
+    stickInterface_->setLightEnable(false);
+    stickInterface_->sensorStop();
+    stickInterface_->setLightBrightness(127);
+    if (enabled_) {
+        stickInterface_->setLightEnable(true);
+    }
+
+    // Deliver whatever was still waiting in the buffer
+    onStreamDataAvailable();
+    qDebug() << "Continuous measurement stopped";
+}
+
+bool DensiStickRunner::streaming() const
+{
+    return streaming_;
+}
+
 void DensiStickRunner::reloadCalibration()
 {
     if (!stickInterface_ || !stickInterface_->hasSettings()) { return; }
-    calData_ = stickInterface_->settings()->readCalibration();
+    calData_ = stickInterface_->calibration();
 }
 
 void DensiStickRunner::onButtonEvent(bool pressed)
 {
-    if (pressed && enabled_ && !measuring_ && !calData_.isEmpty()) {
+    if (pressed && enabled_ && !measuring_ && !streaming_ && !calData_.isEmpty()) {
         startMeasurement();
     }
 }
 
-void DensiStickRunner::onSensorReading(const DensiStickReading& reading)
+void DensiStickRunner::onSensorReadings(const QList<DensiStickReading> &readings)
 {
-    if (!measuring_) { return; }
+    TRACE_SCOPE("DensiStickRunner::onSensorReadings");
+    if (!measuring_ || readings.isEmpty()) { return; }
 
-    qDebug() << reading << (QDateTime::currentMSecsSinceEpoch() - measStartTime_);
+    const DensiStickReading &latest = readings.last();
+    qDebug() << latest << readings.size() << (latest.timestamp() - measStartTime_);
 
-    if (reading.status() != DensiStickReading::ResultValid) {
+    if (latest.status() != DensiStickReading::ResultValid) {
         readingList_.clear();
         return;
     }
@@ -86,16 +135,48 @@ void DensiStickRunner::onSensorReading(const DensiStickReading& reading)
         return;
     }
 
-    readingList_.append(reading);
+    // Average in every valid record from the batch, not just the latest,
+    // as long as it was taken at the same gain
+    for (const DensiStickReading &reading : readings) {
+        if (reading.status() == DensiStickReading::ResultValid && reading.gain() == latest.gain()) {
+            readingList_.append(reading);
+        }
+    }
 
     if (readingList_.size() >= READING_COUNT) {
         finishMeasurement();
     }
 }
 
+void DensiStickRunner::onStreamDataAvailable()
+{
+    DensiStickSample samples[STREAM_READ_CHUNK];
+    QList<DensiStickStreamValue> values;
+
+    size_t count;
+    while ((count = stickInterface_->readStream(samples, STREAM_READ_CHUNK)) > 0) {
+        values.reserve(values.size() + count);
+        for (size_t i = 0; i < count; i++) {
+            const DensiStickSample &sample = samples[i];
+            if (sample.status != DensiStickReading::ResultValid) { continue; }
+
+            DensiStickStreamValue value;
+            value.timestamp = sample.timestamp;
+            value.basicReading = calculateBasicReading(sample.reading, sample.gain, streamTimeMs_);
+            value.density = calculateDensity(value.basicReading);
+            values.append(value);
+        }
+    }
+
+    if (!values.isEmpty()) {
+        emit streamValues(values);
+    }
+}
+
 void DensiStickRunner::startMeasurement()
 {
     qDebug() << "Measuring target";
+    TRACE_INSTANT("DensiStickRunner::startMeasurement");
     measStartTime_ = QDateTime::currentMSecsSinceEpoch();
     stickInterface_->setLightBrightness(0);
     stickInterface_->setSensorGain(STARTING_GAIN);
@@ -111,6 +192,7 @@ void DensiStickRunner::startMeasurement()
 
 void DensiStickRunner::finishMeasurement()
 {
+    TRACE_SCOPE("DensiStickRunner::finishMeasurement");
     measuring_ = false;
     stickInterface_->setLightEnable(false);
     stickInterface_->sensorStop();
@@ -120,6 +202,9 @@ void DensiStickRunner::finishMeasurement()
     qint64 measDuration = QDateTime::currentMSecsSinceEpoch() - measStartTime_;
     qDebug() << "Measurement completed in" << measDuration << "ms";
 
+    static MetricHistogram &durations = Metrics::histogram(QStringLiteral("densistick.measurement.duration"));
+    durations.record(static_cast<quint64>(qMax<qint64>(0, measDuration)) * 1000);
+
     float sum = 0;
     size_t count = 0;
     for (const DensiStickReading& reading : std::as_const(readingList_)) {
@@ -131,32 +216,45 @@ void DensiStickRunner::finishMeasurement()
     float rawReading = sum / (float)count;
 
     const float timeMs = TSL2585::integrationTimeMs(SAMPLE_TIME, SAMPLE_COUNT);
-
-    const int gainIndex = static_cast<int>(readingList_.last().gain());
-    float gainValue = calData_.gainCalibration().gainValue(static_cast<PeripheralCalGain::GainLevel>(gainIndex));
+    const tsl2585_gain_t gain = readingList_.last().gain();
+    const float gainValue = calData_.gainCalibration().gainValue(static_cast<PeripheralCalGain::GainLevel>(gain));
     if (qIsNaN(gainValue) || gainValue <= 0.0F || gainValue > 512.0F) {
         qWarning() << "Bad gain calibration value:" << gainValue;
-        gainValue = TSL2585::gainValue(readingList_.last().gain());
     }
 
-    float alsReading = (float)rawReading / 16.0F;
-    float basicReading = alsReading / (timeMs * gainValue);
+    const float basicReading = calculateBasicReading(rawReading, gain, timeMs);
 
     qDebug() << "Reading:" << Qt::fixed << rawReading << basicReading;
     emit targetMeasurement(basicReading);
 
+    const float meas_d = calculateDensity(basicReading);
+    qDebug() << "Target density:" << Qt::fixed << meas_d;
+    emit targetDensity(meas_d);
+}
+
+float DensiStickRunner::calculateBasicReading(float rawReading, tsl2585_gain_t gain, float timeMs) const
+{
+    float gainValue = calData_.gainCalibration().gainValue(static_cast<PeripheralCalGain::GainLevel>(gain));
+    if (qIsNaN(gainValue) || gainValue <= 0.0F || gainValue > 512.0F) {
+        gainValue = TSL2585::gainValue(gain);
+    }
+
+    const float alsReading = rawReading / 16.0F;
+    return alsReading / (timeMs * gainValue);
+}
+
+float DensiStickRunner::calculateDensity(float basicReading) const
+{
     const PeripheralCalDensityTarget calTarget = calData_.targetCalibration();
 
     /* Convert all values into log units */
-    float meas_ll = std::log10(basicReading);
-    float cal_hi_ll = std::log10(calTarget.hiReading());
-    float cal_lo_ll = std::log10(calTarget.loReading());
+    const float meas_ll = std::log10(basicReading);
+    const float cal_hi_ll = std::log10(calTarget.hiReading());
+    const float cal_lo_ll = std::log10(calTarget.loReading());
 
     /* Calculate the slope of the line */
-    float m = (calTarget.hiDensity() - calTarget.loDensity()) / (cal_hi_ll - cal_lo_ll);
+    const float m = (calTarget.hiDensity() - calTarget.loDensity()) / (cal_hi_ll - cal_lo_ll);
 
     /* Calculate the measured density */
-    float meas_d = (m * (meas_ll - cal_lo_ll)) + calTarget.loDensity();
-    qDebug() << "Target density:" << Qt::fixed << meas_d;
-    emit targetDensity(meas_d);
+    return (m * (meas_ll - cal_lo_ll)) + calTarget.loDensity();
 }
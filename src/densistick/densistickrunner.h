@@ -6,10 +6,21 @@
 #include "densistickinterface.h"
 #include "peripheralcalvalues.h"
 
+struct DensiStickStreamValue
+{
+    qint64 timestamp;
+    float basicReading;
+    float density;
+};
+
 class DensiStickRunner : public QObject
 {
     Q_OBJECT
 public:
+    /* Default integration of roughly 2ms, for about 500 readings per second */
+    static const quint16 STREAM_SAMPLE_TIME = 179;
+    static const quint16 STREAM_SAMPLE_COUNT = 7;
+
     explicit DensiStickRunner(DensiStickInterface *stickInterface, QObject *parent = nullptr);
 
     DensiStickInterface *stickInterface();
@@ -17,23 +28,38 @@ public:
     void setEnabled(bool enabled);
     bool enabled() const;
 
+    /**
+     * Start continuously measuring the target, for scanning by sliding
+     * the probe across it. Results are delivered in batches through
+     * the streamValues() signal until stopStreaming() is called.
+     */
+    bool startStreaming(quint16 sampleTime = STREAM_SAMPLE_TIME, quint16 sampleCount = STREAM_SAMPLE_COUNT);
+    void stopStreaming();
+    bool streaming() const;
+
 public slots:
     void reloadCalibration();
 
 signals:
     void targetMeasurement(float basicReading);
     void targetDensity(float density);
+    void streamValues(const QList<DensiStickStreamValue> &values);
 
 private slots:
     void onButtonEvent(bool pressed);
-    void onSensorReading(const DensiStickReading& reading);
+    void onSensorReadings(const QList<DensiStickReading> &readings);
+    void onStreamDataAvailable();
 
 private:
     void startMeasurement();
     void finishMeasurement();
+    float calculateBasicReading(float rawReading, tsl2585_gain_t gain, float timeMs) const;
+    float calculateDensity(float basicReading) const;
     DensiStickInterface *stickInterface_;
     bool enabled_ = false;
     bool measuring_ = false;
+    bool streaming_ = false;
+    float streamTimeMs_ = 0;
     QList<DensiStickReading> readingList_;
     DensiStickCalibration calData_;
     qint64 measStartTime_;
@@ -138,16 +138,20 @@ bool DensiStickSettings::writeHeaderPage()
 }
 
 DensiStickCalibration DensiStickSettings::readCalibration()
+{
+    // Read the full buffer from the EEPROM
+    return parseCalibration(eeprom_->readBuffer(PAGE_CAL, PAGE_CAL_SIZE));
+}
+
+DensiStickCalibration DensiStickSettings::parseCalibration(const QByteArray &page)
 {
     uint32_t version;
     uint32_t crc;
     uint32_t calculated_crc;
 
-    // Read the full buffer from the EEPROM
-    QByteArray buf = eeprom_->readBuffer(PAGE_CAL, PAGE_CAL_SIZE);
-
-    if (buf.isEmpty()) { return DensiStickCalibration(); }
+    if (page.size() != static_cast<qsizetype>(PAGE_CAL_SIZE)) { return DensiStickCalibration(); }
 
+    QByteArray buf = page;
     uint8_t *data = reinterpret_cast<uint8_t *>(buf.data());
 
     // Get the version
@@ -203,6 +207,12 @@ DensiStickCalibration DensiStickSettings::readCalibration()
 }
 
 bool DensiStickSettings::writeCalibration(const DensiStickCalibration &calibrationData)
+{
+    // Write the buffer to the EEPROM
+    return eeprom_->writeBuffer(PAGE_CAL, encodeCalibration(calibrationData));
+}
+
+QByteArray DensiStickSettings::encodeCalibration(const DensiStickCalibration &calibrationData)
 {
     uint32_t crc;
 
@@ -242,6 +252,5 @@ bool DensiStickSettings::writeCalibration(const DensiStickCalibration &calibrati
         (CAL_TSL2585_TARGET_CRC - CAL_TSL2585_TARGET_LO_DENSITY) / 4UL);
     util::copy_from_u32(data + CAL_TSL2585_TARGET_CRC, crc);
 
-    // Write the buffer to the EEPROM
-    return eeprom_->writeBuffer(PAGE_CAL, buf);
+    return buf;
 }
@@ -26,6 +26,13 @@ public:
     bool writeHeaderPage();
 
     DensiStickCalibration readCalibration();
+
+    /** Parse the contents of the calibration page, as read from the EEPROM */
+    static DensiStickCalibration parseCalibration(const QByteArray &page);
+
+    /** Build the contents of the calibration page, as written to the EEPROM */
+    static QByteArray encodeCalibration(const DensiStickCalibration &calibrationData);
+
     bool writeCalibration(const DensiStickCalibration &calibrationData);
 
 private:
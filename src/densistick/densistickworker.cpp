@@ -0,0 +1,636 @@
+#include "densistickworker.h"
+
+#include <QDateTime>
+#include <QVarLengthArray>
+#include <QDebug>
+#include "ft260.h"
+#include "tsl2585.h"
+#include "m24c08.h"
+#include "densisticksettings.h"
+#include "densistickreading.h"
+#include "../metrics.h"
+#include "../trace.h"
+
+namespace
+{
+/* Size of each TSL2585 FIFO record, ALS data0 (4B) followed by three status bytes */
+static const uint16_t RECORD_SIZE = 7;
+
+/* Size of the TSL2585 FIFO, in bytes */
+static const uint16_t FIFO_SIZE = 512;
+
+static const uint8_t EEPROM_ADDRESS = 0x50;
+static const uint8_t MCP4017_ADDRESS = 0x2F;
+
+/* TSL2585: Only enable Photopic photodiodes on modulator 0 */
+static const photodiode_modulator_array_t sensor_tsl2585_phd_mod_vis{
+    TSL2585_MOD_NONE, TSL2585_MOD0, TSL2585_MOD_NONE, TSL2585_MOD_NONE, TSL2585_MOD_NONE, TSL2585_MOD0
+};
+
+/* TSL2522: Only enable Photopic photodiodes on modulator 0 */
+static const photodiode_modulator_array_t sensor_tsl2522_phd_mod_vis{
+    TSL2585_MOD_NONE, TSL2585_MOD0, TSL2585_MOD0, TSL2585_MOD0, TSL2585_MOD0, TSL2585_MOD_NONE
+};
+
+/* Interrupt once this many bytes of results are waiting in the FIFO while streaming */
+static const uint16_t STREAM_FIFO_THRESHOLD = 32 * 7;
+
+}
+
+DensiStickWorker::DensiStickWorker(Ft260 *ft260, QObject *parent)
+    : QObject(parent), ft260_(ft260)
+{
+    if (ft260_ && !ft260_->parent()) {
+        ft260_->setParent(this);
+    }
+    connect(ft260_, &Ft260::connectionClosed, this, &DensiStickWorker::onConnectionClosed);
+}
+
+DensiStickWorker::~DensiStickWorker()
+{
+    disconnect(ft260_, &Ft260::connectionClosed, this, &DensiStickWorker::onConnectionClosed);
+    shutdown_ = true;
+    close();
+}
+
+bool DensiStickWorker::open()
+{
+    if (!ft260_) { return false; }
+
+    if (connected_) {
+        qWarning() << "Device already open";
+        return false;
+    }
+
+    if (!ft260_->open()) {
+        qWarning() << "Unable to open device";
+        close();
+        return false;
+    }
+
+    // Create the configuration EEPROM device handler
+    eeprom_ = new M24C08(ft260_, EEPROM_ADDRESS);
+
+    // Create the settings data wrapper
+    settings_ = new DensiStickSettings(eeprom_);
+    if (!settings_->init()) {
+        qWarning() << "Unable to read settings";
+        close();
+        return false;
+    }
+
+    hasSettings_ = settings_->headerValid();
+
+    // Create the light sensor device handler
+    sensor_ = new TSL2585(ft260_);
+    tsl2585_ident_t ident;
+    if (!sensor_->init(&ident)) {
+        qWarning() << "Unable to initialize sensor";
+        close();
+        return false;
+    }
+    sensorType_ = TSL2585::sensorType(&ident);
+
+    // Populate the version string
+    Ft260ChipVersion chipVersion;
+    if (ft260_->chipVersion(&chipVersion)) {
+        ft260Version_ = QString("%1%2-%3.%4")
+                            .arg(chipVersion.chip[0], 2, 16, QChar('0'))
+                            .arg(chipVersion.chip[1], 2, 16, QChar('0'))
+                            .arg(chipVersion.major)
+                            .arg(chipVersion.minor);
+    } else {
+        ft260Version_.clear();
+    }
+
+    // Populate the system clock string
+    switch (ft260_->systemClock()) {
+    case FT260_CLOCK_12MHZ:
+        ft260SystemClock_ = QLatin1String("12 MHz");
+        break;
+    case FT260_CLOCK_24MHZ:
+        ft260SystemClock_ = QLatin1String("24 MHz");
+        break;
+    case FT260_CLOCK_48MHZ:
+        ft260SystemClock_ = QLatin1String("48 MHz");
+        break;
+    case FT260_CLOCK_MAX:
+    default:
+        ft260SystemClock_.clear();
+    }
+
+    // Read initial GPIO state
+    if (!ft260_->gpioRead(&gpioReport_)) {
+        qWarning() << "Unable to read initial GPIO state";
+        close();
+        return false;
+    }
+
+    // Update initial GPIO state
+    gpioReport_.gpio_value = 0; // GPIO 0-5 set to off
+    gpioReport_.gpio_dir = 0; // GPIO 0-5 set as input
+    gpioReport_.gpio_ex_value = 0x20; // GPIOF set to high, all others set to low
+    gpioReport_.gpio_ex_dir = 0x80; // GPIOH set as output, all others set as input
+
+    // Write initial GPIO state
+    if (!ft260_->gpioWrite(&gpioReport_)) {
+        qWarning() << "Unable to write initial GPIO state";
+        close();
+        return false;
+    }
+
+    // Read the LED current potentiometer setting
+    if (!ft260_->i2cReadRawByte(MCP4017_ADDRESS, &lightBrightness_)) {
+        qWarning() << "Unable to read initial LED current state";
+        close();
+        return false;
+    }
+
+    if (hasSettings_) {
+        calibration_ = settings_->readCalibration();
+    }
+
+    connect(ft260_, &Ft260::buttonInterrupt, this, &DensiStickWorker::buttonEvent);
+    connect(ft260_, &Ft260::sensorInterrupt, this, &DensiStickWorker::onSensorInterrupt);
+
+    connected_ = true;
+    publishState();
+
+    return true;
+}
+
+void DensiStickWorker::close()
+{
+    setLightEnable(false);
+
+    hasSettings_ = false;
+    connected_ = false;
+    sensorRunning_ = false;
+
+    disconnect(ft260_, &Ft260::buttonInterrupt, this, &DensiStickWorker::buttonEvent);
+    disconnect(ft260_, &Ft260::sensorInterrupt, this, &DensiStickWorker::onSensorInterrupt);
+
+    if (settings_) {
+        delete settings_;
+        settings_ = nullptr;
+    }
+
+    if (eeprom_) {
+        delete eeprom_;
+        eeprom_ = nullptr;
+    }
+
+    if (sensor_) {
+        delete sensor_;
+        sensor_ = nullptr;
+    }
+
+    calibration_ = DensiStickCalibration();
+
+    if (ft260_) {
+        ft260_->close();
+    }
+    if (!shutdown_) {
+        publishState();
+        emit connectionClosed();
+    }
+}
+
+void DensiStickWorker::shutdown()
+{
+    shutdown_ = true;
+    close();
+}
+
+void DensiStickWorker::onConnectionClosed()
+{
+    if (connected_) {
+        close();
+    }
+}
+
+DensiStickState DensiStickWorker::state() const
+{
+    DensiStickState state;
+    state.connected = connected_;
+    state.hasSettings = hasSettings_;
+    state.running = sensorRunning_;
+    state.streaming = sensorStreaming_;
+    state.lightEnabled = (gpioReport_.gpio_ex_value & 0x80) != 0;
+    state.lightBrightness = lightBrightness_;
+    state.version = ft260Version_;
+    state.systemClock = ft260SystemClock_;
+    if (ft260_) {
+        state.serialNumber = ft260_->deviceInfo().serialNumber();
+    }
+    return state;
+}
+
+DensiStickCalibration DensiStickWorker::calibration() const
+{
+    return calibration_;
+}
+
+void DensiStickWorker::setStreamBuffer(DensiStickSampleBuffer *buffer)
+{
+    streamBuffer_ = buffer;
+}
+
+void DensiStickWorker::publishState()
+{
+    emit stateChanged(state());
+}
+
+void DensiStickWorker::readCalibration()
+{
+    if (!connected_ || !hasSettings_) { return; }
+
+    calibration_ = settings_->readCalibration();
+    emit calibrationChanged(calibration_);
+}
+
+void DensiStickWorker::writeCalibration(const DensiStickCalibration &calibration)
+{
+    bool success = false;
+    if (connected_ && hasSettings_) {
+        success = settings_->writeCalibration(calibration);
+        if (success) {
+            calibration_ = calibration;
+            emit calibrationChanged(calibration_);
+        }
+    }
+    emit calibrationWritten(success);
+}
+
+bool DensiStickWorker::setLightEnable(bool enable)
+{
+    if (!ft260_) { return false; }
+
+    Ft260GpioReport updateReport;
+    memcpy(&updateReport, &gpioReport_, sizeof(Ft260GpioReport));
+
+    if (enable) {
+        updateReport.gpio_ex_value = 0x20 | 0x80;
+    } else {
+        updateReport.gpio_ex_value = 0x20;
+    }
+
+    bool result = false;
+    if (ft260_->gpioWrite(&updateReport)) {
+        memcpy(&gpioReport_, &updateReport, sizeof(Ft260GpioReport));
+        result = true;
+    }
+    if (connected_) {
+        publishState();
+    }
+    return result;
+}
+
+bool DensiStickWorker::setLightBrightness(quint8 value)
+{
+    if (!ft260_) { return false; }
+
+    if (value > 127) { value = 127; }
+
+    bool result = false;
+    if (ft260_->i2cWriteRawByte(MCP4017_ADDRESS, value)) {
+        lightBrightness_ = value;
+        result = true;
+    }
+    if (connected_) {
+        publishState();
+    }
+    return result;
+}
+
+bool DensiStickWorker::setSensorGain(int gain)
+{
+    if (sensorRunning_) {
+        if (!sensor_->setModGain(TSL2585_MOD0, TSL2585_STEP0, static_cast<tsl2585_gain_t>(gain))) {
+            return false;
+        }
+        sensorGain_ = gain;
+        discardNextReading_ = true;
+    } else {
+        sensorGain_ = gain;
+    }
+    return true;
+}
+
+bool DensiStickWorker::setSensorIntegration(int sampleTime, int sampleCount)
+{
+    if (sensorRunning_) {
+        if (!sensor_->setSampleTime(sampleTime)) {
+            return false;
+        }
+        sensorSampleTime_ = sampleTime;
+
+        if (!sensor_->setAlsNumSamples(sampleCount)) {
+            return false;
+        }
+        sensorSampleCount_ = sampleCount;
+        discardNextReading_ = true;
+    } else {
+        sensorSampleTime_ = sampleTime;
+        sensorSampleCount_ = sampleCount;
+    }
+    return true;
+}
+
+bool DensiStickWorker::setSensorAgcEnable(int sampleCount)
+{
+    if (sensorRunning_) {
+        if (!sensor_->setAgcNumSamples(sampleCount)) {
+            return false;
+        }
+        sensorAgcCount_ = sampleCount;
+
+        if (!sensor_->setAgcCalibration(true)) {
+            return false;
+        }
+        sensorAgcEnabled_ = true;
+        discardNextReading_ = true;
+    } else {
+        sensorAgcCount_ = sampleCount;
+        sensorAgcEnabled_ = true;
+    }
+    return true;
+}
+
+bool DensiStickWorker::setSensorAgcDisable()
+{
+    if (sensorRunning_) {
+        if (!sensor_->setAgcNumSamples(0)) {
+            return false;
+        }
+        sensorAgcCount_ = 0;
+
+        if (!sensor_->setAgcCalibration(false)) {
+            return false;
+        }
+        sensorAgcEnabled_ = false;
+        agcDisabledResetGain_ = true;
+        discardNextReading_ = true;
+    } else {
+        sensorAgcCount_ = 0;
+        sensorAgcEnabled_ = false;
+    }
+    return true;
+}
+
+bool DensiStickWorker::sensorStart()
+{
+    TRACE_SCOPE("DensiStickWorker::sensorStart");
+    if (!connected_ || sensorRunning_) { return false; }
+
+    do {
+        // Enable writing of ALS status to the FIFO
+        if (!sensor_->setFifoAlsStatusWriteEnable(true)) { break; }
+
+        // Enable writing of results to the FIFO
+        if (!sensor_->setFifoDataWriteEnable(TSL2585_MOD0, true)) { break; }
+        if (!sensor_->setFifoDataWriteEnable(TSL2585_MOD1, false)) { break; }
+        if (!sensor_->setFifoDataWriteEnable(TSL2585_MOD2, false)) { break; }
+
+        // Set FIFO data format to 32-bits
+        if (!sensor_->setFifoAlsDataFormat(TSL2585_ALS_FIFO_32BIT)) { break; }
+
+        // Set MSB position for full 26-bit result
+        if (!sensor_->setAlsMsbPosition(6)) { break; }
+
+        // Make sure residuals are enabled
+        if (!sensor_->setModResidualEnable(TSL2585_MOD0, TSL2585_STEPS_ALL)) { break; }
+        if (!sensor_->setModResidualEnable(TSL2585_MOD1, TSL2585_STEPS_ALL)) { break; }
+        if (!sensor_->setModResidualEnable(TSL2585_MOD2, TSL2585_STEPS_ALL)) { break; }
+
+        // Select alternate gain table, which caps gain at 256x but gives us more residual bits
+        if (!sensor_->setModGainTableSelect(true)) { break; }
+
+        // Set maximum gain to 256x per app note on residual measurement
+        if (!sensor_->setMaxModGain(TSL2585_GAIN_256X)) { break; }
+
+        // Enable modulator 0
+        if (!sensor_->enableModulators(TSL2585_MOD0)) { break; }
+
+        // Enable internal calibration on every sequencer round
+        if (!sensor_->setCalibrationNthIteration(1)) { break; }
+
+        // Configure photodiodes
+        if (sensorType_ == SENSOR_TYPE_TSL2522) {
+            if (!sensor_->setModPhotodiodeSmux(TSL2585_STEP0, sensor_tsl2522_phd_mod_vis)) { break; }
+        } else if (sensorType_ == SENSOR_TYPE_TSL2585) {
+            if (!sensor_->setModPhotodiodeSmux(TSL2585_STEP0, sensor_tsl2585_phd_mod_vis)) { break; }
+        } else {
+            qWarning() << "Unsupported sensor type, cannot configure SMUX";
+            break;
+        }
+
+        // Set initial gain
+        if (!sensor_->setModGain(TSL2585_MOD0, TSL2585_STEP0, static_cast<tsl2585_gain_t>(sensorGain_))) { break; }
+
+        // Set initial integration time
+        if (!sensor_->setSampleTime(sensorSampleTime_)) { break; }
+        if (!sensor_->setAlsNumSamples(sensorSampleCount_)) { break; }
+
+        if (sensorAgcEnabled_) {
+            // Enable AGC
+            if (!sensor_->setAgcNumSamples(sensorAgcCount_)) { break; }
+            if (!sensor_->setAgcCalibration(sensorAgcEnabled_)) { break; }
+
+        } else {
+            // Disable AGC
+            if (!sensor_->setAgcCalibration(false)) { break; }
+            if (!sensor_->setAgcNumSamples(0)) { break; }
+        }
+
+        // Enable sensor interrupts
+        if (!sensor_->setAlsInterruptPersistence(0)) { break; }
+        if (sensorStreaming_) {
+            // Let results accumulate, so they can be drained in bulk
+            if (!sensor_->setFifoThreshold(STREAM_FIFO_THRESHOLD)) { break; }
+            if (!sensor_->setInterruptEnable(TSL2585_INTENAB_FIEN)) { break; }
+        } else {
+            if (!sensor_->setFifoThreshold(255)) { break; }
+            if (!sensor_->setInterruptEnable(TSL2585_INTENAB_AIEN)) { break; }
+        }
+
+        // Enable the sensor
+        if (!sensor_->enable()) { break; }
+
+        discardNextReading_ = true;
+        agcDisabledResetGain_ = false;
+        sensorRunning_ = true;
+    } while (0);
+
+    if (!sensorRunning_) {
+        sensorStreaming_ = false;
+        sensor_->disable();
+    }
+
+    publishState();
+    return sensorRunning_;
+}
+
+bool DensiStickWorker::sensorStartStream()
+{
+    if (!connected_ || sensorRunning_ || !streamBuffer_) { return false; }
+
+    sensorStreaming_ = true;
+    streamDropped_ = 0;
+    return sensorStart();
+}
+
+bool DensiStickWorker::sensorStop()
+{
+    if (!connected_ || !sensorRunning_) { return false; }
+
+    if (sensor_->disable()) {
+        sensorRunning_ = false;
+        sensorStreaming_ = false;
+    }
+
+    publishState();
+    return !sensorRunning_;
+}
+
+void DensiStickWorker::onSensorInterrupt()
+{
+    TRACE_SCOPE("DensiStickWorker::onSensorInterrupt");
+    uint8_t status = 0;
+    QList<DensiStickReading> readings;
+    bool notifyReading = false;
+    if (!sensor_->getStatus(&status)) {
+        qWarning() << "Unable to get interrupt status";
+        return;
+    }
+
+    if (sensorStreaming_) {
+        if ((status & (TSL2585_STATUS_AINT | TSL2585_STATUS_FINT)) != 0) {
+            readings = readSensor();
+            if (discardNextReading_ && !readings.isEmpty()) {
+                // Only the first record can predate the latest settings change
+                readings.removeFirst();
+                discardNextReading_ = false;
+            }
+            notifyReading = !readings.isEmpty();
+        }
+    } else if ((status & TSL2585_STATUS_AINT) != 0) {
+        readings = readSensor();
+        if (discardNextReading_) {
+            discardNextReading_ = false;
+        } else if (!readings.isEmpty()) {
+            if (readings.last().status() != DensiStickReading::ResultOverflow) {
+                sensorGain_ = readings.last().gain();
+            }
+            notifyReading = true;
+        }
+    }
+
+    if (agcDisabledResetGain_) {
+        if (!sensor_->setModGain(TSL2585_MOD0, TSL2585_STEP0, static_cast<tsl2585_gain_t>(sensorGain_))) {
+            qWarning() << "Unable to reset gain after disabling AGC";
+        }
+        agcDisabledResetGain_ = false;
+        discardNextReading_ = true;
+    }
+
+    if (status != 0) {
+        if (!sensor_->setStatus(status)) {
+            qWarning() << "Unable to clear interrupt status";
+        }
+    }
+
+    if (notifyReading && sensorStreaming_) {
+        QVarLengthArray<DensiStickSample, 80> samples;
+        for (const DensiStickReading &reading : std::as_const(readings)) {
+            DensiStickSample sample;
+            sample.timestamp = reading.timestamp();
+            sample.reading = reading.reading();
+            sample.gain = reading.gain();
+            sample.status = reading.status();
+            samples.append(sample);
+        }
+
+        const size_t pushed = streamBuffer_->push(samples.constData(), samples.size());
+        if (pushed < static_cast<size_t>(samples.size())) {
+            streamDropped_ += samples.size() - pushed;
+            static MetricCounter &droppedSamples = Metrics::counter(QStringLiteral("densistick.stream.dropped"));
+            droppedSamples.add(samples.size() - pushed);
+            qWarning() << "Stream buffer full, dropped" << streamDropped_ << "samples so far";
+        }
+        emit streamDataAvailable();
+    } else if (notifyReading) {
+        emit sensorReadings(readings);
+        emit sensorReading(readings.last());
+    }
+}
+
+QList<DensiStickReading> DensiStickWorker::readSensor()
+{
+    TRACE_SCOPE("DensiStickWorker::readSensor");
+    QList<DensiStickReading> readings;
+    tsl2585_fifo_status_t fifo_status;
+    QByteArray data;
+
+    if (!sensor_->getFifoStatus(&fifo_status)) { return readings; }
+
+    // Drain everything the FIFO holds, including any records
+    // that arrived while the previous burst was being read.
+    while (!fifo_status.overflow && fifo_status.level >= RECORD_SIZE && data.size() < FIFO_SIZE) {
+        const uint16_t len = fifo_status.level - (fifo_status.level % RECORD_SIZE);
+        const QByteArray burst = sensor_->readFifo(qMin<uint16_t>(len, FIFO_SIZE - (FIFO_SIZE % RECORD_SIZE)), &fifo_status);
+        if (burst.isEmpty()) { break; }
+        data.append(burst);
+    }
+
+    if (fifo_status.overflow) {
+        qWarning() << "FIFO overflow, clearing";
+        static MetricCounter &overflows = Metrics::counter(QStringLiteral("densistick.fifo.overflows"));
+        overflows.add();
+        sensor_->clearFifo();
+        readings.append(DensiStickReading(DensiStickReading::ResultOverflow, TSL2585_GAIN_MAX, 0,
+                                          QDateTime::currentMSecsSinceEpoch()));
+        return readings;
+    }
+
+    if (data.size() < RECORD_SIZE) { return readings; }
+
+    // Records come out oldest first, one per integration cycle, with
+    // the newest one having just completed.
+    readings = decodeFifoRecords(data, QDateTime::currentMSecsSinceEpoch(),
+                                 TSL2585::integrationTimeMs(sensorSampleTime_, sensorSampleCount_));
+
+    static MetricCounter &readingCount = Metrics::counter(QStringLiteral("densistick.readings"));
+    readingCount.add(readings.size());
+
+    return readings;
+}
+
+QList<DensiStickReading> DensiStickWorker::decodeFifoRecords(const QByteArray &data, qint64 now, float periodMs)
+{
+    QList<DensiStickReading> readings;
+    const qsizetype count = data.size() / RECORD_SIZE;
+    if (count == 0) { return readings; }
+
+    readings.reserve(count);
+    for (qsizetype i = 0; i < count; i++) {
+        const uint8_t *record = reinterpret_cast<const uint8_t *>(data.constData() + (i * RECORD_SIZE));
+        const uint32_t als_data0 = static_cast<uint32_t>(record[0])
+            | (static_cast<uint32_t>(record[1]) << 8)
+            | (static_cast<uint32_t>(record[2]) << 16)
+            | (static_cast<uint32_t>(record[3]) << 24);
+        const uint8_t als_status = record[4];
+        const uint8_t als_status2 = record[5];
+
+        const tsl2585_gain_t gain = static_cast<tsl2585_gain_t>(als_status2 & 0x0F);
+        const qint64 timestamp = now - qRound64((count - 1 - i) * periodMs);
+
+        if ((als_status & TSL2585_ALS_DATA0_ANALOG_SATURATION_STATUS) != 0) {
+            readings.append(DensiStickReading(DensiStickReading::ResultSaturated, gain, 0, timestamp));
+        } else {
+            readings.append(DensiStickReading(DensiStickReading::ResultValid, gain, als_data0, timestamp));
+        }
+    }
+
+    return readings;
+}
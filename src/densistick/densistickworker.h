@@ -0,0 +1,129 @@
+#ifndef DENSISTICKWORKER_H
+#define DENSISTICKWORKER_H
+
+#include <QObject>
+#include "ft260.h"
+#include "densistickreading.h"
+#include "peripheralcalvalues.h"
+#include "../spscringbuffer.h"
+
+class M24C08;
+class DensiStickSettings;
+class TSL2585;
+
+typedef SpscRingBuffer<DensiStickSample> DensiStickSampleBuffer;
+
+/**
+ * Snapshot of the DensiStick state, as published by the worker
+ * whenever something the GUI cares about has changed.
+ */
+struct DensiStickState
+{
+    bool connected = false;
+    bool hasSettings = false;
+    bool running = false;
+    bool streaming = false;
+    bool lightEnabled = false;
+    quint8 lightBrightness = 0;
+    QString version;
+    QString systemClock;
+    QString serialNumber;
+};
+
+Q_DECLARE_METATYPE(DensiStickState)
+
+/**
+ * Performs all I/O with the DensiStick and its peripherals.
+ *
+ * This object, along with the Ft260 it owns, is meant to live in its own
+ * thread so that blocking bus transactions never stall the GUI.
+ * It should only be accessed through DensiStickInterface.
+ */
+class DensiStickWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DensiStickWorker(Ft260 *ft260, QObject *parent = nullptr);
+    ~DensiStickWorker();
+
+    DensiStickState state() const;
+    DensiStickCalibration calibration() const;
+
+    /**
+     * Set the buffer that receives samples while streaming.
+     * Must be called before the worker is moved to its thread,
+     * and the buffer must outlive the worker.
+     */
+    void setStreamBuffer(DensiStickSampleBuffer *buffer);
+
+    /**
+     * Decode a block of records read out of the sensor FIFO, oldest first,
+     * with the newest one having completed at the given time.
+     */
+    static QList<DensiStickReading> decodeFifoRecords(const QByteArray &data, qint64 now, float periodMs);
+
+public slots:
+    bool open();
+    void close();
+    void shutdown();
+
+    bool setLightEnable(bool enable);
+    bool setLightBrightness(quint8 value);
+
+    bool setSensorGain(int gain);
+    bool setSensorIntegration(int sampleTime, int sampleCount);
+    bool setSensorAgcEnable(int sampleCount);
+    bool setSensorAgcDisable();
+
+    bool sensorStart();
+    bool sensorStartStream();
+    bool sensorStop();
+
+    void readCalibration();
+    void writeCalibration(const DensiStickCalibration &calibration);
+
+signals:
+    void stateChanged(const DensiStickState &state);
+    void connectionClosed();
+    void buttonEvent(bool pressed);
+    void sensorReading(const DensiStickReading& reading);
+    void sensorReadings(const QList<DensiStickReading> &readings);
+    void streamDataAvailable();
+    void calibrationChanged(const DensiStickCalibration &calibration);
+    void calibrationWritten(bool success);
+
+private slots:
+    void onConnectionClosed();
+    void onSensorInterrupt();
+
+private:
+    QList<DensiStickReading> readSensor();
+    void publishState();
+
+    bool connected_ = false;
+    Ft260 *ft260_ = nullptr;
+    M24C08 *eeprom_ = nullptr;
+    tsl2585_sensor_type_t sensorType_ = SENSOR_TYPE_UNKNOWN;
+    QString ft260Version_;
+    QString ft260SystemClock_;
+    DensiStickSettings *settings_ = nullptr;
+    TSL2585 *sensor_ = nullptr;
+    bool hasSettings_ = false;
+    DensiStickCalibration calibration_;
+    Ft260GpioReport gpioReport_;
+    quint8 lightBrightness_ = 0;
+    quint8 sensorGain_ = 8;
+    quint16 sensorSampleTime_ = 719;
+    quint16 sensorSampleCount_ = 199;
+    quint16 sensorAgcCount_ = 0;
+    bool sensorAgcEnabled_ = false;
+    bool discardNextReading_ = false;
+    bool agcDisabledResetGain_ = false;
+    bool sensorRunning_ = false;
+    bool sensorStreaming_ = false;
+    DensiStickSampleBuffer *streamBuffer_ = nullptr;
+    quint64 streamDropped_ = 0;
+    bool shutdown_ = false;
+};
+
+#endif // DENSISTICKWORKER_H
@@ -8,6 +8,18 @@
 #include "ft260libusb.h"
 #endif
 #include "ft260hidapi.h"
+#include "ft260emulator.h"
+#include "ft260recorder.h"
+#include "ft260replay.h"
+
+#include <string.h>
+
+namespace
+{
+/* Report IDs used by the I2C request builders */
+static const uint8_t HID_REPORT_FT260_I2C_READ_REQUEST = 0xC2;
+static const uint8_t HID_REPORT_FT260_I2C_IO_BASE = 0xD0;
+}
 
 Ft260::Ft260(Ft260DeviceInfo deviceInfo, QObject *parent) : QObject(parent), deviceInfo_(deviceInfo)
 {
@@ -17,6 +29,78 @@ Ft260::~Ft260()
 {
 }
 
+bool Ft260::i2cTransaction(QList<Ft260I2cOp> &ops)
+{
+    for (Ft260I2cOp &op : ops) {
+        if (op.type == Ft260I2cOp::Read) {
+            op.data = i2cRead(op.addr, op.reg, op.len);
+            if (op.data.isEmpty()) { return false; }
+        } else if (op.type == Ft260I2cOp::Write) {
+            if (!i2cWrite(op.addr, op.reg, op.data)) { return false; }
+        } else if (op.type == Ft260I2cOp::ReadRaw) {
+            quint8 data;
+            if (op.len != 1 || !i2cReadRawByte(op.addr, &data)) { return false; }
+            op.data = QByteArray(1, static_cast<char>(data));
+        } else if (op.type == Ft260I2cOp::WriteRaw) {
+            if (op.data.size() != 1 || !i2cWriteRawByte(op.addr, static_cast<quint8>(op.data[0]))) { return false; }
+        }
+    }
+    return true;
+}
+
+quint32 Ft260::submitI2cTransaction(const QList<Ft260I2cOp> &ops)
+{
+    const quint32 ticket = nextI2cTicket();
+    QList<Ft260I2cOp> result = ops;
+    const bool success = i2cTransaction(result);
+
+    QMetaObject::invokeMethod(this, [this, ticket, success, result]() {
+        emit i2cTransactionFinished(ticket, success, result);
+    }, Qt::QueuedConnection);
+
+    return ticket;
+}
+
+int Ft260::fillI2cWriteRequest(uint8_t *buf, quint8 addr, uint8_t flags, const uint8_t *payload, quint8 payloadSize)
+{
+    if (payloadSize == 0 || payloadSize > HID_MAX_TRAN_SIZE) {
+        return 0;
+    }
+    const uint8_t reportId = HID_REPORT_FT260_I2C_IO_BASE + ((payloadSize - 1) >> 2);
+
+    const uint8_t transferLen = ((reportId - HID_REPORT_FT260_I2C_IO_BASE + 1) * 4) + 4;
+
+    memset(buf, 0, REQUEST_BUF_SIZE);
+    buf[0] = reportId;
+    buf[1] = addr;
+    buf[2] = flags;
+    buf[3] = payloadSize;
+    memcpy(buf + 4, payload, payloadSize);
+
+    return transferLen;
+}
+
+int Ft260::fillI2cReadRequest(uint8_t *buf, quint8 addr, uint8_t flags, quint16 payloadSize)
+{
+    memset(buf, 0, REQUEST_BUF_SIZE);
+    buf[0] = HID_REPORT_FT260_I2C_READ_REQUEST;
+    buf[1] = addr;
+    buf[2] = flags;
+    buf[3] = payloadSize & 0x00FF;
+    buf[4] = (payloadSize & 0xFF00) >> 8;
+
+    return 5;
+}
+
+quint32 Ft260::nextI2cTicket()
+{
+    quint32 ticket = nextI2cTicket_++;
+    if (ticket == 0) {
+        ticket = nextI2cTicket_++;
+    }
+    return ticket;
+}
+
 Ft260 *Ft260::createDriver(const Ft260DeviceInfo &device)
 {
     Ft260 *driver = nullptr;
@@ -28,6 +112,16 @@ Ft260 *Ft260::createDriver(const Ft260DeviceInfo &device)
         driver = new Ft260LibUsb(device);
     }
 #endif
+    else if (device.deviceDriver() == Ft260DeviceInfo::DriverEmulator) {
+        driver = new Ft260Emulator(device);
+    }
+    else if (device.deviceDriver() == Ft260DeviceInfo::DriverReplay) {
+        driver = new Ft260Replay(device);
+    }
+
+    if (driver && device.deviceDriver() != Ft260DeviceInfo::DriverReplay && Ft260Recorder::isRecording()) {
+        driver = new Ft260Recorder(driver);
+    }
     return driver;
 }
 
@@ -40,6 +134,10 @@ QList<Ft260DeviceInfo> Ft260::listDevices()
 #endif
     const QList<Ft260DeviceInfo> listHidApi = Ft260HidApi::listDevices();
     list.append(listHidApi);
+    const QList<Ft260DeviceInfo> listEmulator = Ft260Emulator::listDevices();
+    list.append(listEmulator);
+    const QList<Ft260DeviceInfo> listReplay = Ft260Replay::listDevices();
+    list.append(listReplay);
     return list;
 }
 
@@ -63,3 +161,50 @@ Ft260DeviceInfo Ft260::deviceInfo() const
 {
     return deviceInfo_;
 }
+
+Ft260I2cOp Ft260I2cOp::read(quint8 addr, quint8 reg, quint8 len)
+{
+    Ft260I2cOp op;
+    op.type = Read;
+    op.addr = addr;
+    op.reg = reg;
+    op.len = len;
+    return op;
+}
+
+Ft260I2cOp Ft260I2cOp::write(quint8 addr, quint8 reg, const QByteArray &data)
+{
+    Ft260I2cOp op;
+    op.type = Write;
+    op.addr = addr;
+    op.reg = reg;
+    op.len = data.size();
+    op.data = data;
+    return op;
+}
+
+Ft260I2cOp Ft260I2cOp::writeByte(quint8 addr, quint8 reg, quint8 value)
+{
+    return write(addr, reg, QByteArray(1, static_cast<char>(value)));
+}
+
+Ft260I2cOp Ft260I2cOp::readRaw(quint8 addr, quint8 len)
+{
+    Ft260I2cOp op;
+    op.type = ReadRaw;
+    op.addr = addr;
+    op.reg = 0;
+    op.len = len;
+    return op;
+}
+
+Ft260I2cOp Ft260I2cOp::writeRaw(quint8 addr, const QByteArray &data)
+{
+    Ft260I2cOp op;
+    op.type = WriteRaw;
+    op.addr = addr;
+    op.reg = 0;
+    op.len = data.size();
+    op.data = data;
+    return op;
+}
@@ -2,6 +2,9 @@
 #define FT260_H
 
 #include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <atomic>
 
 #include "ft260deviceinfo.h"
 
@@ -18,6 +21,21 @@ typedef enum {
     FT260_CLOCK_MAX
 } Ft260SystemClock;
 
+/* I2C bus status bits, as returned by Ft260::i2cStatus() */
+#define FT260_I2C_STATUS_CONTROLLER_BUSY   0x01
+#define FT260_I2C_STATUS_ERROR             0x02
+#define FT260_I2C_STATUS_ADDRESS_NACK      0x04
+#define FT260_I2C_STATUS_DATA_NACK         0x08
+#define FT260_I2C_STATUS_ARBITRATION_LOST  0x10
+#define FT260_I2C_STATUS_CONTROLLER_IDLE   0x20
+#define FT260_I2C_STATUS_BUS_BUSY          0x40
+
+/* Largest I2C payload that fits into a single HID report */
+#define HID_MAX_TRAN_SIZE 0x3C
+
+/* Size of a HID request buffer, as filled in by the request builders */
+#define REQUEST_BUF_SIZE  64
+
 typedef struct {
     uint8_t gpio_value;
     uint8_t gpio_dir;
@@ -25,6 +43,37 @@ typedef struct {
     uint8_t gpio_ex_dir;
 } Ft260GpioReport;
 
+/**
+ * Single register operation within a batched I2C transaction.
+ *
+ * Reads fill in the data field with the bytes returned by the device,
+ * writes send the contents of the data field to the register.
+ * The raw variants address the device without a register, for parts
+ * that only have a single register.
+ */
+struct Ft260I2cOp
+{
+    enum Type {
+        Read,
+        Write,
+        ReadRaw,
+        WriteRaw
+    };
+    Type type;
+    quint8 addr;
+    quint8 reg;
+    quint8 len;
+    QByteArray data;
+
+    static Ft260I2cOp read(quint8 addr, quint8 reg, quint8 len);
+    static Ft260I2cOp write(quint8 addr, quint8 reg, const QByteArray &data);
+    static Ft260I2cOp writeByte(quint8 addr, quint8 reg, quint8 value);
+    static Ft260I2cOp readRaw(quint8 addr, quint8 len);
+    static Ft260I2cOp writeRaw(quint8 addr, const QByteArray &data);
+};
+
+Q_DECLARE_METATYPE(Ft260I2cOp)
+
 class Ft260 : public QObject
 {
     Q_OBJECT
@@ -60,6 +109,26 @@ public:
     virtual bool i2cWriteByte(quint8 addr, quint8 reg, quint8 data) = 0;
     virtual bool i2cWriteRawByte(quint8 addr, quint8 data) = 0;
 
+    /**
+     * Perform a sequence of register reads and writes as a single batch.
+     *
+     * Drivers that support it submit all the requests back-to-back,
+     * without waiting on the bus in between, and collect the results
+     * once at the end. The default implementation simply performs each
+     * operation in turn. Processing stops at the first failed operation.
+     */
+    virtual bool i2cTransaction(QList<Ft260I2cOp> &ops);
+
+    /**
+     * Queue a batched I2C transaction without waiting for it to complete.
+     *
+     * Completion is reported through the i2cTransactionFinished() signal,
+     * which is always delivered through the event loop of the thread
+     * this object lives in. Returns a ticket identifying the transaction,
+     * or zero if it could not be queued.
+     */
+    virtual quint32 submitI2cTransaction(const QList<Ft260I2cOp> &ops);
+
     static Ft260 *createDriver(const Ft260DeviceInfo &device);
     static QList<Ft260DeviceInfo> listDevices();
     static bool isMatchingDevice(quint16 vid, quint16 pid);
@@ -69,9 +138,25 @@ signals:
     void connectionClosed();
     void buttonInterrupt(bool pressed);
     void sensorInterrupt();
+    void i2cTransactionFinished(quint32 ticket, bool success, const QList<Ft260I2cOp> &ops);
 
 protected:
+    quint32 nextI2cTicket();
+
+    /** Most read responses left outstanding within a single batch */
+    static const int I2C_BATCH_MAX_READS = 8;
+
+    /**
+     * Fill in an I2C write or read request report, returning its length
+     * or zero if the payload does not fit into a single report.
+     */
+    static int fillI2cWriteRequest(uint8_t *buf, quint8 addr, uint8_t flags, const uint8_t *payload, quint8 payloadSize);
+    static int fillI2cReadRequest(uint8_t *buf, quint8 addr, uint8_t flags, quint16 payloadSize);
+
     const Ft260DeviceInfo deviceInfo_;
+
+private:
+    std::atomic<quint32> nextI2cTicket_ = 1;
 };
 
 #endif // FT260_H
@@ -15,7 +15,9 @@ public:
     enum Driver {
         DriverUnknown = 0,
         DriverLibUsb,
-        DriverHidApi
+        DriverHidApi,
+        DriverEmulator,
+        DriverReplay
     };
 
     Ft260DeviceInfo();
@@ -44,6 +46,8 @@ private:
     Ft260DeviceInfo(const Ft260DeviceInfoPrivate &dd);
     friend QList<Ft260DeviceInfo> listDevicesByLibUsb();
     friend QList<Ft260DeviceInfo> listDevicesByHidApi();
+    friend QList<Ft260DeviceInfo> listDevicesByEmulator();
+    friend QList<Ft260DeviceInfo> listDevicesByReplay();
     std::unique_ptr<Ft260DeviceInfoPrivate> d_ptr;
 };
 
@@ -0,0 +1,981 @@
+#include "ft260emulator.h"
+
+#include <QThread>
+#include <QTimer>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QtMath>
+#include <QDebug>
+
+#include "ft260deviceinfo.h"
+#include "ft260deviceinfo_p.h"
+#include "tsl2585.h"
+#include "tsl2585_p.h"
+
+namespace
+{
+static std::atomic<bool> emulatorEnabled = false;
+
+static const uint8_t TSL2585_ADDRESS = 0x39;
+static const uint8_t EEPROM_ADDRESS = 0x50;
+static const uint8_t MCP4017_ADDRESS = 0x2F;
+
+static const int TSL2585_FIFO_SIZE = 512;
+
+/* Gain-adjusted light level, in counts per ms, at which the modulator saturates */
+static const double TSL2585_SATURATION_RATE = 100000.0;
+
+/* Limit on cycles run in one go, in case the clock jumps far ahead */
+static const int TSL2585_MAX_CATCHUP_CYCLES = 10000;
+
+static const int M24C08_SIZE = 1024;
+static const int M24C08_PAGE = 16;
+static const qint64 M24C08_WRITE_CYCLE_US = 5000;
+
+static const quint8 MCP4017_MAX_VALUE = 0x7F;
+}
+
+/**
+ * Register model of the TSL2585 light sensor, covering the parts of it
+ * that the DensiStick relies upon.
+ */
+class Tsl2585Model
+{
+public:
+    Tsl2585Model() { reset(); }
+
+    void reset()
+    {
+        regs_.fill(0);
+        regs_[TSL2585_AUX_ID] = 0x06;
+        regs_[TSL2585_REV_ID] = 0x11;
+        regs_[TSL2585_ID] = 0x5C;
+        regs_[TSL2585_SAMPLE_TIME0] = 0xB3;
+        regs_[TSL2585_CFG8] = static_cast<uint8_t>(TSL2585_GAIN_4096X << 4);
+        regs_[TSL2585_MEAS_SEQR_STEP0_MOD_GAINX_L] = static_cast<uint8_t>((TSL2585_GAIN_128X << 4) | TSL2585_GAIN_128X);
+        fifo_.clear();
+        overflow_ = false;
+        underflow_ = false;
+        cycleStart_ = 0;
+        cyclesDone_ = 0;
+    }
+
+    bool running() const
+    {
+        return (regs_[TSL2585_ENABLE] & (TSL2585_ENABLE_PON | TSL2585_ENABLE_AEN))
+            == (TSL2585_ENABLE_PON | TSL2585_ENABLE_AEN);
+    }
+
+    qint64 periodUs() const
+    {
+        const uint16_t sampleTime = regs_[TSL2585_SAMPLE_TIME0] | ((regs_[TSL2585_SAMPLE_TIME1] & 0x07) << 8);
+        const uint16_t numSamples = regs_[TSL2585_ALS_NR_SAMPLES0] | ((regs_[TSL2585_ALS_NR_SAMPLES1] & 0x07) << 8);
+        return qMax<qint64>(1, qRound64(TSL2585::integrationTimeMs(sampleTime, numSamples) * 1000.0));
+    }
+
+    /** Time at which the current cycle completes, or -1 if not running */
+    qint64 nextCycleTime() const
+    {
+        if (!running()) { return -1; }
+        return cycleStart_ + ((cyclesDone_ + 1) * periodUs());
+    }
+
+    /** Run every cycle completed by the given time, returning how many that was */
+    int advance(qint64 now, double light)
+    {
+        if (!running()) { return 0; }
+
+        const qint64 period = periodUs();
+        int count = 0;
+        while (cycleStart_ + ((cyclesDone_ + 1) * period) <= now) {
+            if (count >= TSL2585_MAX_CATCHUP_CYCLES) {
+                cyclesDone_ = (now - cycleStart_) / period;
+                break;
+            }
+            cyclesDone_++;
+            completeCycle(light, period);
+            count++;
+        }
+        return count;
+    }
+
+    QByteArray read(uint8_t reg, int len)
+    {
+        QByteArray data;
+        data.reserve(len);
+        for (int i = 0; i < len; i++) {
+            // Reads past the end of the map stay on the FIFO data register
+            const int addr = qMin(reg + i, static_cast<int>(TSL2585_FIFO_DATA));
+            data.append(static_cast<char>(readRegister(static_cast<uint8_t>(addr))));
+        }
+        pointer_ = static_cast<uint8_t>(qMin(reg + len, static_cast<int>(TSL2585_FIFO_DATA)));
+        return data;
+    }
+
+    QByteArray readCurrent(int len)
+    {
+        return read(pointer_, len);
+    }
+
+    void write(uint8_t reg, const QByteArray &data, qint64 now)
+    {
+        const bool wasRunning = running();
+        const qint64 period = periodUs();
+
+        for (qsizetype i = 0; i < data.size(); i++) {
+            const int addr = reg + i;
+            if (addr > 0xFF) { break; }
+            writeRegister(static_cast<uint8_t>(addr), static_cast<uint8_t>(data[i]));
+        }
+        pointer_ = reg;
+
+        // Starting the sensor, or changing its timing, begins a new cycle
+        if (running() && (!wasRunning || periodUs() != period)) {
+            cycleStart_ = now;
+            cyclesDone_ = 0;
+        }
+    }
+
+    bool interruptPending() const
+    {
+        return (regs_[TSL2585_STATUS] & regs_[TSL2585_INTENAB]) != 0;
+    }
+
+    quint64 overflows() const
+    {
+        return overflowCount_;
+    }
+
+private:
+    uint8_t readRegister(uint8_t reg)
+    {
+        const uint16_t level = static_cast<uint16_t>(fifo_.size());
+        switch (reg) {
+        case TSL2585_FIFO_STATUS0:
+            return static_cast<uint8_t>(level >> 2);
+        case TSL2585_FIFO_STATUS1:
+            return static_cast<uint8_t>((level & 0x03) | (overflow_ ? 0x80 : 0x00) | (underflow_ ? 0x40 : 0x00));
+        case TSL2585_FIFO_DATA:
+            if (fifo_.isEmpty()) {
+                underflow_ = true;
+                return 0;
+            } else {
+                const uint8_t value = static_cast<uint8_t>(fifo_.front());
+                fifo_.remove(0, 1);
+                return value;
+            }
+        default:
+            return regs_[reg];
+        }
+    }
+
+    void writeRegister(uint8_t reg, uint8_t value)
+    {
+        switch (reg) {
+        case TSL2585_AUX_ID:
+        case TSL2585_REV_ID:
+        case TSL2585_ID:
+        case TSL2585_ALS_STATUS:
+        case TSL2585_ALS_STATUS2:
+        case TSL2585_ALS_STATUS3:
+        case TSL2585_FIFO_STATUS0:
+        case TSL2585_FIFO_STATUS1:
+        case TSL2585_FIFO_DATA:
+            break;
+        case TSL2585_STATUS:
+            // Interrupt flags are cleared by writing them back
+            regs_[reg] &= ~value;
+            break;
+        case TSL2585_CONTROL:
+            if (value & TSL2585_CONTROL_SOFT_RESET) {
+                const quint64 overflowCount = overflowCount_;
+                reset();
+                overflowCount_ = overflowCount;
+            } else if (value & TSL2585_CONTROL_FIFO_CLR) {
+                fifo_.clear();
+                overflow_ = false;
+                underflow_ = false;
+            }
+            break;
+        default:
+            regs_[reg] = value;
+            break;
+        }
+    }
+
+    tsl2585_gain_t gain() const
+    {
+        return static_cast<tsl2585_gain_t>(qMin<int>(regs_[TSL2585_MEAS_SEQR_STEP0_MOD_GAINX_L] & 0x0F, TSL2585_GAIN_4096X));
+    }
+
+    void setGain(tsl2585_gain_t gain)
+    {
+        regs_[TSL2585_MEAS_SEQR_STEP0_MOD_GAINX_L] = (regs_[TSL2585_MEAS_SEQR_STEP0_MOD_GAINX_L] & 0xF0) | (gain & 0x0F);
+    }
+
+    tsl2585_gain_t maxGain() const
+    {
+        int maxGain = qMin<int>(regs_[TSL2585_CFG8] >> 4, TSL2585_GAIN_4096X);
+
+        // The alternate gain table tops out at 256x
+        if ((regs_[TSL2585_MOD_GAIN_H] & 0x30) != 0) {
+            maxGain = qMin<int>(maxGain, TSL2585_GAIN_256X);
+        }
+        return static_cast<tsl2585_gain_t>(maxGain);
+    }
+
+    uint16_t fifoThreshold() const
+    {
+        return (regs_[TSL2585_CFG2] & 0x01) | (static_cast<uint16_t>(regs_[TSL2585_FIFO_THR]) << 1);
+    }
+
+    void completeCycle(double light, qint64 period)
+    {
+        const tsl2585_gain_t cycleGain = gain();
+        const double rate = light * TSL2585::gainValue(cycleGain);
+        const bool saturated = rate > TSL2585_SATURATION_RATE;
+
+        // Small amount of repeatable noise on top of the ideal result
+        const double noise = 1.0 + ((random_.generateDouble() - 0.5) * 0.001);
+        const double counts = rate * (static_cast<double>(period) / 1000.0) * noise;
+        const uint32_t value = saturated ? 0 : static_cast<uint32_t>(qBound(0.0, counts, 67108863.0));
+
+        regs_[TSL2585_ALS_STATUS] = saturated ? TSL2585_ALS_DATA0_ANALOG_SATURATION_STATUS : 0;
+        regs_[TSL2585_ALS_STATUS2] = static_cast<uint8_t>(cycleGain & 0x0F);
+        regs_[TSL2585_ALS_STATUS3] = 0;
+        regs_[TSL2585_ALS_DATA0_L] = static_cast<uint8_t>(value >> 10);
+        regs_[TSL2585_ALS_DATA0_H] = static_cast<uint8_t>(value >> 18);
+
+        if (regs_[TSL2585_MOD_FIFO_DATA_CFG0] & 0x80) {
+            QByteArray record;
+            const uint8_t format = regs_[TSL2585_CFG4] & 0x03;
+            const int dataSize = (format == TSL2585_ALS_FIFO_32BIT) ? 4 : (format == TSL2585_ALS_FIFO_24BIT) ? 3 : 2;
+            for (int i = 0; i < dataSize; i++) {
+                record.append(static_cast<char>((value >> (i * 8)) & 0xFF));
+            }
+            if (regs_[TSL2585_MEAS_MODE0] & 0x10) {
+                record.append(static_cast<char>(regs_[TSL2585_ALS_STATUS]));
+                record.append(static_cast<char>(regs_[TSL2585_ALS_STATUS2]));
+                record.append(static_cast<char>(regs_[TSL2585_ALS_STATUS3]));
+            }
+
+            if (fifo_.size() + record.size() > TSL2585_FIFO_SIZE) {
+                if (!overflow_) { overflowCount_++; }
+                overflow_ = true;
+            } else {
+                fifo_.append(record);
+            }
+        }
+
+        regs_[TSL2585_STATUS] |= TSL2585_STATUS_AINT;
+        if (fifo_.size() >= fifoThreshold()) {
+            regs_[TSL2585_STATUS] |= TSL2585_STATUS_FINT;
+        }
+
+        // Step the gain for the next cycle, the way the AGC would
+        if (regs_[TSL2585_MOD_CALIB_CFG2] & TSL2585_MOD_CALIB_NTH_ITERATION_AGC_ENABLE) {
+            if (saturated && cycleGain > TSL2585_GAIN_0_5X) {
+                setGain(static_cast<tsl2585_gain_t>(cycleGain - 1));
+            } else if (!saturated && cycleGain < maxGain() && (rate * 2.0) < TSL2585_SATURATION_RATE) {
+                setGain(static_cast<tsl2585_gain_t>(cycleGain + 1));
+            }
+        }
+    }
+
+    std::array<uint8_t, 256> regs_;
+    QByteArray fifo_;
+    uint8_t pointer_ = 0;
+    bool overflow_ = false;
+    bool underflow_ = false;
+    quint64 overflowCount_ = 0;
+    qint64 cycleStart_ = 0;
+    qint64 cyclesDone_ = 0;
+    QRandomGenerator random_{0x2585};
+};
+
+/**
+ * Model of the M24C08 EEPROM, including the time it spends in its
+ * internal write cycle without acknowledging its address.
+ */
+class M24c08Model
+{
+public:
+    M24c08Model() : memory_(M24C08_SIZE, static_cast<char>(0xFF))
+    {
+        // Start out with just a settings header, as on a freshly set up device
+        memory_[0x100] = 'D';
+        memory_[0x101] = 'P';
+        memory_[0x102] = 'D';
+        memory_[0x103] = 0x01;
+    }
+
+    bool busy(qint64 now) const
+    {
+        return now < busyUntil_;
+    }
+
+    void setPointer(quint8 addr, uint8_t offset)
+    {
+        pointer_ = static_cast<uint16_t>(((addr & 0x03) << 8) | offset);
+    }
+
+    QByteArray readCurrent(int len)
+    {
+        QByteArray data;
+        data.reserve(len);
+        for (int i = 0; i < len; i++) {
+            data.append(memory_.at(pointer_));
+            pointer_ = (pointer_ + 1) % M24C08_SIZE;
+        }
+        return data;
+    }
+
+    void write(quint8 addr, uint8_t offset, const QByteArray &data, qint64 now)
+    {
+        setPointer(addr, offset);
+
+        // Data wraps around within the page rather than crossing into the next
+        const uint16_t pageStart = pointer_ - (pointer_ % M24C08_PAGE);
+        uint16_t pos = pointer_;
+        for (char c : data) {
+            memory_[pos] = c;
+            pos = pageStart + ((pos + 1 - pageStart) % M24C08_PAGE);
+        }
+        pointer_ = pos;
+        busyUntil_ = now + M24C08_WRITE_CYCLE_US;
+    }
+
+    QByteArray memory() const
+    {
+        return memory_;
+    }
+
+    void setMemory(const QByteArray &data)
+    {
+        memory_.replace(0, qMin<qsizetype>(data.size(), M24C08_SIZE), data.left(M24C08_SIZE));
+    }
+
+private:
+    QByteArray memory_;
+    uint16_t pointer_ = 0;
+    qint64 busyUntil_ = 0;
+};
+
+Ft260Emulator::Ft260Emulator(const Ft260DeviceInfo &device, QObject *parent) : Ft260(device, parent)
+    , sensor_(new Tsl2585Model())
+    , eeprom_(new M24c08Model())
+    , sensorTimer_(new QTimer(this))
+    , reportTimeUs_(1000)
+    , lightLevel_(40.0)
+    , ambientLevel_(0.0)
+{
+    sensorTimer_->setSingleShot(true);
+    sensorTimer_->setTimerType(Qt::PreciseTimer);
+    connect(sensorTimer_, &QTimer::timeout, this, &Ft260Emulator::onSensorTimeout);
+}
+
+Ft260Emulator::~Ft260Emulator()
+{
+    Ft260Emulator::close();
+}
+
+void Ft260Emulator::setEnabled(bool enabled)
+{
+    emulatorEnabled = enabled;
+}
+
+bool Ft260Emulator::isEnabled()
+{
+    return emulatorEnabled;
+}
+
+void Ft260Emulator::setLightLevel(double level)
+{
+    lightLevel_ = qMax(0.0, level);
+}
+
+double Ft260Emulator::lightLevel() const
+{
+    return lightLevel_;
+}
+
+void Ft260Emulator::setAmbientLevel(double level)
+{
+    ambientLevel_ = qMax(0.0, level);
+}
+
+double Ft260Emulator::ambientLevel() const
+{
+    return ambientLevel_;
+}
+
+void Ft260Emulator::setReportTime(int usec)
+{
+    reportTimeUs_ = qMax(0, usec);
+}
+
+int Ft260Emulator::reportTime() const
+{
+    return reportTimeUs_;
+}
+
+void Ft260Emulator::setRealTime(bool realTime)
+{
+    if (open_) {
+        qWarning() << "Cannot change the emulator clock while open";
+        return;
+    }
+    realTime_ = realTime;
+}
+
+bool Ft260Emulator::realTime() const
+{
+    return realTime_;
+}
+
+void Ft260Emulator::setIdleAdvance(bool enabled)
+{
+    if (open_) {
+        qWarning() << "Cannot change the emulator clock while open";
+        return;
+    }
+    idleAdvance_ = enabled;
+}
+
+bool Ft260Emulator::idleAdvance() const
+{
+    return idleAdvance_;
+}
+
+void Ft260Emulator::setEepromContents(const QByteArray &data)
+{
+    eeprom_->setMemory(data);
+}
+
+QByteArray Ft260Emulator::eepromContents() const
+{
+    return eeprom_->memory();
+}
+
+void Ft260Emulator::advanceClock(qint64 usec)
+{
+    if (usec <= 0) { return; }
+
+    if (realTime_) {
+        QThread::usleep(static_cast<unsigned long>(usec));
+    } else {
+        virtualClockUs_ += usec;
+    }
+    updateSensor();
+}
+
+qint64 Ft260Emulator::stepClock()
+{
+    if (!open_ || realTime_) { return 0; }
+
+    const qint64 next = sensor_->nextCycleTime();
+    if (next < 0) { return 0; }
+
+    const qint64 usec = qMax<qint64>(0, next - virtualClockUs_);
+    virtualClockUs_ += usec;
+    updateSensor();
+    return usec;
+}
+
+qint64 Ft260Emulator::clockUs() const
+{
+    if (realTime_) {
+        return wallClock_.isValid() ? wallClock_.nsecsElapsed() / 1000 : 0;
+    } else {
+        return virtualClockUs_;
+    }
+}
+
+void Ft260Emulator::setButtonPressed(bool pressed)
+{
+    if (buttonPressed_.exchange(pressed) == pressed) { return; }
+
+    QMetaObject::invokeMethod(this, [this, pressed]() {
+        if (open_) {
+            emit buttonInterrupt(pressed);
+        }
+    }, Qt::QueuedConnection);
+}
+
+Ft260EmulatorStats Ft260Emulator::stats() const
+{
+    QMutexLocker locker(&statsMutex_);
+    return stats_;
+}
+
+void Ft260Emulator::resetStats()
+{
+    QMutexLocker locker(&statsMutex_);
+    stats_ = Ft260EmulatorStats();
+}
+
+bool Ft260Emulator::open()
+{
+    if (open_) { return true; }
+
+    wallClock_.start();
+    sensor_->reset();
+    busStatus_ = FT260_I2C_STATUS_CONTROLLER_IDLE;
+    interruptAsserted_ = false;
+    open_ = true;
+
+    qDebug() << "Emulated FT260 opened";
+    emit connectionOpened();
+
+    return true;
+}
+
+void Ft260Emulator::close()
+{
+    sensorTimer_->stop();
+    if (open_) {
+        open_ = false;
+        emit connectionClosed();
+    }
+}
+
+bool Ft260Emulator::chipVersion(Ft260ChipVersion *chipVersion)
+{
+    if (!open_) { return false; }
+
+    chargeReports(1, 1, false);
+
+    if (chipVersion) {
+        chipVersion->chip[0] = 0x02;
+        chipVersion->chip[1] = 0x60;
+        chipVersion->major = 1;
+        chipVersion->minor = 0;
+    }
+    return true;
+}
+
+Ft260SystemClock Ft260Emulator::systemClock() const
+{
+    return FT260_CLOCK_48MHZ;
+}
+
+bool Ft260Emulator::i2cStatus(uint8_t *busStatus, uint16_t *speed)
+{
+    if (!open_) { return false; }
+
+    chargeReports(1, 1, false);
+
+    if (busStatus) { *busStatus = busStatus_; }
+    if (speed) { *speed = busSpeed_; }
+    return true;
+}
+
+bool Ft260Emulator::setI2cClockSpeed(uint16_t speed)
+{
+    if (!open_) { return false; }
+
+    chargeReports(1, 0, false);
+    busSpeed_ = speed;
+    return true;
+}
+
+bool Ft260Emulator::setUartMode(quint8 mode)
+{
+    Q_UNUSED(mode)
+    if (!open_) { return false; }
+
+    chargeReports(1, 0, false);
+    return true;
+}
+
+bool Ft260Emulator::setUartEnableDcdRi(bool enable)
+{
+    Q_UNUSED(enable)
+    if (!open_) { return false; }
+
+    chargeReports(1, 0, false);
+    return true;
+}
+
+bool Ft260Emulator::setUartEnableRiWakeup(bool enable)
+{
+    Q_UNUSED(enable)
+    if (!open_) { return false; }
+
+    chargeReports(1, 0, false);
+    return true;
+}
+
+bool Ft260Emulator::setUartRiWakeupConfig(bool edge)
+{
+    Q_UNUSED(edge)
+    if (!open_) { return false; }
+
+    chargeReports(1, 0, false);
+    return true;
+}
+
+bool Ft260Emulator::gpioRead(Ft260GpioReport *report)
+{
+    if (!open_ || !report) { return false; }
+
+    chargeReports(1, 1, false);
+    *report = gpioReport_;
+    return true;
+}
+
+bool Ft260Emulator::gpioWrite(const Ft260GpioReport *report)
+{
+    if (!open_ || !report) { return false; }
+
+    chargeReports(1, 0, false);
+
+    // Bring the sensor up to date before the light level changes
+    updateSensor();
+    gpioReport_ = *report;
+    return true;
+}
+
+QByteArray Ft260Emulator::i2cRead(quint8 addr, quint8 reg, quint8 len)
+{
+    if (!open_ || len == 0 || len > HID_MAX_TRAN_SIZE) { return QByteArray(); }
+
+    Ft260I2cOp op = Ft260I2cOp::read(addr, reg, len);
+    int outReports;
+    int inReports;
+    opReports(op, &outReports, &inReports);
+    chargeReports(outReports, inReports, false);
+
+    if (!performOp(op)) { return QByteArray(); }
+    return op.data;
+}
+
+bool Ft260Emulator::i2cReadByte(quint8 addr, quint8 reg, quint8 *data)
+{
+    const QByteArray result = i2cRead(addr, reg, 1);
+    if (result.isEmpty()) { return false; }
+
+    if (data) { *data = static_cast<quint8>(result[0]); }
+    return true;
+}
+
+bool Ft260Emulator::i2cReadRawByte(quint8 addr, quint8 *data)
+{
+    if (!open_) { return false; }
+
+    Ft260I2cOp op = Ft260I2cOp::readRaw(addr, 1);
+    chargeReports(1, 1, false);
+
+    if (!performOp(op)) { return false; }
+
+    if (data) { *data = static_cast<quint8>(op.data[0]); }
+    return true;
+}
+
+bool Ft260Emulator::i2cWrite(quint8 addr, quint8 reg, const QByteArray &data)
+{
+    if (!open_ || data.isEmpty() || data.size() > HID_MAX_TRAN_SIZE) { return false; }
+
+    Ft260I2cOp op = Ft260I2cOp::write(addr, reg, data);
+    int outReports;
+    int inReports;
+    opReports(op, &outReports, &inReports);
+    chargeReports(outReports, inReports, false);
+
+    return performOp(op);
+}
+
+bool Ft260Emulator::i2cWriteByte(quint8 addr, quint8 reg, quint8 data)
+{
+    return i2cWrite(addr, reg, QByteArray(1, static_cast<char>(data)));
+}
+
+bool Ft260Emulator::i2cWriteRawByte(quint8 addr, quint8 data)
+{
+    if (!open_) { return false; }
+
+    Ft260I2cOp op = Ft260I2cOp::writeRaw(addr, QByteArray(1, static_cast<char>(data)));
+    chargeReports(1, 0, false);
+
+    return performOp(op);
+}
+
+bool Ft260Emulator::i2cTransaction(QList<Ft260I2cOp> &ops)
+{
+    if (!open_) { return false; }
+    if (ops.isEmpty()) { return true; }
+
+    int outReports = 0;
+    int inReports = 0;
+    for (const Ft260I2cOp &op : std::as_const(ops)) {
+        if ((op.type == Ft260I2cOp::Read || op.type == Ft260I2cOp::ReadRaw)
+            && (op.len == 0 || op.len > HID_MAX_TRAN_SIZE)) {
+            return false;
+        }
+        if ((op.type == Ft260I2cOp::Write || op.type == Ft260I2cOp::WriteRaw)
+            && (op.data.isEmpty() || op.data.size() > HID_MAX_TRAN_SIZE)) {
+            return false;
+        }
+        int out;
+        int in;
+        opReports(op, &out, &in);
+        outReports += out;
+        inReports += in;
+    }
+
+    chargeReports(outReports, inReports, true);
+
+    for (Ft260I2cOp &op : ops) {
+        if (!performOp(op)) { return false; }
+    }
+    return true;
+}
+
+void Ft260Emulator::onSensorTimeout()
+{
+    if (realTime_) {
+        updateSensor();
+    } else {
+        stepClock();
+    }
+}
+
+bool Ft260Emulator::performOp(Ft260I2cOp &op)
+{
+    const qint64 now = clockUs();
+    const bool isRead = (op.type == Ft260I2cOp::Read || op.type == Ft260I2cOp::ReadRaw);
+    bool ack = true;
+
+    busStatus_ = FT260_I2C_STATUS_CONTROLLER_IDLE;
+
+    if (op.addr == TSL2585_ADDRESS) {
+        updateSensor();
+        switch (op.type) {
+        case Ft260I2cOp::Read:
+            op.data = sensor_->read(op.reg, op.len);
+            break;
+        case Ft260I2cOp::Write:
+            sensor_->write(op.reg, op.data, now);
+            break;
+        case Ft260I2cOp::ReadRaw:
+            op.data = sensor_->readCurrent(op.len);
+            break;
+        case Ft260I2cOp::WriteRaw:
+            sensor_->write(static_cast<uint8_t>(op.data[0]), op.data.mid(1), now);
+            break;
+        }
+        updateSensor();
+    } else if ((op.addr & 0xFC) == EEPROM_ADDRESS) {
+        if (eeprom_->busy(now)) {
+            ack = false;
+            QMutexLocker locker(&statsMutex_);
+            stats_.eepromNacks++;
+        } else {
+            switch (op.type) {
+            case Ft260I2cOp::Read:
+                eeprom_->setPointer(op.addr, op.reg);
+                op.data = eeprom_->readCurrent(op.len);
+                break;
+            case Ft260I2cOp::Write:
+                eeprom_->write(op.addr, op.reg, op.data, now);
+                {
+                    QMutexLocker locker(&statsMutex_);
+                    stats_.eepromWriteCycles++;
+                }
+                break;
+            case Ft260I2cOp::ReadRaw:
+                op.data = eeprom_->readCurrent(op.len);
+                break;
+            case Ft260I2cOp::WriteRaw:
+                // A lone address byte only moves the address pointer
+                if (op.data.size() == 1) {
+                    eeprom_->setPointer(op.addr, static_cast<uint8_t>(op.data[0]));
+                } else {
+                    eeprom_->write(op.addr, static_cast<uint8_t>(op.data[0]), op.data.mid(1), now);
+                    QMutexLocker locker(&statsMutex_);
+                    stats_.eepromWriteCycles++;
+                }
+                break;
+            }
+        }
+    } else if (op.addr == MCP4017_ADDRESS) {
+        if (op.type == Ft260I2cOp::ReadRaw) {
+            op.data = QByteArray(op.len, static_cast<char>(potValue_));
+        } else if (op.type == Ft260I2cOp::WriteRaw) {
+            updateSensor();
+            potValue_ = static_cast<quint8>(op.data.back()) & MCP4017_MAX_VALUE;
+        } else {
+            ack = false;
+        }
+    } else {
+        ack = false;
+    }
+
+    if (!ack) {
+        busStatus_ = FT260_I2C_STATUS_CONTROLLER_IDLE | FT260_I2C_STATUS_ERROR | FT260_I2C_STATUS_ADDRESS_NACK;
+
+        // Writes are not acknowledged by the bridge, so a missing device
+        // is only noticed directly by reads, like on the real thing
+        if (isRead) {
+            op.data.clear();
+            return false;
+        }
+        return true;
+    }
+
+    QMutexLocker locker(&statsMutex_);
+    stats_.i2cOperations++;
+    if (isRead) {
+        stats_.bytesRead += op.data.size();
+    } else {
+        stats_.bytesWritten += op.data.size();
+    }
+    return true;
+}
+
+void Ft260Emulator::chargeReports(int outReports, int inReports, bool batched)
+{
+    // Unbatched requests wait for each response before sending the next
+    // report, while a batch keeps the endpoints busy in both directions
+    // and only pays for one extra report of turnaround at the end.
+    int frames;
+    if (batched && inReports > 0) {
+        frames = qMax(outReports, inReports) + 1;
+    } else {
+        frames = outReports + inReports;
+    }
+    const qint64 usec = static_cast<qint64>(frames) * reportTimeUs_;
+
+    {
+        QMutexLocker locker(&statsMutex_);
+        stats_.transactions++;
+        stats_.reports += outReports + inReports;
+        stats_.busTimeUs += usec;
+    }
+
+    if (usec > 0) {
+        if (realTime_) {
+            QThread::usleep(static_cast<unsigned long>(usec));
+        } else {
+            virtualClockUs_ += usec;
+        }
+    }
+}
+
+void Ft260Emulator::opReports(const Ft260I2cOp &op, int *outReports, int *inReports) const
+{
+    switch (op.type) {
+    case Ft260I2cOp::Read:
+        // Register address write, then the read request
+        *outReports = 2;
+        *inReports = (op.len + HID_MAX_TRAN_SIZE - 1) / HID_MAX_TRAN_SIZE;
+        break;
+    case Ft260I2cOp::ReadRaw:
+        *outReports = 1;
+        *inReports = (op.len + HID_MAX_TRAN_SIZE - 1) / HID_MAX_TRAN_SIZE;
+        break;
+    case Ft260I2cOp::Write:
+        *outReports = 1 + ((op.data.size() + HID_MAX_TRAN_SIZE - 1) / HID_MAX_TRAN_SIZE);
+        *inReports = 0;
+        break;
+    case Ft260I2cOp::WriteRaw:
+        *outReports = (op.data.size() + HID_MAX_TRAN_SIZE - 1) / HID_MAX_TRAN_SIZE;
+        *inReports = 0;
+        break;
+    }
+}
+
+void Ft260Emulator::updateSensor()
+{
+    if (!open_) { return; }
+
+    const int cycles = sensor_->advance(clockUs(), sensorLight());
+    const bool pending = sensor_->interruptPending();
+
+    {
+        QMutexLocker locker(&statsMutex_);
+        stats_.sensorCycles += cycles;
+        stats_.fifoOverflows = sensor_->overflows();
+        if (pending && !interruptAsserted_) {
+            stats_.interrupts++;
+        }
+    }
+
+    // The interrupt line is edge triggered, and is always delivered
+    // through the event loop so it never lands in the middle of a request
+    if (pending && !interruptAsserted_) {
+        QMetaObject::invokeMethod(this, [this]() {
+            if (open_) {
+                emit sensorInterrupt();
+            }
+        }, Qt::QueuedConnection);
+    }
+    interruptAsserted_ = pending;
+
+    scheduleSensor();
+}
+
+void Ft260Emulator::scheduleSensor()
+{
+    if (!realTime_ && !idleAdvance_) { return; }
+
+    const qint64 next = sensor_->nextCycleTime();
+    if (next < 0) {
+        sensorTimer_->stop();
+        return;
+    }
+
+    // A zero timeout only fires once everything already queued to the
+    // event loop has been handled, which is the idle point to step from
+    if (!realTime_) {
+        if (!sensorTimer_->isActive()) {
+            sensorTimer_->start(0);
+        }
+        return;
+    }
+
+    const qint64 delayUs = qMax<qint64>(0, next - clockUs());
+    sensorTimer_->start(static_cast<int>((delayUs + 999) / 1000));
+}
+
+double Ft260Emulator::sensorLight() const
+{
+    double level = ambientLevel_;
+
+    if ((gpioReport_.gpio_ex_value & 0x80) != 0) {
+        // LED current follows the potentiometer setting the same way as
+        // in DensiStickInterface::lightCurrent(), relative to full current
+        const double rSet = 0.075 + ((potValue_ / 127.0) * 100.0) + 16.5;
+        const double rSetMin = 0.075 + 16.5;
+        level += lightLevel_ * ((rSetMin - 0.139) / (rSet - 0.139));
+    }
+
+    return level;
+}
+
+QList<Ft260DeviceInfo> listDevicesByEmulator()
+{
+    QList<Ft260DeviceInfo> list;
+    if (!Ft260Emulator::isEnabled()) {
+        return list;
+    }
+
+    Ft260DeviceInfoPrivate privDevice;
+    privDevice.devicePath = QLatin1String("emulator:0");
+    privDevice.deviceDisplayPath = privDevice.devicePath;
+    privDevice.deviceDriver = Ft260DeviceInfo::DriverEmulator;
+    privDevice.vendorId = 0x16D0;
+    privDevice.productId = 0x1382;
+    privDevice.manufacturer = QLatin1String("Dektronics");
+    privDevice.product = QLatin1String("Printalyzer DensiStick");
+    privDevice.serialNumber = QLatin1String("EMULATED");
+    privDevice.description = QString("%1 (%2)").arg(privDevice.product, privDevice.serialNumber);
+    list.append(privDevice);
+
+    return list;
+}
+
+QList<Ft260DeviceInfo> Ft260Emulator::listDevices()
+{
+    return listDevicesByEmulator();
+}
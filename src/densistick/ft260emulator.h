@@ -0,0 +1,165 @@
+#ifndef FT260EMULATOR_H
+#define FT260EMULATOR_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <atomic>
+#include <memory>
+
+#include "ft260.h"
+
+class QTimer;
+class Tsl2585Model;
+class M24c08Model;
+
+/**
+ * Counters kept by the emulator, for measuring how much bus traffic
+ * a piece of code generates.
+ */
+struct Ft260EmulatorStats
+{
+    quint64 transactions = 0;   /*!< Round trips to the bridge, where a batch counts once */
+    quint64 i2cOperations = 0;  /*!< Individual I2C reads and writes */
+    quint64 reports = 0;        /*!< HID reports in either direction */
+    quint64 bytesRead = 0;
+    quint64 bytesWritten = 0;
+    quint64 busTimeUs = 0;      /*!< Modeled time spent waiting on USB */
+    quint64 interrupts = 0;
+    quint64 sensorCycles = 0;
+    quint64 fifoOverflows = 0;
+    quint64 eepromWriteCycles = 0;
+    quint64 eepromNacks = 0;
+};
+
+/**
+ * Software stand-in for an FT260 with a DensiStick attached to it.
+ *
+ * The I2C register maps of the TSL2585 light sensor, the M24C08 EEPROM
+ * and the MCP4017 LED current potentiometer are emulated closely enough
+ * to run the complete DensiStick stack, including FIFO records, AGC,
+ * sensor interrupts and EEPROM write cycle polling.
+ *
+ * Every request is charged the time it would take as HID reports on a
+ * full-speed USB interrupt endpoint. In real-time mode, the emulator
+ * actually waits for that long and the sensor runs off the wall clock.
+ * Otherwise, time only moves forward as the bus is used or through
+ * advanceClock() and stepClock(), which makes every run fully repeatable.
+ * With setIdleAdvance(), the virtual clock also skips ahead to the next
+ * sensor cycle whenever the emulator's thread has nothing else to do.
+ */
+class Ft260Emulator : public Ft260
+{
+    Q_OBJECT
+public:
+    explicit Ft260Emulator(const Ft260DeviceInfo &device, QObject *parent = nullptr);
+    virtual ~Ft260Emulator();
+
+    /** Make the emulated device show up in Ft260::listDevices() */
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+    static QList<Ft260DeviceInfo> listDevices();
+
+    /** Light reaching the sensor with the LED on at full current, in counts per ms at 1x gain */
+    void setLightLevel(double level);
+    double lightLevel() const;
+
+    /** Light reaching the sensor regardless of the LED, in counts per ms at 1x gain */
+    void setAmbientLevel(double level);
+    double ambientLevel() const;
+
+    /** Time taken by each HID report, in microseconds */
+    void setReportTime(int usec);
+    int reportTime() const;
+
+    /** Must be set before the emulator is opened */
+    void setRealTime(bool realTime);
+    bool realTime() const;
+
+    /** Preload the EEPROM contents, which are otherwise blank apart from a settings header */
+    void setEepromContents(const QByteArray &data);
+    QByteArray eepromContents() const;
+
+    /**
+     * Jump the virtual clock to the end of each sensor cycle once the
+     * event loop is idle, so code waiting on sensor interrupts still
+     * gets them without any bus traffic. Must be set before opening.
+     */
+    void setIdleAdvance(bool enabled);
+    bool idleAdvance() const;
+
+    /** Move the emulated clock forward, running the sensor for that long */
+    void advanceClock(qint64 usec);
+
+    /**
+     * Move the virtual clock to the end of the current sensor cycle,
+     * returning how far it went, or 0 if the sensor is not running.
+     */
+    qint64 stepClock();
+
+    /** Current emulated time, which may be read from any thread */
+    qint64 clockUs() const;
+
+    void setButtonPressed(bool pressed);
+
+    Ft260EmulatorStats stats() const;
+    void resetStats();
+
+    bool open();
+    void close();
+
+    bool chipVersion(Ft260ChipVersion *chipVersion);
+    Ft260SystemClock systemClock() const;
+
+    bool i2cStatus(uint8_t *busStatus, uint16_t *speed);
+    bool setI2cClockSpeed(uint16_t speed);
+
+    bool setUartMode(quint8 mode);
+    bool setUartEnableDcdRi(bool enable);
+    bool setUartEnableRiWakeup(bool enable);
+    bool setUartRiWakeupConfig(bool edge);
+
+    bool gpioRead(Ft260GpioReport *report);
+    bool gpioWrite(const Ft260GpioReport *report);
+
+    QByteArray i2cRead(quint8 addr, quint8 reg, quint8 len);
+    bool i2cReadByte(quint8 addr, quint8 reg, quint8 *data);
+    bool i2cReadRawByte(quint8 addr, quint8 *data);
+    bool i2cWrite(quint8 addr, quint8 reg, const QByteArray &data);
+    bool i2cWriteByte(quint8 addr, quint8 reg, quint8 data);
+    bool i2cWriteRawByte(quint8 addr, quint8 data);
+
+    bool i2cTransaction(QList<Ft260I2cOp> &ops);
+
+private slots:
+    void onSensorTimeout();
+
+private:
+    bool performOp(Ft260I2cOp &op);
+    void chargeReports(int outReports, int inReports, bool batched);
+    void opReports(const Ft260I2cOp &op, int *outReports, int *inReports) const;
+    void updateSensor();
+    void scheduleSensor();
+    double sensorLight() const;
+
+    std::unique_ptr<Tsl2585Model> sensor_;
+    std::unique_ptr<M24c08Model> eeprom_;
+    QTimer *sensorTimer_;
+    QElapsedTimer wallClock_;
+    std::atomic<qint64> virtualClockUs_ = 0;
+    bool realTime_ = true;
+    bool idleAdvance_ = false;
+    bool open_ = false;
+    std::atomic<int> reportTimeUs_;
+    std::atomic<double> lightLevel_;
+    std::atomic<double> ambientLevel_;
+    std::atomic<bool> buttonPressed_ = false;
+    Ft260GpioReport gpioReport_ = {0, 0, 0, 0};
+    quint8 potValue_ = 0x40;
+    uint8_t busStatus_ = FT260_I2C_STATUS_CONTROLLER_IDLE;
+    uint16_t busSpeed_ = 100;
+    bool interruptAsserted_ = false;
+    mutable QMutex statsMutex_;
+    Ft260EmulatorStats stats_;
+};
+
+#endif // FT260EMULATOR_H
@@ -12,10 +12,10 @@
 
 #include "ft260deviceinfo.h"
 #include "ft260deviceinfo_p.h"
+#include "../metrics.h"
+#include "../trace.h"
 
-#define HID_MAX_TRAN_SIZE 0x3C
 #define HID_OFFSET_BYTES  0x04
-#define REQUEST_BUF_SIZE  64
 
 namespace
 {
@@ -43,6 +43,12 @@ typedef enum {
     FT260_I2C_STOP           = 0x04,
     FT260_I2C_START_AND_STOP = 0x06
 } FT260_I2C_COMMAND;
+
+MetricCounter &transferErrors()
+{
+    static MetricCounter &counter = Metrics::counter(QStringLiteral("ft260.usb.transfer_errors"));
+    return counter;
+}
 }
 
 Ft260HidApi::Ft260HidApi(const Ft260DeviceInfo &device, QObject *parent) : Ft260(device, parent)
@@ -159,6 +165,7 @@ bool Ft260HidApi::open()
             if (nbytes == 0) { continue; }
             else if (nbytes < 0) {
                 qWarning() << "hid_read_timeout error:" << QString::fromWCharArray(hid_error(handle_[1]));
+                transferErrors().add();
                 break;
             }
 
@@ -252,6 +259,7 @@ bool Ft260HidApi::chipVersion(Ft260ChipVersion *chipVersion)
 
         if (ret < 0) {
             qWarning() << "chipVersion hid_get_feature_report error:" << QString::fromWCharArray(hid_error(handle_[0]));
+            transferErrors().add();
             return false;
         }
 
@@ -285,6 +293,7 @@ bool Ft260HidApi::systemStatus()
 
     if (ret < 0) {
         qWarning() << "systemStatus hid_get_feature_report error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
         return false;
     }
 
@@ -366,6 +375,7 @@ bool Ft260HidApi::i2cStatus(uint8_t *busStatus, uint16_t *speed)
 
     if (ret < 0) {
         qWarning() << "i2cStatus hid_get_feature_report error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
         return false;
     }
 
@@ -396,6 +406,7 @@ bool Ft260HidApi::setI2cClockSpeed(uint16_t speed)
 
     if (ret < 0) {
         qWarning() << "setI2cClockSpeed hid_send_feature_report error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
         return false;
     }
 
@@ -425,6 +436,7 @@ bool Ft260HidApi::setUartMode(quint8 mode)
 
     if (ret < 0) {
         qWarning() << "setUartMode hid_send_feature_report error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
         return false;
     }
 
@@ -446,6 +458,7 @@ bool Ft260HidApi::setUartEnableDcdRi(bool enable)
 
     if (ret < 0) {
         qWarning() << "setUartEnableDcdRi hid_send_feature_report error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
         return false;
     }
 
@@ -467,6 +480,7 @@ bool Ft260HidApi::setUartEnableRiWakeup(bool enable)
 
     if (ret < 0) {
         qWarning() << "setUartEnableRiWakeup hid_send_feature_report error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
         return false;
     }
 
@@ -488,6 +502,7 @@ bool Ft260HidApi::setUartRiWakeupConfig(bool edge)
 
     if (ret < 0) {
         qWarning() << "setUartRiWakeupConfig hid_send_feature_report error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
         return false;
     }
 
@@ -508,6 +523,7 @@ bool Ft260HidApi::gpioRead(Ft260GpioReport *report)
 
     if (ret < 0) {
         qWarning() << "gpioRead hid_get_feature_report error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
         return false;
     }
 
@@ -537,6 +553,7 @@ bool Ft260HidApi::gpioWrite(const Ft260GpioReport *report)
     ret = hid_send_feature_report(handle_[0], buf, sizeof(buf));
     if (ret < 0) {
         qWarning() << "gpioWrite hid_send_feature_report error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
         return false;
     }
 
@@ -548,24 +565,16 @@ bool Ft260HidApi::i2cWriteRequest(quint8 addr, uint8_t flags, const uint8_t *pay
     int ret;
     uint8_t buf[REQUEST_BUF_SIZE];
 
-    if (payloadSize == 0 || payloadSize > 60) {
-        return 0;
+    const int transferLen = fillI2cWriteRequest(buf, addr, flags, payload, payloadSize);
+    if (transferLen == 0) {
+        return false;
     }
-    const uint8_t reportId = 0xD0 + ((payloadSize - 1) >> 2);
-
-    const uint8_t transferLen = ((reportId - 0xD0 + 1) * 4) + 4;
-
-    memset(buf, 0, REQUEST_BUF_SIZE);
-    buf[0] = reportId;
-    buf[1] = addr;
-    buf[2] = flags;
-    buf[3] = payloadSize;
-    memcpy(buf + 4, payload, payloadSize);
 
     ret = hid_write(handle_[0], (unsigned char*)buf, transferLen);
 
     if (ret < 0) {
         qWarning() << "i2cWriteRequest hid_write error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
         return false;
     }
 
@@ -577,17 +586,13 @@ bool Ft260HidApi::i2cReadRequest(quint8 addr, uint8_t flags, quint16 payloadSize
     int ret;
     uint8_t buf[REQUEST_BUF_SIZE];
 
-    memset(buf, 0, REQUEST_BUF_SIZE);
-    buf[0] = HID_REPORT_FT260_I2C_READ_REQUEST;
-    buf[1] = addr;
-    buf[2] = flags;
-    buf[3] = payloadSize & 0x00FF;
-    buf[4] = (payloadSize & 0xFF00) >> 8;
+    const int transferLen = fillI2cReadRequest(buf, addr, flags, payloadSize);
 
-    ret = hid_write(handle_[0], (unsigned char*)buf, 5);
+    ret = hid_write(handle_[0], (unsigned char*)buf, transferLen);
 
     if (ret < 0) {
         qWarning() << "i2cReadRequest hid_write error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
         return false;
     }
 
@@ -596,6 +601,7 @@ bool Ft260HidApi::i2cReadRequest(quint8 addr, uint8_t flags, quint16 payloadSize
 
 QByteArray Ft260HidApi::i2cRead(quint8 addr, quint8 reg, quint8 len)
 {
+    TRACE_SCOPE("Ft260HidApi::i2cRead");
     if (!handle_[0] || addr > 0x7F || len == 0) { return QByteArray(); }
 
     int ret;
@@ -613,6 +619,7 @@ QByteArray Ft260HidApi::i2cRead(quint8 addr, quint8 reg, quint8 len)
 
     if (ret < 0) {
         qWarning() << "i2cRead hid_read error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
     }
 
     if (len != buf[1]) {
@@ -636,6 +643,7 @@ bool Ft260HidApi::i2cReadByte(quint8 addr, quint8 reg, quint8 *data)
 
 bool Ft260HidApi::i2cReadRawByte(quint8 addr, quint8 *data)
 {
+    TRACE_SCOPE("Ft260HidApi::i2cReadRawByte");
     if (!handle_[0] || addr > 0x7F) { return false; }
 
     int ret;
@@ -649,6 +657,7 @@ bool Ft260HidApi::i2cReadRawByte(quint8 addr, quint8 *data)
 
     if (ret < 0) {
         qWarning() << "i2cRead hid_read error:" << QString::fromWCharArray(hid_error(handle_[0]));
+        transferErrors().add();
     }
 
     if (buf[1] != 1) {
@@ -665,6 +674,7 @@ bool Ft260HidApi::i2cReadRawByte(quint8 addr, quint8 *data)
 
 bool Ft260HidApi::i2cWrite(quint8 addr, quint8 reg, const QByteArray &data)
 {
+    TRACE_SCOPE("Ft260HidApi::i2cWrite");
     if (!handle_[0] || addr > 0x7F || data.isEmpty() || data.size() > HID_MAX_TRAN_SIZE) { return false; }
 
     if (!i2cWriteRequest(addr, FT260_I2C_START, &reg, 1)) {
@@ -687,6 +697,7 @@ bool Ft260HidApi::i2cWriteByte(quint8 addr, quint8 reg, quint8 data)
 
 bool Ft260HidApi::i2cWriteRawByte(quint8 addr, quint8 data)
 {
+    TRACE_SCOPE("Ft260HidApi::i2cWriteRawByte");
     if (!handle_[0] || addr > 0x7F) { return false; }
 
     uint8_t buf;
@@ -700,6 +711,84 @@ bool Ft260HidApi::i2cWriteRawByte(quint8 addr, quint8 data)
     return true;
 }
 
+bool Ft260HidApi::i2cTransaction(QList<Ft260I2cOp> &ops)
+{
+    TRACE_SCOPE("Ft260HidApi::i2cTransaction");
+    if (!handle_[0]) { return false; }
+
+    for (const Ft260I2cOp &op : std::as_const(ops)) {
+        if (op.addr > 0x7F) { return false; }
+        if (op.type == Ft260I2cOp::Read || op.type == Ft260I2cOp::ReadRaw) {
+            if (op.len == 0 || op.len > HID_MAX_TRAN_SIZE) { return false; }
+        } else {
+            if (op.data.isEmpty() || op.data.size() > HID_MAX_TRAN_SIZE) { return false; }
+        }
+    }
+
+    qsizetype first = 0;
+    while (first < ops.size()) {
+        // Write out all the requests in the batch before collecting any of
+        // the responses, so the bridge never sits idle waiting on the host.
+        qsizetype count = 0;
+        int reads = 0;
+        while (first + count < ops.size()) {
+            const Ft260I2cOp &op = ops[first + count];
+            if (op.type == Ft260I2cOp::Read) {
+                if (reads == I2C_BATCH_MAX_READS) { break; }
+                if (!i2cWriteRequest(op.addr, FT260_I2C_START, &op.reg, 1)) {
+                    return false;
+                }
+                if (!i2cReadRequest(op.addr, FT260_I2C_REPEATED_START | FT260_I2C_STOP, op.len)) {
+                    return false;
+                }
+                reads++;
+            } else if (op.type == Ft260I2cOp::ReadRaw) {
+                if (reads == I2C_BATCH_MAX_READS) { break; }
+                if (!i2cReadRequest(op.addr, FT260_I2C_START_AND_STOP, op.len)) {
+                    return false;
+                }
+                reads++;
+            } else if (op.type == Ft260I2cOp::WriteRaw) {
+                if (!i2cWriteRequest(op.addr, FT260_I2C_START_AND_STOP, reinterpret_cast<const uint8_t *>(op.data.constData()), op.data.size())) {
+                    return false;
+                }
+            } else {
+                if (!i2cWriteRequest(op.addr, FT260_I2C_START, &op.reg, 1)) {
+                    return false;
+                }
+                if (!i2cWriteRequest(op.addr, FT260_I2C_STOP, reinterpret_cast<const uint8_t *>(op.data.constData()), op.data.size())) {
+                    return false;
+                }
+            }
+            count++;
+        }
+
+        for (qsizetype i = first; i < first + count; i++) {
+            Ft260I2cOp &op = ops[i];
+            if (op.type != Ft260I2cOp::Read && op.type != Ft260I2cOp::ReadRaw) { continue; }
+
+            uint8_t buf[REQUEST_BUF_SIZE];
+            const int ret = hid_read_timeout(handle_[0], buf, sizeof(buf), 5000);
+            if (ret < 0) {
+                qWarning() << "i2cTransaction hid_read error:" << QString::fromWCharArray(hid_error(handle_[0]));
+                transferErrors().add();
+                return false;
+            }
+
+            if (ret < op.len + 2 || buf[1] != op.len) {
+                qWarning() << "Unexpected size returned:" << (ret >= 2 ? buf[1] : 0) << "!=" << op.len;
+                return false;
+            }
+
+            op.data = QByteArray(reinterpret_cast<const char *>(buf + 2), op.len);
+        }
+
+        first += count;
+    }
+
+    return true;
+}
+
 QList<Ft260DeviceInfo> listDevicesByHidApi()
 {
     QList<Ft260DeviceInfo> list;
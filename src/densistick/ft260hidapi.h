@@ -39,6 +39,8 @@ public:
     bool i2cWriteByte(quint8 addr, quint8 reg, quint8 data);
     bool i2cWriteRawByte(quint8 addr, quint8 data);
 
+    bool i2cTransaction(QList<Ft260I2cOp> &ops);
+
     static QList<Ft260DeviceInfo> listDevices();
 
 private slots:
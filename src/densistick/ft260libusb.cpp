@@ -2,16 +2,17 @@
 
 #include <QThread>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QDebug>
 
 #include <libusb-1.0/libusb.h>
 
 #include "ft260deviceinfo.h"
 #include "ft260deviceinfo_p.h"
+#include "../metrics.h"
+#include "../trace.h"
 
-#define HID_MAX_TRAN_SIZE 0x3C
 #define HID_OFFSET_BYTES  0x04
-#define REQUEST_BUF_SIZE  64
 
 namespace
 {
@@ -39,6 +40,26 @@ typedef enum {
     FT260_I2C_STOP           = 0x04,
     FT260_I2C_START_AND_STOP = 0x06
 } FT260_I2C_COMMAND;
+
+bool isI2cReadOp(const Ft260I2cOp &op)
+{
+    return op.type == Ft260I2cOp::Read || op.type == Ft260I2cOp::ReadRaw;
+}
+
+// Time allowed for a batch of read requests to be answered
+static const int I2C_READ_TIMEOUT = 5000;
+
+// Time allowed for a single output report to be accepted
+static const unsigned int OUTPUT_TRANSFER_TIMEOUT = 1000;
+
+// Consecutive event handling errors before the event loop gives up
+static const int EVENT_ERROR_LIMIT = 10;
+
+MetricCounter &transferErrors()
+{
+    static MetricCounter &counter = Metrics::counter(QStringLiteral("ft260.usb.transfer_errors"));
+    return counter;
+}
 }
 
 #if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000108)
@@ -47,6 +68,19 @@ typedef enum {
 #define LIBUSB_STRERROR(x) libusb_strerror(static_cast<enum libusb_error>(x))
 #endif
 
+struct Ft260LibUsb::EventCallbacks
+{
+    static void LIBUSB_CALL inputTransferCallback(struct libusb_transfer *transfer)
+    {
+        static_cast<Ft260LibUsb *>(transfer->user_data)->handleInputTransfer(transfer);
+    }
+
+    static void LIBUSB_CALL outputTransferCallback(struct libusb_transfer *transfer)
+    {
+        static_cast<Ft260LibUsb *>(transfer->user_data)->handleOutputTransfer(transfer);
+    }
+};
+
 Ft260LibUsb::Ft260LibUsb(const Ft260DeviceInfo &device, QObject *parent) : Ft260(device, parent)
 {
     int r;
@@ -248,56 +282,10 @@ bool Ft260LibUsb::open()
         return false;
     }
 
-    thread_ = QThread::create([this] {
-        const qint64 startTime = QDateTime::currentMSecsSinceEpoch();
-        bool started = false;
-        int r = 0;
-        uint8_t buf[128];
-        int nbytes;
-        bool button_pressed = false;
-        do {
-            r = libusb_interrupt_transfer(handle_[1], inputEp_[1], buf, qMin(sizeof(buf), inputEpMaxPacketSize_[1]), &nbytes, 100);
-            if (r == LIBUSB_ERROR_TIMEOUT) { r = 0; continue; }
-            else if (r < 0) {
-                qWarning() << "libusb_interrupt_transfer error:" << LIBUSB_STRERROR(r);
-                break;
-            }
-
-            // Ignore any data received in the first second since starting
-            if (!started) {
-                if (QDateTime::currentMSecsSinceEpoch() > startTime + 1000) {
-                    started = true;
-                } else {
-                    continue;
-                }
-            }
-
-            if (nbytes == 3 && buf[0] == 0xB1) {
-                const uint8_t status_int = buf[1];
-                const uint8_t status_dcd_ri = buf[2];
-
-#if 0
-                qDebug().nospace() << Qt::hex
-                                   << "status_int=" << status_dcd_ri << ", status_dcd_ri=" << status_dcd_ri;
-#endif
-                if (status_int & 0x01) {
-                    emit sensorInterrupt();
-                }
-                if (status_dcd_ri & 0x04) {
-                    const bool pressed = (status_dcd_ri & 0x08) == 0;
-                    if (button_pressed != pressed) {
-                        button_pressed = pressed;
-                        emit buttonInterrupt(pressed);
-                    }
-                }
-            } else {
-                qDebug() << Qt::hex << QByteArray::fromRawData((const char *)buf, nbytes);
-            }
-        } while (r >= 0);
-        qWarning() << "Fell out of loop";
-    });
-    connect(thread_, &QThread::finished, this, &Ft260LibUsb::onIntThreadFinished);
-    thread_->start();
+    if (!startEventThread()) {
+        close();
+        return false;
+    }
 
     connected_ = true;
     emit connectionOpened();
@@ -307,9 +295,7 @@ bool Ft260LibUsb::open()
 
 void Ft260LibUsb::close()
 {
-    if (thread_ && thread_->isRunning()) {
-        disconnect(thread_, &QThread::finished, this, &Ft260LibUsb::onIntThreadFinished);
-    }
+    stopEventThread();
 
     for (int i = 0; i < 2; i++) {
         if (handle_[i]) {
@@ -321,17 +307,480 @@ void Ft260LibUsb::close()
             outputEp_[i] = 0;
         }
     }
-    if (thread_) {
-        thread_->wait();
-        thread_->deleteLater();
-        thread_ = nullptr;
-    }
     if (connected_) {
         connected_ = false;
         emit connectionClosed();
     }
 }
 
+bool Ft260LibUsb::startEventThread()
+{
+    QMutexLocker locker(&mutex_);
+
+    closing_ = false;
+    eventError_ = false;
+    staleReads_ = 0;
+    buttonPressed_ = false;
+    startTime_ = QDateTime::currentMSecsSinceEpoch();
+
+    // Keep an input transfer permanently armed on each interface, so
+    // responses and interrupts are picked up the moment they arrive.
+    for (int i = 0; i < 2; i++) {
+        if (!handle_[i] || inputEp_[i] == 0) { continue; }
+
+        libusb_transfer *transfer = libusb_alloc_transfer(0);
+        if (!transfer) {
+            eventError_ = true;
+            break;
+        }
+
+        libusb_fill_interrupt_transfer(transfer, handle_[i], inputEp_[i],
+                                       inputBuffer_[i], qMin<int>(sizeof(inputBuffer_[i]), inputEpMaxPacketSize_[i]),
+                                       EventCallbacks::inputTransferCallback, this, 0);
+
+        const int r = libusb_submit_transfer(transfer);
+        if (r < 0) {
+            qWarning() << "libusb_submit_transfer error:" << LIBUSB_STRERROR(r);
+            transferErrors().add();
+            libusb_free_transfer(transfer);
+            eventError_ = true;
+            break;
+        }
+
+        inputTransfer_[i] = transfer;
+        activeTransfers_++;
+    }
+
+    thread_ = QThread::create([this] { runEventLoop(); });
+    connect(thread_, &QThread::finished, this, &Ft260LibUsb::onIntThreadFinished);
+    thread_->start();
+
+    return !eventError_;
+}
+
+void Ft260LibUsb::stopEventThread()
+{
+    if (!thread_) { return; }
+
+    disconnect(thread_, &QThread::finished, this, &Ft260LibUsb::onIntThreadFinished);
+
+    {
+        QMutexLocker locker(&mutex_);
+        closing_ = true;
+        for (int i = 0; i < 2; i++) {
+            if (inputTransfer_[i]) {
+                libusb_cancel_transfer(inputTransfer_[i]);
+            }
+        }
+    }
+
+    thread_->wait();
+    thread_->deleteLater();
+    thread_ = nullptr;
+}
+
+void Ft260LibUsb::runEventLoop()
+{
+    int eventErrors = 0;
+    while (true) {
+        QList<I2cTransactionPtr> completed;
+        {
+            QMutexLocker locker(&mutex_);
+            if ((closing_ || eventError_) && activeTransfers_ == 0) { break; }
+
+            if (eventError_) {
+                for (int i = 0; i < 2; i++) {
+                    if (inputTransfer_[i]) {
+                        libusb_cancel_transfer(inputTransfer_[i]);
+                    }
+                }
+            }
+
+            // Fail a transaction whose read responses never showed up
+            if (!transactions_.isEmpty()) {
+                I2cTransactionPtr transaction = transactions_.first();
+                if (transaction->pendingWrites == 0 && transaction->pendingReads > 0
+                    && transaction->deadline.hasExpired()) {
+                    qWarning() << "I2C read timeout";
+                    abandonReads(transaction);
+                    processTransactions();
+                }
+            }
+
+            // Resume once the reports owed to a failed transaction are
+            // no longer expected to show up
+            if (staleReads_ > 0 && staleDeadline_.hasExpired()) {
+                processTransactions();
+            }
+            completed.swap(completed_);
+        }
+        notifyTransactions(completed);
+
+        // The timeout only bounds how long it takes to notice an expired
+        // deadline, since transfer callbacks are dispatched as they complete.
+        struct timeval tv = { 0, 100000 };
+        const int r = libusb_handle_events_timeout_completed(context_, &tv, nullptr);
+        if (r < 0 && r != LIBUSB_ERROR_INTERRUPTED) {
+            qWarning() << "libusb_handle_events error:" << LIBUSB_STRERROR(r);
+            transferErrors().add();
+
+            // Transfer callbacks may never arrive now, so fail anything
+            // waiting on them rather than leaving callers blocked.
+            QList<I2cTransactionPtr> failed;
+            {
+                QMutexLocker locker(&mutex_);
+                eventError_ = true;
+                for (const I2cTransactionPtr &transaction : std::as_const(transactions_)) {
+                    transaction->failed = true;
+                    transaction->finished = true;
+                    failed.append(transaction);
+                }
+                transactions_.clear();
+            }
+            notifyTransactions(failed);
+
+            // Cancelled transfers are only accounted for once libusb
+            // hands them back, which will not happen if it keeps failing
+            if (++eventErrors >= EVENT_ERROR_LIMIT) {
+                qWarning() << "Abandoning libusb event loop after repeated errors";
+                break;
+            }
+        } else {
+            eventErrors = 0;
+        }
+    }
+
+    // Nothing is in flight anymore, so fail anything still waiting
+    QList<I2cTransactionPtr> completed;
+    {
+        QMutexLocker locker(&mutex_);
+        for (const I2cTransactionPtr &transaction : std::as_const(transactions_)) {
+            transaction->failed = true;
+            transaction->finished = true;
+            completed.append(transaction);
+        }
+        transactions_.clear();
+    }
+    notifyTransactions(completed);
+}
+
+void Ft260LibUsb::handleInputTransfer(libusb_transfer *transfer)
+{
+    QList<I2cTransactionPtr> completed;
+    QByteArray interruptReport;
+    {
+        QMutexLocker locker(&mutex_);
+        const int index = (transfer == inputTransfer_[0]) ? 0 : 1;
+
+        if (transfer->status == LIBUSB_TRANSFER_COMPLETED) {
+            if (index == 0) {
+                handleI2cReport(transfer->buffer, transfer->actual_length);
+            } else {
+                interruptReport = QByteArray(reinterpret_cast<const char *>(transfer->buffer), transfer->actual_length);
+            }
+        } else if (transfer->status != LIBUSB_TRANSFER_CANCELLED) {
+            qWarning() << "Input transfer error:" << transfer->status;
+            transferErrors().add();
+            eventError_ = true;
+        }
+
+        bool resubmitted = false;
+        if (!closing_ && !eventError_) {
+            const int r = libusb_submit_transfer(transfer);
+            if (r < 0) {
+                qWarning() << "libusb_submit_transfer error:" << LIBUSB_STRERROR(r);
+                transferErrors().add();
+                eventError_ = true;
+            } else {
+                resubmitted = true;
+            }
+        }
+
+        if (!resubmitted) {
+            inputTransfer_[index] = nullptr;
+            activeTransfers_--;
+            libusb_free_transfer(transfer);
+        }
+
+        processTransactions();
+        completed.swap(completed_);
+    }
+
+    if (!interruptReport.isEmpty()) {
+        handleInterruptReport(interruptReport);
+    }
+    notifyTransactions(completed);
+}
+
+void Ft260LibUsb::handleOutputTransfer(libusb_transfer *transfer)
+{
+    QList<I2cTransactionPtr> completed;
+    {
+        QMutexLocker locker(&mutex_);
+        activeTransfers_--;
+
+        if (!transactions_.isEmpty()) {
+            I2cTransactionPtr transaction = transactions_.first();
+            transaction->pendingWrites--;
+            if (transaction->pendingWrites == 0) {
+                transaction->deadline.setRemainingTime(I2C_READ_TIMEOUT);
+            }
+            if (transfer->status != LIBUSB_TRANSFER_COMPLETED) {
+                qWarning() << "I2C request transfer error:" << transfer->status;
+                transferErrors().add();
+                abandonReads(transaction);
+            }
+        }
+
+        processTransactions();
+        completed.swap(completed_);
+    }
+    notifyTransactions(completed);
+}
+
+void Ft260LibUsb::handleI2cReport(const uint8_t *buf, int len)
+{
+    if (len < 2 || buf[0] < HID_REPORT_FT260_I2C_IO_BASE || buf[0] > HID_REPORT_FT260_I2C_IO_BASE + 0x0E) {
+        qDebug() << Qt::hex << QByteArray::fromRawData(reinterpret_cast<const char *>(buf), len);
+        return;
+    }
+
+    if (staleReads_ > 0) {
+        qDebug() << "Discarding late I2C input report";
+        staleReads_--;
+        return;
+    }
+
+    I2cTransactionPtr transaction = transactions_.isEmpty() ? I2cTransactionPtr() : transactions_.first();
+    if (!transaction || transaction->pendingReads == 0) {
+        qWarning() << "Unexpected I2C input report";
+        return;
+    }
+
+    while (transaction->readIndex < transaction->chunkEnd
+           && !isI2cReadOp(transaction->ops[transaction->readIndex])) {
+        transaction->readIndex++;
+    }
+    if (transaction->readIndex >= transaction->chunkEnd) {
+        transaction->pendingReads = 0;
+        return;
+    }
+
+    Ft260I2cOp &op = transaction->ops[transaction->readIndex++];
+    transaction->pendingReads--;
+
+    if (len < op.len + 2 || buf[1] != op.len) {
+        qWarning() << "Unexpected size returned:" << buf[1] << "!=" << op.len;
+        transaction->failed = true;
+        return;
+    }
+
+    op.data = QByteArray(reinterpret_cast<const char *>(buf + 2), op.len);
+}
+
+void Ft260LibUsb::handleInterruptReport(const QByteArray &report)
+{
+    // Ignore any data received in the first second since starting
+    if (QDateTime::currentMSecsSinceEpoch() < startTime_ + 1000) {
+        return;
+    }
+
+    if (report.size() == 3 && static_cast<uint8_t>(report[0]) == HID_REPORT_FT260_INTERRUPT_STATUS) {
+        const uint8_t status_int = report[1];
+        const uint8_t status_dcd_ri = report[2];
+
+        if (status_int & 0x01) {
+            emit sensorInterrupt();
+        }
+        if (status_dcd_ri & 0x04) {
+            const bool pressed = (status_dcd_ri & 0x08) == 0;
+            if (buttonPressed_ != pressed) {
+                buttonPressed_ = pressed;
+                emit buttonInterrupt(pressed);
+            }
+        }
+    } else {
+        qDebug() << Qt::hex << report;
+    }
+}
+
+Ft260LibUsb::I2cTransactionPtr Ft260LibUsb::queueTransaction(const QList<Ft260I2cOp> &ops, bool notify)
+{
+    if (ops.isEmpty()) { return I2cTransactionPtr(); }
+
+    for (const Ft260I2cOp &op : ops) {
+        if (op.addr > 0x7F) { return I2cTransactionPtr(); }
+        if (isI2cReadOp(op)) {
+            if (op.len == 0 || op.len > HID_MAX_TRAN_SIZE) { return I2cTransactionPtr(); }
+        } else {
+            if (op.data.isEmpty() || op.data.size() > HID_MAX_TRAN_SIZE) { return I2cTransactionPtr(); }
+        }
+    }
+
+    I2cTransactionPtr transaction = I2cTransactionPtr::create();
+    transaction->ticket = nextI2cTicket();
+    transaction->notify = notify;
+    transaction->ops = ops;
+
+    QList<I2cTransactionPtr> completed;
+    {
+        QMutexLocker locker(&mutex_);
+        if (!thread_ || closing_ || eventError_) { return I2cTransactionPtr(); }
+
+        transactions_.append(transaction);
+        processTransactions();
+        completed.swap(completed_);
+    }
+    notifyTransactions(completed);
+
+    return transaction;
+}
+
+void Ft260LibUsb::processTransactions()
+{
+    while (!transactions_.isEmpty()) {
+        I2cTransactionPtr transaction = transactions_.first();
+
+        // Still waiting on the current chunk
+        if (transaction->pendingWrites > 0 || transaction->pendingReads > 0) { return; }
+
+        if (!transaction->failed && transaction->chunkEnd < transaction->ops.size()) {
+            // Hold off until the reports owed to a failed transaction have
+            // been drained, so none of them is taken as a reply to this one
+            if (staleReads_ > 0) {
+                if (!staleDeadline_.hasExpired()) { return; }
+                staleReads_ = 0;
+            }
+
+            if (closing_ || eventError_) {
+                transaction->failed = true;
+            } else {
+                submitTransactionChunk(transaction);
+                if (transaction->pendingWrites > 0) { return; }
+            }
+        }
+
+        transactions_.removeFirst();
+        transaction->finished = true;
+        completed_.append(transaction);
+    }
+}
+
+void Ft260LibUsb::submitTransactionChunk(const I2cTransactionPtr &transaction)
+{
+    uint8_t buf[REQUEST_BUF_SIZE];
+    int reads = 0;
+    int requested = 0;
+
+    transaction->chunkStart = transaction->chunkEnd;
+    transaction->readIndex = transaction->chunkStart;
+
+    // Split into chunks small enough for the bridge to buffer the responses
+    qsizetype i = transaction->chunkStart;
+    for (; i < transaction->ops.size(); i++) {
+        const Ft260I2cOp &op = transaction->ops[i];
+        if (isI2cReadOp(op)) {
+            if (reads == I2C_BATCH_MAX_READS) { break; }
+            reads++;
+        }
+    }
+    transaction->chunkEnd = i;
+    transaction->pendingReads = reads;
+
+    for (i = transaction->chunkStart; i < transaction->chunkEnd; i++) {
+        const Ft260I2cOp &op = transaction->ops[i];
+        const uint8_t *payload = reinterpret_cast<const uint8_t *>(op.data.constData());
+        bool success = true;
+
+        switch (op.type) {
+        case Ft260I2cOp::Read:
+            success = submitOutputReport(buf, fillI2cWriteRequest(buf, op.addr, FT260_I2C_START, &op.reg, 1))
+                && submitOutputReport(buf, fillI2cReadRequest(buf, op.addr, FT260_I2C_REPEATED_START | FT260_I2C_STOP, op.len));
+            break;
+        case Ft260I2cOp::Write:
+            success = submitOutputReport(buf, fillI2cWriteRequest(buf, op.addr, FT260_I2C_START, &op.reg, 1))
+                && submitOutputReport(buf, fillI2cWriteRequest(buf, op.addr, FT260_I2C_STOP, payload, op.data.size()));
+            break;
+        case Ft260I2cOp::ReadRaw:
+            success = submitOutputReport(buf, fillI2cReadRequest(buf, op.addr, FT260_I2C_START_AND_STOP, op.len));
+            break;
+        case Ft260I2cOp::WriteRaw:
+            success = submitOutputReport(buf, fillI2cWriteRequest(buf, op.addr, FT260_I2C_START_AND_STOP, payload, op.data.size()));
+            break;
+        }
+
+        if (!success) {
+            // Let whatever was already submitted finish, then give up
+            transaction->pendingReads = requested;
+            abandonReads(transaction);
+            break;
+        }
+        if (isI2cReadOp(op)) { requested++; }
+    }
+}
+
+void Ft260LibUsb::abandonReads(const I2cTransactionPtr &transaction)
+{
+    // The bridge may still answer read requests it has already been sent,
+    // so those reports are counted off as they arrive instead of being
+    // handed to whatever transaction comes next
+    if (transaction->pendingReads > 0) {
+        staleReads_ += transaction->pendingReads;
+        staleDeadline_.setRemainingTime(I2C_READ_TIMEOUT);
+    }
+    transaction->failed = true;
+    transaction->pendingReads = 0;
+}
+
+bool Ft260LibUsb::submitOutputReport(const uint8_t *report, int len)
+{
+    if (len <= 0) { return false; }
+
+    libusb_transfer *transfer = libusb_alloc_transfer(0);
+    if (!transfer) { return false; }
+
+    uint8_t *buf = static_cast<uint8_t *>(malloc(len));
+    if (!buf) {
+        libusb_free_transfer(transfer);
+        return false;
+    }
+    memcpy(buf, report, len);
+
+    libusb_fill_interrupt_transfer(transfer, handle_[0], outputEp_[0], buf, len,
+                                   EventCallbacks::outputTransferCallback, this, OUTPUT_TRANSFER_TIMEOUT);
+    transfer->flags = LIBUSB_TRANSFER_FREE_BUFFER | LIBUSB_TRANSFER_FREE_TRANSFER;
+
+    const int r = libusb_submit_transfer(transfer);
+    if (r < 0) {
+        qWarning() << "libusb_submit_transfer error:" << LIBUSB_STRERROR(r);
+        transferErrors().add();
+        libusb_free_transfer(transfer);
+        return false;
+    }
+
+    activeTransfers_++;
+    transactions_.first()->pendingWrites++;
+    return true;
+}
+
+void Ft260LibUsb::notifyTransactions(const QList<I2cTransactionPtr> &completed)
+{
+    if (completed.isEmpty()) { return; }
+
+    transactionDone_.wakeAll();
+
+    for (const I2cTransactionPtr &transaction : completed) {
+        if (!transaction->notify) { continue; }
+
+        const quint32 ticket = transaction->ticket;
+        const bool success = !transaction->failed;
+        const QList<Ft260I2cOp> ops = transaction->ops;
+        QMetaObject::invokeMethod(this, [this, ticket, success, ops]() {
+            emit i2cTransactionFinished(ticket, success, ops);
+        }, Qt::QueuedConnection);
+    }
+}
+
 void Ft260LibUsb::onIntThreadFinished()
 {
     if (connected_) {
@@ -366,6 +815,7 @@ bool Ft260LibUsb::chipVersion(Ft260ChipVersion *chipVersion)
                                       1000/*timeout millis*/);
         if (ret < 0) {
             qWarning() << "chipVersion libusb_control_transfer error:" << LIBUSB_STRERROR(ret);
+            transferErrors().add();
             return false;
         }
 
@@ -403,6 +853,7 @@ bool Ft260LibUsb::systemStatus()
                                   1000/*timeout millis*/);
     if (ret < 0) {
         qWarning() << "systemStatus libusb_control_transfer error:" << LIBUSB_STRERROR(ret);
+        transferErrors().add();
         return false;
     }
 
@@ -488,6 +939,7 @@ bool Ft260LibUsb::i2cStatus(uint8_t *busStatus, uint16_t *speed)
                                   1000/*timeout millis*/);
     if (ret < 0) {
         qWarning() << "i2cStatus libusb_control_transfer error:" << LIBUSB_STRERROR(ret);
+        transferErrors().add();
         return false;
     }
 
@@ -523,6 +975,7 @@ bool Ft260LibUsb::setI2cClockSpeed(uint16_t speed)
                                   1000/*timeout millis*/);
     if (ret < 0) {
         qWarning() << "setI2cClockSpeed libusb_control_transfer error:" << LIBUSB_STRERROR(ret);
+        transferErrors().add();
         return false;
     }
 
@@ -557,6 +1010,7 @@ bool Ft260LibUsb::setUartMode(quint8 mode)
                                   1000/*timeout millis*/);
     if (ret < 0) {
         qWarning() << "setUartMode libusb_control_transfer error:" << LIBUSB_STRERROR(ret);
+        transferErrors().add();
         return false;
     }
 
@@ -583,6 +1037,7 @@ bool Ft260LibUsb::setUartEnableDcdRi(bool enable)
                                   1000/*timeout millis*/);
     if (ret < 0) {
         qWarning() << "setUartEnableDcdRi libusb_control_transfer error:" << LIBUSB_STRERROR(ret);
+        transferErrors().add();
         return false;
     }
 
@@ -609,6 +1064,7 @@ bool Ft260LibUsb::setUartEnableRiWakeup(bool enable)
                                   1000/*timeout millis*/);
     if (ret < 0) {
         qWarning() << "setUartEnableRiWakeup libusb_control_transfer error:" << LIBUSB_STRERROR(ret);
+        transferErrors().add();
         return false;
     }
 
@@ -635,6 +1091,7 @@ bool Ft260LibUsb::setUartRiWakeupConfig(bool edge)
                                   1000/*timeout millis*/);
     if (ret < 0) {
         qWarning() << "setUartRiWakeupConfig libusb_control_transfer error:" << LIBUSB_STRERROR(ret);
+        transferErrors().add();
         return false;
     }
 
@@ -659,6 +1116,7 @@ bool Ft260LibUsb::gpioRead(Ft260GpioReport *report)
                                   1000/*timeout millis*/);
     if (ret < 0) {
         qWarning() << "gpioRead libusb_control_transfer error:" << LIBUSB_STRERROR(ret);
+        transferErrors().add();
         return false;
     }
 
@@ -694,67 +1152,7 @@ bool Ft260LibUsb::gpioWrite(const Ft260GpioReport *report)
                                   1000/*timeout millis*/);
     if (ret < 0) {
         qWarning() << "gpioWrite libusb_control_transfer error:" << LIBUSB_STRERROR(ret);
-        return false;
-    }
-
-    return true;
-}
-
-bool Ft260LibUsb::i2cWriteRequest(quint8 addr, uint8_t flags, const uint8_t *payload, quint8 payloadSize)
-{
-    int ret;
-    uint8_t buf[REQUEST_BUF_SIZE];
-
-    if (payloadSize == 0 || payloadSize > 60) {
-        return 0;
-    }
-    const uint8_t reportId = 0xD0 + ((payloadSize - 1) >> 2);
-
-    const uint8_t transferLen = ((reportId - 0xD0 + 1) * 4) + 4;
-
-    memset(buf, 0, REQUEST_BUF_SIZE);
-    buf[0] = reportId;
-    buf[1] = addr;
-    buf[2] = flags;
-    buf[3] = payloadSize;
-    memcpy(buf + 4, payload, payloadSize);
-
-    int actual_length;
-    ret = libusb_interrupt_transfer(handle_[0],
-                                    outputEp_[0],
-                                    (unsigned char*)buf,
-                                    transferLen,
-                                    &actual_length, 1000);
-    Q_UNUSED(actual_length)
-    if (ret < 0) {
-        qWarning() << "i2cWriteRequest libusb_interrupt_transfer error:" << LIBUSB_STRERROR(ret);
-        return false;
-    }
-
-    return true;
-}
-
-bool Ft260LibUsb::i2cReadRequest(quint8 addr, uint8_t flags, quint16 payloadSize)
-{
-    int ret;
-    uint8_t buf[REQUEST_BUF_SIZE];
-
-    memset(buf, 0, REQUEST_BUF_SIZE);
-    buf[0] = HID_REPORT_FT260_I2C_READ_REQUEST;
-    buf[1] = addr;
-    buf[2] = flags;
-    buf[3] = payloadSize & 0x00FF;
-    buf[4] = (payloadSize & 0xFF00) >> 8;
-
-    int actual_length;
-    ret = libusb_interrupt_transfer(handle_[0],
-                                    outputEp_[0],
-                                    (unsigned char*)buf,
-                                    5,
-                                    &actual_length, 1000);
-    Q_UNUSED(actual_length)
-    if (ret < 0) {
-        qWarning() << "i2cReadRequest libusb_interrupt_transfer error:" << LIBUSB_STRERROR(ret);
+        transferErrors().add();
         return false;
     }
 
@@ -763,34 +1161,12 @@ bool Ft260LibUsb::i2cReadRequest(quint8 addr, uint8_t flags, quint16 payloadSize
 
 QByteArray Ft260LibUsb::i2cRead(quint8 addr, quint8 reg, quint8 len)
 {
-    if (!handle_[0] || addr > 0x7F || len == 0) { return QByteArray(); }
-
-    int ret;
-    uint8_t buf[REQUEST_BUF_SIZE];
-
-    if (!i2cWriteRequest(addr, FT260_I2C_START, &reg, 1)) {
-        return QByteArray();
-    }
-
-    if (!i2cReadRequest(addr, FT260_I2C_REPEATED_START | FT260_I2C_STOP, len)) {
-        return QByteArray();
-    }
-
-    int transferred;
-    ret = libusb_interrupt_transfer(handle_[0], inputEp_[0], buf, sizeof(buf), &transferred, 5000);
-    Q_UNUSED(transferred);
-    if (ret < 0) {
-        qWarning() << "i2cRead libusb_interrupt_transfer error:" << LIBUSB_STRERROR(ret);
-    }
-
-    if (len != buf[1]) {
-        qWarning() << "Unexpected size returned:" << buf[1] << "!=" << len;
+    TRACE_SCOPE("Ft260LibUsb::i2cRead");
+    QList<Ft260I2cOp> ops = { Ft260I2cOp::read(addr, reg, len) };
+    if (!i2cTransaction(ops)) {
         return QByteArray();
     }
-
-    QByteArray result(reinterpret_cast<const char *>(buf + 2), len);
-
-    return result;
+    return ops[0].data;
 }
 
 bool Ft260LibUsb::i2cReadByte(quint8 addr, quint8 reg, quint8 *data)
@@ -804,29 +1180,13 @@ bool Ft260LibUsb::i2cReadByte(quint8 addr, quint8 reg, quint8 *data)
 
 bool Ft260LibUsb::i2cReadRawByte(quint8 addr, quint8 *data)
 {
-    if (!handle_[0] || addr > 0x7F) { return false; }
-
-    int ret;
-    uint8_t buf[REQUEST_BUF_SIZE];
-
-    if (!i2cReadRequest(addr, FT260_I2C_START_AND_STOP, 1)) {
-        return false;
-    }
-
-    int transferred;
-    ret = libusb_interrupt_transfer(handle_[0], inputEp_[0], buf, sizeof(buf), &transferred, 5000);
-    Q_UNUSED(transferred);
-    if (ret < 0) {
-        qWarning() << "i2cRead libusb_interrupt_transfer error:" << LIBUSB_STRERROR(ret);
-    }
-
-    if (buf[1] != 1) {
-        qWarning() << "Unexpected size returned:" << buf[1] << "!= 1";
+    QList<Ft260I2cOp> ops = { Ft260I2cOp::readRaw(addr, 1) };
+    if (!i2cTransaction(ops)) {
         return false;
     }
 
     if (data) {
-        *data = buf[2];
+        *data = static_cast<quint8>(ops[0].data[0]);
     }
 
     return true;
@@ -834,20 +1194,9 @@ bool Ft260LibUsb::i2cReadRawByte(quint8 addr, quint8 *data)
 
 bool Ft260LibUsb::i2cWrite(quint8 addr, quint8 reg, const QByteArray &data)
 {
-    if (!handle_[0] || addr > 0x7F || data.isEmpty() || data.size() > HID_MAX_TRAN_SIZE) { return false; }
-
-    int ret;
-    uint8_t buf[64];
-
-    if (!i2cWriteRequest(addr, FT260_I2C_START, &reg, 1)) {
-        return false;
-    }
-
-    if (!i2cWriteRequest(addr, FT260_I2C_STOP, reinterpret_cast<const uint8_t *>(data.constData()), data.size())) {
-        return false;
-    }
-
-    return true;
+    TRACE_SCOPE("Ft260LibUsb::i2cWrite");
+    QList<Ft260I2cOp> ops = { Ft260I2cOp::write(addr, reg, data) };
+    return i2cTransaction(ops);
 }
 
 bool Ft260LibUsb::i2cWriteByte(quint8 addr, quint8 reg, quint8 data)
@@ -859,20 +1208,47 @@ bool Ft260LibUsb::i2cWriteByte(quint8 addr, quint8 reg, quint8 data)
 
 bool Ft260LibUsb::i2cWriteRawByte(quint8 addr, quint8 data)
 {
-    if (!handle_[0] || addr > 0x7F) { return false; }
+    QList<Ft260I2cOp> ops = { Ft260I2cOp::writeRaw(addr, QByteArray(1, static_cast<char>(data))) };
+    return i2cTransaction(ops);
+}
 
-    int ret;
-    uint8_t buf;
+bool Ft260LibUsb::i2cTransaction(QList<Ft260I2cOp> &ops)
+{
+    TRACE_SCOPE("Ft260LibUsb::i2cTransaction");
+    static MetricHistogram &latency = Metrics::histogram(QStringLiteral("ft260.i2c.latency"));
+    static MetricCounter &failures = Metrics::counter(QStringLiteral("ft260.i2c.failures"));
+    QElapsedTimer timer;
+    timer.start();
+
+    I2cTransactionPtr transaction = queueTransaction(ops, false);
+    if (!transaction) {
+        failures.add();
+        return false;
+    }
 
-    buf = data;
+    QMutexLocker locker(&mutex_);
+    while (!transaction->finished) {
+        transactionDone_.wait(&mutex_);
+    }
+    latency.record(static_cast<quint64>(timer.nsecsElapsed() / 1000));
 
-    if (!i2cWriteRequest(addr, FT260_I2C_START_AND_STOP, &buf, 1)) {
+    if (transaction->failed) {
+        failures.add();
         return false;
     }
 
+    ops = transaction->ops;
     return true;
 }
 
+quint32 Ft260LibUsb::submitI2cTransaction(const QList<Ft260I2cOp> &ops)
+{
+    I2cTransactionPtr transaction = queueTransaction(ops, true);
+    if (!transaction) { return 0; }
+
+    return transaction->ticket;
+}
+
 QList<Ft260DeviceInfo> listDevicesByLibUsb()
 {
     QList<Ft260DeviceInfo> list;
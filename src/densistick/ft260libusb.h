@@ -1,11 +1,27 @@
 #ifndef FT260LIBUSB_H
 #define FT260LIBUSB_H
 
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <QSharedPointer>
+
 #include "ft260.h"
 
 typedef struct libusb_context libusb_context;
 typedef struct libusb_device_handle libusb_device_handle;
+typedef struct libusb_transfer libusb_transfer;
 
+/**
+ * FT260 driver built on libusb.
+ *
+ * All USB traffic is asynchronous, and driven by a dedicated event thread
+ * that keeps an interrupt-IN transfer armed on each interface at all
+ * times. Sensor and button interrupts are emitted from that thread as
+ * soon as they arrive. I2C transactions are queued to the event thread,
+ * and either waited on by the blocking calls or reported back through
+ * the i2cTransactionFinished() signal.
+ */
 class Ft260LibUsb : public Ft260
 {
 public:
@@ -38,14 +54,49 @@ public:
     bool i2cWriteByte(quint8 addr, quint8 reg, quint8 data);
     bool i2cWriteRawByte(quint8 addr, quint8 data);
 
+    bool i2cTransaction(QList<Ft260I2cOp> &ops);
+    quint32 submitI2cTransaction(const QList<Ft260I2cOp> &ops);
+
     static QList<Ft260DeviceInfo> listDevices();
 
 private slots:
     void onIntThreadFinished();
 
 private:
-    bool i2cWriteRequest(quint8 addr, uint8_t flags, const uint8_t *payload, quint8 payloadSize);
-    bool i2cReadRequest(quint8 addr, uint8_t flags, quint16 payloadSize);
+    struct EventCallbacks;
+
+    struct I2cTransaction
+    {
+        quint32 ticket = 0;
+        bool notify = false;
+        QList<Ft260I2cOp> ops;
+        qsizetype chunkStart = 0;
+        qsizetype chunkEnd = 0;
+        qsizetype readIndex = 0;
+        int pendingWrites = 0;
+        int pendingReads = 0;
+        QDeadlineTimer deadline;
+        bool failed = false;
+        bool finished = false;
+    };
+    typedef QSharedPointer<I2cTransaction> I2cTransactionPtr;
+
+    bool startEventThread();
+    void stopEventThread();
+    void runEventLoop();
+
+    void handleInputTransfer(libusb_transfer *transfer);
+    void handleOutputTransfer(libusb_transfer *transfer);
+    void handleI2cReport(const uint8_t *buf, int len);
+    void handleInterruptReport(const QByteArray &report);
+
+    I2cTransactionPtr queueTransaction(const QList<Ft260I2cOp> &ops, bool notify);
+    void processTransactions();
+    void submitTransactionChunk(const I2cTransactionPtr &transaction);
+    void abandonReads(const I2cTransactionPtr &transaction);
+    bool submitOutputReport(const uint8_t *report, int len);
+    void notifyTransactions(const QList<I2cTransactionPtr> &completed);
+
     libusb_context *context_ = nullptr;
     libusb_device_handle *handle_[2] = {nullptr, nullptr};
     uint8_t inputEp_[2] = {0, 0};
@@ -53,6 +104,23 @@ private:
     uint8_t outputEp_[2] = {0, 0};
     QThread *thread_ = nullptr;
     bool connected_ = false;
+
+    // Event thread state, guarded by mutex_
+    QMutex mutex_;
+    QWaitCondition transactionDone_;
+    libusb_transfer *inputTransfer_[2] = {nullptr, nullptr};
+    uint8_t inputBuffer_[2][64];
+    int activeTransfers_ = 0;
+    bool closing_ = false;
+    bool eventError_ = false;
+    QList<I2cTransactionPtr> transactions_;
+    QList<I2cTransactionPtr> completed_;
+    int staleReads_ = 0;          /*!< Input reports still owed to failed transactions */
+    QDeadlineTimer staleDeadline_;
+
+    // Only touched by the event thread once it is running
+    qint64 startTime_ = 0;
+    bool buttonPressed_ = false;
     Ft260ChipVersion chipVersion_ = {0};
     Ft260SystemClock systemClock_ = FT260_CLOCK_MAX;
 };
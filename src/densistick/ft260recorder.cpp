@@ -0,0 +1,325 @@
+#include "ft260recorder.h"
+
+#include "../sessioncapture.h"
+
+QByteArray Ft260CaptureCall::encode() const
+{
+    QByteArray buf;
+    buf.append(static_cast<char>(kind));
+    buf.append(static_cast<char>(success ? 1 : 0));
+    SessionEvent::appendVarint(buf, static_cast<quint64>(qMax<qint64>(0, durationUs)));
+    buf.append(static_cast<char>(value & 0xFF));
+    buf.append(static_cast<char>((value >> 8) & 0xFF));
+    SessionEvent::appendVarint(buf, static_cast<quint64>(data.size()));
+    buf.append(data);
+
+    buf.append(static_cast<char>(ops.size()));
+    for (const Ft260I2cOp &op : ops) {
+        buf.append(static_cast<char>(op.type));
+        buf.append(static_cast<char>(op.addr));
+        buf.append(static_cast<char>(op.reg));
+        buf.append(static_cast<char>(op.len));
+        SessionEvent::appendVarint(buf, static_cast<quint64>(op.data.size()));
+        buf.append(op.data);
+    }
+    return buf;
+}
+
+bool Ft260CaptureCall::decode(const QByteArray &payload, Ft260CaptureCall *call)
+{
+    if (!call) { return false; }
+
+    SessionPayloadReader reader(payload);
+    call->kind = static_cast<Kind>(reader.readByte());
+    call->success = reader.readByte() != 0;
+    call->durationUs = static_cast<qint64>(reader.readVarint());
+    call->value = reader.readUint16();
+    call->data = reader.readBytes(static_cast<qsizetype>(reader.readVarint()));
+
+    const int opCount = reader.readByte();
+    call->ops.clear();
+    call->ops.reserve(opCount);
+    for (int i = 0; i < opCount && reader.ok(); i++) {
+        Ft260I2cOp op;
+        op.type = static_cast<Ft260I2cOp::Type>(reader.readByte());
+        op.addr = reader.readByte();
+        op.reg = reader.readByte();
+        op.len = reader.readByte();
+        op.data = reader.readBytes(static_cast<qsizetype>(reader.readVarint()));
+        call->ops.append(op);
+    }
+
+    return reader.ok() && call->kind != KindInvalid;
+}
+
+Ft260Recorder::Ft260Recorder(Ft260 *driver, QObject *parent)
+    : Ft260(driver->deviceInfo(), parent), driver_(driver)
+{
+    driver_->setParent(this);
+
+    connect(driver_, &Ft260::connectionOpened, this, &Ft260::connectionOpened);
+    connect(driver_, &Ft260::connectionClosed, this, &Ft260::connectionClosed);
+
+    // Interrupts may arrive on a driver thread, so record them right there
+    // and let the forwarded signal take care of crossing over
+    connect(driver_, &Ft260::sensorInterrupt, this, [this]() {
+        SessionRecorder::record(SessionEvent::TypeFt260SensorInterrupt);
+        emit sensorInterrupt();
+    }, Qt::DirectConnection);
+    connect(driver_, &Ft260::buttonInterrupt, this, [this](bool pressed) {
+        SessionRecorder::record(SessionEvent::TypeFt260ButtonInterrupt, QByteArray(1, static_cast<char>(pressed ? 1 : 0)));
+        emit buttonInterrupt(pressed);
+    }, Qt::DirectConnection);
+}
+
+Ft260Recorder::~Ft260Recorder()
+{
+}
+
+bool Ft260Recorder::isRecording()
+{
+    return SessionRecorder::isActive();
+}
+
+bool Ft260Recorder::open()
+{
+    return driver_->open();
+}
+
+void Ft260Recorder::close()
+{
+    driver_->close();
+}
+
+bool Ft260Recorder::chipVersion(Ft260ChipVersion *chipVersion)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Ft260ChipVersion version = {{0, 0}, 0, 0};
+    const bool success = driver_->chipVersion(&version);
+    if (chipVersion) { *chipVersion = version; }
+
+    Ft260CaptureCall call;
+    call.kind = Ft260CaptureCall::KindChipVersion;
+    call.success = success;
+    call.durationUs = timer.nsecsElapsed() / 1000;
+    call.data = QByteArray(reinterpret_cast<const char *>(&version), sizeof(version));
+    record(call);
+
+    return success;
+}
+
+Ft260SystemClock Ft260Recorder::systemClock() const
+{
+    return driver_->systemClock();
+}
+
+bool Ft260Recorder::i2cStatus(uint8_t *busStatus, uint16_t *speed)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    uint8_t status = 0;
+    uint16_t busSpeed = 0;
+    const bool success = driver_->i2cStatus(&status, &busSpeed);
+    if (busStatus) { *busStatus = status; }
+    if (speed) { *speed = busSpeed; }
+
+    Ft260CaptureCall call;
+    call.kind = Ft260CaptureCall::KindI2cStatus;
+    call.success = success;
+    call.durationUs = timer.nsecsElapsed() / 1000;
+    call.value = busSpeed;
+    call.data = QByteArray(1, static_cast<char>(status));
+    record(call);
+
+    return success;
+}
+
+bool Ft260Recorder::setI2cClockSpeed(uint16_t speed)
+{
+    QElapsedTimer timer;
+    timer.start();
+    return recordSetting(Ft260CaptureCall::KindSetI2cClockSpeed, speed, driver_->setI2cClockSpeed(speed), timer);
+}
+
+bool Ft260Recorder::setUartMode(quint8 mode)
+{
+    QElapsedTimer timer;
+    timer.start();
+    return recordSetting(Ft260CaptureCall::KindSetUartMode, mode, driver_->setUartMode(mode), timer);
+}
+
+bool Ft260Recorder::setUartEnableDcdRi(bool enable)
+{
+    QElapsedTimer timer;
+    timer.start();
+    return recordSetting(Ft260CaptureCall::KindSetUartEnableDcdRi, enable, driver_->setUartEnableDcdRi(enable), timer);
+}
+
+bool Ft260Recorder::setUartEnableRiWakeup(bool enable)
+{
+    QElapsedTimer timer;
+    timer.start();
+    return recordSetting(Ft260CaptureCall::KindSetUartEnableRiWakeup, enable, driver_->setUartEnableRiWakeup(enable), timer);
+}
+
+bool Ft260Recorder::setUartRiWakeupConfig(bool edge)
+{
+    QElapsedTimer timer;
+    timer.start();
+    return recordSetting(Ft260CaptureCall::KindSetUartRiWakeupConfig, edge, driver_->setUartRiWakeupConfig(edge), timer);
+}
+
+bool Ft260Recorder::gpioRead(Ft260GpioReport *report)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Ft260GpioReport result = {0, 0, 0, 0};
+    const bool success = driver_->gpioRead(&result);
+    if (report) { *report = result; }
+
+    Ft260CaptureCall call;
+    call.kind = Ft260CaptureCall::KindGpioRead;
+    call.success = success;
+    call.durationUs = timer.nsecsElapsed() / 1000;
+    call.data = QByteArray(reinterpret_cast<const char *>(&result), sizeof(result));
+    record(call);
+
+    return success;
+}
+
+bool Ft260Recorder::gpioWrite(const Ft260GpioReport *report)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const bool success = driver_->gpioWrite(report);
+
+    Ft260CaptureCall call;
+    call.kind = Ft260CaptureCall::KindGpioWrite;
+    call.success = success;
+    call.durationUs = timer.nsecsElapsed() / 1000;
+    if (report) {
+        call.data = QByteArray(reinterpret_cast<const char *>(report), sizeof(Ft260GpioReport));
+    }
+    record(call);
+
+    return success;
+}
+
+QByteArray Ft260Recorder::i2cRead(quint8 addr, quint8 reg, quint8 len)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Ft260I2cOp op = Ft260I2cOp::read(addr, reg, len);
+    op.data = driver_->i2cRead(addr, reg, len);
+    recordI2c({op}, !op.data.isEmpty(), timer);
+
+    return op.data;
+}
+
+bool Ft260Recorder::i2cReadByte(quint8 addr, quint8 reg, quint8 *data)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    quint8 value = 0;
+    const bool success = driver_->i2cReadByte(addr, reg, &value);
+    if (data) { *data = value; }
+
+    Ft260I2cOp op = Ft260I2cOp::read(addr, reg, 1);
+    if (success) { op.data = QByteArray(1, static_cast<char>(value)); }
+    recordI2c({op}, success, timer);
+
+    return success;
+}
+
+bool Ft260Recorder::i2cReadRawByte(quint8 addr, quint8 *data)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    quint8 value = 0;
+    const bool success = driver_->i2cReadRawByte(addr, &value);
+    if (data) { *data = value; }
+
+    Ft260I2cOp op = Ft260I2cOp::readRaw(addr, 1);
+    if (success) { op.data = QByteArray(1, static_cast<char>(value)); }
+    recordI2c({op}, success, timer);
+
+    return success;
+}
+
+bool Ft260Recorder::i2cWrite(quint8 addr, quint8 reg, const QByteArray &data)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const bool success = driver_->i2cWrite(addr, reg, data);
+    recordI2c({Ft260I2cOp::write(addr, reg, data)}, success, timer);
+
+    return success;
+}
+
+bool Ft260Recorder::i2cWriteByte(quint8 addr, quint8 reg, quint8 data)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const bool success = driver_->i2cWriteByte(addr, reg, data);
+    recordI2c({Ft260I2cOp::writeByte(addr, reg, data)}, success, timer);
+
+    return success;
+}
+
+bool Ft260Recorder::i2cWriteRawByte(quint8 addr, quint8 data)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const bool success = driver_->i2cWriteRawByte(addr, data);
+    recordI2c({Ft260I2cOp::writeRaw(addr, QByteArray(1, static_cast<char>(data)))}, success, timer);
+
+    return success;
+}
+
+bool Ft260Recorder::i2cTransaction(QList<Ft260I2cOp> &ops)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const bool success = driver_->i2cTransaction(ops);
+    recordI2c(ops, success, timer);
+
+    return success;
+}
+
+void Ft260Recorder::record(const Ft260CaptureCall &call)
+{
+    SessionRecorder::record(SessionEvent::TypeFt260Call, call.encode());
+}
+
+bool Ft260Recorder::recordSetting(Ft260CaptureCall::Kind kind, quint16 value, bool success, const QElapsedTimer &timer)
+{
+    Ft260CaptureCall call;
+    call.kind = kind;
+    call.success = success;
+    call.durationUs = timer.nsecsElapsed() / 1000;
+    call.value = value;
+    record(call);
+    return success;
+}
+
+void Ft260Recorder::recordI2c(const QList<Ft260I2cOp> &ops, bool success, const QElapsedTimer &timer)
+{
+    Ft260CaptureCall call;
+    call.kind = Ft260CaptureCall::KindI2c;
+    call.success = success;
+    call.durationUs = timer.nsecsElapsed() / 1000;
+    call.ops = ops;
+    record(call);
+}
@@ -0,0 +1,90 @@
+#ifndef FT260RECORDER_H
+#define FT260RECORDER_H
+
+#include <QElapsedTimer>
+
+#include "ft260.h"
+
+/**
+ * Completed call into an FT260 driver, as stored in a session capture.
+ *
+ * Unbatched I2C calls are stored the same way as a batched transaction
+ * holding a single operation, so either form can be replayed by either.
+ */
+struct Ft260CaptureCall
+{
+    enum Kind : quint8 {
+        KindInvalid = 0,
+        KindChipVersion,
+        KindI2cStatus,
+        KindSetI2cClockSpeed,
+        KindSetUartMode,
+        KindSetUartEnableDcdRi,
+        KindSetUartEnableRiWakeup,
+        KindSetUartRiWakeupConfig,
+        KindGpioRead,
+        KindGpioWrite,
+        KindI2c
+    };
+
+    Kind kind = KindInvalid;
+    bool success = false;
+    qint64 durationUs = 0;
+    quint16 value = 0;      /*!< Setting passed in, or the bus speed returned by a status query */
+    QByteArray data;        /*!< Raw chip version, bus status or GPIO report */
+    QList<Ft260I2cOp> ops;
+
+    QByteArray encode() const;
+    static bool decode(const QByteArray &payload, Ft260CaptureCall *call);
+};
+
+/**
+ * Driver wrapper that passes every call through to the real driver,
+ * recording it along with its result into the active session capture.
+ */
+class Ft260Recorder : public Ft260
+{
+    Q_OBJECT
+public:
+    /** Takes ownership of the wrapped driver */
+    explicit Ft260Recorder(Ft260 *driver, QObject *parent = nullptr);
+    virtual ~Ft260Recorder();
+
+    bool open();
+    void close();
+
+    bool chipVersion(Ft260ChipVersion *chipVersion);
+    Ft260SystemClock systemClock() const;
+
+    bool i2cStatus(uint8_t *busStatus, uint16_t *speed);
+    bool setI2cClockSpeed(uint16_t speed);
+
+    bool setUartMode(quint8 mode);
+    bool setUartEnableDcdRi(bool enable);
+    bool setUartEnableRiWakeup(bool enable);
+    bool setUartRiWakeupConfig(bool edge);
+
+    bool gpioRead(Ft260GpioReport *report);
+    bool gpioWrite(const Ft260GpioReport *report);
+
+    QByteArray i2cRead(quint8 addr, quint8 reg, quint8 len);
+    bool i2cReadByte(quint8 addr, quint8 reg, quint8 *data);
+    bool i2cReadRawByte(quint8 addr, quint8 *data);
+    bool i2cWrite(quint8 addr, quint8 reg, const QByteArray &data);
+    bool i2cWriteByte(quint8 addr, quint8 reg, quint8 data);
+    bool i2cWriteRawByte(quint8 addr, quint8 data);
+
+    bool i2cTransaction(QList<Ft260I2cOp> &ops);
+
+    /** Check whether new drivers should be wrapped for recording */
+    static bool isRecording();
+
+private:
+    void record(const Ft260CaptureCall &call);
+    bool recordSetting(Ft260CaptureCall::Kind kind, quint16 value, bool success, const QElapsedTimer &timer);
+    void recordI2c(const QList<Ft260I2cOp> &ops, bool success, const QElapsedTimer &timer);
+
+    Ft260 *driver_;
+};
+
+#endif // FT260RECORDER_H
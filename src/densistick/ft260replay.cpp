@@ -0,0 +1,388 @@
+#include "ft260replay.h"
+
+#include <QThread>
+#include <QTimer>
+#include <QFileInfo>
+#include <QDebug>
+#include <string.h>
+
+#include "ft260deviceinfo.h"
+#include "ft260deviceinfo_p.h"
+
+namespace
+{
+static QString replayPortName;
+}
+
+Ft260Replay::Ft260Replay(const Ft260DeviceInfo &device, QObject *parent) : Ft260(device, parent)
+    , interruptTimer_(new QTimer(this))
+{
+    interruptTimer_->setSingleShot(true);
+    interruptTimer_->setTimerType(Qt::PreciseTimer);
+    connect(interruptTimer_, &QTimer::timeout, this, &Ft260Replay::onInterruptTimeout);
+}
+
+Ft260Replay::~Ft260Replay()
+{
+    Ft260Replay::close();
+}
+
+void Ft260Replay::setCapture(const QString &portName)
+{
+    replayPortName = portName;
+}
+
+int Ft260Replay::divergenceCount() const
+{
+    return divergenceCount_;
+}
+
+bool Ft260Replay::open()
+{
+    if (open_) { return true; }
+
+    const QString fileName = SessionCapture::parseReplayPort(deviceInfo_.devicePath(), &fast_);
+
+    SessionCapture capture;
+    if (!capture.load(fileName)) {
+        qWarning() << "Unable to load capture:" << capture.errorString();
+        return false;
+    }
+
+    events_.clear();
+    const QList<SessionEvent> events = capture.events();
+    for (const SessionEvent &event : events) {
+        if (event.isFt260Event()) {
+            events_.append(event);
+        }
+    }
+    if (events_.isEmpty()) {
+        qWarning() << "No FT260 traffic in capture";
+        return false;
+    }
+
+    cursor_ = 0;
+    lastStepUs_ = 0;
+    lastEventUs_ = events_.first().timeUs;
+    divergenceCount_ = 0;
+    finished_ = false;
+    clock_.start();
+    open_ = true;
+
+    emit connectionOpened();
+    pumpInterrupts(false);
+
+    return true;
+}
+
+void Ft260Replay::close()
+{
+    interruptTimer_->stop();
+    if (open_) {
+        open_ = false;
+        emit connectionClosed();
+    }
+}
+
+bool Ft260Replay::chipVersion(Ft260ChipVersion *chipVersion)
+{
+    Ft260CaptureCall call;
+    if (!nextCall(Ft260CaptureCall::KindChipVersion, &call)) { return false; }
+
+    if (chipVersion && call.data.size() == sizeof(Ft260ChipVersion)) {
+        memcpy(chipVersion, call.data.constData(), sizeof(Ft260ChipVersion));
+    }
+    return call.success;
+}
+
+Ft260SystemClock Ft260Replay::systemClock() const
+{
+    return FT260_CLOCK_48MHZ;
+}
+
+bool Ft260Replay::i2cStatus(uint8_t *busStatus, uint16_t *speed)
+{
+    Ft260CaptureCall call;
+    if (!nextCall(Ft260CaptureCall::KindI2cStatus, &call)) { return false; }
+
+    if (busStatus && !call.data.isEmpty()) { *busStatus = static_cast<uint8_t>(call.data.at(0)); }
+    if (speed) { *speed = call.value; }
+    return call.success;
+}
+
+bool Ft260Replay::setI2cClockSpeed(uint16_t speed)
+{
+    return replaySetting(Ft260CaptureCall::KindSetI2cClockSpeed, speed);
+}
+
+bool Ft260Replay::setUartMode(quint8 mode)
+{
+    return replaySetting(Ft260CaptureCall::KindSetUartMode, mode);
+}
+
+bool Ft260Replay::setUartEnableDcdRi(bool enable)
+{
+    return replaySetting(Ft260CaptureCall::KindSetUartEnableDcdRi, enable);
+}
+
+bool Ft260Replay::setUartEnableRiWakeup(bool enable)
+{
+    return replaySetting(Ft260CaptureCall::KindSetUartEnableRiWakeup, enable);
+}
+
+bool Ft260Replay::setUartRiWakeupConfig(bool edge)
+{
+    return replaySetting(Ft260CaptureCall::KindSetUartRiWakeupConfig, edge);
+}
+
+bool Ft260Replay::gpioRead(Ft260GpioReport *report)
+{
+    Ft260CaptureCall call;
+    if (!nextCall(Ft260CaptureCall::KindGpioRead, &call)) { return false; }
+
+    if (report && call.data.size() == sizeof(Ft260GpioReport)) {
+        memcpy(report, call.data.constData(), sizeof(Ft260GpioReport));
+    }
+    return call.success;
+}
+
+bool Ft260Replay::gpioWrite(const Ft260GpioReport *report)
+{
+    Ft260CaptureCall call;
+    if (!nextCall(Ft260CaptureCall::KindGpioWrite, &call)) { return false; }
+
+    if (report && call.data != QByteArray(reinterpret_cast<const char *>(report), sizeof(Ft260GpioReport))) {
+        divergence("GPIO write differs");
+    }
+    return call.success;
+}
+
+QByteArray Ft260Replay::i2cRead(quint8 addr, quint8 reg, quint8 len)
+{
+    QList<Ft260I2cOp> ops{Ft260I2cOp::read(addr, reg, len)};
+    if (!replayI2c(ops)) { return QByteArray(); }
+    return ops.first().data;
+}
+
+bool Ft260Replay::i2cReadByte(quint8 addr, quint8 reg, quint8 *data)
+{
+    QList<Ft260I2cOp> ops{Ft260I2cOp::read(addr, reg, 1)};
+    if (!replayI2c(ops) || ops.first().data.isEmpty()) { return false; }
+
+    if (data) { *data = static_cast<quint8>(ops.first().data.at(0)); }
+    return true;
+}
+
+bool Ft260Replay::i2cReadRawByte(quint8 addr, quint8 *data)
+{
+    QList<Ft260I2cOp> ops{Ft260I2cOp::readRaw(addr, 1)};
+    if (!replayI2c(ops) || ops.first().data.isEmpty()) { return false; }
+
+    if (data) { *data = static_cast<quint8>(ops.first().data.at(0)); }
+    return true;
+}
+
+bool Ft260Replay::i2cWrite(quint8 addr, quint8 reg, const QByteArray &data)
+{
+    QList<Ft260I2cOp> ops{Ft260I2cOp::write(addr, reg, data)};
+    return replayI2c(ops);
+}
+
+bool Ft260Replay::i2cWriteByte(quint8 addr, quint8 reg, quint8 data)
+{
+    QList<Ft260I2cOp> ops{Ft260I2cOp::writeByte(addr, reg, data)};
+    return replayI2c(ops);
+}
+
+bool Ft260Replay::i2cWriteRawByte(quint8 addr, quint8 data)
+{
+    QList<Ft260I2cOp> ops{Ft260I2cOp::writeRaw(addr, QByteArray(1, static_cast<char>(data)))};
+    return replayI2c(ops);
+}
+
+bool Ft260Replay::i2cTransaction(QList<Ft260I2cOp> &ops)
+{
+    return replayI2c(ops);
+}
+
+void Ft260Replay::onInterruptTimeout()
+{
+    pumpInterrupts(false);
+}
+
+bool Ft260Replay::nextCall(Ft260CaptureCall::Kind kind, Ft260CaptureCall *call)
+{
+    if (!open_) { return false; }
+
+    // Anything that happened before this call in the original session
+    // has to happen before it here as well
+    pumpInterrupts(true);
+
+    if (cursor_ >= events_.size()) {
+        divergence("Call past the end of the capture");
+        return false;
+    }
+
+    const SessionEvent &event = events_.at(cursor_);
+    if (!Ft260CaptureCall::decode(event.payload, call)) {
+        divergence("Invalid call record");
+        return false;
+    }
+    if (call->kind != kind) {
+        divergence("Unexpected call");
+        return false;
+    }
+
+    if (!fast_ && call->durationUs > 0) {
+        QThread::usleep(static_cast<unsigned long>(call->durationUs));
+    }
+
+    lastStepUs_ = elapsedUs();
+    lastEventUs_ = event.timeUs;
+    cursor_++;
+
+    pumpInterrupts(false);
+    return true;
+}
+
+bool Ft260Replay::replaySetting(Ft260CaptureCall::Kind kind, quint16 value)
+{
+    Ft260CaptureCall call;
+    if (!nextCall(kind, &call)) { return false; }
+
+    if (call.value != value) {
+        divergence("Setting differs");
+    }
+    return call.success;
+}
+
+bool Ft260Replay::replayI2c(QList<Ft260I2cOp> &ops)
+{
+    if (!open_) { return false; }
+    pumpInterrupts(true);
+
+    // Check before consuming the call, so a mismatch leaves the
+    // capture where it was
+    if (cursor_ < events_.size() && events_.at(cursor_).type == SessionEvent::TypeFt260Call) {
+        Ft260CaptureCall recorded;
+        if (Ft260CaptureCall::decode(events_.at(cursor_).payload, &recorded)
+            && recorded.kind == Ft260CaptureCall::KindI2c) {
+            bool matches = recorded.ops.size() == ops.size();
+            for (qsizetype i = 0; matches && i < ops.size(); i++) {
+                const Ft260I2cOp &op = ops.at(i);
+                const Ft260I2cOp &rec = recorded.ops.at(i);
+                matches = op.type == rec.type && op.addr == rec.addr;
+                if (op.type == Ft260I2cOp::Read || op.type == Ft260I2cOp::Write) {
+                    matches = matches && op.reg == rec.reg;
+                }
+                if (op.type == Ft260I2cOp::Read || op.type == Ft260I2cOp::ReadRaw) {
+                    matches = matches && op.len == rec.len;
+                }
+            }
+            if (!matches) {
+                divergence("I2C operations differ");
+                return false;
+            }
+        }
+    }
+
+    Ft260CaptureCall call;
+    if (!nextCall(Ft260CaptureCall::KindI2c, &call)) { return false; }
+
+    for (qsizetype i = 0; i < ops.size(); i++) {
+        Ft260I2cOp &op = ops[i];
+        if (op.type == Ft260I2cOp::Read || op.type == Ft260I2cOp::ReadRaw) {
+            op.data = call.ops.at(i).data;
+        } else if (op.data != call.ops.at(i).data) {
+            divergence("I2C write data differs");
+        }
+    }
+    return call.success;
+}
+
+void Ft260Replay::pumpInterrupts(bool wait)
+{
+    while (open_ && cursor_ < events_.size()) {
+        const SessionEvent &event = events_.at(cursor_);
+        if (event.type == SessionEvent::TypeFt260Call) { break; }
+
+        if (!fast_) {
+            const qint64 dueUs = lastStepUs_ + (event.timeUs - lastEventUs_);
+            const qint64 waitUs = dueUs - elapsedUs();
+            if (waitUs > 0) {
+                if (wait) {
+                    QThread::usleep(static_cast<unsigned long>(waitUs));
+                } else {
+                    interruptTimer_->start(static_cast<int>((waitUs + 999) / 1000));
+                    return;
+                }
+            }
+            lastStepUs_ = dueUs;
+        } else {
+            lastStepUs_ = elapsedUs();
+        }
+        lastEventUs_ = event.timeUs;
+        cursor_++;
+
+        // Deliver through the event loop, the way a driver thread would
+        if (event.type == SessionEvent::TypeFt260SensorInterrupt) {
+            QMetaObject::invokeMethod(this, [this]() { emit sensorInterrupt(); }, Qt::QueuedConnection);
+        } else if (event.type == SessionEvent::TypeFt260ButtonInterrupt) {
+            const bool pressed = !event.payload.isEmpty() && event.payload.at(0) != 0;
+            QMetaObject::invokeMethod(this, [this, pressed]() { emit buttonInterrupt(pressed); }, Qt::QueuedConnection);
+        }
+    }
+
+    checkFinished();
+}
+
+void Ft260Replay::checkFinished()
+{
+    if (finished_ || cursor_ < events_.size()) { return; }
+
+    finished_ = true;
+    const qint64 elapsedMs = clock_.elapsed();
+    qDebug().nospace() << "Replay finished: " << events_.size() << " events in " << elapsedMs << "ms, "
+                       << divergenceCount_ << " divergences";
+    QMetaObject::invokeMethod(this, [this, elapsedMs]() { emit replayFinished(elapsedMs); }, Qt::QueuedConnection);
+}
+
+void Ft260Replay::divergence(const char *reason)
+{
+    if (divergenceCount_++ == 0) {
+        qWarning() << "Replay diverged at event" << cursor_ << reason;
+    }
+}
+
+qint64 Ft260Replay::elapsedUs() const
+{
+    return clock_.nsecsElapsed() / 1000;
+}
+
+QList<Ft260DeviceInfo> listDevicesByReplay()
+{
+    QList<Ft260DeviceInfo> list;
+    if (replayPortName.isEmpty()) {
+        return list;
+    }
+
+    const QString fileName = SessionCapture::parseReplayPort(replayPortName, nullptr);
+
+    Ft260DeviceInfoPrivate privDevice;
+    privDevice.devicePath = replayPortName;
+    privDevice.deviceDisplayPath = QString("replay:%1").arg(QFileInfo(fileName).fileName());
+    privDevice.deviceDriver = Ft260DeviceInfo::DriverReplay;
+    privDevice.vendorId = 0x16D0;
+    privDevice.productId = 0x1382;
+    privDevice.product = QLatin1String("Printalyzer DensiStick");
+    privDevice.serialNumber = QLatin1String("REPLAY");
+    privDevice.description = QString("%1 (%2)").arg(privDevice.product, privDevice.deviceDisplayPath);
+    list.append(privDevice);
+
+    return list;
+}
+
+QList<Ft260DeviceInfo> Ft260Replay::listDevices()
+{
+    return listDevicesByReplay();
+}
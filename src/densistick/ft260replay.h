@@ -0,0 +1,92 @@
+#ifndef FT260REPLAY_H
+#define FT260REPLAY_H
+
+#include <QElapsedTimer>
+
+#include "ft260.h"
+#include "ft260recorder.h"
+#include "../sessioncapture.h"
+
+class QTimer;
+
+/**
+ * Driver that plays back the FT260 side of a session capture.
+ *
+ * Every call returns the result recorded for it in the original session,
+ * as long as the calls arrive in the same order and with the same
+ * arguments. Interrupts are raised at the same points in the sequence
+ * of calls. In real-time mode each call takes as long as it originally
+ * did, otherwise the capture is played back as fast as possible.
+ */
+class Ft260Replay : public Ft260
+{
+    Q_OBJECT
+public:
+    explicit Ft260Replay(const Ft260DeviceInfo &device, QObject *parent = nullptr);
+    virtual ~Ft260Replay();
+
+    /**
+     * Make a capture show up in Ft260::listDevices(), using the same
+     * replay:<file>[?speed=max] form as a port name.
+     * Must be called before any devices are listed.
+     */
+    static void setCapture(const QString &portName);
+    static QList<Ft260DeviceInfo> listDevices();
+
+    /** Number of calls that did not match the recorded session */
+    int divergenceCount() const;
+
+    bool open();
+    void close();
+
+    bool chipVersion(Ft260ChipVersion *chipVersion);
+    Ft260SystemClock systemClock() const;
+
+    bool i2cStatus(uint8_t *busStatus, uint16_t *speed);
+    bool setI2cClockSpeed(uint16_t speed);
+
+    bool setUartMode(quint8 mode);
+    bool setUartEnableDcdRi(bool enable);
+    bool setUartEnableRiWakeup(bool enable);
+    bool setUartRiWakeupConfig(bool edge);
+
+    bool gpioRead(Ft260GpioReport *report);
+    bool gpioWrite(const Ft260GpioReport *report);
+
+    QByteArray i2cRead(quint8 addr, quint8 reg, quint8 len);
+    bool i2cReadByte(quint8 addr, quint8 reg, quint8 *data);
+    bool i2cReadRawByte(quint8 addr, quint8 *data);
+    bool i2cWrite(quint8 addr, quint8 reg, const QByteArray &data);
+    bool i2cWriteByte(quint8 addr, quint8 reg, quint8 data);
+    bool i2cWriteRawByte(quint8 addr, quint8 data);
+
+    bool i2cTransaction(QList<Ft260I2cOp> &ops);
+
+signals:
+    void replayFinished(qint64 elapsedMs);
+
+private slots:
+    void onInterruptTimeout();
+
+private:
+    bool nextCall(Ft260CaptureCall::Kind kind, Ft260CaptureCall *call);
+    bool replaySetting(Ft260CaptureCall::Kind kind, quint16 value);
+    bool replayI2c(QList<Ft260I2cOp> &ops);
+    void pumpInterrupts(bool wait);
+    void checkFinished();
+    void divergence(const char *reason);
+    qint64 elapsedUs() const;
+
+    QList<SessionEvent> events_;
+    QTimer *interruptTimer_;
+    QElapsedTimer clock_;
+    bool fast_ = false;
+    bool open_ = false;
+    bool finished_ = false;
+    qsizetype cursor_ = 0;
+    qint64 lastStepUs_ = 0;
+    qint64 lastEventUs_ = 0;
+    int divergenceCount_ = 0;
+};
+
+#endif // FT260REPLAY_H
@@ -1,10 +1,16 @@
 #include "m24c08.h"
 
-#include <QThread>
+#include <QDeadlineTimer>
 #include <QDebug>
 
 #include "ft260.h"
 
+namespace
+{
+/* Datasheet maximum write cycle time is 5ms, allow for USB latency on top */
+static const int WRITE_CYCLE_TIMEOUT_MS = 50;
+}
+
 M24C08::M24C08(Ft260 *ft260, quint8 deviceAddress)
 {
     if (!ft260) {
@@ -18,6 +24,7 @@ M24C08::M24C08(Ft260 *ft260, quint8 deviceAddress)
 
     ft260_ = ft260;
     deviceAddress_ = deviceAddress;
+    image_ = QByteArray(M24C08_MEM_SIZE, '\0');
     valid_ = true;
 }
 
@@ -57,11 +64,22 @@ QByteArray M24C08::readBuffer(uint16_t address, size_t len)
             return QByteArray();
         }
 
-        buf.append(seg);
+        buf.append(seg.left(readLen));
+
+        // Anything after a short read would land at the wrong address
+        if (seg.size() < readLen) {
+            break;
+        }
 
         offset += readLen;
     }
 
+    // Only the bytes actually read are known to match the device
+    image_.replace(address, buf.size(), buf);
+    for (qsizetype i = 0; i < buf.size(); i++) {
+        imageValid_.set(address + i);
+    }
+
     return buf;
 }
 
@@ -77,22 +95,82 @@ bool M24C08::writeBuffer(uint16_t address, const QByteArray &data)
     size_t offset = 0;
 
     while (offset < static_cast<size_t>(data.size())) {
+        // Writes cannot cross a page boundary
         const uint16_t writeAddress = address + static_cast<uint16_t>(offset);
-        const quint8 writeLen = static_cast<quint8>(qMin(data.size() - offset, static_cast<size_t>(M24C08_PAGE_SIZE)));
-
-        const uint8_t i2cAddress = static_cast<uint8_t>((uint16_t)deviceAddress_ | ((writeAddress & 0x0300) >> 8));
-        const uint8_t memAddress = static_cast<uint8_t>(writeAddress & 0x00FF);
-
-        if (!ft260_->i2cWrite(i2cAddress, memAddress, data.mid(offset, writeLen))) {
-            qWarning() << "I2C EEPROM write error";
-            return false;
+        const size_t pageRemaining = M24C08_PAGE_SIZE - (writeAddress % M24C08_PAGE_SIZE);
+        const size_t writeLen = qMin(data.size() - offset, pageRemaining);
+
+        // Trim the write down to the bytes that actually differ from what
+        // the device is known to contain, skipping the page if nothing does
+        size_t first = 0;
+        size_t last = writeLen;
+        while (first < last && imageValid_.test(writeAddress + first)
+               && image_.at(writeAddress + first) == data.at(offset + first)) {
+            first++;
+        }
+        while (last > first && imageValid_.test(writeAddress + last - 1)
+               && image_.at(writeAddress + last - 1) == data.at(offset + last - 1)) {
+            last--;
         }
 
-        // Short delay may be necessary to prevent subsequent write from failing
-        QThread::msleep(100);
+        if (first < last) {
+            if (!writePage(writeAddress + first, data.mid(offset + first, last - first))) {
+                return false;
+            }
+        }
 
         offset += writeLen;
     }
 
     return true;
 }
+
+bool M24C08::writePage(uint16_t address, const QByteArray &data)
+{
+    const uint8_t i2cAddress = static_cast<uint8_t>((uint16_t)deviceAddress_ | ((address & 0x0300) >> 8));
+    const uint8_t memAddress = static_cast<uint8_t>(address & 0x00FF);
+
+    // Invalidate first, so a failed write never leaves a stale image behind
+    for (qsizetype i = 0; i < data.size(); i++) {
+        imageValid_.reset(address + i);
+    }
+
+    if (!ft260_->i2cWrite(i2cAddress, memAddress, data)) {
+        qWarning() << "I2C EEPROM write error";
+        return false;
+    }
+
+    if (!waitForWriteCycle(i2cAddress, memAddress)) {
+        qWarning() << "I2C EEPROM write cycle timeout";
+        return false;
+    }
+
+    image_.replace(address, data.size(), data);
+    for (qsizetype i = 0; i < data.size(); i++) {
+        imageValid_.set(address + i);
+    }
+
+    return true;
+}
+
+bool M24C08::waitForWriteCycle(uint8_t i2cAddress, uint8_t memAddress)
+{
+    // The device does not acknowledge its address while the internal
+    // write cycle is in progress. Poll it with an address-only write,
+    // which just sets the address pointer, until it does.
+    QDeadlineTimer deadline(WRITE_CYCLE_TIMEOUT_MS);
+    do {
+        if (!ft260_->i2cWriteRawByte(i2cAddress, memAddress)) { return false; }
+
+        uint8_t busStatus = 0;
+        do {
+            if (!ft260_->i2cStatus(&busStatus, nullptr)) { return false; }
+        } while ((busStatus & FT260_I2C_STATUS_CONTROLLER_BUSY) != 0 && !deadline.hasExpired());
+
+        if ((busStatus & (FT260_I2C_STATUS_CONTROLLER_BUSY | FT260_I2C_STATUS_ERROR | FT260_I2C_STATUS_ADDRESS_NACK)) == 0) {
+            return true;
+        }
+    } while (!deadline.hasExpired());
+
+    return false;
+}
@@ -3,12 +3,21 @@
 
 #include <QtTypes>
 #include <QByteArray>
+#include <bitset>
 
 #define M24C08_PAGE_SIZE  0x10UL
 #define M24C08_MEM_SIZE   0x400UL
 
 class Ft260;
 
+/**
+ * Driver for the M24C08 8-Kbit I2C EEPROM.
+ *
+ * Everything read from or written to the device is kept in a local image
+ * of its contents, so writes can skip bytes that already hold the
+ * requested values. Completion of each page write cycle is detected
+ * by polling the device for an acknowledge.
+ */
 class M24C08
 {
 public:
@@ -21,9 +30,14 @@ public:
     bool writeBuffer(uint16_t address, const QByteArray &data);
 
 private:
+    bool writePage(uint16_t address, const QByteArray &data);
+    bool waitForWriteCycle(uint8_t i2cAddress, uint8_t memAddress);
+
     Ft260 *ft260_ = nullptr;
     quint8 deviceAddress_ = 0;
     bool valid_ = false;
+    QByteArray image_;
+    std::bitset<M24C08_MEM_SIZE> imageValid_;
 };
 
 #endif // M24C08_H
@@ -1,13 +1,45 @@
 #include "tsl2585.h"
 
 #include <QThread>
+#include <QElapsedTimer>
 #include <QDebug>
 
 #include "ft260.h"
+#include "tsl2585_p.h"
+#include "../metrics.h"
+#include "../trace.h"
 
 // I2C device address
 static const uint8_t TSL2585_ADDRESS = 0x39;
 
+// Longest run of registers written out in a single burst
+static const int TSL2585_BURST_MAX = 60;
+
+// Clean registers that may be rewritten to merge two bursts
+static const int TSL2585_BURST_GAP = 2;
+
+/*
+ * Configuration registers mirrored by the shadow register cache.
+ * Anything outside these ranges (ENABLE, CONTROL, status, ALS data,
+ * FIFO, and the VSYNC period and control registers) is volatile and
+ * always goes straight to the device.
+ */
+static const struct {
+    uint8_t first;
+    uint8_t last;
+} TSL2585_SHADOW_RANGES[] = {
+    { 0x40, 0x40 }, /* MOD_CHANNEL_CTRL */
+    { 0x81, 0x8F }, /* MEAS_MODE0 - AIHT2 */
+    { 0xA1, 0xAA }, /* CFG0 - CFG9 */
+    { 0xAC, 0xAE }, /* AGC_NR_SAMPLES_L - TRIGGER_MODE */
+    { 0xBA, 0xBB }, /* INTENAB - SIEN */
+    { 0xCE, 0xE4 }, /* MOD_COMP_CFG1 - MOD_CALIB_CFG0 */
+    { 0xE6, 0xE6 }, /* MOD_CALIB_CFG2 */
+    { 0xED, 0xED }, /* MOD_GAIN_H */
+    { 0xF4, 0xF5 }, /* VSYNC_PERIOD_TARGET_L - VSYNC_PERIOD_TARGET_H */
+    { 0xF7, 0xFC }  /* VSYNC_CFG - FIFO_THR */
+};
+
 /*
  * These notes indicate the default configuration of the TSL2585 specifically.
  * Other sensors in the series may have different defaults.
@@ -59,119 +91,6 @@ static const uint8_t TSL2585_ADDRESS = 0x39;
  * ALSIntegrationTimeStep = (SAMPLE_TIME+1) * 1.388889μs
  */
 
-/* Registers */
-#define TSL2585_UV_CALIB         0x08 /*!< UV calibration factor */
-#define TSL2585_MOD_CHANNEL_CTRL 0x40 /*!< Modulator channel control */
-#define TSL2585_ENABLE           0x80 /*!< Enables device states */
-#define TSL2585_MEAS_MODE0       0x81 /*!< Measurement mode settings 0 */
-#define TSL2585_MEAS_MODE1       0x82 /*!< Measurement mode settings 1 */
-#define TSL2585_SAMPLE_TIME0     0x83 /*!< Flicker sample time settings 0 [7:0] */
-#define TSL2585_SAMPLE_TIME1     0x84 /*!< Flicker sample time settings 1 [10:8] */
-#define TSL2585_ALS_NR_SAMPLES0  0x85 /*!< ALS measurement time settings 0 [7:0] */
-#define TSL2585_ALS_NR_SAMPLES1  0x86 /*!< ALS measurement time settings 1 [10:8] */
-#define TSL2585_FD_NR_SAMPLES0   0x87 /*!< Flicker number of samples 0 [7:0] */
-#define TSL2585_FD_NR_SAMPLES1   0x88 /*!< Flicker number of samples 1 [10:8] */
-#define TSL2585_WTIME            0x89 /*!< Wait time */
-#define TSL2585_AILT0            0x8A /*!< ALS Interrupt Low Threshold [7:0] */
-#define TSL2585_AILT1            0x8B /*!< ALS Interrupt Low Threshold [15:8] */
-#define TSL2585_AILT2            0x8C /*!< ALS Interrupt Low Threshold [23:16] */
-#define TSL2585_AIHT0            0x8D /*!< ALS Interrupt High Threshold [7:0] */
-#define TSL2585_AIHT1            0x8E /*!< ALS Interrupt High Threshold [15:8] */
-#define TSL2585_AIHT2            0x8F /*!< ALS interrupt High Threshold [23:16] */
-#define TSL2585_AUX_ID           0x90 /*!< Auxiliary identification */
-#define TSL2585_REV_ID           0x91 /*!< Revision identification */
-#define TSL2585_ID               0x92 /*!< Device identification */
-#define TSL2585_STATUS           0x93 /*!< Device status information 1 */
-#define TSL2585_ALS_STATUS       0x94 /*!< ALS Status information 1 */
-#define TSL2585_ALS_DATA0_L      0x95 /*!< ALS data channel 0 low byte [7:0] */
-#define TSL2585_ALS_DATA0_H      0x96 /*!< ALS data channel 0 high byte [15:8] */
-#define TSL2585_ALS_DATA1_L      0x97 /*!< ALS data channel 1 low byte [7:0] */
-#define TSL2585_ALS_DATA1_H      0x98 /*!< ALS data channel 1 high byte [15:8] */
-#define TSL2585_ALS_DATA2_L      0x99 /*!< ALS data channel 2 low byte [7:0] */
-#define TSL2585_ALS_DATA2_H      0x9A /*!< ALS data channel 2 high byte [15:8] */
-#define TSL2585_ALS_STATUS2      0x9B /*!< ALS Status information 2 */
-#define TSL2585_ALS_STATUS3      0x9C /*!< ALS Status information 3 */
-#define TSL2585_STATUS2          0x9D /*!< Device Status information 2 */
-#define TSL2585_STATUS3          0x9E /*!< Device Status information 3 */
-#define TSL2585_STATUS4          0x9F /*!< Device Status information 4 */
-#define TSL2585_STATUS5          0xA0 /*!< Device Status information 5 */
-#define TSL2585_CFG0             0xA1 /*!< Configuration 0 */
-#define TSL2585_CFG1             0xA2 /*!< Configuration 1 */
-#define TSL2585_CFG2             0xA3 /*!< Configuration 2 */
-#define TSL2585_CFG3             0xA4 /*!< Configuration 3 */
-#define TSL2585_CFG4             0xA5 /*!< Configuration 4 */
-#define TSL2585_CFG5             0xA6 /*!< Configuration 5 */
-#define TSL2585_CFG6             0xA7 /*!< Configuration 6 */
-#define TSL2585_CFG7             0xA8 /*!< Configuration 7 */
-#define TSL2585_CFG8             0xA9 /*!< Configuration 8 */
-#define TSL2585_CFG9             0xAA /*!< Configuration 9 */
-#define TSL2585_AGC_NR_SAMPLES_L 0xAC /*!< Number of samples for measurement with AGC low [7:0] */
-#define TSL2585_AGC_NR_SAMPLES_H 0xAD /*!< Number of samples for measurement with AGC high [10:8] */
-#define TSL2585_TRIGGER_MODE     0xAE /*!< Wait Time Mode */
-#define TSL2585_CONTROL          0xB1 /*!< Device control settings */
-#define TSL2585_INTENAB          0xBA /*!< Enable interrupts */
-#define TSL2585_SIEN             0xBB /*!< Enable saturation interrupts */
-#define TSL2585_MOD_COMP_CFG1    0xCE /*!< Adjust AutoZero range */
-#define TSL2585_MEAS_SEQR_FD_0                  0xCF /*!< Flicker measurement with sequencer on modulator0 */
-#define TSL2585_MEAS_SEQR_ALS_FD_1              0xD0 /*!< ALS measurement with sequencer on all modulators */
-#define TSL2585_MEAS_SEQR_APERS_AND_VSYNC_WAIT  0xD1 /*!< Defines the measurement sequencer pattern */
-#define TSL2585_MEAS_SEQR_RESIDUAL_0            0xD2 /*!< Residual measurement configuration with sequencer on modulator0 and modulator1 */
-#define TSL2585_MEAS_SEQR_RESIDUAL_1_AND_WAIT   0xD3 /*!< Residual measurement configuration with sequencer on modulator2 and wait time configuration for all sequencers */
-#define TSL2585_MEAS_SEQR_STEP0_MOD_GAINX_L     0xD4 /*!< Gain of modulator0 and modulator1 for sequencer step 0 */
-#define TSL2585_MEAS_SEQR_STEP0_MOD_GAINX_H     0xD5 /*!< Gain of modulator2 for sequencer step 0 */
-#define TSL2585_MEAS_SEQR_STEP1_MOD_GAINX_L     0xD6 /*!< Gain of modulator0 and modulator1 for sequencer step 1 */
-#define TSL2585_MEAS_SEQR_STEP1_MOD_GAINX_H     0xD7 /*!< Gain of modulator2 for sequencer step 1 */
-#define TSL2585_MEAS_SEQR_STEP2_MOD_GAINX_L     0xD8 /*!< Gain of modulator0 and modulator1 for sequencer step 2 */
-#define TSL2585_MEAS_SEQR_STEP2_MOD_GAINX_H     0xD9 /*!< Gain of modulator2 for sequencer step 2 */
-#define TSL2585_MEAS_SEQR_STEP3_MOD_GAINX_L     0xDA /*!< Gain of modulator0 and modulator1 for sequencer step 3 */
-#define TSL2585_MEAS_SEQR_STEP3_MOD_GAINX_H     0xDB /*!< Gain of modulator2 for sequencer step 3 */
-#define TSL2585_MEAS_SEQR_STEP0_MOD_PHDX_SMUX_L 0xDC /*!< Photodiode 0-3 to modulator mapping through multiplexer for sequencer step 0 */
-#define TSL2585_MEAS_SEQR_STEP0_MOD_PHDX_SMUX_H 0xDD /*!< Photodiode 4-5 to modulator mapping through multiplexer for sequencer step 0 */
-#define TSL2585_MEAS_SEQR_STEP1_MOD_PHDX_SMUX_L 0xDE /*!< Photodiode 0-3 to modulator mapping through multiplexer for sequencer step 1 */
-#define TSL2585_MEAS_SEQR_STEP1_MOD_PHDX_SMUX_H 0xDF /*!< Photodiode 4-5 to modulator mapping through multiplexer for sequencer step 1 */
-#define TSL2585_MEAS_SEQR_STEP2_MOD_PHDX_SMUX_L 0xE0 /*!< Photodiode 0-3 to modulator mapping through multiplexer for sequencer step 2 */
-#define TSL2585_MEAS_SEQR_STEP2_MOD_PHDX_SMUX_H 0xE1 /*!< Photodiode 4-5 to modulator mapping through multiplexer for sequencer step 2 */
-#define TSL2585_MEAS_SEQR_STEP3_MOD_PHDX_SMUX_L 0xE2 /*!< Photodiode 0-3 to modulator mapping through multiplexer for sequencer step 3 */
-#define TSL2585_MEAS_SEQR_STEP3_MOD_PHDX_SMUX_H 0xE3 /*!< Photodiode 4-5 to modulator mapping through multiplexer for sequencer step 3 */
-#define TSL2585_MOD_CALIB_CFG0   0xE4 /*!< Modulator calibration config0 */
-#define TSL2585_MOD_CALIB_CFG2   0xE6 /*!< Modulator calibration config2 */
-#define TSL2585_MOD_GAIN_H       0xED /*!< Modulator gain table selection (undocumented, from app note) */
-#define TSL2585_VSYNC_PERIOD_L        0xF2 /*!< Measured VSYNC period */
-#define TSL2585_VSYNC_PERIOD_H        0xF3 /*!< Read and clear measured VSYNC period */
-#define TSL2585_VSYNC_PERIOD_TARGET_L 0xF4 /*!< Targeted VSYNC period */
-#define TSL2585_VSYNC_PERIOD_TARGET_H 0xF5 /*!< Alternative target VSYNC period */
-#define TSL2585_VSYNC_CONTROL         0xF6 /*!< Control of VSYNC period */
-#define TSL2585_VSYNC_CFG             0xF7 /*!< Configuration of VSYNC input */
-#define TSL2585_VSYNC_GPIO_INT        0xF8 /*!< Configuration of GPIO pin */
-#define TSL2585_MOD_FIFO_DATA_CFG0 0xF9 /*!< Configuration of FIFO access for modulator 0 */
-#define TSL2585_MOD_FIFO_DATA_CFG1 0xFA /*!< Configuration of FIFO access for modulator 1 */
-#define TSL2585_MOD_FIFO_DATA_CFG2 0xFB /*!< Configuration of FIFO access for modulator 2 */
-#define TSL2585_FIFO_THR         0xFC /*!< Configuration of FIFO threshold interrupt */
-#define TSL2585_FIFO_STATUS0     0xFD /*!< FIFO status information 0 */
-#define TSL2585_FIFO_STATUS1     0xFE /*!< FIFO status information 1 */
-#define TSL2585_FIFO_DATA        0xFF /*!< FIFO readout */
-
-/* CFG0 register values */
-#define TSL2585_CFG0_SAI                 0x40
-#define TSL2585_CFG0_LOWPOWER_IDLE       0x20
-
-/* CONTROL register values */
-#define TSL2585_CONTROL_SOFT_RESET       0x08
-#define TSL2585_CONTROL_FIFO_CLR         0x02
-#define TSL2585_CONTROL_CLEAR_SAI_ACTIVE 0x01
-
-/* MOD_CALIB_CFG2 register values */
-#define TSL2585_MOD_CALIB_NTH_ITERATION_RC_ENABLE 0x80
-#define TSL2585_MOD_CALIB_NTH_ITERATION_AZ_ENABLE 0x40
-#define TSL2585_MOD_CALIB_NTH_ITERATION_AGC_ENABLE 0x20
-#define TSL2585_MOD_CALIB_RESIDUAL_ENABLE_AUTO_CALIB_ON_GAIN_CHANGE 0x10
-
-/* MEAS_MODE0 register values */
-#define TSL2585_MEAS_MODE0_STOP_AFTER_NTH_ITERATION 0x80
-#define TSL2585_MEAS_MODE0_ENABLE_AGC_ASAT_DOUBLE_STEP_DOWN 0x40
-#define TSL2585_MEAS_MODE0_MEASUREMENT_SEQUENCER_SINGLE_SHOT_MODE 0x20
-#define TSL2585_MEAS_MODE0_MOD_FIFO_ALS_STATUS_WRITE_ENABLE 0x10
-
 TSL2585::TSL2585(Ft260 *ft260) : ft260_(ft260)
 {
 }
@@ -186,7 +105,14 @@ bool TSL2585::init(tsl2585_ident_t *ident)
 
     qDebug() << "Initializing TSL25XX sensor";
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_ID, &devId)) { return false; }
+    QList<Ft260I2cOp> ops = {
+        Ft260I2cOp::read(TSL2585_ADDRESS, TSL2585_ID, 1),
+        Ft260I2cOp::read(TSL2585_ADDRESS, TSL2585_REV_ID, 1),
+        Ft260I2cOp::read(TSL2585_ADDRESS, TSL2585_AUX_ID, 1)
+    };
+    if (!ft260_->i2cTransaction(ops)) { return false; }
+
+    devId = static_cast<quint8>(ops[0].data[0]);
 
     qDebug() << "Device ID:" << Qt::hex << devId;
 
@@ -195,12 +121,11 @@ bool TSL2585::init(tsl2585_ident_t *ident)
         return false;
     }
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_REV_ID, &revId)) { return false; }
+    revId = static_cast<quint8>(ops[1].data[0]);
 
     qDebug() << "Revision ID:" << Qt::hex << revId;
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_AUX_ID, &data)) { return false; }
-    auxId = (data & 0x0F);
+    auxId = (static_cast<quint8>(ops[2].data[0]) & 0x0F);
 
     qDebug() << "Aux ID:" << Qt::hex << auxId;
 
@@ -243,7 +168,18 @@ bool TSL2585::init(tsl2585_ident_t *ident)
 bool TSL2585::setEnable(uint8_t value)
 {
     uint8_t data = value & 0x43; /* Mask bits 6,1:0 */
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_ENABLE, data);
+
+    // Flush any pending configuration changes ahead of the enable write,
+    // so they all go out to the device as part of the same transaction.
+    QList<Ft260I2cOp> ops;
+    appendShadowWrites(&ops);
+    ops.append(Ft260I2cOp::writeByte(TSL2585_ADDRESS, TSL2585_ENABLE, data));
+
+    if (!ft260_->i2cTransaction(ops)) { return false; }
+
+    shadowDirty_.reset();
+    powered_ = (data & TSL2585_ENABLE_PON) != 0;
+    return true;
 }
 
 bool TSL2585::enable()
@@ -259,14 +195,19 @@ bool TSL2585::disable()
 bool TSL2585::setInterruptEnable(uint8_t value)
 {
     uint8_t data = value & 0x8D; /* Mask bits 7,3,2,0 */
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_INTENAB, data);
+    return writeRegister(TSL2585_INTENAB, data);
 }
 
 bool TSL2585::softReset()
 {
     uint8_t data = TSL2585_CONTROL_SOFT_RESET;
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_CONTROL, data);
+    if (!ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_CONTROL, data)) { return false; }
+
+    // All registers return to their defaults, including ENABLE
+    invalidateShadow();
+    powered_ = false;
+    return true;
 }
 
 bool TSL2585::clearFifo()
@@ -281,13 +222,13 @@ bool TSL2585::enableModulators(tsl2585_modulator_t mods)
     /* Mask bits [2:0] and invert since asserting disables the modulators */
     uint8_t data = ~((uint8_t)mods) & 0x03;
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_MOD_CHANNEL_CTRL, data);
+    return writeRegister(TSL2585_MOD_CHANNEL_CTRL, data);
 }
 
 bool TSL2585::getStatus(uint8_t *status)
 {
     uint8_t data;
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_STATUS, &data)) { return false; }
+    if (!readRegister(TSL2585_STATUS, &data)) { return false; }
 
     if (status) {
         *status = data;
@@ -297,13 +238,13 @@ bool TSL2585::getStatus(uint8_t *status)
 
 bool TSL2585::setStatus(uint8_t status)
 {
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_STATUS, status);
+    return writeRegister(TSL2585_STATUS, status);
 }
 
 bool TSL2585::getStatus2(uint8_t *status)
 {
     uint8_t data;
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_STATUS2, &data)) { return false; }
+    if (!readRegister(TSL2585_STATUS2, &data)) { return false; }
 
     if (status) {
         *status = data;
@@ -314,7 +255,7 @@ bool TSL2585::getStatus2(uint8_t *status)
 bool TSL2585::getStatus3(uint8_t *status)
 {
     uint8_t data;
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_STATUS3, &data)) { return false; }
+    if (!readRegister(TSL2585_STATUS3, &data)) { return false; }
 
     if (status) {
         *status = data;
@@ -325,7 +266,7 @@ bool TSL2585::getStatus3(uint8_t *status)
 bool TSL2585::getStatus4(uint8_t *status)
 {
     uint8_t data;
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_STATUS4, &data)) { return false; }
+    if (!readRegister(TSL2585_STATUS4, &data)) { return false; }
 
     if (status) {
         *status = data;
@@ -336,7 +277,7 @@ bool TSL2585::getStatus4(uint8_t *status)
 bool TSL2585::getStatus5(uint8_t *status)
 {
     uint8_t data;
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_STATUS5, &data)) { return false; }
+    if (!readRegister(TSL2585_STATUS5, &data)) { return false; }
 
     if (status) {
         *status = data;
@@ -352,22 +293,22 @@ bool TSL2585::setModGainTableSelect(bool alternate)
      * This register is completely undocumented in the actual datasheet.
      */
     uint8_t data;
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_MOD_GAIN_H, &data)) { return false; }
+    if (!readRegister(TSL2585_MOD_GAIN_H, &data)) { return false; }
 
     data = (data & 0xCF) | (alternate ? 0x30 : 0x00);
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_MOD_GAIN_H, data);
+    return writeRegister(TSL2585_MOD_GAIN_H, data);
 }
 
 bool TSL2585::setMaxModGain(tsl2585_gain_t gain)
 {
     uint8_t data;
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_CFG8, &data)) { return false; }
+    if (!readRegister(TSL2585_CFG8, &data)) { return false; }
 
     data = (data & 0x0F) | (((uint8_t)gain & 0x0F) << 4);
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_CFG8, data);
+    return writeRegister(TSL2585_CFG8, data);
 }
 
 bool TSL2585::gainRegister(tsl2585_modulator_t mod, tsl2585_step_t step, uint8_t *reg, bool *upper)
@@ -420,7 +361,7 @@ bool TSL2585::setModGain(tsl2585_modulator_t mod, tsl2585_step_t step, tsl2585_g
         return false;
     }
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, reg, &data)) { return false; }
+    if (!readRegister(reg, &data)) { return false; }
 
     if (upper) {
         data = (data & 0x0F) | ((uint8_t)gain << 4);
@@ -428,7 +369,7 @@ bool TSL2585::setModGain(tsl2585_modulator_t mod, tsl2585_step_t step, tsl2585_g
         data = (data & 0xF0) | (uint8_t)gain;
     }
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, reg, data);
+    return writeRegister(reg, data);
 }
 
 bool TSL2585::setModResidualEnable(tsl2585_modulator_t mod, tsl2585_step_t steps)
@@ -454,7 +395,7 @@ bool TSL2585::setModResidualEnable(tsl2585_modulator_t mod, tsl2585_step_t steps
         return false;
     }
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, reg, &data)) { return false; }
+    if (!readRegister(reg, &data)) { return false; }
 
     if (upper) {
         data = (data & 0x0F) | (((uint8_t)steps) & 0x0F) << 4;
@@ -462,7 +403,7 @@ bool TSL2585::setModResidualEnable(tsl2585_modulator_t mod, tsl2585_step_t steps
         data = (data & 0xF0) | (((uint8_t)steps) & 0x0F);
     }
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, reg, data);
+    return writeRegister(reg, data);
 }
 
 bool TSL2585::setModPhotodiodeSmux(tsl2585_step_t step, const photodiode_modulator_array_t &phd_mod)
@@ -509,10 +450,8 @@ bool TSL2585::setModPhotodiodeSmux(tsl2585_step_t step, const photodiode_modulat
     }
 
     /* Read the current value */
-    buf = ft260_->i2cRead(TSL2585_ADDRESS, reg, 2);
-    if (buf.isEmpty()) { return false; }
-    data[0] = static_cast<quint8>(buf[0]);
-    data[1] = static_cast<quint8>(buf[1]);
+    if (!readRegister(reg, &data[0])) { return false; }
+    if (!readRegister(reg + 1, &data[1])) { return false; }
 
     /* Clear everything but the unrelated or reserved bits */
     data[0] = 0;
@@ -530,12 +469,12 @@ bool TSL2585::setModPhotodiodeSmux(tsl2585_step_t step, const photodiode_modulat
     buf.clear();
     buf.append(static_cast<uint8_t>(data[0]));
     buf.append(static_cast<uint8_t>(data[1]));
-    return ft260_->i2cWrite(TSL2585_ADDRESS, reg, buf);
+    return writeRegisters(reg, buf);
 }
 
 bool TSL2585::setCalibrationNthIteration(uint8_t iteration)
 {
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_MOD_CALIB_CFG0, iteration);
+    return writeRegister(TSL2585_MOD_CALIB_CFG0, iteration);
 }
 
 bool TSL2585::setSampleTime(uint16_t value)
@@ -549,7 +488,7 @@ bool TSL2585::setSampleTime(uint16_t value)
     buf.append(static_cast<uint8_t>(value & 0x0FF));
     buf.append(static_cast<uint8_t>((value & 0x700) >> 8));
 
-    return ft260_->i2cWrite(TSL2585_ADDRESS, TSL2585_SAMPLE_TIME0, buf);
+    return writeRegisters(TSL2585_SAMPLE_TIME0, buf);
 }
 
 bool TSL2585::setAlsNumSamples(uint16_t value)
@@ -563,29 +502,29 @@ bool TSL2585::setAlsNumSamples(uint16_t value)
     buf.append(static_cast<uint8_t>(value & 0x0FF));
     buf.append(static_cast<uint8_t>((value & 0x700) >> 8));
 
-    return ft260_->i2cWrite(TSL2585_ADDRESS, TSL2585_ALS_NR_SAMPLES0, buf);
+    return writeRegisters(TSL2585_ALS_NR_SAMPLES0, buf);
 }
 
 bool TSL2585::setAlsInterruptPersistence(uint8_t value)
 {
     uint8_t data;
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_CFG5, &data)) { return false; }
+    if (!readRegister(TSL2585_CFG5, &data)) { return false; }
 
     data = (data & 0xF0) | (value & 0x0F);
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_CFG5, data);
+    return writeRegister(TSL2585_CFG5, data);
 }
 
 bool TSL2585::getAlsStatus(uint8_t *status)
 {
-    return ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_ALS_STATUS, status);
+    return readRegister(TSL2585_ALS_STATUS, status);
 }
 
 bool TSL2585::getAlsScale(uint8_t *scale)
 {
     uint8_t data;
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_MEAS_MODE0, &data)) { return false; }
+    if (!readRegister(TSL2585_MEAS_MODE0, &data)) { return false; }
 
     if (scale) {
         *scale = data & 0x0F;
@@ -604,46 +543,46 @@ bool TSL2585::setAgcNumSamples(uint16_t value)
     buf.append(static_cast<uint8_t>(value & 0x0FF));
     buf.append(static_cast<uint8_t>((value & 0x700) >> 8));
 
-    return ft260_->i2cWrite(TSL2585_ADDRESS, TSL2585_AGC_NR_SAMPLES_L, buf);
+    return writeRegisters(TSL2585_AGC_NR_SAMPLES_L, buf);
 }
 
 bool TSL2585::setAgcCalibration(bool enabled)
 {
     uint8_t data;
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_MOD_CALIB_CFG2, &data)) { return false; }
+    if (!readRegister(TSL2585_MOD_CALIB_CFG2, &data)) { return false; }
 
     data = (data & ~TSL2585_MOD_CALIB_NTH_ITERATION_AGC_ENABLE) | (enabled ? TSL2585_MOD_CALIB_NTH_ITERATION_AGC_ENABLE : 0);
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_MOD_CALIB_CFG2, data);
+    return writeRegister(TSL2585_MOD_CALIB_CFG2, data);
 }
 
 bool TSL2585::setFifoAlsStatusWriteEnable(bool enable)
 {
     uint8_t data;
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_MEAS_MODE0, &data)) { return false; }
+    if (!readRegister(TSL2585_MEAS_MODE0, &data)) { return false; }
 
     data = (data & 0xEF) | (enable ? 0x10 : 0x00);
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_MEAS_MODE0, data);
+    return writeRegister(TSL2585_MEAS_MODE0, data);
 }
 
 bool TSL2585::setFifoAlsDataFormat(tsl2585_als_fifo_data_format_t format)
 {
     uint8_t data;
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_CFG4, &data)) { return false; }
+    if (!readRegister(TSL2585_CFG4, &data)) { return false; }
 
     data = (data & 0x03) | format;
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_CFG4, data);
+    return writeRegister(TSL2585_CFG4, data);
 }
 
 bool TSL2585::getAlsMsbPosition(uint8_t *position)
 {
     uint8_t data;
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_MEAS_MODE1, &data)) { return false; }
+    if (!readRegister(TSL2585_MEAS_MODE1, &data)) { return false; }
 
     if (position) {
         *position = data & 0x1F;
@@ -655,17 +594,17 @@ bool TSL2585::setAlsMsbPosition(uint8_t position)
 {
     uint8_t data;
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_MEAS_MODE1, &data)) { return false; }
+    if (!readRegister(TSL2585_MEAS_MODE1, &data)) { return false; }
 
     data = (data & 0xE0) | (position & 0x1F);
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_MEAS_MODE1, data);
+    return writeRegister(TSL2585_MEAS_MODE1, data);
 }
 
 bool TSL2585::getTriggerMode(tsl2585_trigger_mode_t *mode)
 {
     uint8_t data;
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_TRIGGER_MODE, &data)) { return false; }
+    if (!readRegister(TSL2585_TRIGGER_MODE, &data)) { return false; }
 
     if (mode) {
         *mode = static_cast<tsl2585_trigger_mode_t>(data & 0x07);
@@ -675,7 +614,7 @@ bool TSL2585::getTriggerMode(tsl2585_trigger_mode_t *mode)
 
 bool TSL2585::setTriggerMode(tsl2585_trigger_mode_t mode)
 {
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_TRIGGER_MODE, static_cast<uint8_t>(mode));
+    return writeRegister(TSL2585_TRIGGER_MODE, static_cast<uint8_t>(mode));
 }
 
 bool TSL2585::getAlsData0(uint16_t *data)
@@ -733,11 +672,11 @@ bool TSL2585::setFifoDataWriteEnable(tsl2585_modulator_t mod, bool enable)
         return false;
     }
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, reg, &data)) { return false; }
+    if (!readRegister(reg, &data)) { return false; }
 
     data = (data & 0x7F) | (enable ? 0x80 : 0x00);
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, reg, data);
+    return writeRegister(reg, data);
 }
 
 bool TSL2585::setFifoThreshold(uint16_t threshold)
@@ -747,22 +686,23 @@ bool TSL2585::setFifoThreshold(uint16_t threshold)
 
     if (threshold > 0x01FF) { return false; }
 
-    if (!ft260_->i2cReadByte(TSL2585_ADDRESS, TSL2585_CFG2, &data0)) { return false; }
+    if (!readRegister(TSL2585_CFG2, &data0)) { return false; }
 
     data0 = (data0 & 0xFE) | (threshold & 0x0001);
     data1 = threshold >> 1;
 
     /* CFG2 contains FIFO_THR[0] */
-    if (!ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_CFG2, data0)) { return false; }
+    if (!writeRegister(TSL2585_CFG2, data0)) { return false; }
 
     /* FIFO_THR contains FIFO_THR[8:1] */
-    if (!ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_FIFO_THR, data1)) { return false; }
+    if (!writeRegister(TSL2585_FIFO_THR, data1)) { return false; }
 
     return true;
 }
 
 bool TSL2585::getFifoStatus(tsl2585_fifo_status_t *status)
 {
+    TRACE_SCOPE("TSL2585::getFifoStatus");
     QByteArray buf;
     buf = ft260_->i2cRead(TSL2585_ADDRESS, TSL2585_FIFO_STATUS0, 2);
     if (buf.isEmpty()) { return false; }
@@ -770,7 +710,7 @@ bool TSL2585::getFifoStatus(tsl2585_fifo_status_t *status)
     if (status) {
         status->overflow = (static_cast<uint8_t>(buf[1]) & 0x80) ==  0x80;
         status->underflow = (static_cast<uint8_t>(buf[1]) & 0x40) == 0x40;
-        status->level = (static_cast<uint16_t>(buf[0]) << 2) | (static_cast<uint16_t>(buf[1]) & 0x03);
+        status->level = (static_cast<uint16_t>(static_cast<uint8_t>(buf[0])) << 2) | (static_cast<uint8_t>(buf[1]) & 0x03);
     }
 
     return true;
@@ -788,6 +728,48 @@ QByteArray TSL2585::readFifo(uint16_t len)
     return ft260_->i2cRead(TSL2585_ADDRESS, TSL2585_FIFO_DATA, len);
 }
 
+QByteArray TSL2585::readFifo(uint16_t len, tsl2585_fifo_status_t *status)
+{
+    TRACE_SCOPE("TSL2585::readFifo");
+    if (len == 0 || len > 512) {
+        return QByteArray();
+    }
+
+    // The transfer limit of the adapter is far below the FIFO size,
+    // so split the read into as many back-to-back chunks as it takes.
+    QList<Ft260I2cOp> ops;
+    ops.reserve((len / HID_MAX_TRAN_SIZE) + 2);
+    for (uint16_t offset = 0; offset < len; offset += HID_MAX_TRAN_SIZE) {
+        const quint8 chunk = static_cast<quint8>(qMin<uint16_t>(len - offset, HID_MAX_TRAN_SIZE));
+        ops.append(Ft260I2cOp::read(TSL2585_ADDRESS, TSL2585_FIFO_DATA, chunk));
+    }
+    ops.append(Ft260I2cOp::read(TSL2585_ADDRESS, TSL2585_FIFO_STATUS0, 2));
+
+    static MetricHistogram &readLatency = Metrics::histogram(QStringLiteral("tsl2585.fifo.read_latency"));
+    static MetricCounter &readBytes = Metrics::counter(QStringLiteral("tsl2585.fifo.bytes"));
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!ft260_->i2cTransaction(ops)) { return QByteArray(); }
+
+    readLatency.record(static_cast<quint64>(timer.nsecsElapsed() / 1000));
+    readBytes.add(len);
+
+    if (status) {
+        const QByteArray &buf = ops.last().data;
+        status->overflow = (static_cast<uint8_t>(buf[1]) & 0x80) ==  0x80;
+        status->underflow = (static_cast<uint8_t>(buf[1]) & 0x40) == 0x40;
+        status->level = (static_cast<uint16_t>(static_cast<uint8_t>(buf[0])) << 2) | (static_cast<uint8_t>(buf[1]) & 0x03);
+    }
+
+    QByteArray data;
+    data.reserve(len);
+    for (qsizetype i = 0; i < ops.size() - 1; i++) {
+        data.append(ops[i].data);
+    }
+    return data;
+}
+
 bool TSL2585::getVSyncPeriod(uint16_t *period)
 {
     QByteArray buf;
@@ -811,28 +793,183 @@ bool TSL2585::setVSyncPeriodTarget(uint16_t periodTarget, bool useFastTiming)
     buf.append(static_cast<uint8_t>(periodTarget & 0x00FF));
     buf.append(static_cast<uint8_t>((periodTarget & 0x7F00) >> 8) | (useFastTiming ? 0x80 : 0x00));
 
-    return ft260_->i2cWrite(TSL2585_ADDRESS, TSL2585_VSYNC_PERIOD_TARGET_L, buf);
+    return writeRegisters(TSL2585_VSYNC_PERIOD_TARGET_L, buf);
 }
 
 bool TSL2585::setVSyncControl(uint8_t value)
 {
     uint8_t data = value & 0x03;
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_VSYNC_CONTROL, data);
+    return writeRegister(TSL2585_VSYNC_CONTROL, data);
 }
 
 bool TSL2585::setVSyncConfig(uint8_t value)
 {
     uint8_t data = value & 0xC7;
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_VSYNC_CFG, data);
+    return writeRegister(TSL2585_VSYNC_CFG, data);
 }
 
 bool TSL2585::setVSyncGpioInt(uint8_t value)
 {
     uint8_t data = value & 0x7F;
 
-    return ft260_->i2cWriteByte(TSL2585_ADDRESS, TSL2585_VSYNC_GPIO_INT, data);
+    return writeRegister(TSL2585_VSYNC_GPIO_INT, data);
+}
+
+bool TSL2585::readRegister(uint8_t reg, uint8_t *value)
+{
+    TRACE_SCOPE("TSL2585::readRegister");
+    if (!isShadowed(reg)) {
+        return ft260_->i2cReadByte(TSL2585_ADDRESS, reg, value);
+    }
+
+    if (!shadowValid_.test(reg) && !loadShadow()) { return false; }
+
+    static MetricCounter &shadowReads = Metrics::counter(QStringLiteral("tsl2585.shadow.reads"));
+    shadowReads.add();
+
+    if (value) {
+        *value = shadow_[reg];
+    }
+    return true;
+}
+
+bool TSL2585::writeRegister(uint8_t reg, uint8_t value)
+{
+    return writeRegisters(reg, QByteArray(1, static_cast<char>(value)));
+}
+
+bool TSL2585::writeRegisters(uint8_t reg, const QByteArray &data)
+{
+    TRACE_SCOPE("TSL2585::writeRegisters");
+    if (data.isEmpty() || reg + data.size() > 0x100) { return false; }
+
+    bool shadowed = true;
+    for (qsizetype i = 0; i < data.size(); i++) {
+        if (!isShadowed(reg + i)) {
+            shadowed = false;
+            break;
+        }
+    }
+
+    if (!shadowed) {
+        if (!ft260_->i2cWrite(TSL2585_ADDRESS, reg, data)) { return false; }
+
+        for (qsizetype i = 0; i < data.size(); i++) {
+            const uint8_t r = reg + i;
+            if (isShadowed(r)) {
+                shadow_[r] = static_cast<uint8_t>(data[i]);
+                shadowValid_.set(r);
+                shadowDirty_.reset(r);
+            }
+        }
+        return true;
+    }
+
+    static MetricCounter &skippedWrites = Metrics::counter(QStringLiteral("tsl2585.shadow.skipped_writes"));
+    for (qsizetype i = 0; i < data.size(); i++) {
+        const uint8_t r = reg + i;
+        const uint8_t value = static_cast<uint8_t>(data[i]);
+        if (shadowValid_.test(r) && shadow_[r] == value) {
+            skippedWrites.add();
+            continue;
+        }
+
+        shadow_[r] = value;
+        shadowValid_.set(r);
+        shadowDirty_.set(r);
+    }
+
+    // Changes made while the sensor is powered take effect immediately,
+    // otherwise they are held until the next call to enable().
+    if (powered_) {
+        return flushShadow();
+    }
+    return true;
+}
+
+bool TSL2585::loadShadow()
+{
+    TRACE_SCOPE("TSL2585::loadShadow");
+    QList<Ft260I2cOp> ops;
+    for (const auto &range : TSL2585_SHADOW_RANGES) {
+        ops.append(Ft260I2cOp::read(TSL2585_ADDRESS, range.first, range.last - range.first + 1));
+    }
+
+    if (!ft260_->i2cTransaction(ops)) { return false; }
+
+    for (const Ft260I2cOp &op : std::as_const(ops)) {
+        for (int i = 0; i < op.len; i++) {
+            const uint8_t r = op.reg + i;
+
+            // Keep any changes that have not been written out yet
+            if (shadowDirty_.test(r)) { continue; }
+
+            shadow_[r] = static_cast<uint8_t>(op.data[i]);
+            shadowValid_.set(r);
+        }
+    }
+    return true;
+}
+
+bool TSL2585::flushShadow()
+{
+    TRACE_SCOPE("TSL2585::flushShadow");
+    QList<Ft260I2cOp> ops;
+    appendShadowWrites(&ops);
+    if (ops.isEmpty()) { return true; }
+
+    static MetricCounter &bursts = Metrics::counter(QStringLiteral("tsl2585.shadow.bursts"));
+    bursts.add(ops.size());
+
+    if (!ft260_->i2cTransaction(ops)) { return false; }
+
+    shadowDirty_.reset();
+    return true;
+}
+
+void TSL2585::appendShadowWrites(QList<Ft260I2cOp> *ops) const
+{
+    for (const auto &range : TSL2585_SHADOW_RANGES) {
+        int reg = range.first;
+        while (reg <= range.last) {
+            if (!shadowDirty_.test(reg)) {
+                reg++;
+                continue;
+            }
+
+            // Extend the burst over following dirty registers, bridging
+            // short gaps of clean registers with their cached values
+            const int start = reg;
+            int end = reg;
+            for (int next = reg + 1; next <= range.last && next - start < TSL2585_BURST_MAX; next++) {
+                if (shadowDirty_.test(next)) {
+                    end = next;
+                } else if (!shadowValid_.test(next) || next - end > TSL2585_BURST_GAP) {
+                    break;
+                }
+            }
+
+            const QByteArray data(reinterpret_cast<const char *>(shadow_.data() + start), end - start + 1);
+            ops->append(Ft260I2cOp::write(TSL2585_ADDRESS, start, data));
+            reg = end + 1;
+        }
+    }
+}
+
+void TSL2585::invalidateShadow()
+{
+    shadowValid_.reset();
+    shadowDirty_.reset();
+}
+
+bool TSL2585::isShadowed(int reg)
+{
+    for (const auto &range : TSL2585_SHADOW_RANGES) {
+        if (reg >= range.first && reg <= range.last) { return true; }
+    }
+    return false;
 }
 
 tsl2585_sensor_type_t TSL2585::sensorType(const tsl2585_ident_t *ident)
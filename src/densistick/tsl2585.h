@@ -2,6 +2,9 @@
 #define TSL2585_H
 
 #include <QString>
+#include <QList>
+#include <array>
+#include <bitset>
 #include <stdint.h>
 
 #define TSL2585_SAMPLE_TIME_BASE 1.388889F /*!< Sample time base in microseconds */
@@ -202,7 +205,16 @@ typedef enum {
 #define TSL2585_GPIO_INT_VSYNC_GPIO_IN     0x01 /*!< External HIGH or LOW value applied to the VSYNC/GPIO pin */
 
 class Ft260;
+struct Ft260I2cOp;
 
+/**
+ * Driver for the TSL2585 family of ambient light sensors.
+ *
+ * Configuration registers are mirrored in a shadow register cache, so
+ * setters only go to the device for values that have actually changed.
+ * While the sensor is powered off, those changes are held back and
+ * written out in a single batch by the next call to enable().
+ */
 class TSL2585
 {
 public:
@@ -278,6 +290,13 @@ public:
 
     QByteArray readFifo(uint16_t len);
 
+    /**
+     * Read a block from the FIFO along with the FIFO status that follows it,
+     * as a single batched transaction. Reads longer than the adapter can
+     * carry in one report are split into consecutive FIFO reads.
+     */
+    QByteArray readFifo(uint16_t len, tsl2585_fifo_status_t *status);
+
     bool getVSyncPeriod(uint16_t *period);
     bool setVSyncPeriodTarget(uint16_t periodTarget, bool useFastTiming);
     bool setVSyncControl(uint8_t value);
@@ -293,7 +312,21 @@ public:
 private:
     static bool gainRegister(tsl2585_modulator_t mod, tsl2585_step_t step, uint8_t *reg, bool *upper);
 
+    bool readRegister(uint8_t reg, uint8_t *value);
+    bool writeRegister(uint8_t reg, uint8_t value);
+    bool writeRegisters(uint8_t reg, const QByteArray &data);
+
+    bool loadShadow();
+    bool flushShadow();
+    void appendShadowWrites(QList<Ft260I2cOp> *ops) const;
+    void invalidateShadow();
+    static bool isShadowed(int reg);
+
     Ft260 *ft260_;
+    std::array<uint8_t, 256> shadow_ = {};
+    std::bitset<256> shadowValid_;
+    std::bitset<256> shadowDirty_;
+    bool powered_ = false;
 };
 
 #endif // TSL2585_H
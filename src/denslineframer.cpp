@@ -0,0 +1,103 @@
+#include "denslineframer.h"
+
+#include <string.h>
+
+namespace
+{
+/* Initial buffer size, which comfortably holds a burst of log lines */
+static const qsizetype INITIAL_CAPACITY = 4096;
+}
+
+DensLineFramer::DensLineFramer()
+    : readPos_(0), scanPos_(0), writePos_(0), lineStart_(0), blockStart_(-1)
+{
+}
+
+char *DensLineFramer::prepareWrite(qsizetype size)
+{
+    // Move whatever still has to be kept back to the start of the buffer,
+    // so it never grows beyond the longest line or block received
+    const qsizetype keep = blockStart_ >= 0 ? blockStart_ : readPos_;
+    if (keep > 0) {
+        const qsizetype remaining = writePos_ - keep;
+        if (remaining > 0) {
+            memmove(buffer_.data(), buffer_.constData() + keep, remaining);
+        }
+        readPos_ -= keep;
+        scanPos_ -= keep;
+        writePos_ -= keep;
+        lineStart_ = qMax<qsizetype>(0, lineStart_ - keep);
+        if (blockStart_ >= 0) { blockStart_ = 0; }
+    }
+
+    const qsizetype required = writePos_ + size;
+    if (required > buffer_.size()) {
+        buffer_.resize(qMax(required, qMax(INITIAL_CAPACITY, buffer_.size() * 2)));
+    }
+
+    return buffer_.data() + writePos_;
+}
+
+void DensLineFramer::commitWrite(qsizetype size)
+{
+    writePos_ = qMin(writePos_ + qMax<qsizetype>(0, size), buffer_.size());
+}
+
+void DensLineFramer::append(QByteArrayView data)
+{
+    if (data.isEmpty()) { return; }
+    memcpy(prepareWrite(data.size()), data.data(), data.size());
+    commitWrite(data.size());
+}
+
+bool DensLineFramer::nextLine(QByteArrayView *line)
+{
+    // Resume the scan where the last one left off, so a partial line
+    // is never searched twice while waiting for the rest of it
+    const char *start = buffer_.constData();
+    const void *end = memchr(start + scanPos_, '\n', writePos_ - scanPos_);
+    if (!end) {
+        scanPos_ = writePos_;
+        return false;
+    }
+
+    const qsizetype endPos = static_cast<const char *>(end) - start + 1;
+    lineStart_ = readPos_;
+    *line = QByteArrayView(start + readPos_, endPos - readPos_);
+    readPos_ = endPos;
+    scanPos_ = endPos;
+    return true;
+}
+
+void DensLineFramer::beginBlock()
+{
+    blockStart_ = readPos_;
+}
+
+QByteArrayView DensLineFramer::endBlock()
+{
+    if (blockStart_ < 0) { return QByteArrayView(); }
+
+    const qsizetype start = blockStart_;
+    blockStart_ = -1;
+    return QByteArrayView(buffer_.constData() + start, qMax<qsizetype>(0, lineStart_ - start));
+}
+
+bool DensLineFramer::hasBlock() const
+{
+    return blockStart_ >= 0;
+}
+
+qsizetype DensLineFramer::pendingSize() const
+{
+    return writePos_ - readPos_;
+}
+
+void DensLineFramer::clear()
+{
+    readPos_ = 0;
+    scanPos_ = 0;
+    writePos_ = 0;
+    lineStart_ = 0;
+    blockStart_ = -1;
+}
@@ -0,0 +1,62 @@
+#ifndef DENSLINEFRAMER_H
+#define DENSLINEFRAMER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+/**
+ * Splits the byte stream received from the device into lines.
+ *
+ * Incoming data is read straight into a reusable buffer, and every byte
+ * is only scanned once while looking for line endings. Lines are handed
+ * out as views into that buffer, which stay valid until the next call
+ * to prepareWrite() or clear().
+ *
+ * A multiline block can be kept in the buffer while its lines are being
+ * read, so it can be taken out as a whole once its last line arrives.
+ */
+class DensLineFramer
+{
+public:
+    DensLineFramer();
+
+    /**
+     * Make room for at least the given number of bytes, returning where
+     * they should be written. Invalidates any views handed out so far.
+     */
+    char *prepareWrite(qsizetype size);
+
+    /** Account for data written after a call to prepareWrite() */
+    void commitWrite(qsizetype size);
+
+    void append(QByteArrayView data);
+
+    /** Get the next complete line, including its line ending */
+    bool nextLine(QByteArrayView *line);
+
+    /** Keep everything from the next line onwards, until endBlock() is called */
+    void beginBlock();
+
+    /**
+     * Finish the block started with beginBlock(), returning everything
+     * received between that point and the start of the last line read.
+     */
+    QByteArrayView endBlock();
+
+    bool hasBlock() const;
+
+    /** Number of bytes received that are not yet part of a complete line */
+    qsizetype pendingSize() const;
+
+    void clear();
+
+private:
+    QByteArray buffer_;
+    qsizetype readPos_;
+    qsizetype scanPos_;
+    qsizetype writePos_;
+    qsizetype lineStart_;
+    qsizetype blockStart_;
+};
+
+#endif // DENSLINEFRAMER_H
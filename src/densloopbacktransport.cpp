@@ -0,0 +1,81 @@
+#include "densloopbacktransport.h"
+
+DensLoopbackTransport::DensLoopbackTransport(QObject *parent)
+    : DensBufferedTransport(parent)
+{
+}
+
+DensLoopbackTransport::~DensLoopbackTransport()
+{
+    if (peer_ && peer_->peer_ == this) {
+        peer_->peer_ = nullptr;
+    }
+}
+
+void DensLoopbackTransport::connectPair(DensLoopbackTransport *first, DensLoopbackTransport *second)
+{
+    if (!first || !second || first == second) { return; }
+    first->peer_ = second;
+    second->peer_ = first;
+}
+
+DensLoopbackTransport *DensLoopbackTransport::peer() const
+{
+    return peer_;
+}
+
+bool DensLoopbackTransport::open()
+{
+    if (!peer_) { return false; }
+    open_ = true;
+    return true;
+}
+
+void DensLoopbackTransport::close()
+{
+    open_ = false;
+    clearReceived();
+}
+
+bool DensLoopbackTransport::isOpen() const
+{
+    return open_;
+}
+
+QString DensLoopbackTransport::description() const
+{
+    return QLatin1String("loopback");
+}
+
+QString DensLoopbackTransport::errorString() const
+{
+    return peer_ ? QString() : QLatin1String("Not connected to a peer");
+}
+
+qint64 DensLoopbackTransport::write(const QByteArray &data)
+{
+    if (!open_ || !peer_) { return -1; }
+    peer_->receive(data);
+    return data.size();
+}
+
+void DensLoopbackTransport::receive(const QByteArray &data)
+{
+    if (!open_ || data.isEmpty()) { return; }
+
+    appendReceived(data);
+
+    // Coalesce all writes made before the event loop runs into one notification
+    if (!notifyPending_) {
+        notifyPending_ = true;
+        QMetaObject::invokeMethod(this, &DensLoopbackTransport::notifyReadyRead, Qt::QueuedConnection);
+    }
+}
+
+void DensLoopbackTransport::notifyReadyRead()
+{
+    notifyPending_ = false;
+    if (open_ && bytesAvailable() > 0) {
+        emit readyRead();
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef DENSLOOPBACKTRANSPORT_H
+#define DENSLOOPBACKTRANSPORT_H
+
+#include <QPointer>
+
+#include "densbufferedtransport.h"
+
+/**
+ * In-process transport, where everything written to one end shows up
+ * as readable data on its peer.
+ *
+ * Pairs are used to run the protocol stack against a simulated device
+ * within the same process, without any operating system involvement.
+ * Data is delivered to the peer through the event loop, just like it
+ * would be from a real port.
+ */
+class DensLoopbackTransport : public DensBufferedTransport
+{
+    Q_OBJECT
+public:
+    explicit DensLoopbackTransport(QObject *parent = nullptr);
+    ~DensLoopbackTransport();
+
+    /** Connect two endpoints to each other */
+    static void connectPair(DensLoopbackTransport *first, DensLoopbackTransport *second);
+
+    DensLoopbackTransport *peer() const;
+
+    virtual bool open() override;
+    virtual void close() override;
+    virtual bool isOpen() const override;
+
+    virtual QString description() const override;
+    virtual QString errorString() const override;
+
+    virtual qint64 write(const QByteArray &data) override;
+
+private:
+    void receive(const QByteArray &data);
+    void notifyReadyRead();
+
+    QPointer<DensLoopbackTransport> peer_;
+    bool open_ = false;
+    bool notifyPending_ = false;
+};
+
+#endif // DENSLOOPBACKTRANSPORT_H
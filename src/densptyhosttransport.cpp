@@ -0,0 +1,199 @@
+#include "densptyhosttransport.h"
+
+#include <QSocketNotifier>
+
+#include <string.h>
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+/*
+ * Limit on data waiting for the other end to read it. Like a real device
+ * whose host has stopped reading, anything beyond this is dropped.
+ */
+static const qsizetype MAX_WRITE_BUFFER = 1024 * 1024;
+
+static const qsizetype READ_CHUNK_SIZE = 4096;
+}
+
+DensPtyHostTransport::DensPtyHostTransport(QObject *parent)
+    : DensBufferedTransport(parent)
+{
+}
+
+DensPtyHostTransport::~DensPtyHostTransport()
+{
+    close();
+}
+
+QString DensPtyHostTransport::subordinatePath() const
+{
+    return subordinatePath_;
+}
+
+bool DensPtyHostTransport::open()
+{
+#ifdef Q_OS_UNIX
+    if (fd_ >= 0) { return true; }
+
+    do {
+        fd_ = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (fd_ < 0) { break; }
+
+        if (::grantpt(fd_) < 0 || ::unlockpt(fd_) < 0) { break; }
+
+        const char *name = ::ptsname(fd_);
+        if (!name) { break; }
+        subordinatePath_ = QString::fromLocal8Bit(name);
+
+        // Keep the subordinate end open, so the controlling end does not
+        // see a hangup whenever the application disconnects
+        subordinateFd_ = ::open(name, O_RDWR | O_NOCTTY);
+        if (subordinateFd_ < 0) { break; }
+
+        // Pass all bytes through untouched, as on a USB serial device
+        struct termios tio;
+        if (::tcgetattr(subordinateFd_, &tio) < 0) { break; }
+        ::cfmakeraw(&tio);
+        if (::tcsetattr(subordinateFd_, TCSANOW, &tio) < 0) { break; }
+
+        const int flags = ::fcntl(fd_, F_GETFL);
+        if (flags < 0 || ::fcntl(fd_, F_SETFL, flags | O_NONBLOCK) < 0) { break; }
+
+        readNotifier_ = new QSocketNotifier(fd_, QSocketNotifier::Read, this);
+        connect(readNotifier_, &QSocketNotifier::activated, this, &DensPtyHostTransport::onReadActivated);
+
+        writeNotifier_ = new QSocketNotifier(fd_, QSocketNotifier::Write, this);
+        writeNotifier_->setEnabled(false);
+        connect(writeNotifier_, &QSocketNotifier::activated, this, &DensPtyHostTransport::onWriteActivated);
+
+        errorString_.clear();
+        return true;
+    } while (0);
+
+    errorString_ = QString::fromLocal8Bit(::strerror(errno));
+    close();
+    return false;
+#else
+    errorString_ = QLatin1String("Pseudo-terminals are not supported on this platform");
+    return false;
+#endif
+}
+
+void DensPtyHostTransport::close()
+{
+    delete readNotifier_;
+    readNotifier_ = nullptr;
+    delete writeNotifier_;
+    writeNotifier_ = nullptr;
+
+#ifdef Q_OS_UNIX
+    if (subordinateFd_ >= 0) {
+        ::close(subordinateFd_);
+        subordinateFd_ = -1;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+#endif
+
+    subordinatePath_.clear();
+    clearReceived();
+    writeBuffer_.clear();
+}
+
+bool DensPtyHostTransport::isOpen() const
+{
+    return fd_ >= 0;
+}
+
+QString DensPtyHostTransport::description() const
+{
+    return subordinatePath_;
+}
+
+QString DensPtyHostTransport::errorString() const
+{
+    return errorString_;
+}
+
+qint64 DensPtyHostTransport::write(const QByteArray &data)
+{
+    if (fd_ < 0) { return -1; }
+
+    if (writeBuffer_.size() + data.size() > MAX_WRITE_BUFFER) {
+        errorString_ = QLatin1String("Write buffer full");
+        return -1;
+    }
+
+    writeBuffer_.append(data);
+    flushWriteBuffer();
+    return data.size();
+}
+
+void DensPtyHostTransport::onReadActivated()
+{
+#ifdef Q_OS_UNIX
+    bool received = false;
+    char buf[READ_CHUNK_SIZE];
+    for (;;) {
+        const ssize_t n = ::read(fd_, buf, sizeof(buf));
+        if (n > 0) {
+            appendReceived(QByteArrayView(buf, n));
+            received = true;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                errorString_ = QString::fromLocal8Bit(::strerror(errno));
+                emit errorOccurred(errorString_);
+            }
+            break;
+        }
+    }
+
+    if (received) {
+        emit readyRead();
+    }
+#endif
+}
+
+void DensPtyHostTransport::onWriteActivated()
+{
+    flushWriteBuffer();
+}
+
+void DensPtyHostTransport::flushWriteBuffer()
+{
+#ifdef Q_OS_UNIX
+    qsizetype written = 0;
+    while (written < writeBuffer_.size()) {
+        const ssize_t n = ::write(fd_, writeBuffer_.constData() + written, writeBuffer_.size() - written);
+        if (n > 0) {
+            written += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                errorString_ = QString::fromLocal8Bit(::strerror(errno));
+                emit errorOccurred(errorString_);
+            }
+            break;
+        }
+    }
+    writeBuffer_.remove(0, written);
+
+    // Only wait for the other end to catch up while there is something left
+    if (writeNotifier_) {
+        writeNotifier_->setEnabled(!writeBuffer_.isEmpty());
+    }
+#endif
+}
@@ -0,0 +1,50 @@
+#ifndef DENSPTYHOSTTRANSPORT_H
+#define DENSPTYHOSTTRANSPORT_H
+
+#include "densbufferedtransport.h"
+
+class QSocketNotifier;
+
+/**
+ * Transport for the controlling end of a newly created pseudo-terminal.
+ *
+ * This is the device side of the connection, used to run a simulated
+ * device as its own process. Once open, subordinatePath() is the path
+ * that the application can connect to as if it were a serial port.
+ * Only available on Unix-like systems.
+ */
+class DensPtyHostTransport : public DensBufferedTransport
+{
+    Q_OBJECT
+public:
+    explicit DensPtyHostTransport(QObject *parent = nullptr);
+    ~DensPtyHostTransport();
+
+    QString subordinatePath() const;
+
+    virtual bool open() override;
+    virtual void close() override;
+    virtual bool isOpen() const override;
+
+    virtual QString description() const override;
+    virtual QString errorString() const override;
+
+    virtual qint64 write(const QByteArray &data) override;
+
+private slots:
+    void onReadActivated();
+    void onWriteActivated();
+
+private:
+    void flushWriteBuffer();
+
+    int fd_ = -1;
+    int subordinateFd_ = -1;
+    QString subordinatePath_;
+    QString errorString_;
+    QSocketNotifier *readNotifier_ = nullptr;
+    QSocketNotifier *writeNotifier_ = nullptr;
+    QByteArray writeBuffer_;
+};
+
+#endif // DENSPTYHOSTTRANSPORT_H
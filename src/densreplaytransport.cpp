@@ -0,0 +1,177 @@
+#include "densreplaytransport.h"
+
+#include <QTimer>
+#include <QFileInfo>
+#include <QDebug>
+
+namespace
+{
+/* Events handled before yielding to the event loop when replaying at full speed */
+static const int FAST_STEP_EVENTS = 256;
+}
+
+DensReplayTransport::DensReplayTransport(const SessionCapture &capture, QObject *parent)
+    : DensBufferedTransport(parent)
+    , fileName_(capture.fileName())
+    , stepTimer_(new QTimer(this))
+{
+    // Only replay the first connection found in the capture
+    bool connected = false;
+    const QList<SessionEvent> events = capture.events();
+    for (const SessionEvent &event : events) {
+        if (event.type == SessionEvent::TypeDensConnect) {
+            if (connected) { break; }
+            connected = true;
+            if (!event.payload.isEmpty()) {
+                deviceType_ = static_cast<DensInterface::DeviceType>(event.payload.at(0));
+            }
+        } else if (connected && event.isDensEvent()) {
+            events_.append(event);
+        }
+    }
+
+    stepTimer_->setSingleShot(true);
+    stepTimer_->setTimerType(Qt::PreciseTimer);
+    connect(stepTimer_, &QTimer::timeout, this, &DensReplayTransport::onStepTimeout);
+}
+
+DensReplayTransport::~DensReplayTransport()
+{
+}
+
+void DensReplayTransport::setFast(bool fast)
+{
+    fast_ = fast;
+}
+
+bool DensReplayTransport::fast() const
+{
+    return fast_;
+}
+
+DensInterface::DeviceType DensReplayTransport::deviceType() const
+{
+    return deviceType_;
+}
+
+int DensReplayTransport::divergenceCount() const
+{
+    return divergenceCount_;
+}
+
+bool DensReplayTransport::open()
+{
+    if (events_.isEmpty()) { return false; }
+
+    cursor_ = 0;
+    lastStepUs_ = 0;
+    lastEventUs_ = events_.first().timeUs;
+    divergenceCount_ = 0;
+    finished_ = false;
+    written_.clear();
+    clearReceived();
+    clock_.start();
+    open_ = true;
+
+    stepTimer_->start(0);
+    return true;
+}
+
+void DensReplayTransport::close()
+{
+    stepTimer_->stop();
+    open_ = false;
+    written_.clear();
+    clearReceived();
+}
+
+bool DensReplayTransport::isOpen() const
+{
+    return open_;
+}
+
+QString DensReplayTransport::description() const
+{
+    return QFileInfo(fileName_).fileName();
+}
+
+QString DensReplayTransport::errorString() const
+{
+    return events_.isEmpty() ? QLatin1String("No densitometer traffic in capture") : QString();
+}
+
+qint64 DensReplayTransport::write(const QByteArray &data)
+{
+    if (!open_) { return -1; }
+
+    if (!finished_) {
+        written_.append(data);
+        if (!stepTimer_->isActive()) {
+            stepTimer_->start(0);
+        }
+    }
+    return data.size();
+}
+
+void DensReplayTransport::onStepTimeout()
+{
+    bool received = false;
+    int handled = 0;
+
+    while (cursor_ < events_.size()) {
+        const SessionEvent &event = events_.at(cursor_);
+
+        if (event.type == SessionEvent::TypeDensWrite) {
+            // Wait for the host to catch up with the recorded session
+            if (written_.size() < event.payload.size()) { break; }
+
+            if (!written_.startsWith(event.payload)) {
+                if (divergenceCount_++ == 0) {
+                    qWarning() << "Replay diverged at event" << cursor_
+                               << "expected:" << event.payload << "got:" << written_.left(event.payload.size());
+                }
+            }
+            written_.remove(0, event.payload.size());
+            lastStepUs_ = elapsedUs();
+        } else if (event.type == SessionEvent::TypeDensRead) {
+            if (!fast_) {
+                const qint64 dueUs = lastStepUs_ + (event.timeUs - lastEventUs_);
+                const qint64 waitUs = dueUs - elapsedUs();
+                if (waitUs > 0) {
+                    stepTimer_->start(static_cast<int>((waitUs + 999) / 1000));
+                    break;
+                }
+                lastStepUs_ = dueUs;
+            } else {
+                lastStepUs_ = elapsedUs();
+            }
+            appendReceived(event.payload);
+            received = true;
+        }
+
+        lastEventUs_ = event.timeUs;
+        cursor_++;
+
+        if (fast_ && ++handled >= FAST_STEP_EVENTS) {
+            stepTimer_->start(0);
+            break;
+        }
+    }
+
+    if (cursor_ >= events_.size() && !finished_) {
+        finished_ = true;
+        const qint64 elapsedMs = clock_.elapsed();
+        qDebug().nospace() << "Replay finished: " << events_.size() << " events in " << elapsedMs << "ms, "
+                           << divergenceCount_ << " divergences";
+        QTimer::singleShot(0, this, [this, elapsedMs]() { emit replayFinished(elapsedMs); });
+    }
+
+    if (received) {
+        emit readyRead();
+    }
+}
+
+qint64 DensReplayTransport::elapsedUs() const
+{
+    return clock_.nsecsElapsed() / 1000;
+}
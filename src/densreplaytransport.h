@@ -0,0 +1,71 @@
+#ifndef DENSREPLAYTRANSPORT_H
+#define DENSREPLAYTRANSPORT_H
+
+#include <QElapsedTimer>
+
+#include "densbufferedtransport.h"
+#include "densinterface.h"
+#include "sessioncapture.h"
+
+class QTimer;
+
+/**
+ * Transport that plays back the densitometer side of a session capture.
+ *
+ * Recorded lines from the device are handed to DensInterface through
+ * the normal read path. Each command the host sent in the original
+ * session acts as a sync point, and playback does not move past it
+ * until the host sends the same bytes again. Lines are delivered either
+ * with their original spacing, or as fast as the host consumes them.
+ */
+class DensReplayTransport : public DensBufferedTransport
+{
+    Q_OBJECT
+public:
+    explicit DensReplayTransport(const SessionCapture &capture, QObject *parent = nullptr);
+    ~DensReplayTransport();
+
+    /** Deliver lines as fast as possible, instead of at their original pace */
+    void setFast(bool fast);
+    bool fast() const;
+
+    /** Device type of the recorded connection */
+    DensInterface::DeviceType deviceType() const;
+
+    /** Number of times the host sent something other than what was recorded */
+    int divergenceCount() const;
+
+    virtual bool open() override;
+    virtual void close() override;
+    virtual bool isOpen() const override;
+
+    virtual QString description() const override;
+    virtual QString errorString() const override;
+
+    virtual qint64 write(const QByteArray &data) override;
+
+signals:
+    void replayFinished(qint64 elapsedMs);
+
+private slots:
+    void onStepTimeout();
+
+private:
+    qint64 elapsedUs() const;
+
+    QString fileName_;
+    QList<SessionEvent> events_;
+    DensInterface::DeviceType deviceType_ = DensInterface::DeviceUnknown;
+    QTimer *stepTimer_;
+    QElapsedTimer clock_;
+    bool fast_ = false;
+    bool open_ = false;
+    bool finished_ = false;
+    qsizetype cursor_ = 0;
+    qint64 lastStepUs_ = 0;
+    qint64 lastEventUs_ = 0;
+    int divergenceCount_ = 0;
+    QByteArray written_;
+};
+
+#endif // DENSREPLAYTRANSPORT_H
@@ -0,0 +1,115 @@
+#include "densserialtransport.h"
+
+#include <QDebug>
+
+DensSerialTransport::DensSerialTransport(const QSerialPortInfo &info, QObject *parent)
+    : DensTransport(parent)
+    , serialPort_(new QSerialPort(info, this))
+{
+    connect(serialPort_, &QSerialPort::readyRead, this, &DensTransport::readyRead);
+    connect(serialPort_, &QSerialPort::errorOccurred, this, &DensSerialTransport::onErrorOccurred);
+}
+
+DensSerialTransport::DensSerialTransport(const QString &portName, QObject *parent)
+    : DensTransport(parent)
+    , serialPort_(new QSerialPort(portName, this))
+{
+    connect(serialPort_, &QSerialPort::readyRead, this, &DensTransport::readyRead);
+    connect(serialPort_, &QSerialPort::errorOccurred, this, &DensSerialTransport::onErrorOccurred);
+}
+
+bool DensSerialTransport::open()
+{
+    serialPort_->setBaudRate(QSerialPort::Baud115200);
+    serialPort_->setDataBits(QSerialPort::Data8);
+    serialPort_->setParity(QSerialPort::NoParity);
+    serialPort_->setStopBits(QSerialPort::OneStop);
+    serialPort_->setFlowControl(QSerialPort::NoFlowControl);
+    if (!serialPort_->open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    serialPort_->setDataTerminalReady(true);
+    return true;
+}
+
+void DensSerialTransport::close()
+{
+    if (serialPort_->isOpen()) {
+        serialPort_->close();
+    }
+}
+
+bool DensSerialTransport::isOpen() const
+{
+    return serialPort_->isOpen();
+}
+
+QString DensSerialTransport::description() const
+{
+    return serialPort_->portName();
+}
+
+QString DensSerialTransport::errorString() const
+{
+    return serialPort_->errorString();
+}
+
+bool DensSerialTransport::canReadLine() const
+{
+    return serialPort_->canReadLine();
+}
+
+QByteArray DensSerialTransport::readLine()
+{
+    return serialPort_->readLine();
+}
+
+qint64 DensSerialTransport::bytesAvailable() const
+{
+    return serialPort_->bytesAvailable();
+}
+
+qint64 DensSerialTransport::read(char *data, qint64 maxSize)
+{
+    return serialPort_->read(data, maxSize);
+}
+
+qint64 DensSerialTransport::write(const QByteArray &data)
+{
+    return serialPort_->write(data);
+}
+
+void DensSerialTransport::onErrorOccurred(QSerialPort::SerialPortError error)
+{
+    if (error == QSerialPort::NoError) { return; }
+    qDebug() << "Serial port error:" << error;
+    emit errorOccurred(serialPort_->errorString());
+}
+
+DensPtyTransport::DensPtyTransport(const QString &path, QObject *parent)
+    : DensSerialTransport(path, parent)
+    , path_(path)
+{
+}
+
+bool DensPtyTransport::isPtyPath(const QString &portName)
+{
+#if defined(Q_OS_UNIX)
+    return portName.startsWith(QLatin1Char('/'));
+#else
+    Q_UNUSED(portName)
+    return false;
+#endif
+}
+
+bool DensPtyTransport::open()
+{
+    // Line settings and modem control lines mean nothing on a
+    // pseudo-terminal, so just open it in raw mode.
+    return serialPort_->open(QIODevice::ReadWrite);
+}
+
+QString DensPtyTransport::description() const
+{
+    return path_;
+}
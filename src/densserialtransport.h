@@ -0,0 +1,59 @@
+#ifndef DENSSERIALTRANSPORT_H
+#define DENSSERIALTRANSPORT_H
+
+#include <QSerialPort>
+#include <QSerialPortInfo>
+
+#include "denstransport.h"
+
+/**
+ * Transport for a densitometer attached as a USB serial device.
+ */
+class DensSerialTransport : public DensTransport
+{
+    Q_OBJECT
+public:
+    explicit DensSerialTransport(const QSerialPortInfo &info, QObject *parent = nullptr);
+    explicit DensSerialTransport(const QString &portName, QObject *parent = nullptr);
+
+    virtual bool open() override;
+    virtual void close() override;
+    virtual bool isOpen() const override;
+
+    virtual QString description() const override;
+    virtual QString errorString() const override;
+
+    virtual bool canReadLine() const override;
+    virtual QByteArray readLine() override;
+    virtual qint64 bytesAvailable() const override;
+    virtual qint64 read(char *data, qint64 maxSize) override;
+    virtual qint64 write(const QByteArray &data) override;
+
+protected:
+    QSerialPort *serialPort_;
+
+private slots:
+    void onErrorOccurred(QSerialPort::SerialPortError error);
+};
+
+/**
+ * Transport for the subordinate end of a pseudo-terminal, such as one
+ * created by a device simulator, identified by its full device path.
+ */
+class DensPtyTransport : public DensSerialTransport
+{
+    Q_OBJECT
+public:
+    explicit DensPtyTransport(const QString &path, QObject *parent = nullptr);
+
+    /** Check whether a port name given by the user is a pseudo-terminal path */
+    static bool isPtyPath(const QString &portName);
+
+    virtual bool open() override;
+    virtual QString description() const override;
+
+private:
+    QString path_;
+};
+
+#endif // DENSSERIALTRANSPORT_H
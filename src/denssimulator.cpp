@@ -0,0 +1,715 @@
+#include "denssimulator.h"
+
+#include <QTimer>
+#include <QUrlQuery>
+#include <QDebug>
+#include <cmath>
+
+#include "densloopbacktransport.h"
+#include "util.h"
+
+namespace
+{
+static const QLatin1String SIMULATOR_PORT_PREFIX("sim:");
+
+/* Unprompted output is batched, so it never wakes up more often than this */
+static const int MIN_STREAM_INTERVAL_MS = 10;
+static const int MAX_STREAM_INTERVAL_MS = 1000;
+
+static const int DISPLAY_WIDTH = 128;
+static const int DISPLAY_HEIGHT = 64;
+
+/* Full scale sensor count that a density of zero maps onto */
+static const float SENSOR_FULL_SCALE = 60000.0F;
+
+QStringList encodeValues(std::initializer_list<float> values)
+{
+    QStringList result;
+    for (float value : values) {
+        result.append(util::encode_f32(value));
+    }
+    return result;
+}
+
+QStringList snapshotTables(DensInterface::DeviceType deviceType)
+{
+    if (deviceType == DensInterface::DeviceUvVis) {
+        return QStringList() << "GAIN" << "VTEMP" << "UTEMP" << "REFL" << "TRAN" << "UVTR";
+    } else {
+        return QStringList() << "GAIN" << "SLOPE" << "REFL" << "TRAN";
+    }
+}
+}
+
+DensSimulator::DensSimulator(DensInterface::DeviceType deviceType, QObject *parent)
+    : QObject(parent)
+    , deviceType_(deviceType)
+    , sendTimer_(new QTimer(this))
+    , streamTimer_(new QTimer(this))
+    , random_(QRandomGenerator::global()->generate())
+{
+    sendTimer_->setSingleShot(true);
+    sendTimer_->setTimerType(Qt::PreciseTimer);
+    connect(sendTimer_, &QTimer::timeout, this, &DensSimulator::onSendTimeout);
+
+    streamTimer_->setTimerType(Qt::PreciseTimer);
+    connect(streamTimer_, &QTimer::timeout, this, &DensSimulator::onStreamTimeout);
+
+    clock_.start();
+    resetCalibration();
+}
+
+DensSimulator::~DensSimulator()
+{
+    detach();
+}
+
+DensInterface::DeviceType DensSimulator::deviceType() const
+{
+    return deviceType_;
+}
+
+void DensSimulator::setLatency(int msec)
+{
+    latency_ = qMax(0, msec);
+}
+
+int DensSimulator::latency() const
+{
+    return latency_;
+}
+
+void DensSimulator::setJitter(int msec)
+{
+    jitter_ = qMax(0, msec);
+}
+
+int DensSimulator::jitter() const
+{
+    return jitter_;
+}
+
+void DensSimulator::setReadingRate(double rate)
+{
+    readingRate_ = qMax(0.0, rate);
+    updateStreamTimer();
+}
+
+double DensSimulator::readingRate() const
+{
+    return readingRate_;
+}
+
+void DensSimulator::setLogRate(double rate)
+{
+    logRate_ = qMax(0.0, rate);
+    updateStreamTimer();
+}
+
+double DensSimulator::logRate() const
+{
+    return logRate_;
+}
+
+void DensSimulator::setSeed(quint32 seed)
+{
+    random_.seed(seed);
+}
+
+bool DensSimulator::attach(DensTransport *transport)
+{
+    if (!transport || !transport->isOpen()) { return false; }
+
+    detach();
+    transport_ = transport;
+    connect(transport_, &DensTransport::readyRead, this, &DensSimulator::onReadyRead);
+    updateStreamTimer();
+    return true;
+}
+
+void DensSimulator::detach()
+{
+    if (transport_) {
+        disconnect(transport_, &DensTransport::readyRead, this, &DensSimulator::onReadyRead);
+        transport_ = nullptr;
+    }
+    sendTimer_->stop();
+    streamTimer_->stop();
+    pending_.clear();
+    blockCommand_ = DensCommand();
+    blockBuffer_.clear();
+    blockPending_ = false;
+}
+
+DensLoopbackTransport *DensSimulator::createLoopback()
+{
+    DensLoopbackTransport *deviceEnd = new DensLoopbackTransport(this);
+    DensLoopbackTransport *hostEnd = new DensLoopbackTransport();
+    DensLoopbackTransport::connectPair(deviceEnd, hostEnd);
+    deviceEnd->open();
+    attach(deviceEnd);
+    setParent(hostEnd);
+    return hostEnd;
+}
+
+bool DensSimulator::isSimulatorPort(const QString &portName)
+{
+    return portName.startsWith(SIMULATOR_PORT_PREFIX);
+}
+
+DensSimulator *DensSimulator::fromPortName(const QString &portName, QObject *parent)
+{
+    if (!isSimulatorPort(portName)) { return nullptr; }
+
+    const QString spec = portName.mid(SIMULATOR_PORT_PREFIX.size());
+    const qsizetype sep = spec.indexOf('?');
+    const QString typeName = sep < 0 ? spec : spec.left(sep);
+
+    DensInterface::DeviceType deviceType;
+    if (typeName == QLatin1String("baseline")) {
+        deviceType = DensInterface::DeviceBaseline;
+    } else if (typeName == QLatin1String("uvvis")) {
+        deviceType = DensInterface::DeviceUvVis;
+    } else {
+        qWarning() << "Unknown simulator device type:" << typeName;
+        return nullptr;
+    }
+
+    DensSimulator *simulator = new DensSimulator(deviceType, parent);
+    if (sep < 0) { return simulator; }
+
+    const QUrlQuery query(spec.mid(sep + 1));
+    const auto items = query.queryItems();
+    for (const auto &item : items) {
+        bool ok;
+        const double value = item.second.toDouble(&ok);
+        if (!ok) {
+            qWarning() << "Invalid simulator option value:" << item.first << item.second;
+            continue;
+        }
+
+        if (item.first == QLatin1String("latency")) {
+            simulator->setLatency(qRound(value));
+        } else if (item.first == QLatin1String("jitter")) {
+            simulator->setJitter(qRound(value));
+        } else if (item.first == QLatin1String("rate")) {
+            simulator->setReadingRate(value);
+        } else if (item.first == QLatin1String("log")) {
+            simulator->setLogRate(value);
+        } else if (item.first == QLatin1String("seed")) {
+            simulator->setSeed(static_cast<quint32>(value));
+        } else {
+            qWarning() << "Unknown simulator option:" << item.first;
+        }
+    }
+
+    return simulator;
+}
+
+void DensSimulator::onReadyRead()
+{
+    while (transport_ && transport_->canReadLine()) {
+        handleLine(transport_->readLine());
+    }
+}
+
+void DensSimulator::handleLine(const QByteArray &line)
+{
+    if (blockPending_) {
+        if (line == "]]\r\n") {
+            blockPending_ = false;
+            handleCommand(blockCommand_, blockBuffer_);
+            blockCommand_ = DensCommand();
+            blockBuffer_.clear();
+        } else {
+            blockBuffer_.append(line);
+        }
+        return;
+    }
+
+    if (line.trimmed().isEmpty()) { return; }
+
+    const DensCommand command = DensCommand::parse(line);
+    if (!command.isValid()) {
+        // Without a valid header there is nothing to address a response to
+        qDebug() << "Simulator ignoring line:" << line;
+        return;
+    }
+
+    if (command.args().size() == 1 && command.args().at(0) == QLatin1String("[[")) {
+        blockCommand_ = command;
+        blockBuffer_.clear();
+        blockPending_ = true;
+        return;
+    }
+
+    handleCommand(command, QByteArray());
+}
+
+void DensSimulator::handleCommand(const DensCommand &command, const QByteArray &block)
+{
+    switch (command.category()) {
+    case DensCommand::CategorySystem:
+        handleSystem(command);
+        break;
+    case DensCommand::CategoryMeasurement:
+        handleMeasurement(command);
+        break;
+    case DensCommand::CategoryCalibration:
+        handleCalibration(command, block);
+        break;
+    case DensCommand::CategoryDiagnostics:
+        handleDiagnostics(command);
+        break;
+    default:
+        respondNak(command);
+        break;
+    }
+}
+
+void DensSimulator::handleSystem(const DensCommand &command)
+{
+    const QString action = command.action();
+    const QStringList args = command.args();
+    const bool uvvis = deviceType_ == DensInterface::DeviceUvVis;
+
+    if (command.type() == DensCommand::TypeGet) {
+        if (action == QLatin1String("V")) {
+            respond(command, QStringList()
+                    << (uvvis ? "Printalyzer UV/VIS Densitometer" : "Printalyzer Densitometer")
+                    << "0.0.0-sim");
+        } else if (action == QLatin1String("B")) {
+            respond(command, QStringList() << "2024-01-01 00:00" << "simulator" << "00000000");
+        } else if (action == QLatin1String("DEV")) {
+            respond(command, QStringList()
+                    << "1.0.0"
+                    << (uvvis ? "0x0479" : "0x0447")
+                    << "0x1000"
+                    << (uvvis ? "32000000" : "80000000"));
+        } else if (action == QLatin1String("RTOS")) {
+            respond(command, QStringList() << "10.4.6" << "32768" << "8192" << "9");
+        } else if (action == QLatin1String("UID")) {
+            respond(command, QStringList() << "53494D554C41544F52000000");
+        } else if (action == QLatin1String("ISEN")) {
+            const QString vdda = QString::number(3.30 + random_.generateDouble() * 0.01, 'f', 2);
+            const QString mcuTemp = QString::number(25.0 + random_.generateDouble(), 'f', 1);
+            QStringList values = QStringList() << vdda << mcuTemp;
+            if (uvvis) {
+                values << QString::number(24.5 + random_.generateDouble(), 'f', 1);
+            }
+            respond(command, values);
+        } else {
+            respondNak(command);
+        }
+    } else if (command.type() == DensCommand::TypeSet && action == QLatin1String("DISP")) {
+        respond(command, QStringList() << "OK");
+    } else if (command.type() == DensCommand::TypeInvoke && action == QLatin1String("REMOTE")) {
+        if (args.size() != 1) {
+            respond(command, QStringList() << "ERR");
+            return;
+        }
+        remoteControl_ = args.at(0) == QLatin1String("1");
+        respond(command, QStringList() << (remoteControl_ ? "1" : "0"));
+    } else {
+        respondNak(command);
+    }
+}
+
+void DensSimulator::handleMeasurement(const DensCommand &command)
+{
+    const QString action = command.action();
+    const QStringList args = command.args();
+
+    if (command.type() != DensCommand::TypeSet || args.size() != 1) {
+        respondNak(command);
+        return;
+    }
+
+    if (action == QLatin1String("FORMAT")) {
+        if (args.at(0) == QLatin1String("BASIC")) {
+            extendedFormat_ = false;
+        } else if (args.at(0) == QLatin1String("EXT")) {
+            extendedFormat_ = true;
+        } else {
+            respond(command, QStringList() << "ERR");
+            return;
+        }
+        respond(command, QStringList() << "OK");
+    } else if (action == QLatin1String("UNCAL")) {
+        allowUncalibrated_ = args.at(0) == QLatin1String("1");
+        respond(command, QStringList() << "OK");
+    } else {
+        respondNak(command);
+    }
+}
+
+void DensSimulator::handleCalibration(const DensCommand &command, const QByteArray &block)
+{
+    const QString action = command.action();
+    const QStringList args = command.args();
+
+    if (command.type() == DensCommand::TypeInvoke && action == QLatin1String("GAIN")) {
+        // Walk through the same kind of progress updates as the real
+        // calibration process, spread out by the configured latency
+        const int steps = deviceType_ == DensInterface::DeviceUvVis ? 10 : 4;
+        respond(command, QStringList() << "STATUS" << "0");
+        for (int i = 0; i < steps; i++) {
+            respond(command, QStringList() << "STATUS" << "1" << QString::number(i));
+        }
+        respond(command, QStringList() << "OK");
+    } else if (action == QLatin1String("SNAP")) {
+        if (command.type() == DensCommand::TypeGet) {
+            respondBlock(command, calSnapshot());
+        } else if (command.type() == DensCommand::TypeSet && !block.isEmpty()) {
+            respond(command, QStringList() << (setCalSnapshot(block) ? "OK" : "ERR"));
+        } else {
+            respondNak(command);
+        }
+    } else if (!calTables_.contains(action)) {
+        respondNak(command);
+    } else if (command.type() == DensCommand::TypeGet) {
+        respond(command, calTables_.value(action));
+    } else if (command.type() == DensCommand::TypeSet) {
+        if (args.size() != calTables_.value(action).size()) {
+            respond(command, QStringList() << "ERR");
+            return;
+        }
+        calTables_.insert(action, args);
+        respond(command, QStringList() << "OK");
+    } else {
+        respondNak(command);
+    }
+}
+
+void DensSimulator::handleDiagnostics(const DensCommand &command)
+{
+    const QString action = command.action();
+    const QStringList args = command.args();
+    const bool uvvis = deviceType_ == DensInterface::DeviceUvVis;
+    const float reading = SENSOR_FULL_SCALE * std::pow(10.0F, -density_);
+
+    if (command.type() == DensCommand::TypeGet) {
+        if (action == QLatin1String("DISP")) {
+            respondBlock(command, displayScreenshot());
+        } else if (action == QLatin1String("LMAX") && uvvis) {
+            respond(command, QStringList() << "1023");
+        } else if (action == QLatin1String("S")) {
+            if (!sensorRunning_) {
+                respond(command, QStringList() << "ERR");
+            } else if (uvvis) {
+                respond(command, QStringList() << "0" << QString::number(qRound(reading))
+                        << "4" << "719");
+            } else {
+                respond(command, QStringList() << QString::number(qRound(reading))
+                        << QString::number(qRound(reading * 0.1F)));
+            }
+        } else {
+            respondNak(command);
+        }
+    } else if (command.type() == DensCommand::TypeSet) {
+        if (action == QLatin1String("LR") || action == QLatin1String("LT")
+                || (action == QLatin1String("LTU") && uvvis)
+                || action == QLatin1String("S")) {
+            respond(command, QStringList() << "OK");
+        } else if (action == QLatin1String("LOG") && args.size() == 1) {
+            loggingEnabled_ = args.at(0) == QLatin1String("U");
+            respond(command, QStringList() << "OK");
+            updateStreamTimer();
+        } else {
+            respondNak(command);
+        }
+    } else if (command.type() == DensCommand::TypeInvoke) {
+        if (action == QLatin1String("S") && args.size() == 1) {
+            if (args.at(0) == QLatin1String("START")) {
+                sensorRunning_ = true;
+            } else if (args.at(0) == QLatin1String("STOP")) {
+                sensorRunning_ = false;
+            } else {
+                respond(command, QStringList() << "ERR");
+                return;
+            }
+            respond(command, QStringList() << "OK");
+        } else if (action == QLatin1String("READ")) {
+            if (args.size() != (uvvis ? 6 : 3) || args.at(0) == QLatin1String("0")) {
+                respond(command, QStringList() << "ERR");
+            } else if (uvvis) {
+                respond(command, QStringList() << QString::number(qRound(reading)));
+            } else {
+                respond(command, QStringList() << QString::number(qRound(reading))
+                        << QString::number(qRound(reading * 0.1F)));
+            }
+        } else if (action == QLatin1String("MEAS") && uvvis) {
+            if (args.size() != 2) {
+                respond(command, QStringList() << "ERR");
+            } else {
+                respond(command, QStringList() << util::encode_f32(reading / SENSOR_FULL_SCALE));
+            }
+        } else {
+            respondNak(command);
+        }
+    } else {
+        respondNak(command);
+    }
+}
+
+QByteArray DensSimulator::calSnapshot() const
+{
+    QByteArray block;
+    QList<uint32_t> words;
+
+    const QStringList tables = snapshotTables(deviceType_);
+    for (const QString &table : tables) {
+        const QByteArray packed = calTables_.value(table).join(QString()).toLatin1();
+        QByteArray bytes(packed.size() / 2, Qt::Uninitialized);
+        util::decode_hex(packed, reinterpret_cast<uint8_t *>(bytes.data()));
+        for (qsizetype i = 0; i + 4 <= bytes.size(); i += 4) {
+            words.append(util::copy_to_u32(reinterpret_cast<const uint8_t *>(bytes.constData() + i)));
+        }
+
+        block.append(table.toLatin1());
+        block.append(',');
+        block.append(packed);
+        block.append("\r\n");
+    }
+
+    const uint32_t crc = util::calculateStmCrc32(words.data(), words.size());
+    block.append("CRC,");
+    block.append(QByteArray::number(crc, 16).rightJustified(8, '0').toUpper());
+    block.append("\r\n");
+    return block;
+}
+
+bool DensSimulator::setCalSnapshot(const QByteArray &block)
+{
+    QMap<QString, QStringList> tables;
+    QList<uint32_t> words;
+    uint32_t crc = 0;
+    bool hasCrc = false;
+
+    const QList<QByteArray> lines = block.split('\n');
+    for (const QByteArray &rawLine : lines) {
+        const QByteArray line = rawLine.trimmed();
+        if (line.isEmpty()) { continue; }
+
+        const qsizetype sep = line.indexOf(',');
+        if (sep <= 0) { return false; }
+        const QString tag = QString::fromLatin1(line.left(sep));
+        const QByteArray packed = line.mid(sep + 1);
+
+        if (tag == QLatin1String("CRC")) {
+            crc = packed.toUInt(&hasCrc, 16);
+            continue;
+        }
+
+        if (packed.isEmpty() || packed.size() % 8 != 0) { return false; }
+
+        QByteArray bytes(packed.size() / 2, Qt::Uninitialized);
+        if (util::decode_hex(packed, reinterpret_cast<uint8_t *>(bytes.data())) < 0) { return false; }
+        QStringList args;
+        for (qsizetype i = 0; i + 4 <= bytes.size(); i += 4) {
+            words.append(util::copy_to_u32(reinterpret_cast<const uint8_t *>(bytes.constData() + i)));
+            args.append(QString::fromLatin1(packed.mid(i * 2, 8)));
+        }
+
+        if (args.size() != calTables_.value(tag).size()) { return false; }
+        tables.insert(tag, args);
+    }
+
+    if (!hasCrc || util::calculateStmCrc32(words.data(), words.size()) != crc) {
+        return false;
+    }
+
+    // Only apply the snapshot once all of it is known to be good
+    for (auto it = tables.constBegin(); it != tables.constEnd(); ++it) {
+        calTables_.insert(it.key(), it.value());
+    }
+    return true;
+}
+
+void DensSimulator::respond(const DensCommand &command, const QStringList &args)
+{
+    DensCommand response(command.type(), command.category(), command.action(), args);
+    QByteArray data = response.toString().toLatin1();
+    data.append("\r\n");
+    queueOutput(data);
+}
+
+void DensSimulator::respondBlock(const DensCommand &command, const QByteArray &block)
+{
+    DensCommand response(command.type(), command.category(), command.action(), QStringList() << "[[");
+    QByteArray data = response.toString().toLatin1();
+    data.append("\r\n");
+    data.append(block);
+    data.append("]]\r\n");
+    queueOutput(data);
+}
+
+void DensSimulator::respondNak(const DensCommand &command)
+{
+    respond(command, QStringList() << "NAK");
+}
+
+void DensSimulator::queueOutput(const QByteArray &data)
+{
+    qint64 due = clock_.elapsed() + latency_;
+    if (jitter_ > 0) {
+        due += random_.bounded(jitter_ + 1);
+    }
+
+    // The firmware answers commands in the order they arrive,
+    // so jitter may bunch responses up but never reorders them
+    due = qMax(due, lastDue_);
+    lastDue_ = due;
+
+    pending_.push_back(PendingOutput{due, data});
+    scheduleSend();
+}
+
+void DensSimulator::scheduleSend()
+{
+    if (pending_.empty() || sendTimer_->isActive()) { return; }
+    sendTimer_->start(static_cast<int>(qMax<qint64>(0, pending_.front().due - clock_.elapsed())));
+}
+
+void DensSimulator::onSendTimeout()
+{
+    const qint64 now = clock_.elapsed();
+    QByteArray batch;
+    while (!pending_.empty() && pending_.front().due <= now) {
+        batch.append(pending_.front().data);
+        pending_.pop_front();
+    }
+
+    if (!batch.isEmpty() && transport_) {
+        transport_->write(batch);
+    }
+    scheduleSend();
+}
+
+void DensSimulator::updateStreamTimer()
+{
+    const double logRate = loggingEnabled_ ? logRate_ : 0.0;
+    const double rate = qMax(readingRate_, logRate);
+
+    if (!transport_ || rate <= 0.0) {
+        streamTimer_->stop();
+        return;
+    }
+
+    // Output owed is worked out from the time elapsed since the rates
+    // last changed, so it stays accurate even when the timer runs late
+    streamStart_ = clock_.elapsed();
+    readingsSent_ = 0;
+    logLinesSent_ = 0;
+    streamTimer_->start(qBound(MIN_STREAM_INTERVAL_MS, qRound(1000.0 / rate), MAX_STREAM_INTERVAL_MS));
+}
+
+void DensSimulator::onStreamTimeout()
+{
+    const qint64 elapsed = clock_.elapsed() - streamStart_;
+    QByteArray batch;
+
+    if (readingRate_ > 0.0) {
+        const quint64 due = static_cast<quint64>(elapsed * readingRate_ / 1000.0);
+        while (readingsSent_ < due) {
+            batch.append(densityLine());
+            readingsSent_++;
+        }
+    }
+
+    if (loggingEnabled_ && logRate_ > 0.0) {
+        const quint64 due = static_cast<quint64>(elapsed * logRate_ / 1000.0);
+        while (logLinesSent_ < due) {
+            batch.append(logLine());
+            logLinesSent_++;
+        }
+    }
+
+    if (!batch.isEmpty() && transport_) {
+        transport_->write(batch);
+    }
+}
+
+QByteArray DensSimulator::densityLine()
+{
+    // Wander around slowly, like repeated readings of different patches
+    density_ = qBound(0.0F, density_ + static_cast<float>(random_.generateDouble() * 0.2 - 0.1), 4.0F);
+
+    char prefix;
+    if (deviceType_ == DensInterface::DeviceUvVis) {
+        prefix = nextTransmission_ ? 'T' : 'U';
+    } else {
+        prefix = nextTransmission_ ? 'T' : 'R';
+    }
+    nextTransmission_ = !nextTransmission_;
+
+    QByteArray line;
+    line.append(prefix);
+    line.append(QByteArray::number(density_, 'f', 2));
+    line.append('D');
+    if (extendedFormat_) {
+        const float rawValue = std::pow(10.0F, -density_);
+        char buf[8];
+        for (float value : { density_, densityZero_, rawValue, rawValue }) {
+            util::encode_f32(value, buf);
+            line.append(',');
+            line.append(buf, sizeof(buf));
+        }
+    }
+    line.append("\r\n");
+    return line;
+}
+
+QByteArray DensSimulator::logLine()
+{
+    static const char LEVELS[] = { 'D', 'D', 'D', 'I', 'I', 'W' };
+    const char level = LEVELS[random_.bounded(static_cast<int>(sizeof(LEVELS)))];
+    const int ch0 = qRound(SENSOR_FULL_SCALE * std::pow(10.0F, -density_));
+
+    QByteArray line;
+    line.append(level);
+    line.append("/sensor: ch0=");
+    line.append(QByteArray::number(ch0));
+    line.append(", ch1=");
+    line.append(QByteArray::number(ch0 / 10));
+    line.append("\r\n");
+    return line;
+}
+
+QByteArray DensSimulator::displayScreenshot() const
+{
+    // Blank display contents, in the same XBM form the firmware sends
+    QByteArray data;
+    data.append("#define sim_width " + QByteArray::number(DISPLAY_WIDTH) + "\r\n");
+    data.append("#define sim_height " + QByteArray::number(DISPLAY_HEIGHT) + "\r\n");
+    data.append("static unsigned char sim_bits[] = {\r\n");
+
+    const int count = (DISPLAY_WIDTH / 8) * DISPLAY_HEIGHT;
+    for (int i = 0; i < count; i++) {
+        data.append(" 0x00");
+        data.append(i < count - 1 ? "," : "");
+        if ((i % 16) == 15) { data.append("\r\n"); }
+    }
+    data.append("};\r\n");
+    return data;
+}
+
+void DensSimulator::resetCalibration()
+{
+    calTables_.clear();
+    calTables_.insert("REFL", encodeValues({ 0.08F, 0.80F, 1.50F, 0.03F }));
+    calTables_.insert("TRAN", encodeValues({ 0.00F, 1.00F, 2.50F, 0.003F }));
+
+    if (deviceType_ == DensInterface::DeviceUvVis) {
+        calTables_.insert("GAIN", encodeValues({ 0.5F, 1.0F, 2.0F, 4.0F, 8.0F,
+                                                 16.0F, 32.0F, 64.0F, 128.0F, 256.0F }));
+        calTables_.insert("VTEMP", encodeValues({ 0.0F, 0.0F, 0.0F }));
+        calTables_.insert("UTEMP", encodeValues({ 0.0F, 0.0F, 0.0F }));
+        calTables_.insert("UVTR", encodeValues({ 0.00F, 1.00F, 2.00F, 0.01F }));
+    } else {
+        calTables_.insert("LIGHT", QStringList() << "128" << "128");
+        calTables_.insert("GAIN", encodeValues({ 1.0F, 1.0F, 24.5F, 24.8F,
+                                                 392.0F, 395.0F, 6120.0F, 6150.0F }));
+        calTables_.insert("SLOPE", encodeValues({ 0.0F, 1.0F, 0.0F }));
+    }
+}
@@ -0,0 +1,144 @@
+#ifndef DENSSIMULATOR_H
+#define DENSSIMULATOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QMap>
+#include <QPointer>
+#include <deque>
+
+#include "densinterface.h"
+
+class QTimer;
+class DensTransport;
+class DensLoopbackTransport;
+
+/**
+ * Stand-in for a densitometer, speaking the same line protocol as the
+ * device firmware.
+ *
+ * The simulator serves the device side of a transport, which can either
+ * be one end of an in-process loopback pair or the controlling end of a
+ * pseudo-terminal. Responses are delayed by a configurable latency with
+ * random jitter, while density readings and log lines can be sent
+ * unprompted at a configurable rate to put load on the host side.
+ */
+class DensSimulator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DensSimulator(DensInterface::DeviceType deviceType, QObject *parent = nullptr);
+    ~DensSimulator();
+
+    DensInterface::DeviceType deviceType() const;
+
+    /** Fixed delay before each command response, in milliseconds */
+    void setLatency(int msec);
+    int latency() const;
+
+    /** Maximum random delay added on top of the latency, in milliseconds */
+    void setJitter(int msec);
+    int jitter() const;
+
+    /** Unprompted density readings sent per second, or zero to disable */
+    void setReadingRate(double rate);
+    double readingRate() const;
+
+    /** Log lines sent per second while USB logging is enabled */
+    void setLogRate(double rate);
+    double logRate() const;
+
+    /** Seed the random source, so a session can be reproduced exactly */
+    void setSeed(quint32 seed);
+
+    /**
+     * Serve the protocol over the device side of an already open transport.
+     * The transport is not owned by the simulator.
+     */
+    bool attach(DensTransport *transport);
+    void detach();
+
+    /**
+     * Create an in-process connection to this simulator, returning the
+     * host side of it. The simulator becomes owned by the returned
+     * transport, so it goes away once the connection is closed.
+     */
+    DensLoopbackTransport *createLoopback();
+
+    /** Check whether a port name given by the user refers to a simulator */
+    static bool isSimulatorPort(const QString &portName);
+
+    /**
+     * Create a simulator described by a port name, of the form
+     * sim:<baseline|uvvis>[?latency=ms&jitter=ms&rate=n&log=n&seed=n]
+     * Returns nullptr if the port name is not valid.
+     */
+    static DensSimulator *fromPortName(const QString &portName, QObject *parent = nullptr);
+
+private slots:
+    void onReadyRead();
+    void onSendTimeout();
+    void onStreamTimeout();
+
+private:
+    struct PendingOutput
+    {
+        qint64 due;
+        QByteArray data;
+    };
+
+    void handleLine(const QByteArray &line);
+    void handleCommand(const DensCommand &command, const QByteArray &block);
+    void handleSystem(const DensCommand &command);
+    void handleMeasurement(const DensCommand &command);
+    void handleCalibration(const DensCommand &command, const QByteArray &block);
+    void handleDiagnostics(const DensCommand &command);
+    bool setCalSnapshot(const QByteArray &block);
+    QByteArray calSnapshot() const;
+
+    void respond(const DensCommand &command, const QStringList &args);
+    void respondBlock(const DensCommand &command, const QByteArray &block);
+    void respondNak(const DensCommand &command);
+    void queueOutput(const QByteArray &data);
+    void scheduleSend();
+    void updateStreamTimer();
+
+    QByteArray densityLine();
+    QByteArray logLine();
+    QByteArray displayScreenshot() const;
+    void resetCalibration();
+
+    DensInterface::DeviceType deviceType_;
+    QPointer<DensTransport> transport_;
+    QTimer *sendTimer_;
+    QTimer *streamTimer_;
+    QElapsedTimer clock_;
+    QRandomGenerator random_;
+    int latency_ = 0;
+    int jitter_ = 0;
+    double readingRate_ = 0;
+    double logRate_ = 0;
+
+    std::deque<PendingOutput> pending_;
+    qint64 lastDue_ = 0;
+    qint64 streamStart_ = 0;
+    quint64 readingsSent_ = 0;
+    quint64 logLinesSent_ = 0;
+
+    DensCommand blockCommand_;
+    QByteArray blockBuffer_;
+    bool blockPending_ = false;
+
+    bool extendedFormat_ = false;
+    bool allowUncalibrated_ = false;
+    bool remoteControl_ = false;
+    bool loggingEnabled_ = false;
+    bool sensorRunning_ = false;
+    bool nextTransmission_ = false;
+    float density_ = 0.0F;
+    float densityZero_ = qSNaN();
+    QMap<QString, QStringList> calTables_;
+};
+
+#endif // DENSSIMULATOR_H
@@ -0,0 +1,10 @@
+#include "denstransport.h"
+
+DensTransport::DensTransport(QObject *parent)
+    : QObject(parent)
+{
+}
+
+DensTransport::~DensTransport()
+{
+}
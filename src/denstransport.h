@@ -0,0 +1,44 @@
+#ifndef DENSTRANSPORT_H
+#define DENSTRANSPORT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+
+/**
+ * Line-oriented byte stream that carries the densitometer protocol.
+ *
+ * DensInterface only talks to the device through this interface,
+ * so the protocol stack can run on top of a real serial port,
+ * a pseudo-terminal or a purely in-process loopback.
+ */
+class DensTransport : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DensTransport(QObject *parent = nullptr);
+    virtual ~DensTransport();
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    /** Human readable name of the endpoint, such as the port name */
+    virtual QString description() const = 0;
+    virtual QString errorString() const = 0;
+
+    virtual bool canReadLine() const = 0;
+    virtual QByteArray readLine() = 0;
+
+    /** Read whatever has been received so far, regardless of line endings */
+    virtual qint64 bytesAvailable() const = 0;
+    virtual qint64 read(char *data, qint64 maxSize) = 0;
+
+    virtual qint64 write(const QByteArray &data) = 0;
+
+signals:
+    void readyRead();
+    void errorOccurred(const QString &errorString);
+};
+
+#endif // DENSTRANSPORT_H
@@ -2,6 +2,7 @@
 #include "ui_diagnosticstab.h"
 
 #include <QFileDialog>
+#include <QTimer>
 #include <QDebug>
 
 #include "densinterface.h"
@@ -9,14 +10,21 @@
 #include "densistick/densistickinterface.h"
 #include "remotecontroldialog.h"
 #include "stickremotecontroldialog.h"
+#include "metrics.h"
 
 DiagnosticsTab::DiagnosticsTab(DensInterface *densInterface, QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::DiagnosticsTab)
     , densInterface_(densInterface)
+    , metricsTimer_(new QTimer(this))
 {
     ui->setupUi(this);
 
+    // Metrics are only refreshed while the tab is visible
+    metricsTimer_->setInterval(1000);
+    connect(metricsTimer_, &QTimer::timeout, this, &DiagnosticsTab::onRefreshMetrics);
+    connect(ui->resetMetricsPushButton, &QPushButton::clicked, this, &DiagnosticsTab::onResetMetrics);
+
     ui->refreshSensorsPushButton->setEnabled(false);
     ui->screenshotButton->setEnabled(false);
 
@@ -66,6 +74,19 @@ bool DiagnosticsTab::isRemoteOpen() const
     return remoteDialog_ != nullptr;
 }
 
+void DiagnosticsTab::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    onRefreshMetrics();
+    metricsTimer_->start();
+}
+
+void DiagnosticsTab::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    metricsTimer_->stop();
+}
+
 void DiagnosticsTab::onConnectionOpened()
 {
     configureForDeviceType();
@@ -187,6 +208,42 @@ void DiagnosticsTab::onRemoteControlFinished()
     remoteDialog_ = nullptr;
 }
 
+void DiagnosticsTab::onRefreshMetrics()
+{
+    const QList<MetricSnapshot> metrics = Metrics::snapshot();
+    QTreeWidget *tree = ui->metricsTreeWidget;
+
+    // Metrics are never removed, so existing rows line up with the
+    // sorted snapshot and only new ones need to be inserted.
+    for (qsizetype i = 0; i < metrics.size(); i++) {
+        const MetricSnapshot &metric = metrics.at(i);
+        QTreeWidgetItem *item = tree->topLevelItem(static_cast<int>(i));
+        if (!item || item->text(0) != metric.name) {
+            item = new QTreeWidgetItem();
+            item->setText(0, metric.name);
+            for (int column = 1; column < tree->columnCount(); column++) {
+                item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+            }
+            tree->insertTopLevelItem(static_cast<int>(i), item);
+        }
+
+        item->setText(1, QString::number(metric.value));
+        if (metric.type == MetricSnapshot::TypeHistogram) {
+            item->setText(2, QString::number(metric.mean, 'f', 1));
+            item->setText(3, QString::number(metric.p50));
+            item->setText(4, QString::number(metric.p90));
+            item->setText(5, QString::number(metric.p99));
+            item->setText(6, QString::number(metric.max));
+        }
+    }
+}
+
+void DiagnosticsTab::onResetMetrics()
+{
+    Metrics::reset();
+    onRefreshMetrics();
+}
+
 void DiagnosticsTab::configureForDeviceType()
 {
     // Clear all text fields
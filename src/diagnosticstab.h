@@ -9,6 +9,7 @@ namespace Ui {
 class DiagnosticsTab;
 }
 
+class QTimer;
 class DensiStickRunner;
 
 class DiagnosticsTab : public QWidget
@@ -23,6 +24,10 @@ public:
 
     bool isRemoteOpen() const;
 
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
 private slots:
     void onConnectionOpened();
     void onConnectionClosed();
@@ -38,6 +43,9 @@ private slots:
     void onRemoteControl();
     void onRemoteControlFinished();
 
+    void onRefreshMetrics();
+    void onResetMetrics();
+
 private:
     void configureForDeviceType();
     void refreshButtonState();
@@ -48,6 +56,7 @@ private:
     DensInterface::DeviceType lastDeviceType_ = DensInterface::DeviceBaseline;
     QDialog *remoteDialog_ = nullptr;
     DensiStickRunner *stickRunner_ = nullptr;
+    QTimer *metricsTimer_ = nullptr;
 };
 
 #endif // DIAGNOSTICSTAB_H
@@ -7,6 +7,7 @@
 #include <QDebug>
 
 #include "densistick/tsl2585.h"
+#include "trace.h"
 
 GainCalibrationDialog::GainCalibrationDialog(DensInterface *densInterface, QWidget *parent) :
     QDialog(parent),
@@ -82,6 +83,7 @@ void GainCalibrationDialog::onSystemRemoteControl(bool enabled)
 
 void GainCalibrationDialog::onCalGainCalStatus(int status, int param)
 {
+    TRACE_SCOPE("GainCalibrationDialog::onCalGainCalStatus");
     if (status == lastStatus_ && param == lastParam_) {
         return;
     }
@@ -192,6 +194,7 @@ QString GainCalibrationDialog::lightParamText(int param)
 
 void GainCalibrationDialog::onCalGainCalFinished()
 {
+    TRACE_SCOPE("GainCalibrationDialog::onCalGainCalFinished");
     addText(tr("Gain calibration complete!"));
     running_ = false;
     success_ = true;
@@ -200,6 +203,7 @@ void GainCalibrationDialog::onCalGainCalFinished()
 
 void GainCalibrationDialog::onCalGainCalError()
 {
+    TRACE_SCOPE("GainCalibrationDialog::onCalGainCalError");
     addText(tr("Gain calibration failed!"));
     running_ = false;
     success_ = false;
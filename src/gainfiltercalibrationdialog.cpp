@@ -6,6 +6,7 @@
 #include "floatitemdelegate.h"
 #include "intitemdelegate.h"
 #include "util.h"
+#include "trace.h"
 
 namespace
 {
@@ -215,6 +216,7 @@ void GainFilterCalibrationDialog::onScanPushButtonClicked()
 
 void GainFilterCalibrationDialog::measureNextGain()
 {
+    TRACE_SCOPE("GainFilterCalibrationDialog::measureNextGain");
     densInterface_->sendInvokeUvDiagRead(
         DensInterface::SensorLightTransmission, densInterface_->diagLightMax(),
         /*Visual*/ 1, currentGain_, 719, 199);
@@ -222,6 +224,7 @@ void GainFilterCalibrationDialog::measureNextGain()
 
 void GainFilterCalibrationDialog::onDiagSensorUvInvokeReading(unsigned int reading)
 {
+    TRACE_SCOPE("GainFilterCalibrationDialog::onDiagSensorUvInvokeReading");
     bool measError = false;
 
     if (!running_) { return; }
@@ -324,6 +327,7 @@ void GainFilterCalibrationDialog::onGainValueTableWidgetDataChanged()
 
 void GainFilterCalibrationDialog::onCalcPushButtonClicked()
 {
+    TRACE_SCOPE("GainFilterCalibrationDialog::onCalcPushButtonClicked");
     bool ok;
     QList<double> gainRatios(ui->gainRatioTableWidget->rowCount());
 
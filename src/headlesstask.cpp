@@ -2,16 +2,19 @@
 
 #include <iostream>
 
-#include <QSerialPort>
 #include <QSerialPortInfo>
 #include <QDebug>
 
+#include "densserialtransport.h"
+#include "densloopbacktransport.h"
+#include "denssimulator.h"
+#include "densreplaytransport.h"
+#include "sessioncapture.h"
 #include "qsimplesignalaggregator.h"
 #include "settingsexporter.h"
 
 HeadlessTask::HeadlessTask(QObject *parent)
     : QObject{parent}
-    , serialPort_(new QSerialPort(this))
     , densInterface_(new DensInterface(this))
 {
 }
@@ -21,6 +24,11 @@ void HeadlessTask::setPort(const QString &portName)
     portName_ = portName;
 }
 
+void HeadlessTask::setPtyDeviceType(DensInterface::DeviceType deviceType)
+{
+    ptyDeviceType_ = deviceType;
+}
+
 void HeadlessTask::setCommand(HeadlessTask::Command command, const QString &commandArg)
 {
     command_ = command;
@@ -48,6 +56,28 @@ void HeadlessTask::run()
 
 bool HeadlessTask::connectToDevice()
 {
+    if (DensSimulator::isSimulatorPort(portName_)) {
+        DensSimulator *simulator = DensSimulator::fromPortName(portName_);
+        if (!simulator) { return false; }
+        return connectToTransport(simulator->createLoopback(), simulator->deviceType());
+    }
+
+    if (SessionCapture::isReplayPort(portName_)) {
+        bool fast = false;
+        SessionCapture capture;
+        if (!capture.load(SessionCapture::parseReplayPort(portName_, &fast))) {
+            std::cerr << "Unable to load capture: " << capture.errorString().toStdString() << std::endl;
+            return false;
+        }
+        DensReplayTransport *transport = new DensReplayTransport(capture);
+        transport->setFast(fast);
+        return connectToTransport(transport, transport->deviceType());
+    }
+
+    if (DensPtyTransport::isPtyPath(portName_)) {
+        return connectToTransport(new DensPtyTransport(portName_), ptyDeviceType_);
+    }
+
     QSerialPortInfo selectedPort;
 
     const auto infos = QSerialPortInfo::availablePorts();
@@ -71,31 +101,30 @@ bool HeadlessTask::connectToDevice()
 
     if (!selectedPort.isNull()) {
         qDebug() << "Detected device at:" << selectedPort.portName();
-        serialPort_->setPort(selectedPort);
     } else  {
         qWarning() << "No devices found";
         return false;
     }
 
-    serialPort_->setBaudRate(QSerialPort::Baud115200);
-    serialPort_->setDataBits(QSerialPort::Data8);
-    serialPort_->setParity(QSerialPort::NoParity);
-    serialPort_->setStopBits(QSerialPort::OneStop);
-    serialPort_->setFlowControl(QSerialPort::NoFlowControl);
+    return connectToTransport(new DensSerialTransport(selectedPort), DensInterface::portDeviceType(selectedPort));
+}
 
-    if (serialPort_->open(QIODevice::ReadWrite)) {
-        serialPort_->setDataTerminalReady(true);
-        if (densInterface_->connectToDevice(serialPort_, DensInterface::portDeviceType(selectedPort))) {
+bool HeadlessTask::connectToTransport(DensTransport *transport, DensInterface::DeviceType deviceType)
+{
+    if (transport->open()) {
+        if (densInterface_->connectToDevice(transport, deviceType)) {
             qDebug() << "Connected to device";
             return true;
         } else {
-            serialPort_->close();
+            transport->close();
+            delete transport;
             qWarning() << "Unrecognized device";
             return false;
         }
     }
 
-    qDebug() << "Error opening device";
+    qDebug() << "Error opening device:" << transport->errorString();
+    delete transport;
     return false;
 }
 
@@ -5,9 +5,7 @@
 
 #include "densinterface.h"
 
-QT_BEGIN_NAMESPACE
-class QSerialPort;
-QT_END_NAMESPACE
+class DensTransport;
 
 class HeadlessTask : public QObject
 {
@@ -22,6 +20,7 @@ public:
     explicit HeadlessTask(QObject *parent = nullptr);
 
     void setPort(const QString &portName);
+    void setPtyDeviceType(DensInterface::DeviceType deviceType);
     void setCommand(HeadlessTask::Command command, const QString &commandArg);
 
 public slots:
@@ -35,13 +34,14 @@ private slots:
 
 private:
     bool connectToDevice();
+    bool connectToTransport(DensTransport *transport, DensInterface::DeviceType deviceType);
     void systemInfoStart();
     void exportSettingStart();
 
     QString portName_;
+    DensInterface::DeviceType ptyDeviceType_ = DensInterface::DeviceBaseline;
     HeadlessTask::Command command_ = HeadlessTask::CommandUnknown;
     QString commandArg_;
-    QSerialPort *serialPort_ = nullptr;
     DensInterface *densInterface_ = nullptr;
 };
 
@@ -0,0 +1,433 @@
+#include "logarchive.h"
+
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QPointer>
+#include <QTimer>
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <QDebug>
+#include <memory>
+
+#include "util.h"
+
+namespace
+{
+/*
+ * Archive layout:
+ *   Segment files named log-<start time>.dlz, holding chunks that were
+ *   each compressed with qCompress(). Uncompressed, every line in a chunk
+ *   is "<ms since epoch>\t<level or ->\t<source>\t<text>\n".
+ *
+ *   Index files named log-<start time>.dli, starting with the "DLOGIDX"
+ *   magic and a version byte, followed by one entry per chunk:
+ *     64-bit offset of the chunk within the segment
+ *     32-bit compressed size
+ *     32-bit number of lines
+ *     64-bit time of the first and of the last line
+ *     Bit mask of the levels present, padded out to 4 bytes
+ *   All values are little-endian.
+ */
+static const char INDEX_MAGIC[] = "DLOGIDX";
+static const qsizetype INDEX_MAGIC_SIZE = 7;
+static const quint8 INDEX_VERSION = 1;
+static const qsizetype INDEX_HEADER_SIZE = INDEX_MAGIC_SIZE + 1;
+static const qsizetype INDEX_ENTRY_SIZE = 36;
+
+static const char SEGMENT_SUFFIX[] = ".dlz";
+static const char INDEX_SUFFIX[] = ".dli";
+
+/* Chunks are compressed and written out once this much has accumulated */
+static const qsizetype CHUNK_SIZE = 64 * 1024;
+
+/* Partial chunks are written out at least this often */
+static const int FLUSH_INTERVAL_MS = 5000;
+
+/* A new segment is started once the current one reaches this size, or on a new day */
+static const qint64 SEGMENT_SIZE = 8 * 1024 * 1024;
+
+/* Older segments are removed, as are the oldest ones while over the size limit */
+static const int RETENTION_DAYS = 14;
+static const qint64 MAX_ARCHIVE_SIZE = 512LL * 1024 * 1024;
+
+/* Bit used in the level mask for lines without a known level */
+static const quint8 LEVEL_UNKNOWN_BIT = 0x40;
+
+struct ChunkIndex
+{
+    quint64 offset = 0;
+    quint32 size = 0;
+    quint32 lines = 0;
+    qint64 firstMs = 0;
+    qint64 lastMs = 0;
+    quint8 levels = 0;
+};
+
+struct ArchiveState
+{
+    QDir dir;
+    std::unique_ptr<QFile> segment;
+    std::unique_ptr<QFile> index;
+    qint64 segmentDay = 0;
+    QByteArray chunk;
+    ChunkIndex chunkIndex;
+};
+
+/* Only changed by LogArchive::start() and stop(), outside the archive lock */
+QPointer<QTimer> flushTimer;
+QtMessageHandler previousHandler = nullptr;
+
+/* Set while a line is being archived, so messages logged in the process are not archived again */
+thread_local bool archiving = false;
+
+quint8 levelBit(char level)
+{
+    const int rank = util::logLevelRank(level);
+    return rank < 0 ? LEVEL_UNKNOWN_BIT : static_cast<quint8>(1 << rank);
+}
+
+/* Mask of the levels a query for the given minimum level will accept */
+quint8 acceptedLevels(char minimumLevel)
+{
+    const int rank = util::logLevelRank(minimumLevel);
+    if (rank < 0) { return 0xFF; }
+    return static_cast<quint8>((0x3F & ~((1 << rank) - 1)) | LEVEL_UNKNOWN_BIT);
+}
+
+qint64 dayOf(qint64 ms)
+{
+    return QDateTime::fromMSecsSinceEpoch(ms).date().toJulianDay();
+}
+
+QByteArray encodeIndex(const ChunkIndex &entry)
+{
+    QByteArray buf(INDEX_ENTRY_SIZE, '\0');
+    uchar *p = reinterpret_cast<uchar *>(buf.data());
+    qToLittleEndian<quint64>(entry.offset, p);
+    qToLittleEndian<quint32>(entry.size, p + 8);
+    qToLittleEndian<quint32>(entry.lines, p + 12);
+    qToLittleEndian<qint64>(entry.firstMs, p + 16);
+    qToLittleEndian<qint64>(entry.lastMs, p + 24);
+    p[32] = entry.levels;
+    return buf;
+}
+
+ChunkIndex decodeIndex(const uchar *p)
+{
+    ChunkIndex entry;
+    entry.offset = qFromLittleEndian<quint64>(p);
+    entry.size = qFromLittleEndian<quint32>(p + 8);
+    entry.lines = qFromLittleEndian<quint32>(p + 12);
+    entry.firstMs = qFromLittleEndian<qint64>(p + 16);
+    entry.lastMs = qFromLittleEndian<qint64>(p + 24);
+    entry.levels = p[32];
+    return entry;
+}
+
+QStringList segmentNames(const QDir &dir)
+{
+    return dir.entryList(QStringList() << (QLatin1String("log-*") + QLatin1String(SEGMENT_SUFFIX)),
+                         QDir::Files, QDir::Name);
+}
+
+QString indexName(const QString &segmentName)
+{
+    return segmentName.chopped(qstrlen(SEGMENT_SUFFIX)) + QLatin1String(INDEX_SUFFIX);
+}
+
+void pruneArchive(ArchiveState &state)
+{
+    const QStringList names = segmentNames(state.dir);
+    const QString current = state.segment ? QFileInfo(*state.segment).fileName() : QString();
+    const QDateTime cutoff = QDateTime::currentDateTime().addDays(-RETENTION_DAYS);
+
+    qint64 total = 0;
+    for (const QString &name : names) {
+        total += QFileInfo(state.dir.filePath(name)).size();
+    }
+
+    // Names sort by start time, so the oldest segments come first
+    for (const QString &name : names) {
+        if (name == current) { break; }
+        const QFileInfo info(state.dir.filePath(name));
+        if (info.lastModified() >= cutoff && total <= MAX_ARCHIVE_SIZE) { break; }
+        total -= info.size();
+        state.dir.remove(name);
+        state.dir.remove(indexName(name));
+    }
+}
+
+bool openSegment(ArchiveState &state, qint64 startMs)
+{
+    state.segment.reset();
+    state.index.reset();
+
+    const QString name = QLatin1String("log-")
+        + QDateTime::fromMSecsSinceEpoch(startMs).toString(QLatin1String("yyyyMMdd-HHmmss"))
+        + QLatin1String(SEGMENT_SUFFIX);
+
+    auto segment = std::make_unique<QFile>(state.dir.filePath(name));
+    auto index = std::make_unique<QFile>(state.dir.filePath(indexName(name)));
+    if (!segment->open(QIODevice::WriteOnly | QIODevice::Append)
+        || !index->open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return false;
+    }
+
+    if (index->size() == 0) {
+        index->write(INDEX_MAGIC, INDEX_MAGIC_SIZE);
+        index->write(reinterpret_cast<const char *>(&INDEX_VERSION), 1);
+    }
+
+    state.segment = std::move(segment);
+    state.index = std::move(index);
+    state.segmentDay = dayOf(startMs);
+    pruneArchive(state);
+    return true;
+}
+
+void writeChunk(ArchiveState &state)
+{
+    if (state.chunk.isEmpty()) { return; }
+
+    const QByteArray compressed = qCompress(state.chunk);
+
+    if (!state.segment
+        || state.segment->size() + compressed.size() > SEGMENT_SIZE
+        || dayOf(state.chunkIndex.firstMs) != state.segmentDay) {
+        if (!openSegment(state, state.chunkIndex.firstMs)) {
+            qWarning() << "Unable to open log archive segment in" << state.dir.path();
+            state.chunk.clear();
+            state.chunkIndex = ChunkIndex();
+            return;
+        }
+    }
+
+    // The chunk goes out before its index entry, so a partially written
+    // chunk is never referenced if the application stops in between
+    state.chunkIndex.offset = static_cast<quint64>(state.segment->size());
+    state.chunkIndex.size = static_cast<quint32>(compressed.size());
+    if (state.segment->write(compressed) == compressed.size() && state.segment->flush()) {
+        state.index->write(encodeIndex(state.chunkIndex));
+        state.index->flush();
+    } else {
+        qWarning() << "Log archive write error:" << state.segment->errorString();
+    }
+
+    state.chunk.clear();
+    state.chunkIndex = ChunkIndex();
+}
+
+void archiveMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    char level;
+    switch (type) {
+    case QtDebugMsg: level = 'D'; break;
+    case QtInfoMsg: level = 'I'; break;
+    case QtWarningMsg: level = 'W'; break;
+    case QtCriticalMsg: level = 'E'; break;
+    case QtFatalMsg: level = 'A'; break;
+    default: level = 0; break;
+    }
+    LogArchive::append(LogArchiveEntry::SourceHost, level, msg.toUtf8());
+
+    // The default handler aborts on a fatal message, so this is the
+    // last chance to get the lines leading up to it onto disk
+    if (type == QtFatalMsg && !archiving) {
+        LogArchive::flush();
+    }
+
+    if (previousHandler) {
+        previousHandler(type, context, msg);
+    }
+}
+
+bool parseLine(QByteArrayView line, LogArchiveEntry *entry)
+{
+    const qsizetype t1 = line.indexOf('\t');
+    if (t1 <= 0 || line.size() < t1 + 5) { return false; }
+    if (line[t1 + 2] != '\t' || line[t1 + 4] != '\t') { return false; }
+
+    bool ok;
+    entry->timestamp = line.first(t1).toLongLong(&ok);
+    if (!ok) { return false; }
+    entry->level = line[t1 + 1] == '-' ? 0 : line[t1 + 1];
+    entry->source = static_cast<LogArchiveEntry::Source>(line[t1 + 3]);
+    entry->text = line.sliced(t1 + 5).toByteArray();
+    return true;
+}
+}
+
+QString LogArchive::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QLatin1String("/logs");
+}
+
+bool LogArchive::start(const QString &path)
+{
+    {
+        Locked<ArchiveState> state;
+        if (isActive()) { return false; }
+
+        if (!QDir().mkpath(path)) {
+            return false;
+        }
+        state->dir = QDir(path);
+        state->segment.reset();
+        state->index.reset();
+        state->chunk.clear();
+        state->chunkIndex = ChunkIndex();
+        state->chunk.reserve(CHUNK_SIZE + 1024);
+        pruneArchive(*state);
+        setActive(true);
+    }
+
+    if (QCoreApplication::instance()) {
+        QTimer *timer = new QTimer(QCoreApplication::instance());
+        timer->setInterval(FLUSH_INTERVAL_MS);
+        QObject::connect(timer, &QTimer::timeout, timer, &LogArchive::flush);
+        timer->start();
+        flushTimer = timer;
+    }
+
+    previousHandler = qInstallMessageHandler(archiveMessageHandler);
+    return true;
+}
+
+void LogArchive::stop()
+{
+    if (!isActive()) { return; }
+
+    qInstallMessageHandler(previousHandler);
+    if (flushTimer) {
+        delete flushTimer;
+    }
+
+    Locked<ArchiveState> state;
+    setActive(false);
+    writeChunk(*state);
+    state->segment.reset();
+    state->index.reset();
+}
+
+void LogArchive::appendDeviceLine(const QByteArray &line)
+{
+    QByteArrayView text(line);
+    while (text.endsWith('\n') || text.endsWith('\r')) { text.chop(1); }
+
+    char level = 0;
+    if (text.size() >= 2 && text[1] == '/' && util::logLevelRank(text[0]) >= 0) {
+        level = text[0];
+        text = text.sliced(2);
+    }
+    append(LogArchiveEntry::SourceDevice, level, text.toByteArray());
+}
+
+void LogArchive::append(LogArchiveEntry::Source source, char level, const QByteArray &text)
+{
+    if (!isActive() || archiving) { return; }
+    archiving = true;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    {
+        Locked<ArchiveState> state;
+        if (isActive()) {
+            ChunkIndex &chunkIndex = state->chunkIndex;
+            if (chunkIndex.lines == 0) {
+                chunkIndex.firstMs = now;
+            }
+            chunkIndex.lastMs = now;
+            chunkIndex.lines++;
+            chunkIndex.levels |= levelBit(level);
+
+            QByteArray &chunk = state->chunk;
+            chunk.append(QByteArray::number(now));
+            chunk.append('\t');
+            chunk.append(util::logLevelRank(level) < 0 ? '-' : level);
+            chunk.append('\t');
+            chunk.append(static_cast<char>(source));
+            chunk.append('\t');
+            const qsizetype start = chunk.size();
+            chunk.append(text);
+            for (qsizetype i = start; i < chunk.size(); i++) {
+                if (chunk.at(i) == '\n' || chunk.at(i) == '\r') {
+                    chunk[i] = ' ';
+                }
+            }
+            chunk.append('\n');
+
+            if (chunk.size() >= CHUNK_SIZE) {
+                writeChunk(*state);
+            }
+        }
+    }
+
+    archiving = false;
+}
+
+void LogArchive::flush()
+{
+    archiving = true;
+    {
+        Locked<ArchiveState> state;
+        writeChunk(*state);
+    }
+    archiving = false;
+}
+
+QList<LogArchiveEntry> LogArchive::query(const QString &path, qint64 fromMs, qint64 toMs,
+                                         char minimumLevel, qsizetype limit)
+{
+    if (isActive()) { flush(); }
+
+    QList<LogArchiveEntry> result;
+    const QDir dir(path);
+    const quint8 accepted = acceptedLevels(minimumLevel);
+    const int minimumRank = util::logLevelRank(minimumLevel);
+
+    const QStringList names = segmentNames(dir);
+    for (const QString &name : names) {
+        QFile indexFile(dir.filePath(indexName(name)));
+        if (!indexFile.open(QIODevice::ReadOnly)) { continue; }
+
+        const QByteArray index = indexFile.readAll();
+        if (index.size() < INDEX_HEADER_SIZE
+            || !index.startsWith(QByteArrayView(INDEX_MAGIC, INDEX_MAGIC_SIZE))
+            || static_cast<quint8>(index.at(INDEX_MAGIC_SIZE)) != INDEX_VERSION) {
+            continue;
+        }
+
+        // Only the chunks the index says may match get read and decompressed
+        QFile segmentFile(dir.filePath(name));
+        const uchar *p = reinterpret_cast<const uchar *>(index.constData());
+        for (qsizetype pos = INDEX_HEADER_SIZE; pos + INDEX_ENTRY_SIZE <= index.size(); pos += INDEX_ENTRY_SIZE) {
+            const ChunkIndex entry = decodeIndex(p + pos);
+            if (entry.lastMs < fromMs || entry.firstMs > toMs || (entry.levels & accepted) == 0) {
+                continue;
+            }
+
+            if (!segmentFile.isOpen() && !segmentFile.open(QIODevice::ReadOnly)) { break; }
+            if (!segmentFile.seek(static_cast<qint64>(entry.offset))) { continue; }
+            const QByteArray chunk = qUncompress(segmentFile.read(entry.size));
+
+            qsizetype lineStart = 0;
+            while (lineStart < chunk.size()) {
+                qsizetype lineEnd = chunk.indexOf('\n', lineStart);
+                if (lineEnd < 0) { lineEnd = chunk.size(); }
+
+                LogArchiveEntry line;
+                if (parseLine(QByteArrayView(chunk).sliced(lineStart, lineEnd - lineStart), &line)
+                    && line.timestamp >= fromMs && line.timestamp <= toMs
+                    && (minimumRank < 0 || util::logLevelRank(line.level) < 0 || util::logLevelRank(line.level) >= minimumRank)) {
+                    result.append(line);
+                    if (limit >= 0 && result.size() >= limit) { return result; }
+                }
+                lineStart = lineEnd + 1;
+            }
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,64 @@
+#ifndef LOGARCHIVE_H
+#define LOGARCHIVE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include "processrecorder.h"
+
+/**
+ * Single line stored in the log archive.
+ */
+struct LogArchiveEntry
+{
+    enum Source : char {
+        SourceDevice = 'D',     /*!< Log line sent by the device */
+        SourceHost = 'H'        /*!< Message logged by this application */
+    };
+
+    qint64 timestamp = 0;       /*!< Milliseconds since the epoch */
+    char level = 0;             /*!< A/E/W/I/D/V level letter, or zero if unknown */
+    Source source = SourceDevice;
+    QByteArray text;
+};
+
+/**
+ * Process-wide archive of device log lines and application messages.
+ *
+ * Lines are collected into chunks, which are compressed with qCompress()
+ * and appended to segment files in the archive directory. Every segment
+ * has a small index alongside it, holding the time range and levels of
+ * each chunk, so a query only has to decompress the chunks that can
+ * actually contain matching lines. Segments are rolled over by size and
+ * by day, and old ones are pruned to keep the archive bounded.
+ *
+ * Lines may be appended from any thread, and everything still buffered
+ * is written out before a fatal message ends the application.
+ */
+class LogArchive : public ProcessRecorder<LogArchive>
+{
+public:
+    /** Default archive location, within the application data directory */
+    static QString defaultPath();
+
+    static bool start(const QString &path);
+    static void stop();
+
+    /** Archive a device log line, taking its level from its prefix */
+    static void appendDeviceLine(const QByteArray &line);
+    static void append(LogArchiveEntry::Source source, char level, const QByteArray &text);
+
+    /** Write out everything buffered so far */
+    static void flush();
+
+    /**
+     * Find archived lines within a time range, at or above a minimum
+     * level. Lines without a known level are always included.
+     * The range is inclusive and in milliseconds since the epoch.
+     */
+    static QList<LogArchiveEntry> query(const QString &path, qint64 fromMs, qint64 toMs,
+                                        char minimumLevel = 0, qsizetype limit = -1);
+};
+
+#endif // LOGARCHIVE_H
@@ -1,13 +1,32 @@
 #include "logger.h"
 
-#include <QScrollBar>
+#include <QEvent>
 #include <QFont>
+#include <QFontDatabase>
+
+#include "logmodel.h"
+
+namespace
+{
+/* Lines kept for scrolling back through, before the oldest are dropped */
+static const qsizetype LOG_CAPACITY = 1000000;
+
+/* Space for the text of those lines, which is plenty at typical line lengths */
+static const qsizetype LOG_TEXT_CAPACITY = 64 * 1024 * 1024;
+}
 
 Logger::Logger(QWidget *parent)
-    : QPlainTextEdit(parent)
-    , autoScroll_(true)
+    : QListView(parent)
+    , model_(new LogModel(LOG_CAPACITY, LOG_TEXT_CAPACITY, this))
+    , follow_(true)
 {
-    document()->setMaximumBlockCount(5000);
+    // Every row is the same height, which lets the view skip measuring
+    // all of them and only ever lay out the ones that are visible
+    setUniformItemSizes(true);
+    setLayoutMode(QListView::SinglePass);
+    setSelectionMode(QAbstractItemView::ExtendedSelection);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setModel(model_);
 
     const QFont fixedFont = QFontDatabase::systemFont(QFontDatabase::FixedFont);
     setFont(fixedFont);
@@ -16,24 +35,74 @@ Logger::Logger(QWidget *parent)
     p.setColor(QPalette::Base, Qt::black);
     p.setColor(QPalette::Text, Qt::green);
     setPalette(p);
-    setReadOnly(true);
+    updateLevelColors();
 }
 
 void Logger::putData(const QByteArray &data)
 {
-    insertPlainText(data);
+    model_->appendLines(data);
+
+    if (follow_) {
+        scrollToBottom();
+    }
+}
+
+void Logger::setFollow(bool enabled)
+{
+    if (enabled && !follow_) {
+        scrollToBottom();
+    }
+    follow_ = enabled;
+}
+
+void Logger::setMinimumLevel(char level)
+{
+    model_->setMinimumLevel(level);
+    if (follow_) {
+        scrollToBottom();
+    }
+}
+
+bool Logger::findText(const QString &text, bool next, bool backward)
+{
+    // Searching as the text is typed starts from the current match,
+    // so it stays put for as long as that line still matches
+    int start = currentIndex().isValid() ? currentIndex().row() : 0;
+    if (next) {
+        start += backward ? -1 : 1;
+        if (start < 0) { start = model_->rowCount() - 1; }
+        if (start >= model_->rowCount()) { start = 0; }
+    }
+
+    const int row = model_->find(text, start, backward);
+    if (row < 0) { return false; }
 
-    if (autoScroll_) {
-        QScrollBar *bar = verticalScrollBar();
-        bar->setValue(bar->maximum());
+    const QModelIndex index = model_->index(row);
+    setCurrentIndex(index);
+    scrollTo(index, QAbstractItemView::PositionAtCenter);
+    return true;
+}
+
+void Logger::clear()
+{
+    model_->clear();
+}
+
+void Logger::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::PaletteChange) {
+        updateLevelColors();
     }
+    QListView::changeEvent(event);
 }
 
-void Logger::setAutoScroll(bool enabled)
+void Logger::updateLevelColors()
 {
-    if (enabled && !autoScroll_) {
-        QScrollBar *bar = verticalScrollBar();
-        bar->setValue(bar->maximum());
+    // Pick colours that stand out against whatever the background is
+    const bool dark = palette().color(QPalette::Base).lightness() < 128;
+    if (dark) {
+        model_->setLevelColors(QColor(Qt::yellow), QColor(255, 85, 85));
+    } else {
+        model_->setLevelColors(QColor(Qt::darkYellow), QColor(Qt::darkRed));
     }
-    autoScroll_ = enabled;
 }
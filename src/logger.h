@@ -2,17 +2,26 @@
 #define LOGGER_H
 
 #include <QObject>
-#include <QPlainTextEdit>
+#include <QListView>
 
-class Logger : public QPlainTextEdit
+class LogModel;
+
+class Logger : public QListView
 {
     Q_OBJECT
 public:
     explicit Logger(QWidget *parent = nullptr);
     void putData(const QByteArray &data);
-    void setAutoScroll(bool enabled);
+    void setFollow(bool enabled);
+    void setMinimumLevel(char level);
+    bool findText(const QString &text, bool next, bool backward = false);
+    void clear();
+protected:
+    void changeEvent(QEvent *event) override;
 private:
-    bool autoScroll_;
+    void updateLevelColors();
+    LogModel *model_;
+    bool follow_;
 };
 
 #endif // LOGGER_H
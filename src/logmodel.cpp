@@ -0,0 +1,304 @@
+#include "logmodel.h"
+
+#include <QDateTime>
+#include <QString>
+
+#include <string.h>
+
+#include "util.h"
+
+namespace
+{
+/* Arena space reserved up front, grown as needed up to the text capacity */
+static const qsizetype INITIAL_TEXT_SIZE = 64 * 1024;
+
+bool parseLevel(QByteArrayView line, char *level)
+{
+    if (line.size() < 2 || line[1] != '/') { return false; }
+    if (util::logLevelRank(line[0]) < 0) { return false; }
+    *level = line[0];
+    return true;
+}
+}
+
+LogModel::LogModel(qsizetype capacity, qsizetype textCapacity, QObject *parent)
+    : QAbstractListModel(parent)
+    , capacity_(qMax<qsizetype>(1, capacity))
+    , textCapacity_(qMax<qsizetype>(1, textCapacity))
+    , textEnd_(0)
+    , firstSeq_(0)
+    , nextSeq_(0)
+    , minimumLevel_(0)
+    , warningColor_(Qt::darkYellow)
+    , errorColor_(Qt::red)
+{
+}
+
+LogModel::~LogModel()
+{
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) { return 0; }
+    return static_cast<int>(isFiltering() ? filtered_.size() : recordCount());
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rowCount()) { return QVariant(); }
+
+    const Record &rec = record(rowSequence(index.row()));
+    if (role == Qt::DisplayRole) {
+        QString result = QDateTime::fromMSecsSinceEpoch(rec.timestamp).toString(QLatin1String("hh:mm:ss.zzz"));
+        result.append(QLatin1Char(' '));
+        if (rec.level) {
+            result.append(QLatin1Char(rec.level));
+            result.append(QLatin1Char('/'));
+        }
+        result.append(QLatin1StringView(text(rec)));
+        return result;
+    } else if (role == Qt::ForegroundRole) {
+        if (rec.level == 'A' || rec.level == 'E') {
+            return errorColor_;
+        } else if (rec.level == 'W') {
+            return warningColor_;
+        }
+    }
+    return QVariant();
+}
+
+void LogModel::appendLines(const QByteArray &block)
+{
+    struct Incoming
+    {
+        Record record;
+        QByteArrayView text;
+    };
+
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+    const quint64 arenaSize = static_cast<quint64>(textCapacity_);
+
+    // Lay the new lines out in the arena before anything is written, so
+    // everything they push out of it can be evicted in one go. A line is
+    // never split across the end of the arena, it starts over from the
+    // beginning instead.
+    QList<Incoming> incoming;
+    quint64 textEnd = textEnd_;
+    qsizetype pos = 0;
+    while (pos < block.size()) {
+        qsizetype end = block.indexOf('\n', pos);
+        if (end < 0) { end = block.size(); }
+
+        QByteArrayView line = QByteArrayView(block).sliced(pos, end - pos);
+        pos = end + 1;
+        while (line.endsWith('\r')) { line.chop(1); }
+        if (line.isEmpty()) { continue; }
+
+        Incoming item = { { timestamp, 0, 0, 0 }, QByteArrayView() };
+        if (parseLevel(line, &item.record.level)) {
+            line = line.sliced(2);
+        }
+        item.text = line.first(qMin(line.size(), textCapacity_));
+
+        const quint64 offset = textEnd % arenaSize;
+        if (offset + item.text.size() > arenaSize) {
+            textEnd += arenaSize - offset;
+        }
+        item.record.textPos = textEnd;
+        item.record.textSize = static_cast<int>(item.text.size());
+        textEnd += item.text.size();
+
+        incoming.append(item);
+    }
+    if (incoming.isEmpty()) { return; }
+
+    // Only text from the last arena's worth of bytes is still there once
+    // everything has been written, and anything that would not fit even
+    // in an empty ring is never seen
+    const quint64 textStart = textEnd > arenaSize ? textEnd - arenaSize : 0;
+    qsizetype skipped = qMax<qsizetype>(0, incoming.size() - capacity_);
+    while (incoming.at(skipped).record.textPos < textStart) { skipped++; }
+    incoming.remove(0, skipped);
+
+    // Make room for the new records, along with every older one whose
+    // text is about to be written over
+    qsizetype overflow = qMax<qsizetype>(0, recordCount() + incoming.size() - capacity_);
+    while (overflow < recordCount() && record(firstSeq_ + overflow).textPos < textStart) {
+        overflow++;
+    }
+    if (overflow > 0) {
+        evict(overflow);
+    }
+
+    const int firstRow = rowCount();
+    int added = static_cast<int>(incoming.size());
+    if (isFiltering()) {
+        added = 0;
+        for (const Incoming &item : std::as_const(incoming)) {
+            if (accepts(item.record)) { added++; }
+        }
+    }
+
+    if (added > 0) {
+        beginInsertRows(QModelIndex(), firstRow, firstRow + added - 1);
+    }
+    for (const Incoming &item : std::as_const(incoming)) {
+        const qsizetype offset = static_cast<qsizetype>(item.record.textPos % arenaSize);
+        const qsizetype required = offset + item.text.size();
+        if (required > text_.size()) {
+            text_.resize(qMin(textCapacity_, qMax(required, qMax(INITIAL_TEXT_SIZE, text_.size() * 2))));
+        }
+        if (!item.text.isEmpty()) {
+            memcpy(text_.data() + offset, item.text.data(), item.text.size());
+        }
+
+        const quint64 seq = nextSeq_++;
+        if (isFiltering() && accepts(item.record)) {
+            filtered_.append(seq);
+        }
+        const qsizetype slot = static_cast<qsizetype>(seq % capacity_);
+        if (slot == records_.size()) {
+            records_.append(item.record);
+        } else {
+            records_[slot] = item.record;
+        }
+    }
+    textEnd_ = textEnd;
+    if (added > 0) {
+        endInsertRows();
+    }
+}
+
+void LogModel::clear()
+{
+    beginResetModel();
+    records_.clear();
+    filtered_.clear();
+    text_.clear();
+    textEnd_ = 0;
+    firstSeq_ = 0;
+    nextSeq_ = 0;
+    endResetModel();
+}
+
+qsizetype LogModel::capacity() const
+{
+    return capacity_;
+}
+
+qsizetype LogModel::textCapacity() const
+{
+    return textCapacity_;
+}
+
+void LogModel::setLevelColors(const QColor &warning, const QColor &error)
+{
+    if (warning == warningColor_ && error == errorColor_) { return; }
+
+    warningColor_ = warning;
+    errorColor_ = error;
+
+    const int rows = rowCount();
+    if (rows > 0) {
+        emit dataChanged(index(0), index(rows - 1), { Qt::ForegroundRole });
+    }
+}
+
+void LogModel::setMinimumLevel(char level)
+{
+    if (util::logLevelRank(level) < 0) { level = 0; }
+    if (level == minimumLevel_) { return; }
+
+    beginResetModel();
+    minimumLevel_ = level;
+    filtered_.clear();
+    if (isFiltering()) {
+        for (quint64 seq = firstSeq_; seq < nextSeq_; seq++) {
+            if (accepts(record(seq))) {
+                filtered_.append(seq);
+            }
+        }
+    }
+    endResetModel();
+}
+
+char LogModel::minimumLevel() const
+{
+    return minimumLevel_;
+}
+
+int LogModel::find(const QString &text, int startRow, bool backward) const
+{
+    const int rows = rowCount();
+    if (text.isEmpty() || rows == 0) { return -1; }
+
+    // Records are Latin-1, so matching against them directly avoids
+    // building a string for every line that gets looked at
+    const QByteArray needle = text.toLatin1();
+    const QLatin1StringView needleView(needle);
+
+    int row = qBound(0, startRow, rows - 1);
+    for (int i = 0; i < rows; i++) {
+        const Record &rec = record(rowSequence(row));
+        if (QLatin1StringView(text(rec)).contains(needleView, Qt::CaseInsensitive)) {
+            return row;
+        }
+        row = backward ? (row == 0 ? rows - 1 : row - 1) : (row + 1 == rows ? 0 : row + 1);
+    }
+    return -1;
+}
+
+qsizetype LogModel::recordCount() const
+{
+    return static_cast<qsizetype>(nextSeq_ - firstSeq_);
+}
+
+const LogModel::Record &LogModel::record(quint64 seq) const
+{
+    return records_.at(static_cast<qsizetype>(seq % capacity_));
+}
+
+QByteArrayView LogModel::text(const Record &record) const
+{
+    const qsizetype offset = static_cast<qsizetype>(record.textPos % static_cast<quint64>(textCapacity_));
+    return QByteArrayView(text_.constData() + offset, record.textSize);
+}
+
+quint64 LogModel::rowSequence(int row) const
+{
+    return isFiltering() ? filtered_.at(row) : firstSeq_ + row;
+}
+
+bool LogModel::isFiltering() const
+{
+    return minimumLevel_ != 0;
+}
+
+bool LogModel::accepts(const Record &record) const
+{
+    return record.level == 0 || util::logLevelRank(record.level) >= util::logLevelRank(minimumLevel_);
+}
+
+void LogModel::evict(qsizetype count)
+{
+    count = qMin(count, recordCount());
+    if (count <= 0) { return; }
+
+    const quint64 newFirst = firstSeq_ + count;
+    if (isFiltering()) {
+        qsizetype removed = 0;
+        while (removed < filtered_.size() && filtered_.at(removed) < newFirst) { removed++; }
+        if (removed > 0) {
+            beginRemoveRows(QModelIndex(), 0, static_cast<int>(removed - 1));
+            filtered_.remove(0, removed);
+            firstSeq_ = newFirst;
+            endRemoveRows();
+        }
+        firstSeq_ = newFirst;
+    } else {
+        beginRemoveRows(QModelIndex(), 0, static_cast<int>(count - 1));
+        firstSeq_ = newFirst;
+        endRemoveRows();
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QByteArray>
+#include <QColor>
+#include <QList>
+
+/**
+ * List model holding the most recent device log lines.
+ *
+ * Records are kept in a ring of fixed capacity, and the text of every
+ * line is stored back to back in a single arena of fixed size, so memory
+ * use stays bounded over long sessions and the oldest lines are dropped
+ * first when either one runs out of room.
+ * A minimum level can be set to only show the more important lines,
+ * in which case the model keeps an index of the matching records.
+ */
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    LogModel(qsizetype capacity, qsizetype textCapacity, QObject *parent = nullptr);
+    ~LogModel();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    /** Add a block of one or more complete lines */
+    void appendLines(const QByteArray &block);
+    void clear();
+
+    qsizetype capacity() const;
+    qsizetype textCapacity() const;
+
+    /** Text colours for warning and error lines, which should suit the view's background */
+    void setLevelColors(const QColor &warning, const QColor &error);
+
+    /**
+     * Only show lines at or above the given level, from least to most
+     * important: V, D, I, W, E, A. Lines without a level are always
+     * shown. Zero shows everything.
+     */
+    void setMinimumLevel(char level);
+    char minimumLevel() const;
+
+    /**
+     * Find the next row containing the text, ignoring case, starting
+     * at the given row and wrapping around. Returns -1 if none match.
+     */
+    int find(const QString &text, int startRow, bool backward = false) const;
+
+private:
+    struct Record
+    {
+        qint64 timestamp;   /*!< Time the line was received, in ms since the epoch */
+        quint64 textPos;    /*!< Start of the text, counting every byte ever placed in the arena */
+        int textSize;
+        char level;         /*!< Level prefix letter, or zero if the line had none */
+    };
+
+    qsizetype recordCount() const;
+    const Record &record(quint64 seq) const;
+    QByteArrayView text(const Record &record) const;
+    quint64 rowSequence(int row) const;
+    bool isFiltering() const;
+    bool accepts(const Record &record) const;
+    void evict(qsizetype count);
+
+    QList<Record> records_;
+    qsizetype capacity_;
+    QByteArray text_;
+    qsizetype textCapacity_;
+    quint64 textEnd_;
+    quint64 firstSeq_;
+    quint64 nextSeq_;
+    QList<quint64> filtered_;
+    char minimumLevel_;
+    QColor warningColor_;
+    QColor errorColor_;
+};
+
+#endif // LOGMODEL_H
@@ -0,0 +1,89 @@
+#include "logsink.h"
+
+#include <QTimer>
+
+namespace
+{
+/* Lines that can be waiting for the display before new ones get dropped */
+static const qsizetype QUEUE_CAPACITY = 8192;
+
+/* Roughly one display frame, so the widget never updates more often than it can be seen */
+static const int FLUSH_INTERVAL_MS = 16;
+
+/* Lines taken off the queue per flush, so a backlog can't stall the event loop */
+static const qsizetype MAX_FLUSH_LINES = 2048;
+}
+
+LogSink::LogSink(QObject *parent)
+    : QObject(parent)
+    , flushTimer_(new QTimer(this))
+    , dropped_(0)
+    , reportedDropped_(0)
+{
+    flushTimer_->setSingleShot(true);
+    flushTimer_->setInterval(FLUSH_INTERVAL_MS);
+    connect(flushTimer_, &QTimer::timeout, this, &LogSink::flush);
+}
+
+LogSink::~LogSink()
+{
+}
+
+void LogSink::append(const QByteArray &line)
+{
+    if (queue_.size() < QUEUE_CAPACITY) {
+        queue_.append(line);
+    } else {
+        dropped_++;
+    }
+
+    if (!flushTimer_->isActive()) {
+        flushTimer_->start();
+    }
+}
+
+quint64 LogSink::droppedCount() const
+{
+    return dropped_;
+}
+
+void LogSink::clear()
+{
+    queue_.clear();
+    reportedDropped_ = dropped_;
+}
+
+void LogSink::flush()
+{
+    const qsizetype count = qMin(queue_.size(), MAX_FLUSH_LINES);
+
+    qsizetype size = 0;
+    for (qsizetype i = 0; i < count; i++) {
+        size += queue_.at(i).size();
+    }
+
+    QByteArray block;
+    block.reserve(size);
+    for (qsizetype i = 0; i < count; i++) {
+        block.append(queue_.at(i));
+    }
+
+    // Removing from the front releases the flushed lines right away,
+    // without moving the ones still waiting
+    queue_.remove(0, count);
+
+    if (dropped_ != reportedDropped_) {
+        block.append("-- ");
+        block.append(QByteArray::number(dropped_ - reportedDropped_));
+        block.append(" log lines dropped --\n");
+        reportedDropped_ = dropped_;
+    }
+
+    if (!block.isEmpty()) {
+        emit flushed(block);
+    }
+
+    if (!queue_.isEmpty()) {
+        flushTimer_->start();
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef LOGSINK_H
+#define LOGSINK_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+
+class QTimer;
+
+/**
+ * Collects device log lines and hands them to the display in batches.
+ *
+ * Lines are queued as they arrive, and flushed as a single block at
+ * most once per display frame. If the display falls behind and the
+ * queue fills up, new lines are dropped rather than letting it grow
+ * without bound, and the next block notes how many were lost.
+ *
+ * Lines must be appended from the thread the sink lives on.
+ */
+class LogSink : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LogSink(QObject *parent = nullptr);
+    ~LogSink();
+
+    void append(const QByteArray &line);
+
+    /** Total number of lines dropped since the sink was created */
+    quint64 droppedCount() const;
+
+public slots:
+    /** Discard everything that has not been flushed yet */
+    void clear();
+
+signals:
+    void flushed(const QByteArray &block);
+
+private slots:
+    void flush();
+
+private:
+    QList<QByteArray> queue_;
+    QTimer *flushTimer_;
+    quint64 dropped_;
+    quint64 reportedDropped_;
+};
+
+#endif // LOGSINK_H
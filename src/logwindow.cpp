@@ -2,13 +2,18 @@
 #include "ui_logwindow.h"
 
 #include <QDebug>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QApplication>
 
 #include "logger.h"
+#include "logsink.h"
 
 LogWindow::LogWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::LogWindow),
-    logger_(new Logger)
+    logger_(new Logger),
+    logSink_(new LogSink(this))
 {
     ui->setupUi(this);
     logger_->setEnabled(true);
@@ -16,8 +21,32 @@ LogWindow::LogWindow(QWidget *parent) :
 
     ui->actionFollow->setChecked(true);
 
+    levelComboBox_ = new QComboBox(this);
+    levelComboBox_->addItem(tr("All"), QVariant::fromValue<int>(0));
+    levelComboBox_->addItem(tr("Debug"), QVariant::fromValue<int>('D'));
+    levelComboBox_->addItem(tr("Info"), QVariant::fromValue<int>('I'));
+    levelComboBox_->addItem(tr("Warning"), QVariant::fromValue<int>('W'));
+    levelComboBox_->addItem(tr("Error"), QVariant::fromValue<int>('E'));
+    levelComboBox_->setToolTip(tr("Minimum level"));
+
+    searchLineEdit_ = new QLineEdit(this);
+    searchLineEdit_->setPlaceholderText(tr("Search"));
+    searchLineEdit_->setClearButtonEnabled(true);
+    searchLineEdit_->setMaximumWidth(240);
+
+    ui->toolBar->addSeparator();
+    ui->toolBar->addWidget(levelComboBox_);
+    ui->toolBar->addWidget(searchLineEdit_);
+
     connect(ui->actionFollow, &QAction::toggled, this, &LogWindow::onFollowToggled);
     connect(ui->actionClear, &QAction::triggered, this, &LogWindow::onClearTriggered);
+    connect(levelComboBox_, &QComboBox::currentIndexChanged, this, &LogWindow::onLevelChanged);
+    connect(searchLineEdit_, &QLineEdit::textChanged, this, &LogWindow::onSearchTextChanged);
+    connect(searchLineEdit_, &QLineEdit::returnPressed, this, &LogWindow::onSearchNext);
+
+    // Lines can arrive far faster than the widget can show them,
+    // so they are batched up and inserted once per frame
+    connect(logSink_, &LogSink::flushed, logger_, &Logger::putData);
 }
 
 LogWindow::~LogWindow()
@@ -39,15 +68,37 @@ void LogWindow::closeEvent(QCloseEvent *event)
 
 void LogWindow::appendLogLine(const QByteArray &line)
 {
-    logger_->putData(line);
+    logSink_->append(line);
 }
 
 void LogWindow::onFollowToggled(bool checked)
 {
-    logger_->setAutoScroll(checked);
+    logger_->setFollow(checked);
 }
 
 void LogWindow::onClearTriggered()
 {
+    logSink_->clear();
     logger_->clear();
 }
+
+void LogWindow::onLevelChanged(int index)
+{
+    logger_->setMinimumLevel(static_cast<char>(levelComboBox_->itemData(index).toInt()));
+}
+
+void LogWindow::onSearchTextChanged(const QString &text)
+{
+    // Stop following while looking at a match, so it doesn't scroll away
+    if (logger_->findText(text, false)) {
+        ui->actionFollow->setChecked(false);
+    }
+}
+
+void LogWindow::onSearchNext()
+{
+    const bool backward = QApplication::keyboardModifiers().testFlag(Qt::ShiftModifier);
+    if (logger_->findText(searchLineEdit_->text(), true, backward)) {
+        ui->actionFollow->setChecked(false);
+    }
+}
@@ -6,7 +6,10 @@
 namespace Ui {
 class LogWindow;
 }
+class QComboBox;
+class QLineEdit;
 class Logger;
+class LogSink;
 
 class LogWindow : public QMainWindow
 {
@@ -26,6 +29,9 @@ signals:
 private slots:
     void onFollowToggled(bool checked);
     void onClearTriggered();
+    void onLevelChanged(int index);
+    void onSearchTextChanged(const QString &text);
+    void onSearchNext();
 
 protected:
     virtual void showEvent(QShowEvent *event);
@@ -34,6 +40,9 @@ protected:
 private:
     Ui::LogWindow *ui;
     Logger *logger_ = nullptr;;
+    LogSink *logSink_ = nullptr;
+    QComboBox *levelComboBox_ = nullptr;
+    QLineEdit *searchLineEdit_ = nullptr;
 };
 
 #endif // LOGWINDOW_H
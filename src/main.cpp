@@ -6,16 +6,26 @@
 #include <QCommandLineParser>
 #include <QSerialPortInfo>
 #include <QTimer>
+#include <QDateTime>
 #include <QDebug>
 
 #include "mainwindow.h"
 #include "headlesstask.h"
+#include "denssimulator.h"
+#include "densptyhosttransport.h"
+#include "sessioncapture.h"
+#include "logarchive.h"
+#include "metrics.h"
+#include "trace.h"
+#include "densistick/ft260emulator.h"
 
 namespace
 {
 HeadlessTask::Command headlessCommand = HeadlessTask::CommandUnknown;
 QString headlessArg;
 QString connectPort;
+QString simulateSpec;
+DensInterface::DeviceType ptyDeviceType = DensInterface::DeviceBaseline;
 }
 
 bool handleCommandLine(const QCoreApplication &app)
@@ -31,10 +41,48 @@ bool handleCommandLine(const QCoreApplication &app)
     parser.addOption(listOption);
 
     QCommandLineOption portOption(QStringList() << "p" << "port",
-                                  QCoreApplication::translate("main", "Connect to device at the selected port."),
+                                  QCoreApplication::translate("main", "Connect to device at the selected port, to an in-process simulator (sim:baseline, sim:uvvis), or to a recorded session (replay:file, replay:file?speed=max)."),
                                   QCoreApplication::translate("main", "port"));
     parser.addOption(portOption);
 
+    QCommandLineOption ptyTypeOption(QStringList() << "pty-type",
+                                     QCoreApplication::translate("main", "Device type to assume when the port is a pseudo-terminal path (baseline, uvvis)."),
+                                     QCoreApplication::translate("main", "type"));
+    parser.addOption(ptyTypeOption);
+
+    QCommandLineOption simulateOption(QStringList() << "simulate",
+                                      QCoreApplication::translate("main", "Run a simulated device on a new pseudo-terminal (baseline, uvvis), optionally followed by settings such as uvvis?latency=5&jitter=2&rate=1000."),
+                                      QCoreApplication::translate("main", "type"));
+    parser.addOption(simulateOption);
+
+    QCommandLineOption emulateStickOption(QStringList() << "emulate-stick",
+                                          QCoreApplication::translate("main", "Offer an emulated DensiStick alongside any attached devices."));
+    parser.addOption(emulateStickOption);
+
+    QCommandLineOption recordOption(QStringList() << "record",
+                                    QCoreApplication::translate("main", "Record all device traffic to a capture file, for later replay."),
+                                    QCoreApplication::translate("main", "file"));
+    parser.addOption(recordOption);
+
+    QCommandLineOption traceOption(QStringList() << "trace",
+                                   QCoreApplication::translate("main", "Record a timing trace in Chrome trace-event format, saved on exit."),
+                                   QCoreApplication::translate("main", "file"));
+    parser.addOption(traceOption);
+
+    QCommandLineOption showLogsOption(QStringList() << "show-logs",
+                                      QCoreApplication::translate("main", "Print archived log lines within a time range, given as from[,to] in ISO 8601 form."),
+                                      QCoreApplication::translate("main", "range"));
+    parser.addOption(showLogsOption);
+
+    QCommandLineOption logLevelOption(QStringList() << "log-level",
+                                      QCoreApplication::translate("main", "Minimum level of archived log lines to print (V, D, I, W, E, A)."),
+                                      QCoreApplication::translate("main", "level"));
+    parser.addOption(logLevelOption);
+
+    QCommandLineOption metricsOption(QStringList() << "metrics",
+                                     QCoreApplication::translate("main", "Print runtime metrics for the device connection on exit."));
+    parser.addOption(metricsOption);
+
     QCommandLineOption infoOption(QStringList() << "i" << "info",
                                   QCoreApplication::translate("main", "Query device system info."));
     parser.addOption(infoOption);
@@ -47,6 +95,58 @@ bool handleCommandLine(const QCoreApplication &app)
     // Parse the command line
     parser.process(app);
 
+    if (parser.isSet(emulateStickOption)) {
+        Ft260Emulator::setEnabled(true);
+    }
+
+    if (parser.isSet(recordOption)) {
+        if (SessionRecorder::start(parser.value(recordOption))) {
+            QObject::connect(&app, &QCoreApplication::aboutToQuit, &SessionRecorder::stop);
+        } else {
+            std::cerr << "Unable to record to: " << parser.value(recordOption).toStdString() << std::endl;
+        }
+    }
+
+    if (parser.isSet(traceOption)) {
+        const QString traceFile = parser.value(traceOption);
+        Trace::start();
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [traceFile]() {
+            Trace::stop();
+            if (!Trace::save(traceFile)) {
+                std::cerr << "Unable to save trace to: " << traceFile.toStdString() << std::endl;
+            }
+        });
+    }
+
+    if (parser.isSet(metricsOption)) {
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, []() {
+            std::cout << Metrics::dumpText().toStdString() << std::flush;
+        });
+    }
+
+    if (parser.isSet(showLogsOption)) {
+        const QStringList range = parser.value(showLogsOption).split(QLatin1Char(','));
+        const QDateTime from = QDateTime::fromString(range.value(0), Qt::ISODate);
+        const QDateTime to = range.size() > 1 ? QDateTime::fromString(range.value(1), Qt::ISODate) : QDateTime::currentDateTime();
+        if (!from.isValid() || !to.isValid()) {
+            std::cerr << "Invalid time range: " << parser.value(showLogsOption).toStdString() << std::endl;
+            return true;
+        }
+
+        const QString level = parser.value(logLevelOption);
+        const QList<LogArchiveEntry> entries = LogArchive::query(
+            LogArchive::defaultPath(), from.toMSecsSinceEpoch(), to.toMSecsSinceEpoch(),
+            level.isEmpty() ? 0 : level.at(0).toUpper().toLatin1());
+        for (const LogArchiveEntry &entry : entries) {
+            std::cout << QDateTime::fromMSecsSinceEpoch(entry.timestamp).toString(Qt::ISODateWithMs).toStdString()
+                      << " " << static_cast<char>(entry.source)
+                      << " " << (entry.level ? entry.level : '-')
+                      << " " << entry.text.toStdString()
+                      << std::endl;
+        }
+        return true;
+    }
+
     if (parser.isSet(listOption)) {
         bool hasDevices = false;
         const auto infos = QSerialPortInfo::availablePorts();
@@ -73,6 +173,15 @@ bool handleCommandLine(const QCoreApplication &app)
         connectPort = portValue;
     }
 
+    simulateSpec = parser.value(simulateOption);
+
+    const QString ptyTypeValue = parser.value(ptyTypeOption);
+    if (ptyTypeValue == QLatin1String("uvvis")) {
+        ptyDeviceType = DensInterface::DeviceUvVis;
+    } else if (!ptyTypeValue.isEmpty() && ptyTypeValue != QLatin1String("baseline")) {
+        std::cerr << "Unknown device type: " << ptyTypeValue.toStdString() << std::endl;
+    }
+
     if (parser.isSet(infoOption) && headlessCommand == HeadlessTask::CommandUnknown) {
         headlessCommand = HeadlessTask::CommandSystemInfo;
     }
@@ -85,6 +194,25 @@ bool handleCommandLine(const QCoreApplication &app)
     return false;
 }
 
+int runSimulator(QCoreApplication &app)
+{
+    DensSimulator *simulator = DensSimulator::fromPortName(QLatin1String("sim:") + simulateSpec, &app);
+    if (!simulator) {
+        std::cerr << "Invalid simulator: " << simulateSpec.toStdString() << std::endl;
+        return 1;
+    }
+
+    DensPtyHostTransport *transport = new DensPtyHostTransport(&app);
+    if (!transport->open()) {
+        std::cerr << "Unable to create pseudo-terminal: " << transport->errorString().toStdString() << std::endl;
+        return 1;
+    }
+    simulator->attach(transport);
+
+    std::cout << "Simulated device at " << transport->subordinatePath().toStdString() << std::endl;
+    return app.exec();
+}
+
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
@@ -108,9 +236,20 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    if (!simulateSpec.isEmpty()) {
+        return runSimulator(a);
+    }
+
+    if (LogArchive::start(LogArchive::defaultPath())) {
+        QObject::connect(&a, &QCoreApplication::aboutToQuit, &LogArchive::stop);
+    } else {
+        qWarning() << "Unable to open log archive at" << LogArchive::defaultPath();
+    }
+
     if (headlessCommand != HeadlessTask::CommandUnknown) {
         HeadlessTask *task = new HeadlessTask(&a);
         task->setPort(connectPort);
+        task->setPtyDeviceType(ptyDeviceType);
         task->setCommand(headlessCommand, headlessArg);
         QTimer::singleShot(0, task, &HeadlessTask::run);
         QObject::connect(task, &HeadlessTask::finished, &a, &QCoreApplication::quit);
@@ -120,7 +259,7 @@ int main(int argc, char *argv[])
         w.show();
 
         if (!connectPort.isEmpty()) {
-            w.connectToPort(connectPort);
+            w.connectToPort(connectPort, ptyDeviceType);
         }
         return a.exec();
     }
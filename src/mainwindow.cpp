@@ -17,6 +17,11 @@
 
 #include "connectdialog.h"
 #include "densinterface.h"
+#include "densserialtransport.h"
+#include "densloopbacktransport.h"
+#include "denssimulator.h"
+#include "densreplaytransport.h"
+#include "sessioncapture.h"
 #include "diagnosticstab.h"
 #include "calibrationbaselinetab.h"
 #include "calibrationuvvistab.h"
@@ -25,8 +30,10 @@
 #include "settingsexporter.h"
 #include "settingsimportdialog.h"
 #include "settingsuvvisimportdialog.h"
+#include "trace.h"
 #include "floatitemdelegate.h"
 #include "densistick/ft260.h"
+#include "densistick/ft260replay.h"
 #include "densistick/densistickinterface.h"
 #include "densistick/densistickrunner.h"
 #include "util.h"
@@ -40,7 +47,6 @@ MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , statusLabel_(new QLabel)
-    , serialPort_(new QSerialPort(this))
     , densInterface_(new DensInterface(this))
     , logWindow_(new LogWindow(this))
     , densPrecision_(2)
@@ -89,7 +95,9 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->actionImportSettings, &QAction::triggered, this, &MainWindow::onImportSettings);
     connect(ui->actionExportSettings, &QAction::triggered, this, &MainWindow::onExportSettings);
     connect(ui->actionLogger, &QAction::triggered, this, &MainWindow::onLogger);
+    connect(ui->actionTrace, &QAction::triggered, this, &MainWindow::onTrace);
     connect(ui->actionAbout, &QAction::triggered, this, &MainWindow::about);
+    ui->actionTrace->setChecked(Trace::isActive());
 
     // Log window UI signals
     connect(logWindow_, &LogWindow::opened, this, &MainWindow::onLoggerOpened);
@@ -184,9 +192,32 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
-void MainWindow::connectToPort(const QString &portName)
+void MainWindow::connectToPort(const QString &portName, DensInterface::DeviceType ptyDeviceType)
 {
-    if (!portName.isEmpty()) {
+    if (DensSimulator::isSimulatorPort(portName)) {
+        DensSimulator *simulator = DensSimulator::fromPortName(portName);
+        if (simulator) {
+            openConnectionToTransport(simulator->createLoopback(), simulator->deviceType());
+        }
+    } else if (SessionCapture::isReplayPort(portName)) {
+        bool fast = false;
+        SessionCapture capture;
+        if (!capture.load(SessionCapture::parseReplayPort(portName, &fast))) {
+            QMessageBox::critical(this, tr("Error"), capture.errorString());
+        } else if (capture.hasDensEvents()) {
+            DensReplayTransport *transport = new DensReplayTransport(capture);
+            transport->setFast(fast);
+            openConnectionToTransport(transport, transport->deviceType());
+        } else if (capture.hasFt260Events()) {
+            Ft260Replay::setCapture(portName);
+            const QList<Ft260DeviceInfo> infos = Ft260Replay::listDevices();
+            if (!infos.isEmpty()) {
+                openConnectionToFt260(infos.first());
+            }
+        }
+    } else if (DensPtyTransport::isPtyPath(portName)) {
+        openConnectionToTransport(new DensPtyTransport(portName), ptyDeviceType);
+    } else if (!portName.isEmpty()) {
         const auto serInfos = QSerialPortInfo::availablePorts();
         for (const QSerialPortInfo &info : serInfos) {
             if (info.portName() == portName) {
@@ -225,27 +256,27 @@ void MainWindow::onOpenConnectionDialogFinished(int result)
 
 void MainWindow::openConnectionToSerialPort(const QSerialPortInfo &info)
 {
-    qDebug() << "Connecting to:" << info.portName();
-    serialPort_->setPortName(info.portName());
-    serialPort_->setBaudRate(QSerialPort::Baud115200);
-    serialPort_->setDataBits(QSerialPort::Data8);
-    serialPort_->setParity(QSerialPort::NoParity);
-    serialPort_->setStopBits(QSerialPort::OneStop);
-    serialPort_->setFlowControl(QSerialPort::NoFlowControl);
-    if (serialPort_->open(QIODevice::ReadWrite)) {
-        serialPort_->setDataTerminalReady(true);
-        if (densInterface_->connectToDevice(serialPort_, DensInterface::portDeviceType(info))) {
+    openConnectionToTransport(new DensSerialTransport(info), DensInterface::portDeviceType(info));
+}
+
+void MainWindow::openConnectionToTransport(DensTransport *transport, DensInterface::DeviceType deviceType)
+{
+    qDebug() << "Connecting to:" << transport->description();
+    if (transport->open()) {
+        if (densInterface_->connectToDevice(transport, deviceType)) {
             ui->actionConnect->setEnabled(false);
             ui->actionDisconnect->setEnabled(true);
-            statusLabel_->setText(tr("Connected to %1").arg(info.portName()));
+            statusLabel_->setText(tr("Connected to %1").arg(transport->description()));
         } else {
-            serialPort_->close();
+            transport->close();
+            delete transport;
             statusLabel_->setText(tr("Unrecognized device"));
             QMessageBox::critical(this, tr("Error"), tr("Unrecognized device"));
         }
     } else {
         statusLabel_->setText(tr("Open error"));
-        QMessageBox::critical(this, tr("Error"), serialPort_->errorString());
+        QMessageBox::critical(this, tr("Error"), transport->errorString());
+        delete transport;
     }
 }
 
@@ -295,9 +326,6 @@ void MainWindow::closeConnection()
         stickRunner_ = nullptr;
     } else {
         densInterface_->disconnectFromDevice();
-        if (serialPort_->isOpen()) {
-            serialPort_->close();
-        }
     }
     refreshButtonState();
     ui->actionConnect->setEnabled(true);
@@ -401,6 +429,26 @@ void MainWindow::onLoggerClosed()
     }
 }
 
+void MainWindow::onTrace(bool checked)
+{
+    if (checked) {
+        Trace::start();
+        return;
+    }
+
+    Trace::stop();
+
+    QFileDialog fileDialog(this, tr("Save Trace"), QString(), tr("Trace File (*.json)"));
+    fileDialog.setDefaultSuffix(".json");
+    fileDialog.setAcceptMode(QFileDialog::AcceptSave);
+    if (fileDialog.exec() && !fileDialog.selectedFiles().isEmpty()) {
+        const QString filename = fileDialog.selectedFiles().constFirst();
+        if (!filename.isEmpty() && !Trace::save(filename)) {
+            QMessageBox::warning(this, tr("Save Trace"), tr("Unable to save trace to file."));
+        }
+    }
+}
+
 void MainWindow::onEditAdvCalibration(bool checked)
 {
     QSettings settings;
@@ -10,7 +10,6 @@
 QT_BEGIN_NAMESPACE
 
 class QLabel;
-class QSerialPort;
 class QLineEdit;
 class QSpinBox;
 class QStandardItemModel;
@@ -26,6 +25,7 @@ class LogWindow;
 class RemoteControlDialog;
 class DensiStickInterface;
 class DensiStickRunner;
+class DensTransport;
 
 class MainWindow : public QMainWindow
 {
@@ -35,7 +35,7 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
-    void connectToPort(const QString &portName);
+    void connectToPort(const QString &portName, DensInterface::DeviceType ptyDeviceType = DensInterface::DeviceBaseline);
 
 private slots:
     void openConnection();
@@ -46,6 +46,7 @@ private slots:
     void onLogger(bool checked);
     void onLoggerOpened();
     void onLoggerClosed();
+    void onTrace(bool checked);
     void onEditAdvCalibration(bool checked);
     void onChangeDensityPrecision();
     void about();
@@ -70,6 +71,7 @@ private slots:
 
 private:
     void openConnectionToSerialPort(const QSerialPortInfo &info);
+    void openConnectionToTransport(DensTransport *transport, DensInterface::DeviceType deviceType);
     void openConnectionToFt260(const Ft260DeviceInfo &info);
     void refreshButtonState();
     void updateAdvCalibrationEditable(bool editable);
@@ -83,7 +85,6 @@ private:
 
     Ui::MainWindow *ui = nullptr;
     QLabel *statusLabel_ = nullptr;
-    QSerialPort *serialPort_ = nullptr;
     DensInterface *densInterface_ = nullptr;
     DensiStickRunner *stickRunner_ = nullptr;
     DiagnosticsTab *diagnosticsTab_ = nullptr;
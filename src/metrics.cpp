@@ -0,0 +1,216 @@
+#include "metrics.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <map>
+#include <memory>
+
+namespace
+{
+struct Registry
+{
+    QMutex mutex;
+    std::map<QString, std::unique_ptr<MetricCounter>> counters;
+    std::map<QString, std::unique_ptr<MetricGauge>> gauges;
+    std::map<QString, std::unique_ptr<MetricHistogram>> histograms;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+template <typename T>
+T &findOrCreate(std::map<QString, std::unique_ptr<T>> &map, const QString &name)
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    std::unique_ptr<T> &entry = map[name];
+    if (!entry) {
+        entry = std::make_unique<T>();
+    }
+    return *entry;
+}
+}
+
+MetricHistogram::MetricHistogram()
+{
+    for (std::atomic<quint64> &bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricHistogram::record(quint64 value)
+{
+    buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+
+    quint64 current = max_.load(std::memory_order_relaxed);
+    while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+quint64 MetricHistogram::count() const
+{
+    return count_.load(std::memory_order_relaxed);
+}
+
+quint64 MetricHistogram::sum() const
+{
+    return sum_.load(std::memory_order_relaxed);
+}
+
+quint64 MetricHistogram::max() const
+{
+    return max_.load(std::memory_order_relaxed);
+}
+
+double MetricHistogram::mean() const
+{
+    const quint64 n = count();
+    return n > 0 ? static_cast<double>(sum()) / static_cast<double>(n) : 0.0;
+}
+
+quint64 MetricHistogram::percentile(double fraction) const
+{
+    const quint64 total = count();
+    if (total == 0) { return 0; }
+
+    const quint64 target = qMax<quint64>(1, static_cast<quint64>(fraction * static_cast<double>(total) + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return qMin(bucketUpperBound(i), max());
+        }
+    }
+    return max();
+}
+
+void MetricHistogram::reset()
+{
+    for (std::atomic<quint64> &bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+int MetricHistogram::bucketIndex(quint64 value)
+{
+    if (value < static_cast<quint64>(SubBuckets)) {
+        return static_cast<int>(value);
+    }
+
+    const int magnitude = 63 - qCountLeadingZeroBits(value);
+    if (magnitude >= MaxMagnitude) {
+        return BucketCount - 1;
+    }
+
+    const int sub = static_cast<int>((value >> (magnitude - SubBucketBits)) & (SubBuckets - 1));
+    return (magnitude - SubBucketBits + 1) * SubBuckets + sub;
+}
+
+quint64 MetricHistogram::bucketUpperBound(int index)
+{
+    if (index < SubBuckets) {
+        return static_cast<quint64>(index);
+    }
+
+    const int magnitude = index / SubBuckets + SubBucketBits - 1;
+    const quint64 sub = static_cast<quint64>(index % SubBuckets);
+    const int shift = magnitude - SubBucketBits;
+    return ((SubBuckets + sub + 1) << shift) - 1;
+}
+
+MetricCounter &Metrics::counter(const QString &name)
+{
+    return findOrCreate(registry().counters, name);
+}
+
+MetricGauge &Metrics::gauge(const QString &name)
+{
+    return findOrCreate(registry().gauges, name);
+}
+
+MetricHistogram &Metrics::histogram(const QString &name)
+{
+    return findOrCreate(registry().histograms, name);
+}
+
+QList<MetricSnapshot> Metrics::snapshot()
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+
+    QList<MetricSnapshot> result;
+    for (const auto &[name, counter] : reg.counters) {
+        MetricSnapshot snap;
+        snap.name = name;
+        snap.type = MetricSnapshot::TypeCounter;
+        snap.value = static_cast<qint64>(counter->value());
+        result.append(snap);
+    }
+    for (const auto &[name, gauge] : reg.gauges) {
+        MetricSnapshot snap;
+        snap.name = name;
+        snap.type = MetricSnapshot::TypeGauge;
+        snap.value = gauge->value();
+        result.append(snap);
+    }
+    for (const auto &[name, histogram] : reg.histograms) {
+        MetricSnapshot snap;
+        snap.name = name;
+        snap.type = MetricSnapshot::TypeHistogram;
+        snap.value = static_cast<qint64>(histogram->count());
+        snap.sum = histogram->sum();
+        snap.max = histogram->max();
+        snap.mean = histogram->mean();
+        snap.p50 = histogram->percentile(0.50);
+        snap.p90 = histogram->percentile(0.90);
+        snap.p99 = histogram->percentile(0.99);
+        result.append(snap);
+    }
+
+    std::sort(result.begin(), result.end(), [](const MetricSnapshot &a, const MetricSnapshot &b) {
+        return a.name < b.name;
+    });
+    return result;
+}
+
+QString Metrics::dumpText()
+{
+    QString result;
+    QTextStream out(&result);
+    const QList<MetricSnapshot> metrics = snapshot();
+    for (const MetricSnapshot &metric : metrics) {
+        out << metric.name << " ";
+        if (metric.type == MetricSnapshot::TypeHistogram) {
+            out << "count=" << metric.value
+                << " mean=" << QString::number(metric.mean, 'f', 1) << "us"
+                << " p50=" << metric.p50 << "us"
+                << " p90=" << metric.p90 << "us"
+                << " p99=" << metric.p99 << "us"
+                << " max=" << metric.max << "us";
+        } else {
+            out << metric.value;
+        }
+        out << "\n";
+    }
+    return result;
+}
+
+void Metrics::reset()
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (const auto &entry : reg.counters) { entry.second->reset(); }
+    for (const auto &entry : reg.gauges) { entry.second->reset(); }
+    for (const auto &entry : reg.histograms) { entry.second->reset(); }
+}
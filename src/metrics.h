@@ -0,0 +1,124 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QList>
+#include <QString>
+#include <array>
+#include <atomic>
+
+/**
+ * Monotonically increasing count of events.
+ */
+class MetricCounter
+{
+public:
+    void add(quint64 n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    quint64 value() const { return value_.load(std::memory_order_relaxed); }
+    void reset() { value_.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> value_ = 0;
+};
+
+/**
+ * Value that can go up and down, such as a queue depth.
+ */
+class MetricGauge
+{
+public:
+    void set(qint64 value) { value_.store(value, std::memory_order_relaxed); }
+    void add(qint64 n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    qint64 value() const { return value_.load(std::memory_order_relaxed); }
+    void reset() { value_.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<qint64> value_ = 0;
+};
+
+/**
+ * Distribution of durations, in microseconds.
+ *
+ * Values are counted in buckets that are linear within each power of two
+ * and logarithmic across them, in the style of an HDR histogram. That keeps
+ * every recorded value within about 6% of its true size across the whole
+ * range, while recording stays a handful of relaxed atomic operations.
+ */
+class MetricHistogram
+{
+public:
+    static constexpr int SubBucketBits = 4;
+    static constexpr int SubBuckets = 1 << SubBucketBits;
+    static constexpr int MaxMagnitude = 48;
+    static constexpr int BucketCount = (MaxMagnitude - SubBucketBits + 1) * SubBuckets;
+
+    MetricHistogram();
+
+    void record(quint64 value);
+
+    quint64 count() const;
+    quint64 sum() const;
+    quint64 max() const;
+    double mean() const;
+
+    /** Smallest recorded value that at least the given fraction of values are at or below */
+    quint64 percentile(double fraction) const;
+
+    void reset();
+
+    static int bucketIndex(quint64 value);
+    static quint64 bucketUpperBound(int index);
+
+private:
+    std::array<std::atomic<quint64>, BucketCount> buckets_;
+    std::atomic<quint64> count_ = 0;
+    std::atomic<quint64> sum_ = 0;
+    std::atomic<quint64> max_ = 0;
+};
+
+/**
+ * Point in time copy of a single metric.
+ */
+struct MetricSnapshot
+{
+    enum Type {
+        TypeCounter,
+        TypeGauge,
+        TypeHistogram
+    };
+
+    QString name;
+    Type type = TypeCounter;
+    qint64 value = 0;   /*!< Counter or gauge value, or the histogram count */
+    quint64 sum = 0;
+    quint64 max = 0;
+    double mean = 0;
+    quint64 p50 = 0;
+    quint64 p90 = 0;
+    quint64 p99 = 0;
+};
+
+/**
+ * Process-wide registry of runtime metrics.
+ *
+ * Metrics are created on first use and live for the rest of the process,
+ * so the returned references can be kept in a function-local static at
+ * the point of instrumentation. Updating a metric never takes a lock.
+ */
+class Metrics
+{
+public:
+    static MetricCounter &counter(const QString &name);
+    static MetricGauge &gauge(const QString &name);
+    static MetricHistogram &histogram(const QString &name);
+
+    /** Copy of every metric, sorted by name */
+    static QList<MetricSnapshot> snapshot();
+
+    /** Human readable dump of every metric, one per line */
+    static QString dumpText();
+
+    /** Reset every metric back to zero */
+    static void reset();
+};
+
+#endif // METRICS_H
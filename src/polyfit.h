@@ -0,0 +1,206 @@
+#ifndef POLYFIT_H
+#define POLYFIT_H
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+/**
+ * Weighted least-squares polynomial fit of a fixed degree.
+ *
+ * Points are accumulated straight into the power sums that make up the
+ * normal equations, so adding or removing a point costs O(Degree) no
+ * matter how many points came before it, and the fit can be solved at
+ * any time without going back over the data.
+ *
+ * The sums are taken around the first point added, and are moved to the
+ * mean of x before solving, so inputs that sit far from zero (such as
+ * temperatures) do not lose their precision to the size of x itself.
+ */
+template <int Degree>
+class PolyFit
+{
+    static_assert(Degree >= 0, "Degree must not be negative");
+
+public:
+    static constexpr int Terms = Degree + 1;
+
+    typedef std::array<double, Terms> Coefficients;
+
+    PolyFit() { clear(); }
+
+    void clear()
+    {
+        sums_.fill(0.0);
+        rhs_.fill(0.0);
+        origin_ = 0.0;
+        count_ = 0;
+    }
+
+    void addPoint(double x, double y, double weight = 1.0)
+    {
+        // Start over from the first point, which also throws away any
+        // rounding left behind by points that have since been removed
+        if (count_ == 0) {
+            clear();
+            origin_ = x;
+        }
+        accumulate(x - origin_, y, weight);
+        count_++;
+    }
+
+    /** Take back a point previously added with the same values */
+    void removePoint(double x, double y, double weight = 1.0)
+    {
+        accumulate(x - origin_, y, -weight);
+        count_--;
+    }
+
+    int count() const { return count_; }
+
+    /**
+     * Solve for the coefficients, lowest order first. Returns false,
+     * leaving the output untouched, if there are too few points or
+     * they do not determine a unique fit.
+     */
+    bool solve(Coefficients &coefficients) const
+    {
+        if (count_ < Terms || !(sums_[0] > 0.0)) { return false; }
+
+        // Centre the sums on the mean of x
+        const double mean = sums_[1] / sums_[0];
+        const std::array<double, 2 * Degree + 1> sums = shifted(sums_, mean);
+        const Coefficients rhs = shifted(rhs_, mean);
+
+        // Normal equations, augmented with the right-hand side
+        double a[Terms][Terms + 1];
+        for (int i = 0; i < Terms; i++) {
+            for (int j = 0; j < Terms; j++) {
+                a[i][j] = sums[i + j];
+            }
+            a[i][Terms] = rhs[i];
+        }
+
+        // Scale the system so its diagonal is all ones. The power sums
+        // grow with x^(2*Degree), and without this the pivots for the
+        // higher terms swamp the lower ones when x is far from one.
+        double scale[Terms];
+        for (int i = 0; i < Terms; i++) {
+            if (!(a[i][i] > 0.0)) { return false; }
+            scale[i] = 1.0 / std::sqrt(a[i][i]);
+        }
+        for (int i = 0; i < Terms; i++) {
+            for (int j = 0; j < Terms; j++) {
+                a[i][j] *= scale[i] * scale[j];
+            }
+            a[i][Terms] *= scale[i];
+        }
+
+        // Gaussian elimination with partial pivoting
+        for (int i = 0; i < Terms; i++) {
+            int pivot = i;
+            for (int k = i + 1; k < Terms; k++) {
+                if (std::abs(a[k][i]) > std::abs(a[pivot][i])) { pivot = k; }
+            }
+            if (std::abs(a[pivot][i]) < PIVOT_EPSILON) { return false; }
+            if (pivot != i) {
+                for (int j = i; j <= Terms; j++) {
+                    std::swap(a[i][j], a[pivot][j]);
+                }
+            }
+
+            for (int k = i + 1; k < Terms; k++) {
+                const double term = a[k][i] / a[i][i];
+                for (int j = i; j <= Terms; j++) {
+                    a[k][j] -= term * a[i][j];
+                }
+            }
+        }
+
+        // Back-substitution, undoing the scaling on the way out
+        Coefficients result;
+        for (int i = Terms - 1; i >= 0; i--) {
+            double value = a[i][Terms];
+            for (int j = i + 1; j < Terms; j++) {
+                value -= a[i][j] * result[j];
+            }
+            result[i] = value / a[i][i];
+        }
+        for (int i = 0; i < Terms; i++) {
+            result[i] *= scale[i];
+        }
+
+        coefficients = expanded(result, origin_ + mean);
+        return true;
+    }
+
+    /** Solved coefficients, or all NaN if there is no unique fit */
+    Coefficients coefficients() const
+    {
+        Coefficients result;
+        if (!solve(result)) {
+            result.fill(std::numeric_limits<double>::quiet_NaN());
+        }
+        return result;
+    }
+
+private:
+    /* Smallest pivot accepted once the system has been scaled */
+    static constexpr double PIVOT_EPSILON = 1e-12;
+
+    /** Turn sums of w * x^k (times y) into sums of w * (x - offset)^k */
+    template <std::size_t N>
+    static std::array<double, N> shifted(const std::array<double, N> &sums, double offset)
+    {
+        std::array<double, N> result;
+        for (int k = 0; k < static_cast<int>(N); k++) {
+            // C(k, j) * (-offset)^(k - j), starting from j = k
+            double factor = 1.0;
+            double value = 0.0;
+            for (int j = k; j >= 0; j--) {
+                value += factor * sums[j];
+                factor *= -offset * j / (k - j + 1);
+            }
+            result[k] = value;
+        }
+        return result;
+    }
+
+    /** Coefficients of a polynomial in (x - offset), as plain powers of x */
+    static Coefficients expanded(const Coefficients &coefficients, double offset)
+    {
+        Coefficients result;
+        result.fill(0.0);
+        for (int i = 0; i < Terms; i++) {
+            // C(i, j) * (-offset)^(i - j), starting from j = i
+            double factor = 1.0;
+            for (int j = i; j >= 0; j--) {
+                result[j] += factor * coefficients[i];
+                factor *= -offset * j / (i - j + 1);
+            }
+        }
+        return result;
+    }
+
+    void accumulate(double x, double y, double weight)
+    {
+        double power = weight;
+        for (int k = 0; k < Terms; k++) {
+            sums_[k] += power;
+            rhs_[k] += power * y;
+            power *= x;
+        }
+        for (int k = Terms; k <= 2 * Degree; k++) {
+            sums_[k] += power;
+            power *= x;
+        }
+    }
+
+    std::array<double, 2 * Degree + 1> sums_; /*!< Sum of w * x^k */
+    std::array<double, Terms> rhs_;           /*!< Sum of w * x^k * y */
+    double origin_;                           /*!< x that the sums are taken around */
+    int count_;
+};
+
+#endif // POLYFIT_H
@@ -0,0 +1,55 @@
+#ifndef PROCESSRECORDER_H
+#define PROCESSRECORDER_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <atomic>
+
+/**
+ * Base for the static, process-wide recorders, such as SessionRecorder
+ * and LogArchive, whose hooks may be called from any thread.
+ *
+ * Hooks check isActive() before anything else, which only loads a flag,
+ * so call sites can be left in place whether or not anything is being
+ * recorded. The recorder's own state is created on first use, and is
+ * only reached through a Locked handle that holds its mutex.
+ */
+template <typename Owner>
+class ProcessRecorder
+{
+public:
+    static bool isActive() { return active_.load(std::memory_order_relaxed); }
+
+protected:
+    static void setActive(bool active) { active_.store(active, std::memory_order_relaxed); }
+
+    template <typename State>
+    class Locked
+    {
+    public:
+        Locked() : locker_(&instance().mutex) {}
+
+        State &operator*() const { return instance().state; }
+        State *operator->() const { return &instance().state; }
+
+    private:
+        struct Instance
+        {
+            QMutex mutex;
+            State state;
+        };
+
+        static Instance &instance()
+        {
+            static Instance instance;
+            return instance;
+        }
+
+        QMutexLocker<QMutex> locker_;
+    };
+
+private:
+    static inline std::atomic<bool> active_ = false;
+};
+
+#endif // PROCESSRECORDER_H
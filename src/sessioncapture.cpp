@@ -0,0 +1,307 @@
+#include "sessioncapture.h"
+
+#include <QFile>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <QDebug>
+#include <memory>
+
+namespace
+{
+/*
+ * File layout:
+ *   "DENSCAP" magic, followed by a format version byte
+ *   Capture start time, as 64-bit little-endian milliseconds since epoch
+ *   Events, each one as:
+ *     Type byte
+ *     Microseconds since the previous event, as a varint
+ *     Payload length, as a varint
+ *     Payload bytes
+ */
+static const char CAPTURE_MAGIC[] = "DENSCAP";
+static const qsizetype CAPTURE_MAGIC_SIZE = 7;
+static const quint8 CAPTURE_VERSION = 1;
+static const qsizetype CAPTURE_HEADER_SIZE = CAPTURE_MAGIC_SIZE + 1 + 8;
+
+/* Buffered events are written out once this much has accumulated */
+static const qsizetype FLUSH_THRESHOLD = 64 * 1024;
+
+struct RecorderState
+{
+    std::unique_ptr<QFile> file;
+    QElapsedTimer clock;
+    qint64 lastUs = 0;
+    QByteArray buffer;
+};
+
+void flushRecorder(RecorderState &state)
+{
+    if (state.file && !state.buffer.isEmpty()) {
+        if (state.file->write(state.buffer) != state.buffer.size()) {
+            qWarning() << "Capture write error:" << state.file->errorString();
+        }
+        state.buffer.clear();
+    }
+}
+
+bool readVarint(const QByteArray &data, qsizetype *pos, quint64 *value)
+{
+    quint64 result = 0;
+    int shift = 0;
+    while (*pos < data.size() && shift < 64) {
+        const quint8 byte = static_cast<quint8>(data.at((*pos)++));
+        result |= static_cast<quint64>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+        shift += 7;
+    }
+    return false;
+}
+}
+
+bool SessionEvent::isDensEvent() const
+{
+    return type == TypeDensConnect || type == TypeDensRead || type == TypeDensWrite;
+}
+
+bool SessionEvent::isFt260Event() const
+{
+    return type == TypeFt260Call || type == TypeFt260SensorInterrupt || type == TypeFt260ButtonInterrupt;
+}
+
+void SessionEvent::appendVarint(QByteArray &buf, quint64 value)
+{
+    while (value >= 0x80) {
+        buf.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buf.append(static_cast<char>(value));
+}
+
+SessionPayloadReader::SessionPayloadReader(const QByteArray &payload) : payload_(payload)
+{
+}
+
+quint8 SessionPayloadReader::readByte()
+{
+    if (pos_ >= payload_.size()) {
+        ok_ = false;
+        return 0;
+    }
+    return static_cast<quint8>(payload_.at(pos_++));
+}
+
+quint16 SessionPayloadReader::readUint16()
+{
+    const quint16 lo = readByte();
+    const quint16 hi = readByte();
+    return lo | (hi << 8);
+}
+
+quint64 SessionPayloadReader::readVarint()
+{
+    quint64 value = 0;
+    if (!::readVarint(payload_, &pos_, &value)) {
+        ok_ = false;
+        return 0;
+    }
+    return value;
+}
+
+QByteArray SessionPayloadReader::readBytes(qsizetype len)
+{
+    if (len < 0 || pos_ + len > payload_.size()) {
+        ok_ = false;
+        pos_ = payload_.size();
+        return QByteArray();
+    }
+    const QByteArray data = payload_.mid(pos_, len);
+    pos_ += len;
+    return data;
+}
+
+bool SessionPayloadReader::atEnd() const
+{
+    return pos_ >= payload_.size();
+}
+
+bool SessionPayloadReader::ok() const
+{
+    return ok_;
+}
+
+bool SessionRecorder::start(const QString &fileName)
+{
+    Locked<RecorderState> state;
+
+    if (state->file) {
+        qWarning() << "Capture already in progress";
+        return false;
+    }
+
+    auto file = std::make_unique<QFile>(fileName);
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Unable to open capture file:" << file->errorString();
+        return false;
+    }
+
+    QByteArray header(CAPTURE_MAGIC, CAPTURE_MAGIC_SIZE);
+    header.append(static_cast<char>(CAPTURE_VERSION));
+    char startTime[8];
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), startTime);
+    header.append(startTime, sizeof(startTime));
+
+    state->file = std::move(file);
+    state->buffer = header;
+    state->clock.start();
+    state->lastUs = 0;
+    setActive(true);
+
+    qDebug() << "Recording session to" << fileName;
+    return true;
+}
+
+void SessionRecorder::stop()
+{
+    Locked<RecorderState> state;
+
+    setActive(false);
+    if (state->file) {
+        flushRecorder(*state);
+        state->file->close();
+        state->file.reset();
+        qDebug() << "Session recording stopped";
+    }
+}
+
+void SessionRecorder::record(SessionEvent::Type type, const QByteArray &payload)
+{
+    if (!isActive()) { return; }
+
+    Locked<RecorderState> state;
+    if (!state->file) { return; }
+
+    // Events from different threads may race for the lock, so never
+    // let the timestamps run backwards
+    const qint64 nowUs = qMax(state->lastUs, state->clock.nsecsElapsed() / 1000);
+
+    state->buffer.append(static_cast<char>(type));
+    SessionEvent::appendVarint(state->buffer, static_cast<quint64>(nowUs - state->lastUs));
+    SessionEvent::appendVarint(state->buffer, static_cast<quint64>(payload.size()));
+    state->buffer.append(payload);
+    state->lastUs = nowUs;
+
+    if (state->buffer.size() >= FLUSH_THRESHOLD) {
+        flushRecorder(*state);
+    }
+}
+
+SessionCapture::SessionCapture()
+{
+}
+
+bool SessionCapture::load(const QString &fileName)
+{
+    fileName_ = fileName;
+    events_.clear();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        errorString_ = file.errorString();
+        return false;
+    }
+    const QByteArray data = file.readAll();
+
+    if (data.size() < CAPTURE_HEADER_SIZE || !data.startsWith(QByteArray(CAPTURE_MAGIC, CAPTURE_MAGIC_SIZE))) {
+        errorString_ = QLatin1String("Not a capture file");
+        return false;
+    }
+    if (static_cast<quint8>(data.at(CAPTURE_MAGIC_SIZE)) != CAPTURE_VERSION) {
+        errorString_ = QLatin1String("Unsupported capture version");
+        return false;
+    }
+    startTime_ = QDateTime::fromMSecsSinceEpoch(qFromLittleEndian<qint64>(data.constData() + CAPTURE_MAGIC_SIZE + 1));
+
+    qsizetype pos = CAPTURE_HEADER_SIZE;
+    qint64 timeUs = 0;
+    while (pos < data.size()) {
+        SessionEvent event;
+        event.type = static_cast<SessionEvent::Type>(static_cast<quint8>(data.at(pos++)));
+
+        quint64 delta = 0;
+        quint64 len = 0;
+        if (!readVarint(data, &pos, &delta) || !readVarint(data, &pos, &len)
+            || len > static_cast<quint64>(data.size() - pos)) {
+            // A capture cut short by a crash is still useful up to that point
+            qWarning() << "Capture truncated after" << events_.size() << "events";
+            break;
+        }
+
+        timeUs += static_cast<qint64>(delta);
+        event.timeUs = timeUs;
+        event.payload = data.mid(pos, static_cast<qsizetype>(len));
+        pos += static_cast<qsizetype>(len);
+        events_.append(event);
+    }
+
+    errorString_.clear();
+    return true;
+}
+
+QString SessionCapture::errorString() const
+{
+    return errorString_;
+}
+
+QString SessionCapture::fileName() const
+{
+    return fileName_;
+}
+
+QDateTime SessionCapture::startTime() const
+{
+    return startTime_;
+}
+
+QList<SessionEvent> SessionCapture::events() const
+{
+    return events_;
+}
+
+bool SessionCapture::hasDensEvents() const
+{
+    for (const SessionEvent &event : events_) {
+        if (event.isDensEvent()) { return true; }
+    }
+    return false;
+}
+
+bool SessionCapture::hasFt260Events() const
+{
+    for (const SessionEvent &event : events_) {
+        if (event.isFt260Event()) { return true; }
+    }
+    return false;
+}
+
+bool SessionCapture::isReplayPort(const QString &portName)
+{
+    return portName.startsWith(QLatin1String("replay:"));
+}
+
+QString SessionCapture::parseReplayPort(const QString &portName, bool *fast)
+{
+    QString fileName = portName.mid(7);
+    bool isFast = false;
+
+    const qsizetype query = fileName.lastIndexOf(QLatin1Char('?'));
+    if (query >= 0) {
+        isFast = fileName.mid(query + 1) == QLatin1String("speed=max");
+        fileName.truncate(query);
+    }
+
+    if (fast) { *fast = isFast; }
+    return fileName;
+}
@@ -0,0 +1,110 @@
+#ifndef SESSIONCAPTURE_H
+#define SESSIONCAPTURE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+#include "processrecorder.h"
+
+/**
+ * Single timestamped entry in a session capture.
+ */
+struct SessionEvent
+{
+    enum Type : quint8 {
+        TypeInvalid = 0,
+        TypeDensConnect = 1,      /*!< Densitometer connection opened, payload is the device type */
+        TypeDensRead = 2,         /*!< Line received from the densitometer */
+        TypeDensWrite = 3,        /*!< Bytes sent to the densitometer */
+        TypeFt260Call = 16,       /*!< Completed call into the FT260 driver */
+        TypeFt260SensorInterrupt = 17,
+        TypeFt260ButtonInterrupt = 18 /*!< Payload is the button state */
+    };
+
+    Type type = TypeInvalid;
+    qint64 timeUs = 0;  /*!< Time since the start of the capture */
+    QByteArray payload;
+
+    bool isDensEvent() const;
+    bool isFt260Event() const;
+
+    static void appendVarint(QByteArray &buf, quint64 value);
+};
+
+/**
+ * Sequential reader for the fields within an event payload.
+ *
+ * Reading past the end of the payload yields zeros and clears the
+ * ok() flag, so a whole record can be parsed before checking it once.
+ */
+class SessionPayloadReader
+{
+public:
+    explicit SessionPayloadReader(const QByteArray &payload);
+
+    quint8 readByte();
+    quint16 readUint16();
+    quint64 readVarint();
+    QByteArray readBytes(qsizetype len);
+
+    bool atEnd() const;
+    bool ok() const;
+
+private:
+    const QByteArray &payload_;
+    qsizetype pos_ = 0;
+    bool ok_ = true;
+};
+
+/**
+ * Process-wide recorder that writes device traffic to a capture file.
+ *
+ * Events may be recorded from any thread, and are written out in the
+ * order they were recorded.
+ */
+class SessionRecorder : public ProcessRecorder<SessionRecorder>
+{
+public:
+    static bool start(const QString &fileName);
+    static void stop();
+
+    static void record(SessionEvent::Type type, const QByteArray &payload = QByteArray());
+};
+
+/**
+ * Contents of a capture file, loaded into memory for replay.
+ */
+class SessionCapture
+{
+public:
+    SessionCapture();
+
+    bool load(const QString &fileName);
+    QString errorString() const;
+
+    QString fileName() const;
+    QDateTime startTime() const;
+    QList<SessionEvent> events() const;
+
+    bool hasDensEvents() const;
+    bool hasFt260Events() const;
+
+    /** Check whether a port name given by the user refers to a capture file */
+    static bool isReplayPort(const QString &portName);
+
+    /**
+     * Split a port name of the form replay:<file>[?speed=max] into the
+     * capture file name and whether to replay as fast as possible.
+     */
+    static QString parseReplayPort(const QString &portName, bool *fast);
+
+private:
+    QString fileName_;
+    QString errorString_;
+    QDateTime startTime_;
+    QList<SessionEvent> events_;
+};
+
+#endif // SESSIONCAPTURE_H
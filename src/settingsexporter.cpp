@@ -3,50 +3,29 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QFile>
-#include <QTimer>
 #include <QDebug>
 
 SettingsExporter::SettingsExporter(DensInterface *densInterface, QObject *parent)
     : QObject{parent},
       densInterface_(densInterface)
 {
-    timer_ = new QTimer(this);
-    timer_->setSingleShot(true);
-    connect(timer_, &QTimer::timeout, this, QOverload<>::of(&SettingsExporter::onPrepareTimeout));
-
-    connect(densInterface_, &DensInterface::connectionClosed, this, &SettingsExporter::onConnectionClosed);
-    connect(densInterface_, &DensInterface::systemVersionResponse, this, &SettingsExporter::onSystemVersionResponse);
-    connect(densInterface_, &DensInterface::systemBuildResponse, this, &SettingsExporter::onSystemBuildResponse);
-    connect(densInterface_, &DensInterface::systemUniqueId, this, &SettingsExporter::onSystemUniqueId);
-
-    connect(densInterface_, &DensInterface::calGainResponse, this, &SettingsExporter::onCalGainResponse);
-    connect(densInterface_, &DensInterface::calSlopeResponse, this, &SettingsExporter::onCalSlopeResponse);
-    connect(densInterface_, &DensInterface::calReflectionResponse, this, &SettingsExporter::onCalReflectionResponse);
-    connect(densInterface_, &DensInterface::calTransmissionResponse, this, &SettingsExporter::onCalTransmissionResponse);
-    connect(densInterface_, &DensInterface::calUvTransmissionResponse, this, &SettingsExporter::onCalUvTransmissionResponse);
-    connect(densInterface_, &DensInterface::calVisTemperatureResponse, this, &SettingsExporter::onCalVisTemperatureResponse);
-    connect(densInterface_, &DensInterface::calUvTemperatureResponse, this, &SettingsExporter::onCalUvTemperatureResponse);
 }
 
 void SettingsExporter::prepareExport()
 {
     qDebug() << "Getting all settings for export";
-    densInterface_->sendGetSystemVersion();
-    densInterface_->sendGetSystemBuild();
-    densInterface_->sendGetSystemUID();
-    densInterface_->sendGetCalGain();
-    densInterface_->sendGetCalReflection();
-    densInterface_->sendGetCalTransmission();
+    pendingResponses_ = 0;
+    hasAllData_ = false;
+    prepareFailed_ = false;
 
-    if (densInterface_->deviceType() == DensInterface::DeviceBaseline) {
-        densInterface_->sendGetCalSlope();
-    } else if (densInterface_->deviceType() == DensInterface::DeviceUvVis) {
-        densInterface_->sendGetCalUvTransmission();
-        densInterface_->sendGetCalVisTemperature();
-        densInterface_->sendGetCalUvTemperature();
-    }
+    addPendingResponse(densInterface_->sendGetSystemVersion());
+    addPendingResponse(densInterface_->sendGetSystemBuild());
+    addPendingResponse(densInterface_->sendGetSystemUID());
 
-    timer_->start(5000);
+    pendingResponses_++;
+    densInterface_->sendGetCalSnapshot(this, [this](DensInterface::CommandResult result, const DensCommand &) {
+        onResponse(result);
+    });
 }
 
 bool SettingsExporter::saveExport(const QString &filename)
@@ -141,103 +120,35 @@ bool SettingsExporter::saveExport(const QString &filename)
     return true;
 }
 
-void SettingsExporter::onPrepareTimeout()
+void SettingsExporter::addPendingResponse(quint32 ticket)
 {
-    if (!hasAllData_) {
-        timer_->stop();
-        prepareFailed_ = true;
-        emit exportFailed();
-    }
-}
+    if (prepareFailed_) { return; }
 
-void SettingsExporter::onConnectionClosed()
-{
-    if (!hasAllData_) {
-        timer_->stop();
-        prepareFailed_ = true;
-        emit exportFailed();
-    }
-}
+    const bool added = densInterface_->addResponseHandler(ticket, this,
+        [this](DensInterface::CommandResult result, const DensCommand &) {
+        onResponse(result);
+    });
 
-void SettingsExporter::onSystemVersionResponse()
-{
-    hasSystemVersion_ = true;
-    checkResponses();
-}
-
-void SettingsExporter::onSystemBuildResponse()
-{
-    hasSystemBuild_ = true;
-    checkResponses();
-}
-
-void SettingsExporter::onSystemUniqueId()
-{
-    hasSystemUid_ = true;
-    checkResponses();
-}
-
-void SettingsExporter::onCalGainResponse()
-{
-    hasCalGain_ = true;
-    checkResponses();
-}
-
-void SettingsExporter::onCalSlopeResponse()
-{
-    hasCalSlope_ = true;
-    checkResponses();
-}
-
-void SettingsExporter::onCalReflectionResponse()
-{
-    hasCalReflection_ = true;
-    checkResponses();
-}
-
-void SettingsExporter::onCalTransmissionResponse()
-{
-    hasCalTransmission_ = true;
-    checkResponses();
-}
-
-void SettingsExporter::onCalUvTransmissionResponse()
-{
-    hasCalUvTransmission_ = true;
-    checkResponses();
-}
-
-void SettingsExporter::onCalVisTemperatureResponse()
-{
-    hasCalVisTemperature_ = true;
-    checkResponses();
+    if (added) {
+        pendingResponses_++;
+    } else {
+        onResponse(DensInterface::ResultError);
+    }
 }
 
-void SettingsExporter::onCalUvTemperatureResponse()
+void SettingsExporter::onResponse(DensInterface::CommandResult result)
 {
-    hasCalUvTemperature_ = true;
-    checkResponses();
-}
+    if (prepareFailed_ || hasAllData_) { return; }
 
-void SettingsExporter::checkResponses()
-{
-    if (!hasSystemVersion_ || !hasSystemBuild_ || !hasSystemUid_
-        || !hasCalGain_
-        || !hasCalReflection_ || !hasCalTransmission_) {
+    if (result != DensInterface::ResultOk) {
+        prepareFailed_ = true;
+        emit exportFailed();
         return;
     }
 
-    if (densInterface_->deviceType() == DensInterface::DeviceBaseline) {
-        if (!hasCalSlope_) {
-            return;
-        }
-    } else if (densInterface_->deviceType() == DensInterface::DeviceUvVis) {
-        if (!hasCalUvTransmission_ || !hasCalVisTemperature_ || !hasCalUvTemperature_) {
-            return;
-        }
+    pendingResponses_--;
+    if (pendingResponses_ == 0) {
+        hasAllData_ = true;
+        emit exportReady();
     }
-
-    hasAllData_ = true;
-    timer_->stop();
-    emit exportReady();
 }
@@ -6,8 +6,6 @@
 
 #include "densinterface.h"
 
-class QTimer;
-
 class SettingsExporter : public QObject
 {
     Q_OBJECT
@@ -21,36 +19,13 @@ signals:
     void exportReady();
     void exportFailed();
 
-private slots:
-    void onPrepareTimeout();
-    void onConnectionClosed();
-    void onSystemVersionResponse();
-    void onSystemBuildResponse();
-    void onSystemUniqueId();
-    void onCalGainResponse();
-    void onCalSlopeResponse();
-    void onCalReflectionResponse();
-    void onCalTransmissionResponse();
-    void onCalUvTransmissionResponse();
-    void onCalVisTemperatureResponse();
-    void onCalUvTemperatureResponse();
-
 private:
     QJsonObject createJsonCalTarget(const DensCalTarget &calTarget);
-    void checkResponses();
+    void addPendingResponse(quint32 ticket);
+    void onResponse(DensInterface::CommandResult result);
 
     DensInterface *densInterface_;
-    QTimer *timer_ = nullptr;
-    bool hasSystemVersion_ = false;
-    bool hasSystemBuild_ = false;
-    bool hasSystemUid_ = false;
-    bool hasCalGain_ = false;
-    bool hasCalSlope_ = false;
-    bool hasCalReflection_ = false;
-    bool hasCalTransmission_ = false;
-    bool hasCalUvTransmission_ = false;
-    bool hasCalVisTemperature_ = false;
-    bool hasCalUvTemperature_ = false;
+    int pendingResponses_ = 0;
     bool hasAllData_ = false;
     bool prepareFailed_ = false;
 };
@@ -232,6 +232,8 @@ void SettingsImportDialog::sendSelectedSettings(DensInterface *densInterface)
 {
     if (!densInterface) { return; }
 
+    densInterface->beginCalSnapshot();
+
     if (ui->importGainCheckBox->isChecked()) {
         densInterface->sendSetCalGain(calGain_);
     }
@@ -244,4 +246,6 @@ void SettingsImportDialog::sendSelectedSettings(DensInterface *densInterface)
     if (ui->importTranCheckBox->isChecked()) {
         densInterface->sendSetCalTransmission(calTransmission_);
     }
+
+    densInterface->commitCalSnapshot();
 }
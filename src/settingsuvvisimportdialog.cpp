@@ -270,6 +270,8 @@ void SettingsUvVisImportDialog::sendSelectedSettings(DensInterface *densInterfac
 {
     if (!densInterface) { return; }
 
+    densInterface->beginCalSnapshot();
+
     if (ui->importGainCheckBox->isChecked()) {
         densInterface->sendSetUvVisCalGain(calGain_);
     }
@@ -286,4 +288,6 @@ void SettingsUvVisImportDialog::sendSelectedSettings(DensInterface *densInterfac
     if (ui->importUvTranCheckBox->isChecked()) {
         densInterface->sendSetCalUvTransmission(calUvTransmission_);
     }
+
+    densInterface->commitCalSnapshot();
 }
@@ -10,7 +10,9 @@
 #include <QDebug>
 #include <cmath>
 #include "floatitemdelegate.h"
+#include "polyfit.h"
 #include "util.h"
+#include "trace.h"
 
 SlopeCalibrationDialog::SlopeCalibrationDialog(QWidget *parent) :
     QDialog(parent),
@@ -75,6 +77,13 @@ SlopeCalibrationDialog::SlopeCalibrationDialog(QWidget *parent) :
 
     connect(ui->wedgePrecSpinBox, &QSpinBox::valueChanged, this, &SlopeCalibrationDialog::wedgePrecValueChanged);
     connect(ui->wedgeCountSpinBox, &QSpinBox::valueChanged, this, &SlopeCalibrationDialog::wedgeCountValueChanged);
+
+    // Keep the fit in step with the table as it is edited
+    connect(model_, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &topLeft) { updateFit(topLeft.row()); });
+    connect(model_, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex &, int first) { updateFit(first); });
+    connect(model_, &QAbstractItemModel::rowsRemoved, this, [this](const QModelIndex &, int first) { updateFit(first); });
+    connect(model_, &QAbstractItemModel::modelReset, this, [this]() { updateFit(0); });
+    updateFit(0);
 }
 
 SlopeCalibrationDialog::SlopeCalibrationDialog(DensInterface *densInterface, QWidget *parent)
@@ -99,7 +108,7 @@ SlopeCalibrationDialog::~SlopeCalibrationDialog()
     delete ui;
 }
 
-std::tuple<float, float, float> SlopeCalibrationDialog::calValues() const
+PolyFit<2>::Coefficients SlopeCalibrationDialog::calValues() const
 {
     return calValues_;
 }
@@ -158,6 +167,7 @@ void SlopeCalibrationDialog::onTargetMeasurement(float basicReading)
 
 void SlopeCalibrationDialog::addRawMeasurement(float rawValue)
 {
+    TRACE_SCOPE("SlopeCalibrationDialog::addRawMeasurement");
     if (qIsNaN(rawValue) || rawValue < 0.0F) {
         return;
     }
@@ -333,18 +343,44 @@ void SlopeCalibrationDialog::onActionDelete()
     }
 }
 
-void SlopeCalibrationDialog::onCalculateResults()
+void SlopeCalibrationDialog::updateFit(int firstRow)
 {
-    qDebug() << "Calculate Results";
-    QList<float> xList;
-    QList<float> yList;
+    TRACE_SCOPE("SlopeCalibrationDialog::updateFit");
+
+    // Every row is measured against the first one, and the fit stops at
+    // the first incomplete row, so a change can only affect the rows
+    // from it onwards
+    if (firstRow < 0) { firstRow = 0; }
+    if (firstRow > 0 && (firstRow > rowPoints_.size() || rowPoints_[firstRow - 1].isEmpty())) {
+        // The fit already stops before this row
+        rowPoints_.resize(model_->rowCount());
+        return;
+    }
+
     float base_measurement = qSNaN();
+    if (firstRow > 0) {
+        const float density = itemValueAsFloat(0, 0);
+        const float measurement = itemValueAsFloat(0, 1);
+        base_measurement = enableReflReadings_ ? measurement * std::pow(10.0F, density) : measurement;
+    }
+
+    bool complete = true;
+    for (int row = firstRow; row < qMax<int>(model_->rowCount(), rowPoints_.size()); row++) {
+        if (row >= rowPoints_.size()) { rowPoints_.resize(row + 1); }
+        QList<QPointF> &points = rowPoints_[row];
+
+        for (const QPointF &point : std::as_const(points)) {
+            fit_.removePoint(point.x(), point.y());
+        }
+        points.clear();
+
+        if (!complete || row >= model_->rowCount()) { continue; }
 
-    for (int row = 0; row < model_->rowCount(); row++) {
         float density = itemValueAsFloat(row, 0);
         float measurement = itemValueAsFloat(row, 1);
         if (qIsNaN(density) || qIsNaN(measurement)) {
-            break;
+            complete = false;
+            continue;
         }
         if (row == 0) {
             if (enableReflReadings_) {
@@ -357,41 +393,50 @@ void SlopeCalibrationDialog::onCalculateResults()
                 // provided input.
                 base_measurement = measurement * std::pow(10.0F, density);
                 float logBase = std::log10(base_measurement);
-                xList.append(logBase);
-                yList.append(logBase);
+                points.append(QPointF(logBase, logBase));
 
                 float logMeas = std::log10(measurement);
-                xList.append(logMeas);
-                yList.append(logMeas);
+                points.append(QPointF(logMeas, logMeas));
             } else {
                 if (density < 0.0F || density > 0.001F) {
                     qDebug() << "First row density must be zero:" << density;
-                    break;
+                    complete = false;
+                    continue;
                 }
 
                 float x = std::log10(measurement);
-                xList.append(x);
-                yList.append(x);
+                points.append(QPointF(x, x));
                 base_measurement = measurement;
             }
         } else {
             float x = std::log10(measurement);
             float y = std::log10(base_measurement / std::pow(10.0F, density));
-            xList.append(x);
-            yList.append(y);
+            points.append(QPointF(x, y));
+        }
+
+        for (const QPointF &point : std::as_const(points)) {
+            fit_.addPoint(point.x(), point.y());
         }
     }
-    qDebug() << "Have" << xList.size() << "rows of data";
-    if (xList.size() < 5) {
+    rowPoints_.resize(model_->rowCount());
+}
+
+void SlopeCalibrationDialog::onCalculateResults()
+{
+    TRACE_SCOPE("SlopeCalibrationDialog::onCalculateResults");
+    qDebug() << "Calculate Results";
+
+    qDebug() << "Have" << fit_.count() << "rows of data";
+    if (fit_.count() < 5) {
         qDebug() << "Not enough rows of data";
         return;
     }
 
-    auto beta = util::polyfit(xList, yList);
+    const PolyFit<2>::Coefficients beta = fit_.coefficients();
 
-    ui->b0LineEdit->setText(QString::number(std::get<0>(beta), 'f'));
-    ui->b1LineEdit->setText(QString::number(std::get<1>(beta), 'f'));
-    ui->b2LineEdit->setText(QString::number(std::get<2>(beta), 'f'));
+    ui->b0LineEdit->setText(QString::number(beta[0], 'f'));
+    ui->b1LineEdit->setText(QString::number(beta[1], 'f'));
+    ui->b2LineEdit->setText(QString::number(beta[2], 'f'));
     calValues_ = beta;
     ui->buttonBox->button(QDialogButtonBox::Ok)->setEnabled(true);
 }
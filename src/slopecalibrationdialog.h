@@ -5,9 +5,10 @@
 #include <QStandardItemModel>
 #include <QList>
 #include <QPair>
-#include <tuple>
+#include <QPointF>
 #include "densinterface.h"
 #include "densistick/densistickrunner.h"
+#include "polyfit.h"
 
 namespace Ui {
 class SlopeCalibrationDialog;
@@ -24,7 +25,7 @@ public:
     explicit SlopeCalibrationDialog(DensiStickRunner *stickRunner, QWidget *parent = nullptr);
     ~SlopeCalibrationDialog();
 
-    std::tuple<float, float, float> calValues() const;
+    PolyFit<2>::Coefficients calValues() const;
 
 private slots:
     void wedgePrecValueChanged(int value);
@@ -40,13 +41,16 @@ private slots:
 
 private:
     void addRawMeasurement(float rawValue);
+    void updateFit(int firstRow);
     QPair<int, int> upperLeftActiveIndex() const;
     float itemValueAsFloat(int row, int col) const;
 
     Ui::SlopeCalibrationDialog *ui;
     QStandardItemModel *model_;
     bool enableReflReadings_;
-    std::tuple<float, float, float> calValues_;
+    PolyFit<2> fit_;
+    QList<QList<QPointF>> rowPoints_; /*!< Points each table row has put into the fit */
+    PolyFit<2>::Coefficients calValues_;
 };
 
 #endif // SLOPECALIBRATIONDIALOG_H
@@ -0,0 +1,85 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+/**
+ * Fixed-capacity lock-free ring buffer for one producer and one consumer.
+ *
+ * The producer only ever writes the head index and the consumer only
+ * ever writes the tail index, so neither side needs to take a lock.
+ * Capacity is rounded up to a power of two. When the buffer is full,
+ * new elements are rejected rather than overwriting unread ones.
+ */
+template <typename T>
+class SpscRingBuffer
+{
+public:
+    explicit SpscRingBuffer(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity) { size <<= 1; }
+        mask_ = size - 1;
+        buffer_ = std::make_unique<T[]>(size);
+    }
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    /** Producer side: append up to count elements, returning how many fit */
+    size_t push(const T *values, size_t count)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t space = capacity() - (head - tail);
+        const size_t n = qMin(count, space);
+
+        for (size_t i = 0; i < n; i++) {
+            buffer_[(head + i) & mask_] = values[i];
+        }
+
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    bool push(const T &value) { return push(&value, 1) == 1; }
+
+    /** Consumer side: remove up to count elements, returning how many were read */
+    size_t pop(T *values, size_t count)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t n = qMin(count, head - tail);
+
+        for (size_t i = 0; i < n; i++) {
+            values[i] = buffer_[(tail + i) & mask_];
+        }
+
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    /** Approximate number of elements waiting, exact only from the consumer side */
+    size_t size() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    /** Consumer side: discard everything currently in the buffer */
+    void clear()
+    {
+        tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    std::unique_ptr<T[]> buffer_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_ = 0;
+    alignas(64) std::atomic<size_t> tail_ = 0;
+};
+
+#endif // SPSCRINGBUFFER_H
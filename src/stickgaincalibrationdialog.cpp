@@ -6,6 +6,8 @@
 #include <QPushButton>
 #include <QDebug>
 
+#include "trace.h"
+
 namespace
 {
 static const tsl2585_gain_t MAX_GAIN = TSL2585_GAIN_256X;
@@ -107,6 +109,7 @@ void StickGainCalibrationDialog::showEvent(QShowEvent *event)
 
 void StickGainCalibrationDialog::timerEvent(QTimerEvent *event)
 {
+    TRACE_SCOPE("StickGainCalibrationDialog::timerEvent");
     if (event->timerId() != timerId_) { return; }
     if (step_ == 1) {
         // Initialize finding gain measurement brightness values
@@ -312,6 +315,7 @@ void StickGainCalibrationDialog::timerEvent(QTimerEvent *event)
 
 void StickGainCalibrationDialog::onSensorReading(const DensiStickReading& reading)
 {
+    TRACE_SCOPE("StickGainCalibrationDialog::onSensorReading");
     if (!started_ || !running_ || !captureReadings_) { return; }
     if (skipCount_ > 0) {
         skipCount_--;
@@ -0,0 +1,330 @@
+#include "stmcrc32.h"
+
+#include <QtEndian>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define STMCRC32_HAS_CLMUL
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#include <cpuid.h>
+#define STMCRC32_TARGET_CLMUL __attribute__((target("pclmul,sse2")))
+#else
+#include <intrin.h>
+#define STMCRC32_TARGET_CLMUL
+#endif
+#endif
+
+namespace
+{
+static const uint32_t CRC_POLY = 0x04C11DB7;
+static const uint32_t CRC_INIT = 0xFFFFFFFF;
+
+typedef uint32_t (*CrcFunction)(uint32_t crc, const uint8_t *data, size_t words);
+
+/*
+ * Table k holds the effect of a byte followed by k zero bytes,
+ * so eight bytes can be folded into the CRC in one step.
+ */
+struct CrcTables
+{
+    uint32_t t[8][256];
+};
+
+constexpr CrcTables makeCrcTables()
+{
+    CrcTables tables{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i << 24;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80000000U) ? ((crc << 1) ^ CRC_POLY) : (crc << 1);
+        }
+        tables.t[0][i] = crc;
+    }
+    for (int k = 1; k < 8; k++) {
+        for (uint32_t i = 0; i < 256; i++) {
+            const uint32_t prev = tables.t[k - 1][i];
+            tables.t[k][i] = (prev << 8) ^ tables.t[0][prev >> 24];
+        }
+    }
+    return tables;
+}
+
+static constexpr CrcTables CRC_TABLES = makeCrcTables();
+
+inline uint32_t loadWord(const uint8_t *data)
+{
+    return qFromLittleEndian<quint32>(data);
+}
+
+uint32_t crcNibble(uint32_t crc, const uint8_t *data, size_t words)
+{
+    // Calculate the CRC-32 checksum on a block of data, using the same algorithm
+    // used by the hardware CRC module inside the STM32F4 microcontroller.
+    //
+    // Based on the C implementation posted here:
+    // https://community.st.com/s/question/0D50X0000AIeYIb/stm32f4-crc32-algorithm-headache
+
+    static const uint32_t crcTable[] = {
+        0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9,
+        0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
+        0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61,
+        0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD
+    };
+
+    for (size_t i = 0; i < words; i++) {
+        crc = crc ^ loadWord(data + (i * 4));
+
+        crc = (crc << 4) ^ crcTable[crc >> 28];
+        crc = (crc << 4) ^ crcTable[crc >> 28];
+        crc = (crc << 4) ^ crcTable[crc >> 28];
+        crc = (crc << 4) ^ crcTable[crc >> 28];
+        crc = (crc << 4) ^ crcTable[crc >> 28];
+        crc = (crc << 4) ^ crcTable[crc >> 28];
+        crc = (crc << 4) ^ crcTable[crc >> 28];
+        crc = (crc << 4) ^ crcTable[crc >> 28];
+    }
+
+    return crc;
+}
+
+uint32_t crcSlicing8(uint32_t crc, const uint8_t *data, size_t words)
+{
+    const CrcTables &t = CRC_TABLES;
+
+    for (; words >= 2; words -= 2, data += 8) {
+        const uint32_t c = crc ^ loadWord(data);
+        const uint32_t w = loadWord(data + 4);
+        crc = t.t[7][c >> 24] ^ t.t[6][(c >> 16) & 0xFF] ^ t.t[5][(c >> 8) & 0xFF] ^ t.t[4][c & 0xFF]
+            ^ t.t[3][w >> 24] ^ t.t[2][(w >> 16) & 0xFF] ^ t.t[1][(w >> 8) & 0xFF] ^ t.t[0][w & 0xFF];
+    }
+
+    if (words > 0) {
+        const uint32_t c = crc ^ loadWord(data);
+        crc = t.t[3][c >> 24] ^ t.t[2][(c >> 16) & 0xFF] ^ t.t[1][(c >> 8) & 0xFF] ^ t.t[0][c & 0xFF];
+    }
+
+    return crc;
+}
+
+#if defined(STMCRC32_HAS_CLMUL)
+/* x^n mod P, used as the folding constants */
+constexpr uint64_t xPowModPoly(int n)
+{
+    uint64_t result = 1;
+    for (int i = 0; i < n; i++) {
+        result <<= 1;
+        if (result & 0x100000000ULL) {
+            result ^= 0x100000000ULL | CRC_POLY;
+        }
+    }
+    return result;
+}
+
+/* Four words, as a 128-bit polynomial with the first word at the top */
+STMCRC32_TARGET_CLMUL inline __m128i loadChunk(const uint8_t *data)
+{
+    return _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data)), 0x1B);
+}
+
+/* Multiply a 128-bit remainder by the distance in k, and add the next chunk */
+STMCRC32_TARGET_CLMUL inline __m128i foldChunk(__m128i value, __m128i k, __m128i next)
+{
+    return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(value, k, 0x11),
+                                       _mm_clmulepi64_si128(value, k, 0x00)), next);
+}
+
+STMCRC32_TARGET_CLMUL uint32_t crcClmul(uint32_t crc, const uint8_t *data, size_t words)
+{
+    // Folding only pays off once there are a few chunks to work with
+    if (words < 8) { return crcSlicing8(crc, data, words); }
+
+    const __m128i k1 = _mm_set_epi64x(static_cast<qint64>(xPowModPoly(128 + 64)), static_cast<qint64>(xPowModPoly(128)));
+    const __m128i k4 = _mm_set_epi64x(static_cast<qint64>(xPowModPoly(512 + 64)), static_cast<qint64>(xPowModPoly(512)));
+
+    // The running CRC is the same as XOR-ing it into the next word
+    __m128i a0 = _mm_xor_si128(loadChunk(data), _mm_set_epi32(static_cast<int>(crc), 0, 0, 0));
+    data += 16;
+    words -= 4;
+
+    // Fold four independent chunks at a time, to keep the multiplier busy
+    if (words >= 16) {
+        __m128i a1 = loadChunk(data);
+        __m128i a2 = loadChunk(data + 16);
+        __m128i a3 = loadChunk(data + 32);
+        data += 48;
+        words -= 12;
+
+        while (words >= 16) {
+            a0 = foldChunk(a0, k4, loadChunk(data));
+            a1 = foldChunk(a1, k4, loadChunk(data + 16));
+            a2 = foldChunk(a2, k4, loadChunk(data + 32));
+            a3 = foldChunk(a3, k4, loadChunk(data + 48));
+            data += 64;
+            words -= 16;
+        }
+
+        a0 = foldChunk(a0, k1, a1);
+        a0 = foldChunk(a0, k1, a2);
+        a0 = foldChunk(a0, k1, a3);
+    }
+
+    while (words >= 4) {
+        a0 = foldChunk(a0, k1, loadChunk(data));
+        data += 16;
+        words -= 4;
+    }
+
+    // The remainder is congruent to the message so far, so reducing
+    // it as four words from zero gives the CRC to carry on with.
+    uint8_t remainder[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(remainder), _mm_shuffle_epi32(a0, 0x1B));
+    crc = crcSlicing8(0, remainder, 4);
+
+    return crcSlicing8(crc, data, words);
+}
+
+bool cpuHasClmul()
+{
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+#if defined(__GNUC__) || defined(__clang__)
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) { return false; }
+#else
+    int info[4] = { 0, 0, 0, 0 };
+    __cpuid(info, 1);
+    ecx = static_cast<unsigned int>(info[2]);
+    edx = static_cast<unsigned int>(info[3]);
+#endif
+    const bool hasSse2 = (edx & (1U << 26)) != 0;
+    const bool hasPclmul = (ecx & (1U << 1)) != 0;
+    return hasSse2 && hasPclmul;
+}
+#endif
+
+CrcFunction engineFunction(StmCrc32::Engine engine)
+{
+    switch (engine) {
+    case StmCrc32::EngineNibble:
+        return crcNibble;
+#if defined(STMCRC32_HAS_CLMUL)
+    case StmCrc32::EngineClmul:
+        return crcClmul;
+#endif
+    case StmCrc32::EngineSlicing8:
+    default:
+        return crcSlicing8;
+    }
+}
+
+CrcFunction activeFunction()
+{
+    static const CrcFunction function = engineFunction(StmCrc32::activeEngine());
+    return function;
+}
+}
+
+StmCrc32::StmCrc32()
+    : crc_(CRC_INIT), pending_{0, 0, 0, 0}, pendingSize_(0)
+{
+}
+
+void StmCrc32::reset()
+{
+    crc_ = CRC_INIT;
+    pendingSize_ = 0;
+}
+
+void StmCrc32::addWords(const uint32_t *data, size_t count)
+{
+    if (pendingSize_ > 0) {
+        addData(QByteArrayView(reinterpret_cast<const char *>(data), static_cast<qsizetype>(count * 4)));
+        return;
+    }
+    crc_ = activeFunction()(crc_, reinterpret_cast<const uint8_t *>(data), count);
+}
+
+void StmCrc32::addData(QByteArrayView data)
+{
+    if (data.isEmpty()) { return; }
+
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.data());
+    size_t size = static_cast<size_t>(data.size());
+
+    // Complete a word left over from the previous call
+    if (pendingSize_ > 0) {
+        const size_t fill = qMin<size_t>(4 - pendingSize_, size);
+        memcpy(pending_ + pendingSize_, bytes, fill);
+        pendingSize_ += static_cast<int>(fill);
+        bytes += fill;
+        size -= fill;
+        if (pendingSize_ < 4) { return; }
+
+        crc_ = activeFunction()(crc_, pending_, 1);
+        pendingSize_ = 0;
+    }
+
+    const size_t words = size / 4;
+    crc_ = activeFunction()(crc_, bytes, words);
+
+    pendingSize_ = static_cast<int>(size % 4);
+    if (pendingSize_ > 0) {
+        memcpy(pending_, bytes + (words * 4), pendingSize_);
+    }
+}
+
+uint32_t StmCrc32::result() const
+{
+    if (pendingSize_ == 0) { return crc_; }
+
+    uint8_t last[4] = { 0, 0, 0, 0 };
+    memcpy(last, pending_, pendingSize_);
+    return activeFunction()(crc_, last, 1);
+}
+
+uint32_t StmCrc32::checksum(const uint32_t *data, size_t count)
+{
+    return activeFunction()(CRC_INIT, reinterpret_cast<const uint8_t *>(data), count);
+}
+
+uint32_t StmCrc32::checksum(QByteArrayView data)
+{
+    StmCrc32 crc;
+    crc.addData(data);
+    return crc.result();
+}
+
+StmCrc32::Engine StmCrc32::activeEngine()
+{
+    static const Engine engine = isSupported(EngineClmul) ? EngineClmul : EngineSlicing8;
+    return engine;
+}
+
+bool StmCrc32::isSupported(Engine engine)
+{
+    switch (engine) {
+    case EngineNibble:
+    case EngineSlicing8:
+        return true;
+    case EngineClmul:
+#if defined(STMCRC32_HAS_CLMUL)
+    {
+        static const bool supported = cpuHasClmul();
+        return supported;
+    }
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+uint32_t StmCrc32::update(Engine engine, uint32_t crc, const uint32_t *data, size_t count)
+{
+    if (!isSupported(engine)) { engine = EngineSlicing8; }
+    return engineFunction(engine)(crc, reinterpret_cast<const uint8_t *>(data), count);
+}
@@ -0,0 +1,69 @@
+#ifndef STMCRC32_H
+#define STMCRC32_H
+
+#include <QByteArrayView>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * CRC-32 as calculated by the hardware CRC unit of the STM32
+ * microcontrollers used in the devices.
+ *
+ * That unit works on whole 32-bit words, shifted in MSB first,
+ * using polynomial 0x04C11DB7 and an initial value of 0xFFFFFFFF,
+ * with no reflection or final XOR. Byte buffers are read as
+ * little-endian words, the same way the device reads them out
+ * of its own memory.
+ *
+ * Checksums can be calculated in one call, or incrementally by
+ * feeding data into an instance as it becomes available.
+ */
+class StmCrc32
+{
+public:
+    enum Engine {
+        EngineNibble,   /*!< Reference implementation, one nibble at a time */
+        EngineSlicing8, /*!< Eight table lookups per pair of words */
+        EngineClmul     /*!< Folding with carry-less multiply, on x86 CPUs with PCLMULQDQ */
+    };
+
+    StmCrc32();
+
+    void reset();
+
+    /** Add whole words, in host byte order */
+    void addWords(const uint32_t *data, size_t count);
+
+    /**
+     * Add a block of bytes. Bytes past the last whole word are held
+     * until the next call completes it.
+     */
+    void addData(QByteArrayView data);
+
+    /**
+     * Checksum of everything added so far. If the data does not end on
+     * a word boundary, the last word is padded out with zero bytes.
+     */
+    uint32_t result() const;
+
+    static uint32_t checksum(const uint32_t *data, size_t count);
+    static uint32_t checksum(QByteArrayView data);
+
+    /** Fastest engine supported by the CPU, which all the other calls use */
+    static Engine activeEngine();
+    static bool isSupported(Engine engine);
+
+    /**
+     * Continue a checksum over whole words with a specific engine,
+     * starting from a previous result or 0xFFFFFFFF.
+     */
+    static uint32_t update(Engine engine, uint32_t crc, const uint32_t *data, size_t count);
+
+private:
+    uint32_t crc_;
+    uint8_t pending_[4];
+    int pendingSize_;
+};
+
+#endif // STMCRC32_H
@@ -8,10 +8,13 @@
 #include <QJsonArray>
 
 #include "floatitemdelegate.h"
+#include "tempcorrectionfitter.h"
 #include "util.h"
+#include "trace.h"
 
 TempCalibrationDialog::TempCalibrationDialog(QWidget *parent)
     : QDialog(parent)
+    , fitter_(new TempCorrectionFitter(this))
     , ui(new Ui::TempCalibrationDialog)
 {
     ui->setupUi(this);
@@ -35,6 +38,14 @@ TempCalibrationDialog::TempCalibrationDialog(QWidget *parent)
     connect(ui->clearPushButton, &QPushButton::clicked, this, &TempCalibrationDialog::onClearClicked);
     connect(ui->calculatePushButton, &QPushButton::clicked, this, &TempCalibrationDialog::onCalculateClicked);
 
+    // Results are kept for each set until its input changes
+    connect(fitter_, &TempCorrectionFitter::columnFitted, this, &TempCalibrationDialog::onColumnFitted);
+    connect(fitter_, &TempCorrectionFitter::finished, this, &TempCalibrationDialog::onFittingFinished);
+    connect(ui->visInputTableWidget->model(), &QAbstractItemModel::dataChanged, this, [this]() { fitter_->invalidate(0); });
+    connect(ui->visInputTableWidget->model(), &QAbstractItemModel::modelReset, this, [this]() { fitter_->invalidate(0); });
+    connect(ui->uvInputTableWidget->model(), &QAbstractItemModel::dataChanged, this, [this]() { fitter_->invalidate(1); });
+    connect(ui->uvInputTableWidget->model(), &QAbstractItemModel::modelReset, this, [this]() { fitter_->invalidate(1); });
+
     ui->visInputTableWidget->setItemDelegateForColumn(0, new FloatItemDelegate(-20, 100, 2));
     for (int i = 1; i < ui->visInputTableWidget->columnCount(); i++) {
         ui->visInputTableWidget->setItemDelegateForColumn(i, new FloatItemDelegate(0, 1000, 6));
@@ -254,43 +265,50 @@ void TempCalibrationDialog::onClearClicked()
     ui->resultsTableWidget->clearContents();
     ui->uvInputTableWidget->clearContents();
     ui->resultsTableWidget->clearContents();
+    fitter_->invalidateAll();
     ui->buttonBox->button(QDialogButtonBox::Ok)->setEnabled(false);
 }
 
 void TempCalibrationDialog::onCalculateClicked()
 {
-    int maxColumns;
-    QList<QList<double>> tableData;
-    int refTempRow;
+    TRACE_SCOPE("TempCalibrationDialog::onCalculateClicked");
 
+    // Fits still running are superseded by the ones started here
     ui->resultsTableWidget->clearContents();
     hasVisValues_ = false;
     hasUvValues_ = false;
 
     // Calculate VIS corrections
-    maxColumns = findMaxValidColumns(ui->visInputTableWidget);
-    tableData = collectInputData(ui->visInputTableWidget, maxColumns);
-    refTempRow = findReferenceRow(tableData);
-
-    if (tableData.isEmpty() || refTempRow < 0) {
+    if (!startCorrections(ui->visInputTableWidget, 0)) {
         QMessageBox::warning(this, tr("Invalid Values"), tr("Cannot calculate VIS corrections from invalid or incomplete data."));
-    } else {
-        calculateCorrections(tableData, refTempRow, ui->resultsTableWidget, 0);
-        hasVisValues_ = true;
     }
 
     // Calculate UV corrections
-    maxColumns = findMaxValidColumns(ui->visInputTableWidget);
-    tableData = collectInputData(ui->uvInputTableWidget, maxColumns);
-    refTempRow = findReferenceRow(tableData);
-
-    if (tableData.isEmpty() || refTempRow < 0) {
+    if (!startCorrections(ui->uvInputTableWidget, 1)) {
         QMessageBox::warning(this, tr("Invalid Values"), tr("Cannot calculate UV corrections from invalid or incomplete data."));
+    }
+
+    if (fitter_->isBusy()) {
+        ui->calculatePushButton->setEnabled(false);
+        ui->buttonBox->button(QDialogButtonBox::Ok)->setEnabled(false);
     } else {
-        calculateCorrections(tableData, refTempRow, ui->resultsTableWidget, 1);
+        onFittingFinished();
+    }
+}
+
+void TempCalibrationDialog::onColumnFitted(int column, const DensCalTemperature &values)
+{
+    coefficientSetAssignColumn(ui->resultsTableWidget, column, values);
+    if (column == 0) {
+        hasVisValues_ = true;
+    } else if (column == 1) {
         hasUvValues_ = true;
     }
+}
 
+void TempCalibrationDialog::onFittingFinished()
+{
+    ui->calculatePushButton->setEnabled(true);
     ui->buttonBox->button(QDialogButtonBox::Ok)->setEnabled(hasVisValues_ || hasUvValues_);
 }
 
@@ -356,34 +374,26 @@ int TempCalibrationDialog::findReferenceRow(const QList<QList<double>> &tableDat
     return refTempRow;
 }
 
-void TempCalibrationDialog::calculateCorrections(const QList<QList<double>> &tableData, int refTempRow,
-                                                 QTableWidget *resultsTableWidget, int resultsCol)
+bool TempCalibrationDialog::startCorrections(QTableWidget *inputTableWidget, int resultsCol)
 {
-    const QList<double> refRowData = tableData[refTempRow];
-
-    QList<float> tempList;
-    QList<float> corrList;
-
-    for (qsizetype row = 0; row < tableData.size(); row++) {
-        const QList<double> rowData = tableData[row];
-        tempList.append(rowData[0]);
-
-        if (row == refTempRow) {
-            corrList.append(1.0);
-        } else {
-            double corrSum = 0.0;
-            for (qsizetype i = 1; i < rowData.size(); i++) {
-                corrSum += refRowData[i] / rowData[i];
-            }
-            corrList.append(static_cast<float>(corrSum / (rowData.size() - 1)));
-        }
+    // Nothing in this set has changed since it was last fitted
+    if (fitter_->hasResult(resultsCol)) {
+        onColumnFitted(resultsCol, fitter_->result(resultsCol));
+        return true;
     }
 
-    std::tuple<float, float, float> polyResult = util::polyfit(tempList, corrList);
+    const int maxColumns = findMaxValidColumns(inputTableWidget);
+    const QList<QList<double>> tableData = collectInputData(inputTableWidget, maxColumns);
+    const int refTempRow = findReferenceRow(tableData);
 
-    coefficientSetAssignColumn(resultsTableWidget, resultsCol, DensCalTemperature(polyResult));
+    if (tableData.isEmpty() || refTempRow < 0) {
+        return false;
+    }
 
     qDebug() << "Reference temp:" << QString("%1°C").arg(QString::number(tableData[refTempRow][0], 'f', 1));
+
+    fitter_->fit(resultsCol, tableData, refTempRow);
+    return true;
 }
 
 QTableWidgetItem *TempCalibrationDialog::tableWidgetItem(QTableWidget *table, int row, int column)
@@ -7,6 +7,8 @@
 
 #include "denscalvalues.h"
 
+class TempCorrectionFitter;
+
 class QTableWidget;
 class QTableWidgetItem;
 
@@ -38,6 +40,8 @@ private slots:
     void onImportClicked();
     void onClearClicked();
     void onCalculateClicked();
+    void onColumnFitted(int column, const DensCalTemperature &values);
+    void onFittingFinished();
 
 private:
     bool processImportData(const QByteArray &importData);
@@ -45,8 +49,7 @@ private:
     int findMaxValidColumns(QTableWidget *inputTableWidget);
     QList<QList<double>> collectInputData(QTableWidget *inputTableWidget, int maxColumns);
     int findReferenceRow(const QList<QList<double>> &tableData);
-    void calculateCorrections(const QList<QList<double>> &tableData, int refTempRow,
-                              QTableWidget *resultsTableWidget, int resultsCol);
+    bool startCorrections(QTableWidget *inputTableWidget, int resultsCol);
     QTableWidgetItem *tableWidgetItem(QTableWidget *table, int row, int column);
     void coefficientSetAssignColumn(QTableWidget *table, int col, const DensCalTemperature &sourceValues);
     DensCalTemperature coefficientSetCollectColumn(const QTableWidget *table, int col) const;
@@ -54,6 +57,7 @@ private:
     QString uniqueId_;
     bool hasVisValues_ = false;
     bool hasUvValues_ = false;
+    TempCorrectionFitter *fitter_;
     Ui::TempCalibrationDialog *ui;
 };
 
@@ -0,0 +1,147 @@
+#include "tempcorrectionfitter.h"
+
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QDebug>
+
+#include "trace.h"
+
+TempCorrectionFitter::TempCorrectionFitter(QObject *parent)
+    : QObject{parent}
+{
+}
+
+bool TempCorrectionFitter::hasResult(int column) const
+{
+    const auto it = columns_.constFind(column);
+    return it != columns_.constEnd() && it->valid && !it->pending;
+}
+
+DensCalTemperature TempCorrectionFitter::result(int column) const
+{
+    return columns_.value(column).values;
+}
+
+void TempCorrectionFitter::invalidate(int column)
+{
+    ColumnState &state = columns_[column];
+    state.valid = false;
+
+    // Any fit still running was started from the old input
+    state.generation++;
+    if (state.pending) {
+        state.pending = false;
+        if (!isBusy()) { emit finished(); }
+    }
+}
+
+void TempCorrectionFitter::invalidateAll()
+{
+    for (auto it = columns_.begin(); it != columns_.end(); ++it) {
+        invalidate(it.key());
+    }
+}
+
+void TempCorrectionFitter::fit(int column, const QList<QList<double>> &tableData, int refTempRow)
+{
+    ColumnState &state = columns_[column];
+    const quint64 generation = ++state.generation;
+    state.pending = true;
+    state.valid = false;
+
+    // Every correction is relative to the reference row, so if that has
+    // moved or changed then all the rows have to be worked out again
+    const bool sameReference = refTempRow == state.fittedRefRow
+        && refTempRow < state.fittedData.size()
+        && tableData[refTempRow] == state.fittedData[refTempRow];
+
+    QList<qsizetype> rows;
+    for (qsizetype row = 0; row < tableData.size(); row++) {
+        if (!sameReference || row >= state.fittedData.size() || tableData[row] != state.fittedData[row]) {
+            rows.append(row);
+        }
+    }
+
+    auto *watcher = new QFutureWatcher<QList<QPointF>>(this);
+    connect(watcher, &QFutureWatcher<QList<QPointF>>::finished, this,
+            [this, watcher, column, generation, tableData, refTempRow, rows]() {
+        onFitFinished(column, generation, tableData, refTempRow, rows, watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&TempCorrectionFitter::correctionPoints, tableData, refTempRow, rows));
+}
+
+bool TempCorrectionFitter::isBusy() const
+{
+    for (const ColumnState &state : columns_) {
+        if (state.pending) { return true; }
+    }
+    return false;
+}
+
+void TempCorrectionFitter::onFitFinished(int column, quint64 generation,
+                                         const QList<QList<double>> &tableData, int refTempRow,
+                                         const QList<qsizetype> &rows, const QList<QPointF> &points)
+{
+    ColumnState &state = columns_[column];
+    if (state.generation != generation) { return; }
+
+    // Swap in the points for the rows that changed, which always
+    // includes every row past the end of the previous input
+    for (qsizetype i = 0; i < rows.size(); i++) {
+        const qsizetype row = rows[i];
+        if (row < state.points.size()) {
+            state.fit.removePoint(state.points[row].x(), state.points[row].y());
+            state.points[row] = points[i];
+        } else {
+            state.points.append(points[i]);
+        }
+        state.fit.addPoint(points[i].x(), points[i].y());
+    }
+
+    // Then take out the rows that are no longer there
+    while (state.points.size() > tableData.size()) {
+        const QPointF point = state.points.takeLast();
+        state.fit.removePoint(point.x(), point.y());
+    }
+
+    state.fittedData = tableData;
+    state.fittedRefRow = refTempRow;
+
+    const PolyFit<2>::Coefficients beta = state.fit.coefficients();
+
+    state.pending = false;
+    state.valid = true;
+    state.values = DensCalTemperature(static_cast<float>(beta[0]),
+                                      static_cast<float>(beta[1]),
+                                      static_cast<float>(beta[2]));
+
+    emit columnFitted(column, state.values);
+    if (!isBusy()) { emit finished(); }
+}
+
+QList<QPointF> TempCorrectionFitter::correctionPoints(const QList<QList<double>> &tableData, int refTempRow,
+                                                      const QList<qsizetype> &rows)
+{
+    TRACE_SCOPE("TempCorrectionFitter::correctionPoints");
+    const QList<double> &refRowData = tableData[refTempRow];
+
+    QList<QPointF> points;
+    points.reserve(rows.size());
+
+    for (const qsizetype row : rows) {
+        const QList<double> &rowData = tableData[row];
+
+        if (row == refTempRow) {
+            points.append(QPointF(rowData[0], 1.0));
+        } else {
+            double corrSum = 0.0;
+            for (qsizetype i = 1; i < rowData.size(); i++) {
+                corrSum += refRowData[i] / rowData[i];
+            }
+            points.append(QPointF(rowData[0], corrSum / (rowData.size() - 1)));
+        }
+    }
+
+    return points;
+}
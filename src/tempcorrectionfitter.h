@@ -0,0 +1,72 @@
+#ifndef TEMPCORRECTIONFITTER_H
+#define TEMPCORRECTIONFITTER_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QPointF>
+
+#include "denscalvalues.h"
+#include "polyfit.h"
+
+/**
+ * Fits temperature correction curves in the background, one per
+ * results column, with all the requested columns running concurrently.
+ *
+ * Each column keeps its fit between runs. A new run only works out the
+ * corrections for the input rows that differ from the last run, and
+ * swaps just those points in the fit, unless the reference row itself
+ * has changed.
+ */
+class TempCorrectionFitter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TempCorrectionFitter(QObject *parent = nullptr);
+
+    /** Whether the column has a result that is still current */
+    bool hasResult(int column) const;
+    DensCalTemperature result(int column) const;
+
+    /** Mark the result as stale, and drop any fit still running for it */
+    void invalidate(int column);
+    void invalidateAll();
+
+    /**
+     * Start fitting a column from its input table, where the first
+     * column of each row is the temperature and the rest are sensor
+     * readings. Any fit already running for the column is superseded.
+     */
+    void fit(int column, const QList<QList<double>> &tableData, int refTempRow);
+
+    bool isBusy() const;
+
+    /** Correction point for each of the listed rows of the input table */
+    static QList<QPointF> correctionPoints(const QList<QList<double>> &tableData, int refTempRow,
+                                           const QList<qsizetype> &rows);
+
+signals:
+    void columnFitted(int column, const DensCalTemperature &values);
+    void finished();
+
+private:
+    struct ColumnState
+    {
+        quint64 generation = 0;
+        bool pending = false;
+        bool valid = false;
+        DensCalTemperature values;
+        PolyFit<2> fit;
+        QList<QList<double>> fittedData; /*!< Input the fit was last updated from */
+        int fittedRefRow = -1;
+        QList<QPointF> points;           /*!< Point each row of that input added */
+    };
+
+    void onFitFinished(int column, quint64 generation,
+                       const QList<QList<double>> &tableData, int refTempRow,
+                       const QList<qsizetype> &rows, const QList<QPointF> &points);
+
+    QHash<int, ColumnState> columns_;
+};
+
+#endif // TEMPCORRECTIONFITTER_H
@@ -0,0 +1,250 @@
+#include "trace.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QFile>
+#include <QDebug>
+#include <memory>
+#include <vector>
+
+namespace
+{
+/* Events kept per thread, anything past this is dropped until the next start */
+static const qsizetype THREAD_BUFFER_EVENTS = 128 * 1024;
+
+/* Process ID written into the trace, there is only ever one */
+static const int TRACE_PID = 1;
+
+struct TraceEvent
+{
+    const char *name;
+    qint64 startUs;
+    qint64 durationUs;  /*!< Negative for an instant event */
+};
+
+/**
+ * Events recorded by a single thread.
+ *
+ * Only the owning thread writes events, and it publishes them by
+ * advancing the count, so the buffer can be read from any thread
+ * without stopping the writer. The owning thread is also the only one
+ * that empties the buffer, the first time it records something in a
+ * new session, so starting a trace never resets a count from under it.
+ */
+struct ThreadBuffer
+{
+    int tid = 0;
+    QString threadName;
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<quint64> session = 0;   /*!< Session the events belong to */
+    std::atomic<qsizetype> count = 0;
+    std::atomic<quint64> dropped = 0;
+};
+
+struct TraceState
+{
+    QMutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+TraceState &state()
+{
+    static TraceState instance;
+    return instance;
+}
+
+const QElapsedTimer &traceClock()
+{
+    static const QElapsedTimer clock = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock;
+}
+
+ThreadBuffer *threadBuffer()
+{
+    // Buffers outlive their threads, so spans from worker threads
+    // that have since finished still end up in the saved trace.
+    thread_local ThreadBuffer *buffer = nullptr;
+    if (!buffer) {
+        auto entry = std::make_unique<ThreadBuffer>();
+        entry->events = std::make_unique<TraceEvent[]>(THREAD_BUFFER_EVENTS);
+
+        QThread *thread = QThread::currentThread();
+        if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+            entry->threadName = QStringLiteral("Main");
+        } else if (thread && !thread->objectName().isEmpty()) {
+            entry->threadName = thread->objectName();
+        }
+
+        TraceState &s = state();
+        QMutexLocker locker(&s.mutex);
+        entry->tid = static_cast<int>(s.buffers.size()) + 1;
+        if (entry->threadName.isEmpty()) {
+            entry->threadName = QStringLiteral("Thread %1").arg(entry->tid);
+        }
+        buffer = entry.get();
+        s.buffers.push_back(std::move(entry));
+    }
+    return buffer;
+}
+
+void append(const char *name, qint64 startUs, qint64 durationUs, quint64 session)
+{
+    if (session != Trace::session()) { return; }
+
+    ThreadBuffer *buffer = threadBuffer();
+    if (buffer->session.load(std::memory_order_relaxed) != session) {
+        // Whatever is left over is from an earlier session, and the
+        // buffer only counts as part of this one once it is empty
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->session.store(session, std::memory_order_release);
+    }
+
+    const qsizetype index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= THREAD_BUFFER_EVENTS) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent &event = buffer->events[index];
+    event.name = name;
+    event.startUs = startUs;
+    event.durationUs = durationUs;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void appendJsonString(QByteArray &out, const QByteArray &value)
+{
+    out.append('"');
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            out.append('\\');
+            out.append(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out.append(' ');
+        } else {
+            out.append(c);
+        }
+    }
+    out.append('"');
+}
+}
+
+std::atomic<bool> Trace::active_ = false;
+std::atomic<quint64> Trace::session_ = 0;
+
+void Trace::start()
+{
+    if (isActive()) { return; }
+
+    traceClock();
+
+    // Buffers still holding events from the last session are left for
+    // their own threads to empty, and are skipped when saving until then
+    session_.fetch_add(1, std::memory_order_relaxed);
+    active_ = true;
+    qDebug() << "Tracing started";
+}
+
+void Trace::stop()
+{
+    if (!isActive()) { return; }
+    active_ = false;
+    qDebug() << "Tracing stopped";
+}
+
+bool Trace::save(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Unable to write trace:" << file.errorString();
+        return false;
+    }
+
+    QByteArray out;
+    out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    quint64 total = 0;
+    quint64 dropped = 0;
+    bool first = true;
+
+    const quint64 current = session();
+
+    TraceState &s = state();
+    QMutexLocker locker(&s.mutex);
+    for (const std::unique_ptr<ThreadBuffer> &buffer : s.buffers) {
+        if (buffer->session.load(std::memory_order_acquire) != current) { continue; }
+
+        const qsizetype count = buffer->count.load(std::memory_order_acquire);
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+
+        if (!first) { out.append(",\n"); }
+        first = false;
+        out.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":");
+        out.append(QByteArray::number(TRACE_PID));
+        out.append(",\"tid\":");
+        out.append(QByteArray::number(buffer->tid));
+        out.append(",\"args\":{\"name\":");
+        appendJsonString(out, buffer->threadName.toUtf8());
+        out.append("}}");
+
+        for (qsizetype i = 0; i < count; i++) {
+            const TraceEvent &event = buffer->events[i];
+            out.append(",\n{\"name\":");
+            appendJsonString(out, QByteArray(event.name));
+            if (event.durationUs >= 0) {
+                out.append(",\"ph\":\"X\",\"ts\":");
+                out.append(QByteArray::number(event.startUs));
+                out.append(",\"dur\":");
+                out.append(QByteArray::number(event.durationUs));
+            } else {
+                out.append(",\"ph\":\"i\",\"s\":\"t\",\"ts\":");
+                out.append(QByteArray::number(event.startUs));
+            }
+            out.append(",\"pid\":");
+            out.append(QByteArray::number(TRACE_PID));
+            out.append(",\"tid\":");
+            out.append(QByteArray::number(buffer->tid));
+            out.append('}');
+
+            if (out.size() >= 64 * 1024) {
+                file.write(out);
+                out.clear();
+            }
+        }
+        total += count;
+    }
+    locker.unlock();
+
+    out.append("\n]}\n");
+    file.write(out);
+
+    if (dropped > 0) {
+        qWarning() << "Trace buffers overflowed, dropped" << dropped << "events";
+    }
+    qDebug() << "Saved" << total << "trace events to" << fileName;
+
+    return file.error() == QFileDevice::NoError;
+}
+
+qint64 Trace::nowUs()
+{
+    return traceClock().nsecsElapsed() / 1000;
+}
+
+void Trace::complete(const char *name, qint64 startUs, qint64 durationUs, quint64 session)
+{
+    append(name, startUs, durationUs, session);
+}
+
+void Trace::instant(const char *name)
+{
+    append(name, nowUs(), -1, session());
+}
@@ -0,0 +1,87 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <atomic>
+
+/**
+ * Process-wide recorder of timed spans, for finding out where the time
+ * goes in a slow measurement or calibration step.
+ *
+ * Each thread appends to its own fixed-size buffer, so recording a span
+ * never takes a lock or allocates. Spans are only recorded while tracing
+ * is active, and the whole facility can be compiled out by defining
+ * DENS_TRACE_DISABLED. Traces are saved in the Chrome trace-event JSON
+ * format, for viewing in chrome://tracing or Perfetto.
+ */
+class Trace
+{
+public:
+    /** Discard anything previously recorded and start recording */
+    static void start();
+    static void stop();
+    static bool isActive() { return active_.load(std::memory_order_relaxed); }
+
+    /** Identifies the current recording, which changes on every start() */
+    static quint64 session() { return session_.load(std::memory_order_relaxed); }
+
+    /** Write everything recorded so far as Chrome trace-event JSON */
+    static bool save(const QString &fileName);
+
+    /** Microseconds since the trace clock was started */
+    static qint64 nowUs();
+
+    /**
+     * Record a completed span, the name must be a string literal.
+     * The span is dropped if it was started during an earlier session.
+     */
+    static void complete(const char *name, qint64 startUs, qint64 durationUs, quint64 session);
+
+    /** Record a point in time, the name must be a string literal */
+    static void instant(const char *name);
+
+private:
+    static std::atomic<bool> active_;
+    static std::atomic<quint64> session_;
+};
+
+/**
+ * Records a span covering its own lifetime, if tracing was active when
+ * it was created.
+ */
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name)
+        : name_(Trace::isActive() ? name : nullptr)
+        , session_(name_ ? Trace::session() : 0)
+        , startUs_(name_ ? Trace::nowUs() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (name_) { Trace::complete(name_, startUs_, Trace::nowUs() - startUs_, session_); }
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name_;
+    quint64 session_;
+    qint64 startUs_;
+};
+
+#define DENS_TRACE_CONCAT_(a, b) a##b
+#define DENS_TRACE_CONCAT(a, b) DENS_TRACE_CONCAT_(a, b)
+
+#ifndef DENS_TRACE_DISABLED
+#define TRACE_SCOPE(name) TraceScope DENS_TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_INSTANT(name) do { if (Trace::isActive()) { Trace::instant(name); } } while (0)
+#else
+#define TRACE_SCOPE(name) do { } while (0)
+#define TRACE_INSTANT(name) do { } while (0)
+#endif
+
+#endif // TRACE_H
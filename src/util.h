@@ -2,6 +2,9 @@
 #define UTIL_H
 
 #include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QByteArrayView>
 #include <QJsonValue>
 
 #include <stddef.h>
@@ -24,15 +27,38 @@ uint32_t copy_to_u32(const uint8_t *buf);
 void copy_from_f32(uint8_t *buf, float val);
 float copy_to_f32(const uint8_t *buf);
 
+/**
+ * Write the 8 uppercase hex digit form of a float, as used by the
+ * device protocol, into a caller provided buffer of at least 8 chars.
+ */
+void encode_f32(float val, char *out);
 QString encode_f32(float val);
+
+/**
+ * Decode the 8 hex digit form of a float, returning NaN if the
+ * value is not in that form.
+ */
 float decode_f32(const QString &val);
+float decode_f32(QStringView val);
+float decode_f32(QByteArrayView val);
+
+/**
+ * Decode the first count values of an argument list into the output
+ * array. Returns false if any of them are missing or invalid, leaving
+ * NaN in their place.
+ */
+bool decode_f32_list(const QStringList &vals, float *out, qsizetype count);
+
+/**
+ * Decode a block of hex digits into the output buffer, which must hold
+ * at least half as many bytes. Returns the number of bytes written,
+ * or -1 if the block is not valid hex.
+ */
+qsizetype decode_hex(QByteArrayView hex, uint8_t *out);
 
 uint32_t calculateStmCrc32(uint32_t *data, size_t len);
 uint16_t calculateFtdiChecksum(const uint8_t *data, size_t len);
 
-double **make2DArray(const size_t rows, const size_t cols);
-void free2DArray(double **array, const size_t rows);
-
 std::tuple<float, float, float> polyfit(const QList<float> &xList, const QList<float> &yList);
 
 QValidator *createIntValidator(int min, int max, QObject *parent = nullptr);
@@ -50,6 +76,12 @@ void tableWidgetDelete(QTableWidget *tableWidget, bool clearSelection = true);
 QTableWidgetItem *tableWidgetItem(QTableWidget *table, int row, int column);
 bool tableWidgetHasEmptyCells(QTableWidget *tableWidget);
 
+/**
+ * Rank of a device log level letter, from least to most important:
+ * V, D, I, W, E, A. Returns -1 for anything else.
+ */
+int logLevelRank(char level);
+
 int parseJsonInt(const QJsonValue &value);
 float parseJsonFloat(const QJsonValue &value);
 
@@ -0,0 +1,265 @@
+#include "util.h"
+#include "polyfit.h"
+#include "stmcrc32.h"
+
+#include <QDebug>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+/* Nibble value of each possible character, or -1 if it is not a hex digit */
+struct HexTable
+{
+    int8_t value[256];
+};
+
+constexpr HexTable makeHexTable()
+{
+    HexTable table{};
+    for (int i = 0; i < 256; i++) { table.value[i] = -1; }
+    for (int i = 0; i < 10; i++) { table.value['0' + i] = static_cast<int8_t>(i); }
+    for (int i = 0; i < 6; i++) {
+        table.value['A' + i] = static_cast<int8_t>(10 + i);
+        table.value['a' + i] = static_cast<int8_t>(10 + i);
+    }
+    return table;
+}
+
+static constexpr HexTable HEX_TABLE = makeHexTable();
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+template <typename Char>
+inline float decodeHexF32(const Char *data)
+{
+    uint32_t int_val = 0;
+    int invalid = 0;
+    for (int i = 0; i < 8; i++) {
+        const uint32_t c = static_cast<uint32_t>(data[i]);
+        const int nibble = c < 256 ? HEX_TABLE.value[c] : -1;
+        invalid |= nibble;
+        int_val = (int_val << 4) | static_cast<uint32_t>(nibble & 0x0F);
+    }
+    if (invalid < 0) { return qSNaN(); }
+
+    float result;
+    memcpy(&result, &int_val, sizeof(float));
+    return result;
+}
+}
+
+namespace util
+{
+
+void copy_from_u32(uint8_t *buf, uint32_t val)
+{
+    buf[0] = (val >> 24) & 0xFF;
+    buf[1] = (val >> 16) & 0xFF;
+    buf[2] = (val >> 8) & 0xFF;
+    buf[3] = val & 0xFF;
+}
+
+uint32_t copy_to_u32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] << 24
+        | (uint32_t)buf[1] << 16
+        | (uint32_t)buf[2] << 8
+        | (uint32_t)buf[3];
+}
+
+void copy_from_f32(uint8_t *buf, float val)
+{
+    uint32_t int_val;
+    memcpy(&int_val, &val, sizeof(float));
+    copy_from_u32(buf, int_val);
+}
+
+float copy_to_f32(const uint8_t *buf)
+{
+    float val;
+    uint32_t int_val = copy_to_u32(buf);
+    memcpy(&val, &int_val, sizeof(float));
+    return val;
+}
+
+void encode_f32(float val, char *out)
+{
+    uint32_t int_val;
+    memcpy(&int_val, &val, sizeof(float));
+    for (int i = 7; i >= 0; i--) {
+        out[i] = HEX_DIGITS[int_val & 0x0F];
+        int_val >>= 4;
+    }
+}
+
+QString encode_f32(float val)
+{
+    char buf[8];
+    encode_f32(val, buf);
+    return QString::fromLatin1(buf, sizeof(buf));
+}
+
+float decode_f32(const QString &val)
+{
+    return decode_f32(QStringView(val));
+}
+
+float decode_f32(QStringView val)
+{
+    if (val.size() != 8) { return qSNaN(); }
+    return decodeHexF32(val.utf16());
+}
+
+float decode_f32(QByteArrayView val)
+{
+    // Decodes the 8 hex digit form produced by encode_f32() directly
+    // from the source buffer, without building intermediate strings
+    if (val.size() != 8) { return qSNaN(); }
+    return decodeHexF32(reinterpret_cast<const uint8_t *>(val.data()));
+}
+
+bool decode_f32_list(const QStringList &vals, float *out, qsizetype count)
+{
+    bool valid = vals.size() >= count;
+    for (qsizetype i = 0; i < count; i++) {
+        out[i] = i < vals.size() ? decode_f32(QStringView(vals.at(i))) : qSNaN();
+        valid = valid && !qIsNaN(out[i]);
+    }
+    return valid;
+}
+
+qsizetype decode_hex(QByteArrayView hex, uint8_t *out)
+{
+    if (hex.size() % 2 != 0) { return -1; }
+
+    const uint8_t *in = reinterpret_cast<const uint8_t *>(hex.data());
+    const qsizetype len = hex.size();
+    qsizetype i = 0;
+
+#if defined(__SSE2__)
+    // Decode 16 digits at a time, which covers most of a calibration
+    // snapshot block before falling back to the table for the tail
+    const __m128i zero = _mm_set1_epi8('0' - 1);
+    const __m128i nine = _mm_set1_epi8('9' + 1);
+    const __m128i lowerA = _mm_set1_epi8('a' - 1);
+    const __m128i lowerF = _mm_set1_epi8('f' + 1);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i digitBase = _mm_set1_epi8('0');
+    const __m128i alphaBase = _mm_set1_epi8('a' - 10);
+    const __m128i lowByte = _mm_set1_epi16(0x00FF);
+
+    for (; i + 16 <= len; i += 16) {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        const __m128i lower = _mm_or_si128(chars, caseBit);
+
+        const __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(chars, zero), _mm_cmplt_epi8(chars, nine));
+        const __m128i isAlpha = _mm_and_si128(_mm_cmpgt_epi8(lower, lowerA), _mm_cmplt_epi8(lower, lowerF));
+        if (_mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) != 0xFFFF) { return -1; }
+
+        const __m128i nibbles = _mm_or_si128(
+            _mm_and_si128(isDigit, _mm_sub_epi8(chars, digitBase)),
+            _mm_and_si128(isAlpha, _mm_sub_epi8(lower, alphaBase)));
+
+        // Each 16-bit lane holds the high nibble in its low byte and the
+        // low nibble in its high byte, so swap them into a single byte
+        const __m128i bytes = _mm_or_si128(
+            _mm_slli_epi16(_mm_and_si128(nibbles, lowByte), 4),
+            _mm_srli_epi16(nibbles, 8));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i / 2), _mm_packus_epi16(bytes, bytes));
+    }
+#endif
+
+    for (; i < len; i += 2) {
+        const int hi = HEX_TABLE.value[in[i]];
+        const int lo = HEX_TABLE.value[in[i + 1]];
+        if ((hi | lo) < 0) { return -1; }
+        out[i / 2] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+
+    return len / 2;
+}
+
+uint32_t calculateStmCrc32(uint32_t *data, size_t len)
+{
+    return StmCrc32::checksum(data, len);
+}
+
+uint16_t calculateFtdiChecksum(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xAAAA;
+
+    if (len % 2 != 0) { return 0; }
+
+    for (size_t i = 0; i < len; i += 2) {
+        crc ^= data[i] | (data[i + 1] << 8);
+        crc = (crc << 1) | (crc >> 15);
+    }
+    return crc;
+}
+
+std::tuple<float, float, float> polyfit(const QList<float> &xList, const QList<float> &yList)
+{
+    if (xList.isEmpty() || xList.size() != yList.size()) {
+        return {qSNaN(), qSNaN(), qSNaN()};
+    }
+
+    PolyFit<2> fit;
+    for (qsizetype i = 0; i < xList.size(); i++) {
+        fit.addPoint(xList[i], yList[i]);
+    }
+
+    const PolyFit<2>::Coefficients beta = fit.coefficients();
+    return {static_cast<float>(beta[0]), static_cast<float>(beta[1]), static_cast<float>(beta[2])};
+}
+
+int logLevelRank(char level)
+{
+    switch (level) {
+    case 'V': return 0;
+    case 'D': return 1;
+    case 'I': return 2;
+    case 'W': return 3;
+    case 'E': return 4;
+    case 'A': return 5;
+    default: return -1;
+    }
+}
+
+int parseJsonInt(const QJsonValue &value)
+{
+    if (value.isDouble()) {
+        return (int)value.toDouble(0);
+    } else if (value.isString()) {
+        bool ok;
+        float result = value.toString().toInt(&ok);
+        if (ok) {
+            return result;
+        } else {
+            return 0;
+        }
+    } else {
+        return 0;
+    }
+}
+
+float parseJsonFloat(const QJsonValue &value)
+{
+    if (value.isDouble()) {
+        return value.toDouble(qSNaN());
+    } else if (value.isString()) {
+        bool ok;
+        float result = value.toString().toFloat(&ok);
+        if (ok) {
+            return result;
+        } else {
+            return qSNaN();
+        }
+    } else {
+        return qSNaN();
+    }
+}
+
+}
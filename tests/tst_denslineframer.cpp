@@ -0,0 +1,95 @@
+#include <QtTest>
+#include <QByteArray>
+#include <string.h>
+
+#include "../src/denslineframer.h"
+
+class TestDensLineFramer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void splitsLines();
+    void directWrites();
+    void keepsBlocks();
+};
+
+void TestDensLineFramer::splitsLines()
+{
+    DensLineFramer framer;
+    QByteArrayView line;
+
+    framer.append("GMSI");
+    QVERIFY(!framer.nextLine(&line));
+    QCOMPARE(framer.pendingSize(), 4);
+
+    framer.append(QByteArrayView("D\r\nGMV,3,1\r\nGM"));
+    QVERIFY(framer.nextLine(&line));
+    QCOMPARE(line.toByteArray(), QByteArray("GMSID\r\n"));
+    QVERIFY(framer.nextLine(&line));
+    QCOMPARE(line.toByteArray(), QByteArray("GMV,3,1\r\n"));
+    QVERIFY(!framer.nextLine(&line));
+    QCOMPARE(framer.pendingSize(), 2);
+
+    framer.append("\n");
+    QVERIFY(framer.nextLine(&line));
+    QCOMPARE(line.toByteArray(), QByteArray("GM\n"));
+    QCOMPARE(framer.pendingSize(), 0);
+
+    framer.append("partial");
+    framer.clear();
+    QCOMPARE(framer.pendingSize(), 0);
+    QVERIFY(!framer.nextLine(&line));
+}
+
+void TestDensLineFramer::directWrites()
+{
+    DensLineFramer framer;
+    QByteArrayView line;
+
+    // Write more than the initial capacity, a few bytes at a time
+    QByteArray expected;
+    for (int i = 0; i < 1000; i++) {
+        const QByteArray text = QByteArray::number(i) + '\n';
+        expected.append(text);
+        char *out = framer.prepareWrite(64);
+        memcpy(out, text.constData(), text.size());
+        framer.commitWrite(text.size());
+    }
+
+    QByteArray received;
+    while (framer.nextLine(&line)) {
+        received.append(line);
+    }
+    QCOMPARE(received, expected);
+    QCOMPARE(framer.pendingSize(), 0);
+}
+
+void TestDensLineFramer::keepsBlocks()
+{
+    DensLineFramer framer;
+    QByteArrayView line;
+
+    framer.append("HEADER\n");
+    QVERIFY(framer.nextLine(&line));
+    QCOMPARE(line.toByteArray(), QByteArray("HEADER\n"));
+
+    framer.beginBlock();
+    QVERIFY(framer.hasBlock());
+
+    // Writes while the block is open must not lose its start
+    framer.append("L1\n");
+    QVERIFY(framer.nextLine(&line));
+    framer.append("L2\nEND\n");
+    QVERIFY(framer.nextLine(&line));
+    QVERIFY(framer.nextLine(&line));
+    QCOMPARE(line.toByteArray(), QByteArray("END\n"));
+
+    QCOMPARE(framer.endBlock().toByteArray(), QByteArray("L1\nL2\n"));
+    QVERIFY(!framer.hasBlock());
+    QVERIFY(framer.endBlock().isNull());
+}
+
+QTEST_GUILESS_MAIN(TestDensLineFramer)
+
+#include "tst_denslineframer.moc"
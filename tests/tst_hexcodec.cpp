@@ -0,0 +1,105 @@
+#include <QtTest>
+#include <QByteArray>
+#include <QRandomGenerator>
+
+#include "../src/util.h"
+
+namespace
+{
+QByteArray randomBytes(qsizetype size)
+{
+    QRandomGenerator generator(static_cast<quint32>(size));
+    QByteArray bytes(size, Qt::Uninitialized);
+    for (qsizetype i = 0; i < size; i++) {
+        bytes[i] = static_cast<char>(generator.bounded(256));
+    }
+    return bytes;
+}
+}
+
+class TestHexCodec : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void encodeF32();
+    void decodeF32();
+    void decodeF32List();
+    void decodeHex();
+};
+
+void TestHexCodec::encodeF32()
+{
+    QCOMPARE(util::encode_f32(1.0F), QString("3F800000"));
+    QCOMPARE(util::encode_f32(-2.5F), QString("C0200000"));
+    QCOMPARE(util::encode_f32(0.0F), QString("00000000"));
+
+    char buf[8];
+    util::encode_f32(0.1F, buf);
+    QCOMPARE(QByteArray(buf, sizeof(buf)), QByteArray("3DCCCCCD"));
+}
+
+void TestHexCodec::decodeF32()
+{
+    QCOMPARE(util::decode_f32(QByteArrayView("3F800000")), 1.0F);
+    QCOMPARE(util::decode_f32(QByteArrayView("c0200000")), -2.5F);
+    QCOMPARE(util::decode_f32(QString("3DCCCCCD")), 0.1F);
+    QCOMPARE(util::decode_f32(QStringView(u"3dcccccd")), 0.1F);
+
+    QVERIFY(qIsNaN(util::decode_f32(QByteArrayView("3F80000G"))));
+    QVERIFY(qIsNaN(util::decode_f32(QByteArrayView("3F8000"))));
+    QVERIFY(qIsNaN(util::decode_f32(QByteArrayView("3F8000000"))));
+    QVERIFY(qIsNaN(util::decode_f32(QString(u"3F80000\u0133"))));
+
+    const float values[] = { 1.0F, -1.0F, 3.14159F, 1.0e-40F, 6.5e12F };
+    for (const float value : values) {
+        QCOMPARE(util::decode_f32(util::encode_f32(value)), value);
+    }
+}
+
+void TestHexCodec::decodeF32List()
+{
+    float out[3];
+    QVERIFY(util::decode_f32_list(QStringList() << "3F800000" << "C0200000" << "00000000", out, 3));
+    QCOMPARE(out[0], 1.0F);
+    QCOMPARE(out[1], -2.5F);
+    QCOMPARE(out[2], 0.0F);
+
+    QVERIFY(!util::decode_f32_list(QStringList() << "3F800000" << "XYZ", out, 3));
+    QCOMPARE(out[0], 1.0F);
+    QVERIFY(qIsNaN(out[1]));
+    QVERIFY(qIsNaN(out[2]));
+}
+
+void TestHexCodec::decodeHex()
+{
+    uint8_t out[64];
+
+    QCOMPARE(util::decode_hex("00FFa5", out), 3);
+    QCOMPARE(out[0], 0x00);
+    QCOMPARE(out[1], 0xFF);
+    QCOMPARE(out[2], 0xA5);
+
+    QCOMPARE(util::decode_hex("ABC", out), -1);
+    QCOMPARE(util::decode_hex("0G", out), -1);
+    QCOMPARE(util::decode_hex("", out), 0);
+
+    // Long enough to go through the vectorized path and the tail after it
+    const QByteArray bytes = randomBytes(37);
+    const QByteArray hex = bytes.toHex();
+    QCOMPARE(util::decode_hex(hex, out), bytes.size());
+    QCOMPARE(QByteArray(reinterpret_cast<const char *>(out), bytes.size()), bytes);
+    QCOMPARE(util::decode_hex(hex.toUpper(), out), bytes.size());
+    QCOMPARE(QByteArray(reinterpret_cast<const char *>(out), bytes.size()), bytes);
+
+    // Invalid digits in both the vectorized part and the tail
+    for (const qsizetype pos : { qsizetype(3), qsizetype(20), hex.size() - 1 }) {
+        QByteArray invalid = hex;
+        invalid[pos] = 'g';
+        QCOMPARE(util::decode_hex(invalid, out), -1);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestHexCodec)
+
+#include "tst_hexcodec.moc"
@@ -0,0 +1,82 @@
+#include <QtTest>
+
+#include "../src/metrics.h"
+
+class TestMetricHistogram : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void buckets();
+    void record();
+    void percentiles();
+};
+
+void TestMetricHistogram::buckets()
+{
+    for (quint64 value = 0; value < MetricHistogram::SubBuckets; value++) {
+        QCOMPARE(MetricHistogram::bucketIndex(value), static_cast<int>(value));
+        QCOMPARE(MetricHistogram::bucketUpperBound(static_cast<int>(value)), value);
+    }
+
+    // Every value lands in a bucket no more than 1/16th wider than itself,
+    // and the buckets only ever go up with the value
+    int lastIndex = 0;
+    for (quint64 value = 1; value < (Q_UINT64_C(1) << 40); value += 1 + value / 7) {
+        const int index = MetricHistogram::bucketIndex(value);
+        QVERIFY(index >= lastIndex);
+        QVERIFY(index < MetricHistogram::BucketCount);
+
+        const quint64 upper = MetricHistogram::bucketUpperBound(index);
+        QVERIFY(upper >= value);
+        QVERIFY(upper - value <= value / MetricHistogram::SubBuckets);
+        lastIndex = index;
+    }
+
+    QCOMPARE(MetricHistogram::bucketIndex(Q_UINT64_C(1) << 50), MetricHistogram::BucketCount - 1);
+    QCOMPARE(MetricHistogram::bucketIndex(~Q_UINT64_C(0)), MetricHistogram::BucketCount - 1);
+}
+
+void TestMetricHistogram::record()
+{
+    MetricHistogram histogram;
+    QCOMPARE(histogram.count(), 0U);
+    QCOMPARE(histogram.mean(), 0.0);
+    QCOMPARE(histogram.percentile(0.5), 0U);
+
+    histogram.record(10);
+    histogram.record(30);
+    histogram.record(1000);
+    QCOMPARE(histogram.count(), 3U);
+    QCOMPARE(histogram.sum(), 1040U);
+    QCOMPARE(histogram.max(), 1000U);
+    QCOMPARE(histogram.mean(), 1040.0 / 3.0);
+
+    histogram.reset();
+    QCOMPARE(histogram.count(), 0U);
+    QCOMPARE(histogram.sum(), 0U);
+    QCOMPARE(histogram.max(), 0U);
+}
+
+void TestMetricHistogram::percentiles()
+{
+    MetricHistogram histogram;
+    for (quint64 value = 1; value <= 100; value++) {
+        histogram.record(value);
+    }
+
+    const double fractions[] = { 0.01, 0.5, 0.9, 0.99 };
+    for (const double fraction : fractions) {
+        const quint64 exact = static_cast<quint64>(fraction * 100.0 + 0.5);
+        const quint64 value = histogram.percentile(fraction);
+        QVERIFY(value >= exact);
+        QVERIFY(value - exact <= exact / MetricHistogram::SubBuckets);
+    }
+
+    // Never reported above the largest value recorded
+    QCOMPARE(histogram.percentile(1.0), 100U);
+}
+
+QTEST_GUILESS_MAIN(TestMetricHistogram)
+
+#include "tst_metrichistogram.moc"
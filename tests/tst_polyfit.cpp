@@ -0,0 +1,128 @@
+#include <QtTest>
+#include <cmath>
+#include <tuple>
+
+#include "../src/polyfit.h"
+#include "../src/util.h"
+
+class TestPolyFit : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void exact();
+    void offsetInput();
+    void addRemove();
+    void degenerate();
+};
+
+void TestPolyFit::exact()
+{
+    PolyFit<2> fit;
+    for (int i = 0; i < 21; i++) {
+        const double x = i * 0.15;
+        fit.addPoint(x, 0.02 + (0.98 * x) + (0.015 * x * x));
+    }
+    QCOMPARE(fit.count(), 21);
+
+    PolyFit<2>::Coefficients beta;
+    QVERIFY(fit.solve(beta));
+    QVERIFY(qAbs(beta[0] - 0.02) < 1e-9);
+    QVERIFY(qAbs(beta[1] - 0.98) < 1e-9);
+    QVERIFY(qAbs(beta[2] - 0.015) < 1e-9);
+}
+
+void TestPolyFit::offsetInput()
+{
+    // Temperature correction curves, with x in degrees Celsius
+    PolyFit<2> fit;
+    for (int i = 0; i <= 20; i++) {
+        const double x = 15.0 + (i * 1.25);
+        fit.addPoint(x, 1.2 - (0.012 * x) + (0.00021 * x * x));
+    }
+
+    const PolyFit<2>::Coefficients beta = fit.coefficients();
+    QVERIFY(qAbs(beta[0] - 1.2) < 1e-9);
+    QVERIFY(qAbs(beta[1] + 0.012) < 1e-10);
+    QVERIFY(qAbs(beta[2] - 0.00021) < 1e-12);
+}
+
+void TestPolyFit::addRemove()
+{
+    PolyFit<2> fit;
+    PolyFit<2> reference;
+    for (int i = 0; i < 10; i++) {
+        const double x = 20.0 + i;
+        fit.addPoint(x, std::sqrt(x));
+        reference.addPoint(x, std::sqrt(x));
+    }
+
+    // An outlier taken back out again leaves the same fit behind
+    fit.addPoint(95.0, -40.0);
+    fit.removePoint(95.0, -40.0);
+    QCOMPARE(fit.count(), reference.count());
+
+    const PolyFit<2>::Coefficients beta = fit.coefficients();
+    const PolyFit<2>::Coefficients expected = reference.coefficients();
+    for (int i = 0; i < PolyFit<2>::Terms; i++) {
+        QVERIFY(qAbs(beta[i] - expected[i]) < 1e-9 * qMax(1.0, qAbs(expected[i])));
+    }
+
+    // Emptying the fit and starting again behaves like a new one
+    for (int i = 0; i < 10; i++) {
+        const double x = 20.0 + i;
+        fit.removePoint(x, std::sqrt(x));
+    }
+    QCOMPARE(fit.count(), 0);
+    fit.addPoint(1.0, 3.0);
+    fit.addPoint(2.0, 5.0);
+    fit.addPoint(3.0, 7.0);
+    const PolyFit<2>::Coefficients line = fit.coefficients();
+    QVERIFY(qAbs(line[0] - 1.0) < 1e-9);
+    QVERIFY(qAbs(line[1] - 2.0) < 1e-9);
+    QVERIFY(qAbs(line[2]) < 1e-9);
+}
+
+void TestPolyFit::degenerate()
+{
+    PolyFit<2> fit;
+    PolyFit<2>::Coefficients beta;
+    beta.fill(42.0);
+
+    // Nothing to fit
+    QVERIFY(!fit.solve(beta));
+    QCOMPARE(beta[0], 42.0);
+
+    // Too few points
+    fit.addPoint(1.0, 1.0);
+    fit.addPoint(2.0, 2.0);
+    QVERIFY(!fit.solve(beta));
+    QCOMPARE(beta[0], 42.0);
+
+    // Enough points, but all at the same x
+    fit.clear();
+    fit.addPoint(5.0, 1.0);
+    fit.addPoint(5.0, 2.0);
+    fit.addPoint(5.0, 3.0);
+    QVERIFY(!fit.solve(beta));
+
+    const PolyFit<2>::Coefficients nan = fit.coefficients();
+    for (int i = 0; i < PolyFit<2>::Terms; i++) {
+        QVERIFY(qIsNaN(nan[i]));
+    }
+
+    // Only two distinct x values for a quadratic
+    fit.clear();
+    fit.addPoint(1.0, 1.0);
+    fit.addPoint(1.0, 1.5);
+    fit.addPoint(2.0, 2.0);
+    fit.addPoint(2.0, 2.5);
+    QVERIFY(!fit.solve(beta));
+
+    const std::tuple<float, float, float> empty = util::polyfit(QList<float>(), QList<float>());
+    QVERIFY(qIsNaN(std::get<0>(empty)));
+}
+
+QTEST_GUILESS_MAIN(TestPolyFit)
+
+#include "tst_polyfit.moc"
@@ -0,0 +1,110 @@
+#include <QtTest>
+#include <QThread>
+
+#include "../src/spscringbuffer.h"
+
+namespace
+{
+/* Elements passed between the threads in the stress test */
+static const int RING_STRESS_COUNT = 200000;
+}
+
+class TestSpscRingBuffer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void capacity();
+    void wrapAround();
+    void threads();
+};
+
+void TestSpscRingBuffer::capacity()
+{
+    QCOMPARE(SpscRingBuffer<int>(0).capacity(), 2U);
+    QCOMPARE(SpscRingBuffer<int>(5).capacity(), 8U);
+    QCOMPARE(SpscRingBuffer<int>(64).capacity(), 64U);
+
+    SpscRingBuffer<int> buffer(4);
+    const int values[] = { 1, 2, 3, 4, 5, 6 };
+    QCOMPARE(buffer.push(values, 6), 4U);
+    QCOMPARE(buffer.size(), 4U);
+    QVERIFY(!buffer.push(7));
+
+    int out[8];
+    QCOMPARE(buffer.pop(out, 8), 4U);
+    QCOMPARE(out[0], 1);
+    QCOMPARE(out[3], 4);
+    QCOMPARE(buffer.pop(out, 8), 0U);
+
+    QVERIFY(buffer.push(8));
+    buffer.clear();
+    QCOMPARE(buffer.size(), 0U);
+}
+
+void TestSpscRingBuffer::wrapAround()
+{
+    SpscRingBuffer<int> buffer(8);
+    int next = 0;
+    int expected = 0;
+
+    // Uneven pushes and pops, so the indices wrap at every position
+    for (int round = 0; round < 100; round++) {
+        int in[5];
+        for (int &value : in) { value = next++; }
+        const size_t pushed = buffer.push(in, 5);
+        next -= static_cast<int>(5 - pushed);
+
+        int out[3];
+        const size_t popped = buffer.pop(out, 3);
+        for (size_t i = 0; i < popped; i++) {
+            QCOMPARE(out[i], expected++);
+        }
+    }
+
+    int out[8];
+    const size_t popped = buffer.pop(out, 8);
+    for (size_t i = 0; i < popped; i++) {
+        QCOMPARE(out[i], expected++);
+    }
+    QCOMPARE(expected, next);
+}
+
+void TestSpscRingBuffer::threads()
+{
+    SpscRingBuffer<int> buffer(256);
+
+    QThread *producer = QThread::create([&buffer]() {
+        int next = 0;
+        while (next < RING_STRESS_COUNT) {
+            if (buffer.push(next)) {
+                next++;
+            } else {
+                QThread::yieldCurrentThread();
+            }
+        }
+    });
+    producer->start();
+
+    int expected = 0;
+    bool ordered = true;
+    while (expected < RING_STRESS_COUNT) {
+        int out[64];
+        const size_t popped = buffer.pop(out, 64);
+        for (size_t i = 0; i < popped; i++) {
+            ordered = ordered && out[i] == expected;
+            expected++;
+        }
+        if (popped == 0) { QThread::yieldCurrentThread(); }
+    }
+
+    producer->wait();
+    delete producer;
+
+    QVERIFY(ordered);
+    QCOMPARE(buffer.size(), 0U);
+}
+
+QTEST_GUILESS_MAIN(TestSpscRingBuffer)
+
+#include "tst_spscringbuffer.moc"
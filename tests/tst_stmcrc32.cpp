@@ -0,0 +1,139 @@
+#include <QtTest>
+#include <QByteArray>
+#include <QRandomGenerator>
+#include <QtEndian>
+#include <vector>
+
+#include "../src/stmcrc32.h"
+#include "../src/util.h"
+
+namespace
+{
+/* STM32 hardware CRC of the single word 0x12345678 */
+static const uint32_t CRC_WORD_REFERENCE = 0xDF8A8A2B;
+
+/* STM32 hardware CRC of "123456789", padded out to a whole word with zeros */
+static const uint32_t CRC_TEXT_REFERENCE = 0xAFF19057;
+
+/* Words compared between the engines, several passes through each block loop */
+static const size_t CRC_ENGINE_WORDS = 600;
+
+QByteArray randomBytes(qsizetype size)
+{
+    QRandomGenerator generator(static_cast<quint32>(size));
+    QByteArray bytes(size, Qt::Uninitialized);
+    for (qsizetype i = 0; i < size; i++) {
+        bytes[i] = static_cast<char>(generator.bounded(256));
+    }
+    return bytes;
+}
+
+/* Bit at a time STM32 CRC, as an independent reference for the engines */
+uint32_t bitwiseCrc(uint32_t crc, const uint32_t *words, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        crc ^= words[i];
+        for (int bit = 0; bit < 32; bit++) {
+            crc = (crc & 0x80000000U) ? (crc << 1) ^ 0x04C11DB7U : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+std::vector<uint32_t> bytesToWords(const QByteArray &bytes)
+{
+    std::vector<uint32_t> words(static_cast<size_t>(bytes.size() / 4));
+    for (size_t i = 0; i < words.size(); i++) {
+        words[i] = qFromLittleEndian<uint32_t>(bytes.constData() + (i * 4));
+    }
+    return words;
+}
+}
+
+class TestStmCrc32 : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void reference();
+    void engines();
+    void unevenData();
+};
+
+void TestStmCrc32::reference()
+{
+    const uint32_t word = 0x12345678;
+    QCOMPARE(StmCrc32::checksum(&word, 1), CRC_WORD_REFERENCE);
+    QCOMPARE(StmCrc32::checksum(QByteArrayView("123456789")), CRC_TEXT_REFERENCE);
+    QCOMPARE(StmCrc32::checksum(QByteArrayView()), 0xFFFFFFFFU);
+
+    uint32_t buf = 0x12345678;
+    QCOMPARE(util::calculateStmCrc32(&buf, 1), CRC_WORD_REFERENCE);
+}
+
+void TestStmCrc32::engines()
+{
+    const StmCrc32::Engine engines[] = {
+        StmCrc32::EngineNibble, StmCrc32::EngineSlicing8, StmCrc32::EngineClmul
+    };
+
+    const uint32_t word = 0x12345678;
+    const std::vector<uint32_t> words = bytesToWords(randomBytes(CRC_ENGINE_WORDS * 4));
+    QCOMPARE(bitwiseCrc(0xFFFFFFFF, &word, 1), CRC_WORD_REFERENCE);
+
+    for (const StmCrc32::Engine engine : engines) {
+        if (!StmCrc32::isSupported(engine)) {
+            qInfo() << "Engine" << engine << "is not supported on this CPU";
+            continue;
+        }
+
+        QCOMPARE(StmCrc32::update(engine, 0xFFFFFFFF, &word, 1), CRC_WORD_REFERENCE);
+
+        // Every length up to several hundred words, so each engine's block
+        // loop and tail handling are covered at every alignment
+        for (size_t count = 0; count <= words.size(); count++) {
+            const uint32_t expected = bitwiseCrc(0xFFFFFFFF, words.data(), count);
+            QCOMPARE(StmCrc32::update(engine, 0xFFFFFFFF, words.data(), count), expected);
+        }
+
+        // Continuing from a previous result matches one pass over the whole
+        const uint32_t whole = bitwiseCrc(0xFFFFFFFF, words.data(), words.size());
+        const uint32_t first = StmCrc32::update(engine, 0xFFFFFFFF, words.data(), 93);
+        QCOMPARE(StmCrc32::update(engine, first, words.data() + 93, words.size() - 93), whole);
+    }
+}
+
+void TestStmCrc32::unevenData()
+{
+    const QByteArray bytes = randomBytes(517);
+    const uint32_t expected = StmCrc32::checksum(bytes);
+
+    // Same as the data padded out to a whole word with zeros
+    QByteArray padded = bytes;
+    padded.append(3, '\0');
+    const std::vector<uint32_t> words = bytesToWords(padded);
+    QCOMPARE(StmCrc32::update(StmCrc32::EngineNibble, 0xFFFFFFFF, words.data(), words.size()), expected);
+
+    for (const qsizetype step : { 1, 2, 3, 5, 7, 61 }) {
+        StmCrc32 crc;
+        for (qsizetype pos = 0; pos < bytes.size(); pos += step) {
+            crc.addData(QByteArrayView(bytes).sliced(pos, qMin(step, bytes.size() - pos)));
+        }
+        QCOMPARE(crc.result(), expected);
+    }
+
+    // Whole words added while part of a word is still pending
+    StmCrc32 crc;
+    crc.addData(QByteArrayView(padded).first(3));
+    std::vector<uint32_t> shifted = bytesToWords(QByteArrayView(padded).sliced(3, 512).toByteArray());
+    crc.addWords(shifted.data(), shifted.size());
+    crc.addData(QByteArrayView(bytes).sliced(515));
+    QCOMPARE(crc.result(), expected);
+
+    crc.reset();
+    QCOMPARE(crc.result(), 0xFFFFFFFFU);
+}
+
+QTEST_GUILESS_MAIN(TestStmCrc32)
+
+#include "tst_stmcrc32.moc"